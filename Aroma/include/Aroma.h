@@ -22,6 +22,9 @@
 #include "aroma/common/ScopedPtr.h"
 #include "aroma/common/Algorithm.h"
 #include "aroma/common/BitFlag.h"
+#include "aroma/common/LockFreeQueue.h"
+#include "aroma/common/Scheduler.h"
+#include "aroma/common/Task.h"
 
 // app includes
 #include "aroma/app/App.h"
@@ -36,9 +39,22 @@
 #include "aroma/data/Color.h"
 #include "aroma/data/DDS.h"
 #include "aroma/data/FixedArray.h"
+#include "aroma/data/Hash.h"
+#include "aroma/data/StringId.h"
+#include "aroma/data/LZ4.h"
+#include "aroma/data/ChunkedCompression.h"
+#include "aroma/data/PixelConvert.h"
+#include "aroma/data/MipGenerator.h"
 
 // file includes
 #include "aroma/file/FileIO.h"
+#include "aroma/file/MappedFile.h"
+#include "aroma/file/AsyncFileReader.h"
+#include "aroma/file/ParallelRead.h"
+#include "aroma/file/FileWriter.h"
+#include "aroma/file/ArchiveFormat.h"
+#include "aroma/file/ArchiveReader.h"
+#include "aroma/file/ArchiveBuilder.h"
 
 // util includes
 #include "aroma/util/NonCopyable.h"
@@ -54,11 +70,17 @@
 #include "aroma/render/SwapChain.h"
 #include "aroma/render/Texture.h"
 #include "aroma/render/TextureView.h"
+#include "aroma/render/TextureStreamer.h"
 #include "aroma/render/RenderTargetView.h"
 #include "aroma/render/DepthStencilView.h"
 #include "aroma/render/DeferredContext.h"
 #include "aroma/render/CommandList.h"
+#include "aroma/render/ParallelCommandRecorder.h"
 #include "aroma/render/Buffer.h"
 #include "aroma/render/Shader.h"
 #include "aroma/render/InputLayout.h"
+#include "aroma/render/PipelineState.h"
+#include "aroma/render/BindingGroup.h"
+#include "aroma/render/RenderQueue.h"
+#include "aroma/render/CommandStats.h"
 //! @}
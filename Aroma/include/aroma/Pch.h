@@ -18,6 +18,12 @@
 #endif
 #endif
 
+#ifndef AROMA_POSIX
+#if !defined( AROMA_WINDOWS ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+#define AROMA_POSIX 1
+#endif
+#endif
+
 //---------------------------------------------------------------------------
 // Debug Definition
 //---------------------------------------------------------------------------
@@ -58,7 +64,9 @@
 //---------------------------------------------------------------------------
 // Check Preprocessor Definitions
 //---------------------------------------------------------------------------
+// POSIXのビルド(CMakeLists.txt)はグラフィックスAPIを使用しないモジュールのみ.
 #ifdef AROMA_RENDER_DX11
+#elif defined( AROMA_POSIX )
 #else
 #error No graphic API specified. \
 Please apply the configuration file "Aroma.props".
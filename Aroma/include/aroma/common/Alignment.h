@@ -22,15 +22,15 @@
 #define AROMA_ALIGN4_BEGIN		__declspec( align( 4) )
 #define AROMA_ALIGN4_END
 
-#elif defined( AROMA_NX )
+#elif defined( AROMA_NX ) || defined( AROMA_POSIX )
 
-#define AROMA_ALIGN32_BEGIN		__attribute__( aligned(32) )
+#define AROMA_ALIGN32_BEGIN		__attribute__(( aligned(32) ))
 #define AROMA_ALIGN32_END
-#define AROMA_ALIGN16_BEGIN		__attribute__( aligned(16) )
+#define AROMA_ALIGN16_BEGIN		__attribute__(( aligned(16) ))
 #define AROMA_ALIGN16_END
-#define AROMA_ALIGN8_BEGIN		__attribute__( aligned( 8) )
+#define AROMA_ALIGN8_BEGIN		__attribute__(( aligned( 8) ))
 #define AROMA_ALIGN8_END
-#define AROMA_ALIGN4_BEGIN		__attribute__( aligned( 4) )
+#define AROMA_ALIGN4_BEGIN		__attribute__(( aligned( 4) ))
 #define AROMA_ALIGN4_END
 
 #else
@@ -40,6 +40,13 @@
 
 namespace aroma {
 
+//---------------------------------------------------------------------------
+//! @brief	キャッシュラインサイズ.
+//!
+//! @note	スレッド間の偽共有(false sharing)回避のためのパディングに使用します.
+//---------------------------------------------------------------------------
+constexpr size_t kCacheLineSize = 64;
+
 //---------------------------------------------------------------------------
 //! @brief	アラインメントサイズ切り上げマクロ.
 //---------------------------------------------------------------------------
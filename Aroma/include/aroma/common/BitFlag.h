@@ -15,8 +15,8 @@ namespace aroma {
 //---------------------------------------------------------------------------
 //!	@brief	指定位置ビットが立った整数値を作成.
 //---------------------------------------------------------------------------
-static inline constexpr u32 Bit32( u32 n ){ return ( 1ui32 << n ); }
-static inline constexpr u64 Bit64( u32 n ){ return ( 1ui64 << n ); }
+static inline constexpr u32 Bit32( u32 n ){ return ( 1u << n ); }
+static inline constexpr u64 Bit64( u32 n ){ return ( 1ull << n ); }
 
 //---------------------------------------------------------------------------
 //!	@brief	ビットフラグをオン.
@@ -9,12 +9,17 @@
 //===========================================================================
 #pragma once
 
+#include <cstring>
+#include "Typedef.h"
+
 //---------------------------------------------------------------------------
 //! @brief プラットフォーム別バイトオーダー定義.
 //---------------------------------------------------------------------------
 #if defined( AROMA_WINDOWS )
 #define AROMA_ENDIAN_LE 1	//!< // リトルエンディアン.
-#elif 0
+#elif defined( AROMA_POSIX ) && defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+#define AROMA_ENDIAN_LE 1	//!< // リトルエンディアン.
+#elif defined( AROMA_POSIX ) && defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ )
 #define AROMA_ENDIAN_BE 1	//!< // ビッグエンディアン.
 #else
 #error Undefined platform.
@@ -100,8 +105,8 @@ static inline u16 SwapEndian16( u16 data )
 {
 	u32 _data = data;
 	return static_cast< u16 >(
-		((_data >> 8) & 0x00ffui16) +
-		((_data << 8) & 0xff00ui16)
+		((_data >> 8) & 0x00ffu) +
+		((_data << 8) & 0xff00u)
 	);
 }
 
@@ -111,10 +116,10 @@ static inline u16 SwapEndian16( u16 data )
 static inline u32 SwapEndian32( u32 data )
 {
 	return
-		((data >> 24)	& 0x000000ffui32) +
-		((data >> 8)	& 0x0000ff00ui32) +
-		((data << 8)	& 0x00ff0000ui32) +
-		((data << 24)	& 0xff000000ui32);
+		((data >> 24)	& 0x000000ffu) +
+		((data >> 8)	& 0x0000ff00u) +
+		((data << 8)	& 0x00ff0000u) +
+		((data << 24)	& 0xff000000u);
 }
 
 //---------------------------------------------------------------------------
@@ -123,14 +128,14 @@ static inline u32 SwapEndian32( u32 data )
 static inline u64 SwapEndian64( u64 data )
 {
 	return
-		((data >> 56)	& 0x00000000000000ffui64) +
-		((data >> 40)	& 0x000000000000ff00ui64) +
-		((data >> 24)	& 0x0000000000ff0000ui64) +
-		((data >> 8)	& 0x00000000ff000000ui64) +
-		((data << 8)	& 0x000000ff00000000ui64) +
-		((data << 24)	& 0x0000ff0000000000ui64) +
-		((data << 40)	& 0x00ff000000000000ui64) +
-		((data << 56)	& 0xff00000000000000ui64);
+		((data >> 56)	& 0x00000000000000ffull) +
+		((data >> 40)	& 0x000000000000ff00ull) +
+		((data >> 24)	& 0x0000000000ff0000ull) +
+		((data >> 8)	& 0x00000000ff000000ull) +
+		((data << 8)	& 0x000000ff00000000ull) +
+		((data << 24)	& 0x0000ff0000000000ull) +
+		((data << 40)	& 0x00ff000000000000ull) +
+		((data << 56)	& 0xff00000000000000ull);
 }
 
 //===========================================================================
@@ -159,28 +164,34 @@ static inline s8	SwapEndian( const s8& data )
 }
 static inline s16	SwapEndian( const s16& data )
 {
-	u16 temp  = SwapEndian16( *( reinterpret_cast< const u16* >( &data ) ) );
-	return *( reinterpret_cast< const s16* >( &temp ) );
+	return static_cast< s16 >( SwapEndian16( static_cast< u16 >( data ) ) );
 }
 static inline s32	SwapEndian( const s32& data )
 {
-	u32 temp  = SwapEndian32( *( reinterpret_cast< const u32* >( &data ) ) );
-	return *( reinterpret_cast< const s32* >( &temp ) );
+	return static_cast< s32 >( SwapEndian32( static_cast< u32 >( data ) ) );
 }
 static inline s64	SwapEndian( const s64& data )
 {
-	u64 temp  = SwapEndian64( *( reinterpret_cast< const u64* >( &data ) ) );
-	return *( reinterpret_cast< const s64* >( &temp ) );
+	return static_cast< s64 >( SwapEndian64( static_cast< u64 >( data ) ) );
 }
 static inline f32	SwapEndian( const f32& data )
 {
-	u32 temp  = SwapEndian32( *( reinterpret_cast< const u32* >( &data ) ) );
-	return *( reinterpret_cast< const f32* >( &temp ) );
+	// 型の読み替えはstrict aliasingに違反するためmemcpyでビット列をコピー.
+	u32 temp;
+	memcpy( &temp, &data, sizeof( temp ) );
+	temp = SwapEndian32( temp );
+	f32 result;
+	memcpy( &result, &temp, sizeof( result ) );
+	return result;
 }
 static inline f64	SwapEndian( const f64& data )
 {
-	u64 temp  = SwapEndian64( *( reinterpret_cast< const u64* >( &data ) ) );
-	return *( reinterpret_cast< const f64* >( &temp ) );
+	u64 temp;
+	memcpy( &temp, &data, sizeof( temp ) );
+	temp = SwapEndian64( temp );
+	f64 result;
+	memcpy( &result, &temp, sizeof( result ) );
+	return result;
 }
 //! @}
 
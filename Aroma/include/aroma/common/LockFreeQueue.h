@@ -0,0 +1,451 @@
+﻿//===========================================================================
+//!
+//!	@file		LockFreeQueue.h
+//!	@brief		固定長ロックフリーキュー.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Typedef.h"
+#include "Alignment.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+
+namespace detail {
+//---------------------------------------------------------------------------
+//!	@brief		2の累乗に切り上げ.
+//---------------------------------------------------------------------------
+inline size_t RoundUpPow2( size_t value )
+{
+	size_t result = 2;
+	while( result < value )
+	{
+		result <<= 1;
+	}
+	return result;
+}
+} // namespace detail
+
+//---------------------------------------------------------------------------
+//!	@brief		固定長ロックフリーキュー : 単一生産者/単一消費者(SPSC).
+//!
+//! @details
+//!		生産者スレッド1つ, 消費者スレッド1つからのみ使用可能なリングバッファです.
+//!		書き込み位置と読み出し位置は別キャッシュラインに配置し, 相手側の位置は
+//!		キャッシュしてキャッシュラインの往復を抑えています.
+//!
+//!		容量は2の累乗に切り上げられます.
+//---------------------------------------------------------------------------
+template< typename T >
+class SPSCQueue final : private util::NonCopyable< SPSCQueue< T > >
+{
+public:
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//!	@param[in]	capacity	最大要素数(2の累乗に切り上げ).
+	//-----------------------------------------------------------------------
+	explicit SPSCQueue( size_t capacity )
+		: _buffer( nullptr )
+		, _mask( 0 )
+		, _head( 0 )
+		, _cachedTail( 0 )
+		, _tail( 0 )
+		, _cachedHead( 0 )
+	{
+		size_t size = detail::RoundUpPow2( capacity );
+		_mask	= size - 1;
+		_buffer	= new Storage[ size ];
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		デストラクタ.
+	//!
+	//! @note		残っている要素は破棄されます.
+	//-----------------------------------------------------------------------
+	~SPSCQueue()
+	{
+		size_t head = _head.load( std::memory_order_relaxed );
+		size_t tail = _tail.load( std::memory_order_relaxed );
+		for( ; head != tail; ++head )
+		{
+			At( head )->~T();
+		}
+		delete[] _buffer;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		要素追加(生産者スレッド専用).
+	//!	@retval		true	: 追加成功.
+	//!	@retval		false	: キューが満杯.
+	//-----------------------------------------------------------------------
+	bool TryEnqueue( const T& value ) { return Emplace( value ); }
+	bool TryEnqueue( T&& value ) { return Emplace( std::move( value ) ); }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		要素取り出し(消費者スレッド専用).
+	//!	@retval		true	: 取り出し成功.
+	//!	@retval		false	: キューが空.
+	//-----------------------------------------------------------------------
+	bool TryDequeue( T* outValue )
+	{
+		return TryDequeueBulk( outValue, 1 ) == 1;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		複数要素の一括追加(生産者スレッド専用).
+	//!	@param[in]	values	追加する要素配列.
+	//!	@param[in]	count	要素数.
+	//!	@return		追加できた要素数(先頭から順に追加).
+	//!
+	//! @note		公開は最後に1回だけ行うため, 消費者側からは一度に見えます.
+	//-----------------------------------------------------------------------
+	size_t TryEnqueueBulk( const T* values, size_t count )
+	{
+		const size_t tail = _tail.load( std::memory_order_relaxed );
+		size_t free = GetCapacity() - ( tail - _cachedHead );
+		if( free < count )
+		{
+			_cachedHead = _head.load( std::memory_order_acquire );
+			free = GetCapacity() - ( tail - _cachedHead );
+		}
+
+		const size_t n = count < free ? count : free;
+		for( size_t i = 0; i < n; ++i )
+		{
+			new( At( tail + i ) ) T( values[ i ] );
+		}
+		if( n > 0 )
+		{
+			_tail.store( tail + n, std::memory_order_release );
+		}
+		return n;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		複数要素の一括取り出し(消費者スレッド専用).
+	//!	@param[out]	outValues	取り出し先配列.
+	//!	@param[in]	maxCount	最大取り出し数.
+	//!	@return		取り出した要素数.
+	//-----------------------------------------------------------------------
+	size_t TryDequeueBulk( T* outValues, size_t maxCount )
+	{
+		const size_t head = _head.load( std::memory_order_relaxed );
+		size_t available = _cachedTail - head;
+		if( available < maxCount )
+		{
+			_cachedTail = _tail.load( std::memory_order_acquire );
+			available = _cachedTail - head;
+		}
+
+		const size_t n = maxCount < available ? maxCount : available;
+		for( size_t i = 0; i < n; ++i )
+		{
+			T* item = At( head + i );
+			outValues[ i ] = std::move( *item );
+			item->~T();
+		}
+		if( n > 0 )
+		{
+			_head.store( head + n, std::memory_order_release );
+		}
+		return n;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		最大要素数取得.
+	//-----------------------------------------------------------------------
+	size_t GetCapacity() const { return _mask + 1; }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		要素数取得(他スレッド動作中は概算値).
+	//-----------------------------------------------------------------------
+	size_t GetSizeApprox() const
+	{
+		// 読み出し位置を先に読めば, 後から読む書き込み位置より大きくならない.
+		// 2つの読み込みの間に取り出しと追加が進んだ場合は容量を超えうるため制限する.
+		const size_t head = _head.load( std::memory_order_acquire );
+		const size_t tail = _tail.load( std::memory_order_acquire );
+		const size_t size = tail - head;
+		return size < GetCapacity() ? size : GetCapacity();
+	}
+
+private:
+	using Storage = typename std::aligned_storage< sizeof( T ), alignof( T ) >::type;
+
+	T* At( size_t index ) { return reinterpret_cast< T* >( &_buffer[ index & _mask ] ); }
+
+	template< typename U >
+	bool Emplace( U&& value )
+	{
+		const size_t tail = _tail.load( std::memory_order_relaxed );
+		if( tail - _cachedHead >= GetCapacity() )
+		{
+			_cachedHead = _head.load( std::memory_order_acquire );
+			if( tail - _cachedHead >= GetCapacity() ) return false;
+		}
+		new( At( tail ) ) T( std::forward< U >( value ) );
+		_tail.store( tail + 1, std::memory_order_release );
+		return true;
+	}
+
+	// 読み取り専用(共有).
+	Storage*				_buffer;
+	size_t					_mask;
+	u8						_pad0[ kCacheLineSize ];
+
+	// 消費者側.
+	std::atomic< size_t >	_head;
+	size_t					_cachedTail;
+	u8						_pad1[ kCacheLineSize ];
+
+	// 生産者側.
+	std::atomic< size_t >	_tail;
+	size_t					_cachedHead;
+	u8						_pad2[ kCacheLineSize ];
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		固定長ロックフリーキュー : 複数生産者/複数消費者(MPMC).
+//!
+//! @details
+//!		Dmitry Vyukov方式のセル毎シーケンス番号によるリングバッファです.
+//!		各セルのシーケンス番号で書き込み/読み出し可能かを判定するため,
+//!		生産者同士, 消費者同士はCASで位置を確保するだけで排他します.
+//!
+//!		容量は2の累乗に切り上げられます.
+//---------------------------------------------------------------------------
+template< typename T >
+class MPMCQueue final : private util::NonCopyable< MPMCQueue< T > >
+{
+public:
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//!	@param[in]	capacity	最大要素数(2の累乗に切り上げ).
+	//-----------------------------------------------------------------------
+	explicit MPMCQueue( size_t capacity )
+		: _cells( nullptr )
+		, _mask( 0 )
+		, _enqueuePos( 0 )
+		, _dequeuePos( 0 )
+	{
+		size_t size = detail::RoundUpPow2( capacity );
+		_mask	= size - 1;
+		_cells	= new Cell[ size ];
+		for( size_t i = 0; i < size; ++i )
+		{
+			_cells[ i ].sequence.store( i, std::memory_order_relaxed );
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		デストラクタ.
+	//!
+	//! @note		残っている要素は破棄されます.
+	//-----------------------------------------------------------------------
+	~MPMCQueue()
+	{
+		size_t pos = _dequeuePos.load( std::memory_order_relaxed );
+		size_t end = _enqueuePos.load( std::memory_order_relaxed );
+		for( ; pos != end; ++pos )
+		{
+			_cells[ pos & _mask ].Get()->~T();
+		}
+		delete[] _cells;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		要素追加.
+	//!	@retval		true	: 追加成功.
+	//!	@retval		false	: キューが満杯.
+	//-----------------------------------------------------------------------
+	bool TryEnqueue( const T& value ) { return Emplace( value ); }
+	bool TryEnqueue( T&& value ) { return Emplace( std::move( value ) ); }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		要素取り出し.
+	//!	@retval		true	: 取り出し成功.
+	//!	@retval		false	: キューが空.
+	//-----------------------------------------------------------------------
+	bool TryDequeue( T* outValue )
+	{
+		return TryDequeueBulk( outValue, 1 ) == 1;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		複数要素の一括追加.
+	//!	@param[in]	values	追加する要素配列.
+	//!	@param[in]	count	要素数.
+	//!	@return		追加できた要素数(先頭から順に追加).
+	//!
+	//! @note		空きの連続したセルをCAS1回でまとめて確保します.
+	//-----------------------------------------------------------------------
+	size_t TryEnqueueBulk( const T* values, size_t count )
+	{
+		if( count == 0 ) return 0;
+
+		size_t pos = _enqueuePos.load( std::memory_order_relaxed );
+		size_t n;
+		while( true )
+		{
+			// 確保位置から連続して書き込み可能なセル数を数える.
+			for( n = 0; n < count; ++n )
+			{
+				size_t seq = _cells[ ( pos + n ) & _mask ].sequence.load( std::memory_order_acquire );
+				if( seq != pos + n ) break;
+			}
+
+			if( n == 0 )
+			{
+				size_t seq = _cells[ pos & _mask ].sequence.load( std::memory_order_acquire );
+				if( static_cast< intptr >( seq - pos ) < 0 ) return 0;	// 満杯.
+				pos = _enqueuePos.load( std::memory_order_relaxed );	// 他の生産者が先行.
+				continue;
+			}
+
+			if( _enqueuePos.compare_exchange_weak( pos, pos + n, std::memory_order_relaxed ) )
+			{
+				break;
+			}
+		}
+
+		for( size_t i = 0; i < n; ++i )
+		{
+			Cell& cell = _cells[ ( pos + i ) & _mask ];
+			new( cell.Get() ) T( values[ i ] );
+			cell.sequence.store( pos + i + 1, std::memory_order_release );
+		}
+		return n;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		複数要素の一括取り出し.
+	//!	@param[out]	outValues	取り出し先配列.
+	//!	@param[in]	maxCount	最大取り出し数.
+	//!	@return		取り出した要素数.
+	//!
+	//! @note		読み出し可能な連続したセルをCAS1回でまとめて確保します.
+	//-----------------------------------------------------------------------
+	size_t TryDequeueBulk( T* outValues, size_t maxCount )
+	{
+		if( maxCount == 0 ) return 0;
+
+		size_t pos = _dequeuePos.load( std::memory_order_relaxed );
+		size_t n;
+		while( true )
+		{
+			// 確保位置から連続して読み出し可能なセル数を数える.
+			for( n = 0; n < maxCount; ++n )
+			{
+				size_t seq = _cells[ ( pos + n ) & _mask ].sequence.load( std::memory_order_acquire );
+				if( seq != pos + n + 1 ) break;
+			}
+
+			if( n == 0 )
+			{
+				size_t seq = _cells[ pos & _mask ].sequence.load( std::memory_order_acquire );
+				if( static_cast< intptr >( seq - ( pos + 1 ) ) < 0 ) return 0;	// 空.
+				pos = _dequeuePos.load( std::memory_order_relaxed );			// 他の消費者が先行.
+				continue;
+			}
+
+			if( _dequeuePos.compare_exchange_weak( pos, pos + n, std::memory_order_relaxed ) )
+			{
+				break;
+			}
+		}
+
+		for( size_t i = 0; i < n; ++i )
+		{
+			Cell& cell = _cells[ ( pos + i ) & _mask ];
+			T* item = cell.Get();
+			outValues[ i ] = std::move( *item );
+			item->~T();
+			cell.sequence.store( pos + i + _mask + 1, std::memory_order_release );
+		}
+		return n;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		最大要素数取得.
+	//-----------------------------------------------------------------------
+	size_t GetCapacity() const { return _mask + 1; }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		要素数取得(他スレッド動作中は概算値).
+	//-----------------------------------------------------------------------
+	size_t GetSizeApprox() const
+	{
+		size_t enqueuePos = _enqueuePos.load( std::memory_order_acquire );
+		size_t dequeuePos = _dequeuePos.load( std::memory_order_acquire );
+		return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+	}
+
+private:
+	using Storage = typename std::aligned_storage< sizeof( T ), alignof( T ) >::type;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		セル.
+	//-----------------------------------------------------------------------
+	struct Cell
+	{
+		std::atomic< size_t >	sequence;	//!< シーケンス番号.
+		Storage					storage;	//!< 要素格納領域.
+
+		T* Get() { return reinterpret_cast< T* >( &storage ); }
+	};
+
+	template< typename U >
+	bool Emplace( U&& value )
+	{
+		size_t	pos = _enqueuePos.load( std::memory_order_relaxed );
+		Cell*	cell;
+		while( true )
+		{
+			cell = &_cells[ pos & _mask ];
+			size_t	seq		= cell->sequence.load( std::memory_order_acquire );
+			intptr	diff	= static_cast< intptr >( seq - pos );
+			if( diff == 0 )
+			{
+				if( _enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				{
+					break;
+				}
+			}
+			else if( diff < 0 )
+			{
+				return false;	// 満杯.
+			}
+			else
+			{
+				pos = _enqueuePos.load( std::memory_order_relaxed );
+			}
+		}
+
+		new( cell->Get() ) T( std::forward< U >( value ) );
+		cell->sequence.store( pos + 1, std::memory_order_release );
+		return true;
+	}
+
+	// 読み取り専用(共有).
+	Cell*					_cells;
+	size_t					_mask;
+	u8						_pad0[ kCacheLineSize ];
+
+	// 生産者側.
+	std::atomic< size_t >	_enqueuePos;
+	u8						_pad1[ kCacheLineSize ];
+
+	// 消費者側.
+	std::atomic< size_t >	_dequeuePos;
+	u8						_pad2[ kCacheLineSize ];
+};
+
+} // namespace aroma
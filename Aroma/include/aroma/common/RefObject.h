@@ -12,6 +12,7 @@
 #include <atomic>
 #include <list>
 #include "Typedef.h"
+#include "SyncObject.h"
 
 namespace aroma
 {
@@ -65,6 +66,7 @@ private:
 	static void AddObj( RefObject* obj );
 	static void DelObj( RefObject* obj );
 	static std::list< RefObject* > _objs;
+	static SpinLockObject _lock;	//!< 複数スレッドからの生成/破棄に対する排他.
 };
 #endif
 
@@ -0,0 +1,167 @@
+﻿//===========================================================================
+//!
+//!	@file		Scheduler.h
+//!	@brief		ジョブスケジューラー.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "Typedef.h"
+#include "LockFreeQueue.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+
+//---------------------------------------------------------------------------
+//!	@brief		スケジューラーインターフェース.
+//!
+//! @details
+//!		ジョブをどのスレッドで実行するかを決定します.
+//!		Task<T>の継続やコルーチンの再開先として使用されます.
+//---------------------------------------------------------------------------
+class IScheduler
+{
+public:
+	using Job = std::function< void() >;
+
+	IScheduler() = default;
+	virtual ~IScheduler() = default;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ジョブ登録.
+	//-----------------------------------------------------------------------
+	virtual void Schedule( Job&& job ) = 0;
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		スレッドプールスケジューラー.
+//!
+//! @details
+//!		登録されたジョブをワーカースレッドで実行します.
+//!		ジョブキューが満杯の場合はオーバーフローリストへ退避し, キューの後に実行します.
+//---------------------------------------------------------------------------
+class ThreadPoolScheduler final : public IScheduler, private util::NonCopyable< ThreadPoolScheduler >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		u32		threadCount;	//!< ワーカースレッド数(0の場合は論理コア数-1, 最低1).
+		u32		queueCapacity;	//!< ジョブキュー最大数.
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			threadCount		= 0;
+			queueCapacity	= 1024;
+		}
+	};
+
+public:
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//-----------------------------------------------------------------------
+	ThreadPoolScheduler();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		デストラクタ.
+	//-----------------------------------------------------------------------
+	virtual ~ThreadPoolScheduler() override;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		初期化.
+	//-----------------------------------------------------------------------
+	void Initialize( const Desc& desc );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		解放.
+	//!
+	//! @note		キューに残っているジョブは全て実行してから終了します.
+	//-----------------------------------------------------------------------
+	void Finalize();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ジョブ登録.
+	//-----------------------------------------------------------------------
+	virtual void Schedule( Job&& job ) override;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ワーカースレッド数取得.
+	//-----------------------------------------------------------------------
+	u32 GetThreadCount() const;
+
+private:
+	//-----------------------------------------------------------------------
+	//!	@brief		ワーカースレッドメイン.
+	//-----------------------------------------------------------------------
+	void WorkerMain();
+
+	bool					_initialized;
+	Desc					_desc;
+	MPMCQueue< Job >*		_queue;
+	std::thread*			_threads;
+	std::atomic< u32 >		_sleepingCount;
+	std::atomic< bool >		_quit;
+	std::mutex				_mutex;			//!< 待機とオーバーフローリストの保護.
+	std::condition_variable	_condition;
+	std::deque< Job >		_overflow;		//!< キューに入らなかったジョブ.
+	std::atomic< u32 >		_overflowCount;
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		手動実行スケジューラー.
+//!
+//! @details
+//!		登録されたジョブをRunPending()を呼び出したスレッドで実行します.
+//!		メインスレッドで毎フレームRunPending()を呼び出すことで,
+//!		コルーチンをメインスレッドへ戻すことができます.
+//---------------------------------------------------------------------------
+class ManualScheduler final : public IScheduler, private util::NonCopyable< ManualScheduler >
+{
+public:
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//!	@param[in]	capacity	ジョブキュー最大数.
+	//-----------------------------------------------------------------------
+	explicit ManualScheduler( u32 capacity = 1024 );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		デストラクタ.
+	//-----------------------------------------------------------------------
+	virtual ~ManualScheduler() override;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ジョブ登録.
+	//!
+	//! @note		キューが満杯の場合はオーバーフローリストへ退避するため,
+	//!				RunPending()を呼び出すスレッド自身から登録しても待機しません.
+	//-----------------------------------------------------------------------
+	virtual void Schedule( Job&& job ) override;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		登録済みジョブの実行.
+	//!	@param[in]	maxCount	最大実行数.
+	//!	@return		実行したジョブ数.
+	//-----------------------------------------------------------------------
+	u32 RunPending( u32 maxCount = AROMA_UINT32_MAX );
+
+private:
+	MPMCQueue< Job >		_queue;
+	std::mutex				_overflowMutex;
+	std::deque< Job >		_overflow;		//!< キューに入らなかったジョブ.
+	std::atomic< u32 >		_overflowCount;
+};
+
+} // namespace aroma
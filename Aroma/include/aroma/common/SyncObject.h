@@ -10,6 +10,7 @@
 #pragma once
 
 #include <atomic>
+#include "Typedef.h"
 
 namespace aroma
 {
@@ -41,4 +42,60 @@ private:
 	std::atomic_flag	m_obj;
 };
 
+//---------------------------------------------------------------------------
+//! @brief		読み書きスピンロック.
+//!
+//! @details
+//!		Lock()は排他ロック, LockShared()は共有ロックです.
+//!		共有ロックは同時に複数スレッドが取得できます.
+//!		排他ロック待ちのスレッドがある間は新たな共有ロックを待たせるため, 書き込みが飢餓状態になりません.
+//---------------------------------------------------------------------------
+class ReadWriteSpinLockObject : public ISyncObject
+{
+public:
+	ReadWriteSpinLockObject();
+	virtual ~ReadWriteSpinLockObject() override;
+	virtual void Lock() override;
+	virtual void Unlock() override;
+	void LockShared();
+	void UnlockShared();
+
+private:
+	static constexpr u32 kWriterBit = 1u << 31;	//!< 排他ロック(待ちを含む).
+
+	std::atomic< u32 >	m_state;	//!< kWriterBit | 共有ロック数.
+};
+
+//---------------------------------------------------------------------------
+//! @brief		スコープロック.
+//---------------------------------------------------------------------------
+class ScopedLock
+{
+public:
+	explicit ScopedLock( ISyncObject& obj ) : m_obj( obj ) { m_obj.Lock(); }
+	~ScopedLock() { m_obj.Unlock(); }
+
+	ScopedLock( const ScopedLock& ) = delete;
+	ScopedLock& operator=( const ScopedLock& ) = delete;
+
+private:
+	ISyncObject&	m_obj;
+};
+
+//---------------------------------------------------------------------------
+//! @brief		スコープ共有ロック.
+//---------------------------------------------------------------------------
+class ScopedSharedLock
+{
+public:
+	explicit ScopedSharedLock( ReadWriteSpinLockObject& obj ) : m_obj( obj ) { m_obj.LockShared(); }
+	~ScopedSharedLock() { m_obj.UnlockShared(); }
+
+	ScopedSharedLock( const ScopedSharedLock& ) = delete;
+	ScopedSharedLock& operator=( const ScopedSharedLock& ) = delete;
+
+private:
+	ReadWriteSpinLockObject&	m_obj;
+};
+
 } // namespace aroma
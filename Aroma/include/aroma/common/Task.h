@@ -0,0 +1,630 @@
+﻿//===========================================================================
+//!
+//!	@file		Task.h
+//!	@brief		非同期タスク.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <type_traits>
+#include <exception>
+#include <atomic>
+#include <functional>
+#include "Typedef.h"
+#include "Scheduler.h"
+
+//---------------------------------------------------------------------------
+// コルーチン対応判定.
+//---------------------------------------------------------------------------
+#if defined( __cpp_impl_coroutine )
+#include <coroutine>
+#define AROMA_COROUTINE_ENABLE 1
+#elif defined( _RESUMABLE_FUNCTIONS_SUPPORTED )
+#include <experimental/resumable>
+#define AROMA_COROUTINE_ENABLE 1
+#endif
+
+namespace aroma {
+
+template< typename T > class Task;
+template< typename T > class TaskPromise;
+
+namespace detail {
+
+#if defined( __cpp_impl_coroutine )
+namespace coro = std;
+#elif defined( _RESUMABLE_FUNCTIONS_SUPPORTED )
+namespace coro = std::experimental;
+#endif
+
+#ifdef AROMA_COROUTINE_ENABLE
+template< typename T > class CoroutinePromise;
+#endif
+
+// TaskPromiseの定義後に定義.
+template< typename R > struct TaskInvoker;
+
+//---------------------------------------------------------------------------
+//!	@brief		関数の戻り値の型.
+//!
+//! @details	std::result_ofはC++20で削除されたため, 対応する場合はstd::invoke_resultを使用します.
+//---------------------------------------------------------------------------
+#if defined( __cpp_lib_is_invocable )
+template< typename F, typename... Args >
+using InvokeResult = typename std::invoke_result< F, Args... >::type;
+#else
+template< typename F, typename... Args >
+using InvokeResult = typename std::result_of< F( Args... ) >::type;
+#endif
+
+//---------------------------------------------------------------------------
+//!	@brief		タスク結果格納.
+//---------------------------------------------------------------------------
+template< typename T >
+class TaskResult
+{
+public:
+	TaskResult() : _hasValue( false ) {}
+	~TaskResult()
+	{
+		if( _hasValue )
+		{
+			reinterpret_cast< T* >( &_storage )->~T();
+		}
+	}
+
+	void Set( T&& value )
+	{
+		new( &_storage ) T( std::move( value ) );
+		_hasValue = true;
+	}
+	void Set( const T& value )
+	{
+		new( &_storage ) T( value );
+		_hasValue = true;
+	}
+	const T& Get() const { return *reinterpret_cast< const T* >( &_storage ); }
+	T& Get() { return *reinterpret_cast< T* >( &_storage ); }
+
+private:
+	typename std::aligned_storage< sizeof( T ), std::alignment_of< T >::value >::type	_storage;
+	bool	_hasValue;
+};
+
+template<>
+class TaskResult< void >
+{
+public:
+	void Set() {}
+	void Get() const {}
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		タスク共有状態.
+//!
+//! @details
+//!		完了フラグ, 結果(または例外), 継続リストを保持します.
+//!		Task<T>とTaskPromise<T>の間でstd::shared_ptrにより共有されます.
+//---------------------------------------------------------------------------
+template< typename T >
+class TaskState
+{
+public:
+	using Continuation = std::function< void() >;
+
+	TaskState() : _ready( false ) {}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		完了済み判定.
+	//-----------------------------------------------------------------------
+	bool IsReady() const
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		return _ready;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		完了待ち.
+	//-----------------------------------------------------------------------
+	void Wait() const
+	{
+		std::unique_lock< std::mutex > lock( _mutex );
+		_condition.wait( lock, [ this ]{ return _ready; } );
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		継続登録.
+	//!
+	//! @note		完了済みの場合は呼び出し元スレッドで即時実行します.
+	//-----------------------------------------------------------------------
+	void AddContinuation( Continuation&& continuation )
+	{
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			if( !_ready )
+			{
+				_continuations.push_back( std::move( continuation ) );
+				return;
+			}
+		}
+		continuation();
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		結果設定して完了.
+	//-----------------------------------------------------------------------
+	template< typename... Args >
+	void Complete( Args&&... args )
+	{
+		std::vector< Continuation > continuations;
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			if( _ready )
+			{
+				AROMA_ASSERT( false, _T( "Task is already completed.\n" ) );
+				return;
+			}
+			_result.Set( std::forward< Args >( args )... );
+			_ready = true;
+			continuations.swap( _continuations );
+		}
+		RunContinuations( continuations );
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		例外を設定して完了.
+	//-----------------------------------------------------------------------
+	void CompleteWithException( std::exception_ptr exception )
+	{
+		std::vector< Continuation > continuations;
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			if( _ready )
+			{
+				AROMA_ASSERT( false, _T( "Task is already completed.\n" ) );
+				return;
+			}
+			_exception = exception;
+			_ready = true;
+			continuations.swap( _continuations );
+		}
+		RunContinuations( continuations );
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		例外で完了した場合は再送出.
+	//!
+	//! @note		完了後(Wait()後)に呼び出して下さい.
+	//-----------------------------------------------------------------------
+	void RethrowIfFailed() const
+	{
+		if( _exception )
+		{
+			std::rethrow_exception( _exception );
+		}
+	}
+
+	TaskResult< T >&		GetResult()			{ return _result; }
+	const TaskResult< T >&	GetResult() const	{ return _result; }
+
+private:
+	void RunContinuations( std::vector< Continuation >& continuations )
+	{
+		_condition.notify_all();
+
+		// 継続はロック外で実行(継続内で別タスクを待つ場合に備える).
+		for( auto& continuation : continuations )
+		{
+			continuation();
+		}
+	}
+
+	mutable std::mutex					_mutex;
+	mutable std::condition_variable		_condition;
+	bool								_ready;
+	TaskResult< T >						_result;
+	std::exception_ptr					_exception;
+	std::vector< Continuation >			_continuations;
+};
+
+} // namespace detail
+
+//---------------------------------------------------------------------------
+//!	@brief		非同期タスク.
+//!
+//! @details
+//!		非同期処理の結果を表します. 完了時に登録済みの継続を実行します.
+//!		Then()で継続を実行するスケジューラーを指定でき,
+//!		I/O完了をワーカースレッドで受けてメインスレッドで後続処理を行う等の
+//!		スレッドの切り替えを表現できます.
+//!
+//!		タスクの関数(継続, コルーチンを含む)が送出した例外はタスクに格納され,
+//!		Get()で再送出されます. 継続内でGet()を呼び出すと後続のタスクへ伝搬します.
+//!
+//!		コルーチン対応コンパイラ(C++20 または MSVC /await)では
+//!		Task<T>を戻り値とする関数内でco_awaitが使用できます.
+//!
+//! @code
+//!	// 継続による記述.
+//!	RunTask( pool, [ path ]{ return LoadFile( path ); } )
+//!		.Then( mainThread, [ device ]( const Task< Blob >& t ){ return CreateTexture( device, t.Get() ); } );
+//!
+//!	// コルーチンによる記述(AROMA_COROUTINE_ENABLE時).
+//!	Task< Texture2D* > LoadTexture( Device* device, CTStr path )
+//!	{
+//!		Blob blob = co_await RunTask( pool, [ path ]{ return LoadFile( path ); } );
+//!		co_await ScheduleOn( mainThread );
+//!		co_return CreateTexture( device, blob );
+//!	}
+//! @endcode
+//---------------------------------------------------------------------------
+template< typename T >
+class Task
+{
+public:
+#ifdef AROMA_COROUTINE_ENABLE
+	using promise_type = detail::CoroutinePromise< T >;
+#endif
+
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//-----------------------------------------------------------------------
+	Task() {}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		有効判定.
+	//-----------------------------------------------------------------------
+	bool IsValid() const { return _state != nullptr; }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		完了済み判定.
+	//-----------------------------------------------------------------------
+	bool IsReady() const
+	{
+		AROMA_ASSERT( IsValid(), _T( "Invalid task.\n" ) );
+		return _state->IsReady();
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		完了待ち.
+	//-----------------------------------------------------------------------
+	void Wait() const
+	{
+		AROMA_ASSERT( IsValid(), _T( "Invalid task.\n" ) );
+		_state->Wait();
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		結果取得.
+	//!
+	//! @note		未完了の場合は完了まで待機します.
+	//!				例外で完了した場合はその例外を再送出します.
+	//-----------------------------------------------------------------------
+	auto Get() const -> decltype( std::declval< const detail::TaskResult< T >& >().Get() )
+	{
+		Wait();
+		_state->RethrowIfFailed();
+		return _state->GetResult().Get();
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		継続登録.
+	//!
+	//!	@param[in]	scheduler	継続を実行するスケジューラー.
+	//!							nullptrの場合は完了させたスレッドで実行します.
+	//!	@param[in]	func		継続関数. 引数に完了済みのこのタスクを受け取ります.
+	//!	@return		継続関数の戻り値を結果とするタスク.
+	//-----------------------------------------------------------------------
+	template< typename F >
+	auto Then( IScheduler* scheduler, F&& func ) const -> Task< detail::InvokeResult< F, const Task< T >& > >
+	{
+		using Result = detail::InvokeResult< F, const Task< T >& >;
+		AROMA_ASSERT( IsValid(), _T( "Invalid task.\n" ) );
+
+		auto promise = std::make_shared< TaskPromise< Result > >();
+		Task< Result > result = promise->GetTask();
+		Task< T > self = *this;
+		auto body = [ promise, self, func ]() mutable
+		{
+			detail::TaskInvoker< Result >::Run( *promise, func, self );
+		};
+
+		if( scheduler )
+		{
+			_state->AddContinuation( [ scheduler, body ]() mutable { scheduler->Schedule( std::move( body ) ); } );
+		}
+		else
+		{
+			_state->AddContinuation( std::move( body ) );
+		}
+		return result;
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		内部用: 完了時の継続登録.
+	//-----------------------------------------------------------------------
+	void OnCompleted( std::function< void() >&& continuation ) const
+	{
+		AROMA_ASSERT( IsValid(), _T( "Invalid task.\n" ) );
+		_state->AddContinuation( std::move( continuation ) );
+	}
+
+private:
+	friend class TaskPromise< T >;
+
+	explicit Task( const std::shared_ptr< detail::TaskState< T > >& state )
+		: _state( state )
+	{
+	}
+
+	std::shared_ptr< detail::TaskState< T > >	_state;
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		タスクプロミス.
+//!
+//! @details
+//!		タスクを完了させる側のオブジェクトです.
+//!		I/O完了コールバック等からSetValue()を呼び出してタスクを完了させます.
+//---------------------------------------------------------------------------
+template< typename T >
+class TaskPromise
+{
+public:
+	TaskPromise() : _state( std::make_shared< detail::TaskState< T > >() ) {}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		タスク取得.
+	//-----------------------------------------------------------------------
+	Task< T > GetTask() const { return Task< T >( _state ); }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		結果設定して完了.
+	//-----------------------------------------------------------------------
+	void SetValue( T&& value ) { _state->Complete( std::move( value ) ); }
+	void SetValue( const T& value ) { _state->Complete( value ); }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		例外を設定して完了.
+	//-----------------------------------------------------------------------
+	void SetException( std::exception_ptr exception ) { _state->CompleteWithException( exception ); }
+
+private:
+	std::shared_ptr< detail::TaskState< T > >	_state;
+};
+
+template<>
+class TaskPromise< void >
+{
+public:
+	TaskPromise() : _state( std::make_shared< detail::TaskState< void > >() ) {}
+
+	Task< void > GetTask() const { return Task< void >( _state ); }
+	void SetValue() { _state->Complete(); }
+	void SetException( std::exception_ptr exception ) { _state->CompleteWithException( exception ); }
+
+private:
+	std::shared_ptr< detail::TaskState< void > >	_state;
+};
+
+namespace detail {
+
+//---------------------------------------------------------------------------
+//!	@brief		関数を実行して結果(送出された場合は例外)をプロミスへ設定.
+//!
+//! @note		完了時に実行される継続の例外を捕捉しないよう, 関数の呼び出しのみを対象とする.
+//---------------------------------------------------------------------------
+template< typename R >
+struct TaskInvoker
+{
+	template< typename F, typename... Args >
+	static void Run( TaskPromise< R >& promise, F& func, Args&&... args )
+	{
+		TaskResult< R > result;
+		try
+		{
+			result.Set( func( std::forward< Args >( args )... ) );
+		}
+		catch( ... )
+		{
+			promise.SetException( std::current_exception() );
+			return;
+		}
+		promise.SetValue( std::move( result.Get() ) );
+	}
+};
+
+template<>
+struct TaskInvoker< void >
+{
+	template< typename F, typename... Args >
+	static void Run( TaskPromise< void >& promise, F& func, Args&&... args )
+	{
+		try
+		{
+			func( std::forward< Args >( args )... );
+		}
+		catch( ... )
+		{
+			promise.SetException( std::current_exception() );
+			return;
+		}
+		promise.SetValue();
+	}
+};
+
+} // namespace detail
+
+#ifdef AROMA_COROUTINE_ENABLE
+namespace detail {
+
+//---------------------------------------------------------------------------
+//!	@brief		コルーチンプロミス.
+//!
+//! @details
+//!		Task<T>を戻り値とする関数内でco_awaitを使用可能にします.
+//!		コルーチンは即時開始し, 完了時にフレームを自動解放します.
+//!		コルーチン内で捕捉されなかった例外はタスクへ格納します.
+//---------------------------------------------------------------------------
+template< typename T >
+class CoroutinePromiseBase
+{
+public:
+	Task< T > get_return_object() { return _promise.GetTask(); }
+	coro::suspend_never initial_suspend() { return {}; }
+	coro::suspend_never final_suspend() noexcept { return {}; }
+	void unhandled_exception() { _promise.SetException( std::current_exception() ); }
+
+protected:
+	TaskPromise< T >	_promise;
+};
+
+template< typename T >
+class CoroutinePromise : public CoroutinePromiseBase< T >
+{
+public:
+	void return_value( T value ) { this->_promise.SetValue( std::move( value ) ); }
+};
+
+template<>
+class CoroutinePromise< void > : public CoroutinePromiseBase< void >
+{
+public:
+	void return_void() { this->_promise.SetValue(); }
+};
+
+} // namespace detail
+#endif
+
+//---------------------------------------------------------------------------
+//!	@brief		スケジューラー上で関数を実行.
+//!	@return		関数の戻り値を結果とするタスク.
+//---------------------------------------------------------------------------
+template< typename F >
+auto RunTask( IScheduler* scheduler, F&& func ) -> Task< detail::InvokeResult< F > >
+{
+	using Result = detail::InvokeResult< F >;
+	AROMA_ASSERT( scheduler, _T( "scheduler is null.\n" ) );
+
+	auto promise = std::make_shared< TaskPromise< Result > >();
+	Task< Result > result = promise->GetTask();
+	scheduler->Schedule( [ promise, func ]() mutable
+	{
+		detail::TaskInvoker< Result >::Run( *promise, func );
+	} );
+	return result;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		完了済みタスク作成.
+//---------------------------------------------------------------------------
+template< typename T >
+Task< typename std::decay< T >::type > MakeReadyTask( T&& value )
+{
+	TaskPromise< typename std::decay< T >::type > promise;
+	promise.SetValue( std::forward< T >( value ) );
+	return promise.GetTask();
+}
+
+inline Task< void > MakeReadyTask()
+{
+	TaskPromise< void > promise;
+	promise.SetValue();
+	return promise.GetTask();
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		全タスク完了待ちタスク作成.
+//!
+//! @note		戻り値のタスクは最後に完了したタスクの完了スレッドで完了します.
+//!				例外で完了したタスクも完了として数えます(例外は各タスクのGet()で取得します).
+//---------------------------------------------------------------------------
+template< typename T >
+Task< void > WhenAll( u32 count, const Task< T >* tasks )
+{
+	if( count == 0 ) return MakeReadyTask();
+
+	auto promise	= std::make_shared< TaskPromise< void > >();
+	auto remain		= std::make_shared< std::atomic< u32 > >( count );
+	for( u32 i = 0; i < count; ++i )
+	{
+		tasks[ i ].OnCompleted( [ promise, remain ]
+		{
+			if( remain->fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+			{
+				promise->SetValue();
+			}
+		} );
+	}
+	return promise->GetTask();
+}
+
+#ifdef AROMA_COROUTINE_ENABLE
+//---------------------------------------------------------------------------
+//!	@brief		タスクの待機.
+//!
+//! @details
+//!		co_await task; で未完了の場合はコルーチンを中断し,
+//!		タスクを完了させたスレッドで再開します.
+//---------------------------------------------------------------------------
+template< typename T >
+class TaskAwaiter
+{
+public:
+	explicit TaskAwaiter( const Task< T >& task ) : _task( task ) {}
+
+	bool await_ready() const { return _task.IsReady(); }
+	void await_suspend( detail::coro::coroutine_handle<> handle ) const
+	{
+		_task.OnCompleted( [ handle ]() mutable { handle.resume(); } );
+	}
+	auto await_resume() const -> decltype( std::declval< const Task< T >& >().Get() ) { return _task.Get(); }
+
+private:
+	Task< T >	_task;
+};
+
+template< typename T >
+TaskAwaiter< T > operator co_await( const Task< T >& task )
+{
+	return TaskAwaiter< T >( task );
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		スケジューラーへの切り替え.
+//!
+//! @details
+//!		co_await ScheduleOn( scheduler ); で以降の処理を
+//!		指定スケジューラー上で再開します.
+//---------------------------------------------------------------------------
+class ScheduleAwaiter
+{
+public:
+	explicit ScheduleAwaiter( IScheduler* scheduler ) : _scheduler( scheduler ) {}
+
+	bool await_ready() const { return false; }
+	void await_suspend( detail::coro::coroutine_handle<> handle ) const
+	{
+		_scheduler->Schedule( [ handle ]() mutable { handle.resume(); } );
+	}
+	void await_resume() const {}
+
+private:
+	IScheduler*	_scheduler;
+};
+
+inline ScheduleAwaiter ScheduleOn( IScheduler* scheduler )
+{
+	AROMA_ASSERT( scheduler, _T( "scheduler is null.\n" ) );
+	return ScheduleAwaiter( scheduler );
+}
+#endif
+
+} // namespace aroma
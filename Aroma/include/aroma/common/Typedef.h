@@ -10,7 +10,14 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
+#ifdef AROMA_WINDOWS
 #include <tchar.h>
+#else
+#ifndef _T
+#define _T( x ) x
+#endif
+#endif
 #include <climits>
 #include <float.h>
 
@@ -62,25 +69,25 @@ using CTStr		= const char*;
 //!	@name		マクロ定義.
 //---------------------------------------------------------------------------
 //! @
-#define AROMA_SINT8_MAX ( 127i8 )							//!< s8 最大値.
-#define AROMA_SINT8_MIN ( -127i8 - 1 )						//!< s8 最低値.
-#define AROMA_UINT8_MAX ( 0xffui8 )							//!< u8 最大値.
-#define AROMA_UINT8_MIN ( 0ui8 )							//!< u8 最低値.
+#define AROMA_SINT8_MAX ( static_cast< aroma::s8 >( 127 ) )								//!< s8 最大値.
+#define AROMA_SINT8_MIN ( static_cast< aroma::s8 >( -127 - 1 ) )						//!< s8 最低値.
+#define AROMA_UINT8_MAX ( static_cast< aroma::u8 >( 0xff ) )							//!< u8 最大値.
+#define AROMA_UINT8_MIN ( static_cast< aroma::u8 >( 0 ) )								//!< u8 最低値.
 
-#define AROMA_SINT16_MAX ( 32767i16 )						//!< s16 最大値.
-#define AROMA_SINT16_MIN ( -32767i16 - 1 )					//!< s16 最低値.
-#define AROMA_UINT16_MAX ( 0xffffui16 )						//!< u16 最大値.
-#define AROMA_UINT16_MIN ( 0ui16 )							//!< u16 最低値.
+#define AROMA_SINT16_MAX ( static_cast< aroma::s16 >( 32767 ) )							//!< s16 最大値.
+#define AROMA_SINT16_MIN ( static_cast< aroma::s16 >( -32767 - 1 ) )					//!< s16 最低値.
+#define AROMA_UINT16_MAX ( static_cast< aroma::u16 >( 0xffff ) )						//!< u16 最大値.
+#define AROMA_UINT16_MIN ( static_cast< aroma::u16 >( 0 ) )								//!< u16 最低値.
 
-#define AROMA_SINT32_MAX ( 2147483647i32 )					//!< s32 最大値.
-#define AROMA_SINT32_MIN ( -2147483647i32 - 1 )				//!< s32 最低値.
-#define AROMA_UINT32_MAX ( 0xffffffffui32 )					//!< u32 最大値.
-#define AROMA_UINT32_MIN ( 0ui32 )							//!< u32 最低値.
+#define AROMA_SINT32_MAX ( static_cast< aroma::s32 >( 2147483647 ) )					//!< s32 最大値.
+#define AROMA_SINT32_MIN ( static_cast< aroma::s32 >( -2147483647 - 1 ) )				//!< s32 最低値.
+#define AROMA_UINT32_MAX ( static_cast< aroma::u32 >( 0xffffffffu ) )					//!< u32 最大値.
+#define AROMA_UINT32_MIN ( static_cast< aroma::u32 >( 0 ) )								//!< u32 最低値.
 
-#define AROMA_SINT64_MAX ( 9223372036854775807i64 )			//!< s32 最大値.
-#define AROMA_SINT64_MIN ( -9223372036854775807i64 - 1 )	//!< s32 最低値.
-#define AROMA_UINT64_MAX ( 0xffffffffffffffffui64 )			//!< u32 最大値.
-#define AROMA_UINT64_MIN ( 0ui64 )							//!< u32 最低値.
+#define AROMA_SINT64_MAX ( static_cast< aroma::s64 >( 9223372036854775807ll ) )			//!< s32 最大値.
+#define AROMA_SINT64_MIN ( static_cast< aroma::s64 >( -9223372036854775807ll - 1 ) )	//!< s32 最低値.
+#define AROMA_UINT64_MAX ( static_cast< aroma::u64 >( 0xffffffffffffffffull ) )			//!< u32 最大値.
+#define AROMA_UINT64_MIN ( static_cast< aroma::u64 >( 0 ) )								//!< u32 最低値.
 
 #define	AROMA_FLT32_MAX	( 3.402823466e+38F )				//!< f32 最大値.
 #define	AROMA_FLT32_MIN	( 1.175494351e-38F )				//!< f32 最低値.
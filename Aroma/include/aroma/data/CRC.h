@@ -12,6 +12,25 @@
 namespace aroma {
 namespace data {
 
+//! CRC32継続計算の初期値.
+constexpr u32 kCRCInitial = 0xffffffff;
+
+//! CRC32速度計測のバッファサイズ(64B, 4KB, 1MB, 64MB).
+constexpr size_t kCRCBenchmarkSizes[] = { 64, 4 * 1024, 1024 * 1024, 64 * 1024 * 1024 };
+constexpr u32 kCRCBenchmarkSizeCount = static_cast< u32 >( sizeof( kCRCBenchmarkSizes ) / sizeof( kCRCBenchmarkSizes[ 0 ] ) );
+
+//---------------------------------------------------------------------------
+//!	@brief		CRC32速度計測結果.
+//---------------------------------------------------------------------------
+struct CRCBenchmarkResult
+{
+	u64		bytes;				//!< バッファサイズ.
+	u32		iterations;			//!< 計算回数.
+	f64		byteWiseMBps;		//!< GetCRC()の速度(MB/s).
+	f64		bulkMBps;			//!< GetCRCBulk()の速度(MB/s).
+	bool	succeeded;			//!< GetCRC()とGetCRCBulk()の結果が一致したか.
+};
+
 //---------------------------------------------------------------------------
 //! @brief		CRC取得モジュール.
 //---------------------------------------------------------------------------
@@ -23,6 +42,35 @@ public:
 	//-----------------------------------------------------------------------
 	static inline u32 GetCRC(const void* pbuf,u32 bytes );
 
+	//-----------------------------------------------------------------------
+	//! @brief	大容量バッファ用CRC32取得.
+	//!
+	//! @details	GetCRC()と同じ値を返します.
+	//!			PCLMULQDQ対応CPUではキャリーレス乗算による畳み込み,
+	//!			非対応CPUではslicing-by-16で計算します.
+	//!			数KB以上のアセットデータの検証に使用して下さい.
+	//-----------------------------------------------------------------------
+	static u32 GetCRCBulk( const void* pbuf, size_t bytes );
+
+	//-----------------------------------------------------------------------
+	//! @brief	大容量バッファ用CRC32継続計算.
+	//!	@param[in]	crc		前回の戻り値(初回はkCRCInitial).
+	//!
+	//! @details	分割読み込みしたデータを順に渡すことで,
+	//!			全体に対するGetCRCBulk()と同じ値が得られます.
+	//-----------------------------------------------------------------------
+	static u32 UpdateCRCBulk( u32 crc, const void* pbuf, size_t bytes );
+
+	//-----------------------------------------------------------------------
+	//! @brief	CRC32速度計測.
+	//!	@param[in]	bytesPerSize	サイズ毎に計算する合計バイト数の目安(各サイズ最低1回).
+	//!	@param[out]	results			kCRCBenchmarkSizes毎の結果(kCRCBenchmarkSizeCount個).
+	//!
+	//! @details	kCRCBenchmarkSizesの各サイズでGetCRC()とGetCRCBulk()の速度を求めます.
+	//!			ロード時のアセット検証が読み込みに対して十分速いかの確認に使用します.
+	//-----------------------------------------------------------------------
+	static bool Benchmark( u64 bytesPerSize, CRCBenchmarkResult* results );
+
 private:
 	static const u32 _CRCtable[ 256 ];
 	static const u32 _CRC32Ctable[ 256 ];
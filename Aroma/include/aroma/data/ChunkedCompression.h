@@ -0,0 +1,119 @@
+﻿//===========================================================================
+//!
+//!	@file		ChunkedCompression.h
+//!	@brief		チャンク分割圧縮.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <vector>
+#include "DataDef.h"
+#include "../common/Scheduler.h"
+#include "../common/Task.h"
+
+namespace aroma {
+namespace data {
+
+//---------------------------------------------------------------------------
+//!	@name	定数.
+//---------------------------------------------------------------------------
+//! @{
+
+//! チャンク分割圧縮データ識別子.
+constexpr u32		kChunkedCompressionMagic	= FourCC< 'L', 'Z', 'C', 'K' >::value;
+
+//! 既定のチャンクサイズ(展開の並列単位).
+constexpr u32		kCompressedChunkSize		= 256 * 1024;
+
+//! @}
+
+//---------------------------------------------------------------------------
+//!	@brief		チャンク分割圧縮データヘッダー.
+//!
+//! @details
+//!		データ構成(リトルエンディアン) :
+//!			ChunkedCompressionHeader
+//!			u64[ chunkCount + 1 ]			: 各チャンクの開始オフセット(データ先頭から. 最後は終端).
+//!			チャンクデータ					: LZ4ブロック. 圧縮後のサイズが元と同じチャンクは無圧縮.
+//!
+//!		チャンク毎に独立して圧縮するため, 任意のチャンクを並列に展開できます.
+//---------------------------------------------------------------------------
+struct ChunkedCompressionHeader
+{
+	u32		magic;			//!< kChunkedCompressionMagic.
+	u32		chunkSize;		//!< 展開後のチャンクサイズ(最後のチャンク以外).
+	u32		chunkCount;		//!< チャンク数.
+	u32		reserved;		//!< 予約(0).
+	u64		originalSize;	//!< 展開後のサイズ.
+};
+
+static_assert( sizeof( ChunkedCompressionHeader ) == 24, "ChunkedCompressionHeader layout changed." );
+
+//---------------------------------------------------------------------------
+//!	@brief		展開速度計測結果.
+//---------------------------------------------------------------------------
+struct ChunkedDecodeBenchmarkResult
+{
+	u64		originalBytes;		//!< 展開後のサイズ.
+	u64		compressedBytes;	//!< 圧縮後のサイズ(ヘッダーを含む).
+	f64		singleThreadMBps;	//!< 呼び出しスレッドのみで展開した場合の速度(MB/s).
+	f64		multiThreadMBps;	//!< スケジューラーで並列に展開した場合の速度(MB/s).
+	bool	succeeded;			//!< 全ての展開結果が元データと一致したか.
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		チャンク分割圧縮.
+//!
+//! @param[in]	src			圧縮するデータ.
+//! @param[in]	srcBytes	圧縮するデータサイズ.
+//! @param[out]	out			圧縮データ格納先(上書きされます).
+//! @param[in]	chunkSize	チャンクサイズ.
+//---------------------------------------------------------------------------
+void CompressChunked( const void* src, size_t srcBytes, std::vector< u8 >* out, u32 chunkSize = kCompressedChunkSize );
+
+//---------------------------------------------------------------------------
+//!	@brief		チャンク分割圧縮データの展開後のサイズ取得.
+//!
+//! @return		展開後のサイズ(フォーマット不正の場合は0).
+//---------------------------------------------------------------------------
+u64 GetChunkedOriginalSize( const void* payload, size_t payloadBytes );
+
+//---------------------------------------------------------------------------
+//!	@brief		チャンク分割圧縮データを並列に展開.
+//!
+//! @details
+//!		各チャンクをスケジューラーのワーカースレッドで展開先へ直接展開し,
+//!		全てのチャンクが完了した時点で一度だけタスクを完了させます.
+//!		中間バッファは使用しないため, ファイルのマップから直接GPUアップロード用バッファ等へ展開できます.
+//!
+//! @param[in]	payload			圧縮データ.
+//! @param[in]	payloadBytes	圧縮データサイズ.
+//! @param[out]	dest			展開先.
+//! @param[in]	destBytes		展開先サイズ(展開後のサイズと一致する必要があります).
+//! @param[in]	scheduler		展開を実行するスケジューラー(nullptrの場合は呼び出しスレッドで順に展開).
+//!
+//! @return		全チャンクの展開に成功した場合にtrueで完了するタスク.
+//!
+//! @note		圧縮データと展開先はタスクの完了まで解放しないで下さい.
+//---------------------------------------------------------------------------
+Task< bool > DecompressChunkedAsync( const void* payload, size_t payloadBytes, void* dest, size_t destBytes, IScheduler* scheduler );
+
+//---------------------------------------------------------------------------
+//!	@brief		チャンク分割圧縮データを展開(完了まで待機).
+//---------------------------------------------------------------------------
+bool DecompressChunked( const void* payload, size_t payloadBytes, void* dest, size_t destBytes, IScheduler* scheduler = nullptr );
+
+//---------------------------------------------------------------------------
+//!	@brief		チャンク分割圧縮データの展開速度計測.
+//!
+//! @details
+//!		srcを圧縮した後, 1スレッドとスケジューラーによる並列でそれぞれiterations回展開して速度を求めます.
+//!		アセットの圧縮を有効にするか(ストレージ帯域と展開速度のどちらが律速か)の判断に使用します.
+//---------------------------------------------------------------------------
+bool BenchmarkChunkedDecode( const void* src, size_t srcBytes, IScheduler* scheduler, u32 iterations, ChunkedDecodeBenchmarkResult* result );
+
+} // namespace data
+} // namespace aroma
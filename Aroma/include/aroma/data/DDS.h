@@ -68,6 +68,10 @@ enum DDSHeaderFlag
 //---------------------------------------------------------------------------
 enum DDSPixelFormatFlag
 {
+	//! DDPF_ALPHAPIXELS
+	//! dwABitMaskに有効なアルファチャンネルのマスクが格納される.
+	kDDSPixelFormatFlagAlphaPixels	= 0x00000001U,
+
 	//! DDPF_FOURCC
 	//! 圧縮フォーマットを示す4文字コードを持つ.
 	kDDSPixelFormatFlagFourCC		= 0x00000004U,
@@ -167,6 +171,8 @@ enum DDSCap2Flag
 //---------------------------------------------------------------------------
 enum class DDSDXGIFormat : u32
 {
+	kUnknown				= 0,
+
 	kR8G8B8					= 20,
 	kA8R8G8B8				= 21,
 	kX8R8G8B8				= 22,
@@ -337,12 +343,17 @@ public:
 	//-----------------------------------------------------------------------
 	//! @brief		DDSデータ設定コンストラクタ.
 	//-----------------------------------------------------------------------
-	explicit DDSAccessor( void* ddsData );
+	explicit DDSAccessor( const void* ddsData, size_t dataSize = 0 );
 
 	//-----------------------------------------------------------------------
 	//! @brief		DDSデータ設定.
+	//!
+	//! @param[in]	ddsData		DDSファイルの内容(file::MappedFileのマップ先等).
+	//! @param[in]	dataSize	DDSデータサイズ. 0以外の場合はデータが範囲内に収まるか検証します.
+	//!
+	//! @note		データはコピーせず参照のみ保持します.
 	//-----------------------------------------------------------------------
-	bool Set( void* ddsData );
+	bool Set( const void* ddsData, size_t dataSize = 0 );
 
 	//-----------------------------------------------------------------------
 	//! @brief		設定済みDDSデータ正規判定.
@@ -382,11 +393,30 @@ public:
 	//-----------------------------------------------------------------------
 	const void* GetImageTop() const;
 
+	//-----------------------------------------------------------------------
+	//!	@brief		DDSデータサイズ取得.
+	//!
+	//! @return		設定時に指定したサイズ(未指定の場合は0).
+	//-----------------------------------------------------------------------
+	size_t GetDataSize() const;
+
 	//-----------------------------------------------------------------------
 	//!	@brief		ピクセルフォーマット取得.
 	//-----------------------------------------------------------------------
 	PixelFormat GetPixelFormat() const;
 
+	//-----------------------------------------------------------------------
+	//!	@brief		旧形式(DX10拡張なし)のフォーマット取得.
+	//!
+	//! @details
+	//!		ピクセルフォーマットのビットマスク(またはFourCCに格納された数値)から
+	//!		D3DFORMAT相当の値を判定します. GPUが直接扱えないフォーマットは
+	//!		GetPixelFormat()がPixelFormat::kUnknownを返すため, ConvertLegacyDDS()で変換して下さい.
+	//!
+	//! @return		フォーマット(DX10拡張ありまたは判定できない場合はDDSDXGIFormat::kUnknown).
+	//-----------------------------------------------------------------------
+	DDSDXGIFormat GetLegacyFormat() const;
+
 	//-----------------------------------------------------------------------
 	//!	@brief		ミップマップ数取得.
 	//-----------------------------------------------------------------------
@@ -411,10 +441,20 @@ public:
 
 private:
 	const void*				_ddsData;
+	size_t					_ddsDataSize;
 	const DDSHeader*		_ddsHeader;
 	const DDSHeaderDX10*	_ddsHeaderDX10;
 };
 
+//---------------------------------------------------------------------------
+//!	@brief		DX10拡張ヘッダー付きの2DテクスチャのDDSヘッダー書き込み.
+//!
+//! @details
+//!		destにsizeof( DDSHeader ) + sizeof( DDSHeaderDX10 )バイトを書き込みます.
+//!		イメージデータは続けて配列, ミップの順に格納して下さい.
+//---------------------------------------------------------------------------
+void WriteDDSHeaderDX10( void* dest, u32 width, u32 height, u32 mipCount, u32 arrayCount, PixelFormat format );
+
 AROMA_STATIC_ASSERT(sizeof(DDSHeader) == kDDSHeaderSize + 4, _T( "DDSHeader size mismatch.\n" ) );
 AROMA_STATIC_ASSERT(sizeof(DDSHeaderDX10) == kDDSHeaderDX10Size, _T( "DDSHeaderDXT10 size mismatch.\n") );
 AROMA_STATIC_ASSERT(sizeof(DDSPixelFormat) == kDDSPixelFormatSize, _T( "DDSPixelFormat size mismatch.\n") );
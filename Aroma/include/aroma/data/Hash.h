@@ -0,0 +1,125 @@
+﻿//===========================================================================
+//!
+//!	@file		Hash.h
+//!	@brief		文字列ハッシュ.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+namespace aroma {
+namespace data {
+
+//---------------------------------------------------------------------------
+//! @brief		FNV-1a定数.
+//---------------------------------------------------------------------------
+//! @{
+constexpr u32 kFNV32Offset	= 2166136261u;
+constexpr u32 kFNV32Prime	= 16777619u;
+constexpr u64 kFNV64Offset	= 14695981039346656037ull;
+constexpr u64 kFNV64Prime	= 1099511628211ull;
+//! @}
+
+namespace detail {
+
+//---------------------------------------------------------------------------
+//	FNV-1a 1文字分.
+//	文字コードの下位バイトから順に, 0以外の上位バイトが無くなるまで処理する.
+//	ASCII文字列はchar/wchar_tのどちらでも同じ値となる.
+//---------------------------------------------------------------------------
+constexpr u32 FNV1a32Char( u32 hash, u32 c )
+{
+	return ( c >> 8 ) ? FNV1a32Char( ( hash ^ ( c & 0xff ) ) * kFNV32Prime, c >> 8 ) : ( hash ^ c ) * kFNV32Prime;
+}
+constexpr u64 FNV1a64Char( u64 hash, u32 c )
+{
+	return ( c >> 8 ) ? FNV1a64Char( ( hash ^ ( c & 0xff ) ) * kFNV64Prime, c >> 8 ) : ( hash ^ c ) * kFNV64Prime;
+}
+
+//---------------------------------------------------------------------------
+//	CRC32 1バイト分(テーブル無し).
+//---------------------------------------------------------------------------
+constexpr u32 CRC32Bit( u32 crc, u32 bit )
+{
+	return bit == 0 ? crc : CRC32Bit( ( crc >> 1 ) ^ ( ( crc & 1 ) ? 0xedb88320u : 0 ), bit - 1 );
+}
+constexpr u32 CRC32Char( u32 crc, u32 c )
+{
+	return ( c >> 8 ) ? CRC32Char( CRC32Bit( crc ^ ( c & 0xff ), 8 ), c >> 8 ) : CRC32Bit( crc ^ c, 8 );
+}
+
+//---------------------------------------------------------------------------
+//	文字コードを符号無しに変換.
+//---------------------------------------------------------------------------
+constexpr u32 CharCode( char c )		{ return static_cast< u8 >( c ); }
+constexpr u32 CharCode( wchar_t c )		{ return static_cast< u32 >( c ); }
+
+} // namespace detail
+
+//---------------------------------------------------------------------------
+//!	@brief		FNV-1a 32bitハッシュ(終端文字列).
+//!
+//! @details	constexprのため文字列リテラルはコンパイル時に計算されます.
+//!				実行時の長い文字列には範囲指定版を使用して下さい.
+//---------------------------------------------------------------------------
+template< typename C >
+constexpr u32 HashFNV1a32( const C* str, u32 hash = kFNV32Offset )
+{
+	return *str ? HashFNV1a32( str + 1, detail::FNV1a32Char( hash, detail::CharCode( *str ) ) ) : hash;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		FNV-1a 64bitハッシュ(終端文字列).
+//---------------------------------------------------------------------------
+template< typename C >
+constexpr u64 HashFNV1a64( const C* str, u64 hash = kFNV64Offset )
+{
+	return *str ? HashFNV1a64( str + 1, detail::FNV1a64Char( hash, detail::CharCode( *str ) ) ) : hash;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		CRC32ハッシュ(終端文字列).
+//!
+//! @details	char文字列ではCRC::GetCRC()と同じ値を返します.
+//!				コンパイル時計算用のため, 実行時はCRC::GetCRC()を使用して下さい.
+//---------------------------------------------------------------------------
+template< typename C >
+constexpr u32 HashCRC32( const C* str, u32 crc = 0xffffffffu )
+{
+	return *str ? HashCRC32( str + 1, detail::CRC32Char( crc, detail::CharCode( *str ) ) ) : crc;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		FNV-1a 32bitハッシュ(範囲指定).
+//!	@param[in]	begin	先頭文字.
+//!	@param[in]	end		終端(含まない).
+//---------------------------------------------------------------------------
+template< typename C >
+inline u32 HashFNV1a32( const C* begin, const C* end, u32 hash = kFNV32Offset )
+{
+	for( const C* p = begin; p != end; ++p )
+	{
+		hash = detail::FNV1a32Char( hash, detail::CharCode( *p ) );
+	}
+	return hash;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		FNV-1a 64bitハッシュ(範囲指定).
+//!	@param[in]	begin	先頭文字.
+//!	@param[in]	end		終端(含まない).
+//---------------------------------------------------------------------------
+template< typename C >
+inline u64 HashFNV1a64( const C* begin, const C* end, u64 hash = kFNV64Offset )
+{
+	for( const C* p = begin; p != end; ++p )
+	{
+		hash = detail::FNV1a64Char( hash, detail::CharCode( *p ) );
+	}
+	return hash;
+}
+
+} // namespace data
+} // namespace aroma
@@ -0,0 +1,58 @@
+﻿//===========================================================================
+//!
+//!	@file		LZ4.h
+//!	@brief		LZ4ブロック圧縮.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+namespace aroma {
+namespace data {
+
+//---------------------------------------------------------------------------
+//! @brief		LZ4ブロック圧縮モジュール.
+//!
+//! @details
+//!		LZ4のブロックフォーマット(フレームヘッダー無し)で圧縮, 展開します.
+//!		展開はCPU負荷が小さく, ディスクの読み込み量を減らす用途に向きます.
+//!		展開は入力を全て検証するため, 破損したデータでも範囲外へアクセスしません.
+//---------------------------------------------------------------------------
+class LZ4
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief	圧縮後の最大サイズ取得.
+	//-----------------------------------------------------------------------
+	static size_t GetCompressBound( size_t srcBytes );
+
+	//-----------------------------------------------------------------------
+	//! @brief	圧縮.
+	//!
+	//!	@param[in]	src				圧縮するデータ.
+	//!	@param[in]	srcBytes		圧縮するデータサイズ.
+	//!	@param[out]	dst				圧縮データ格納先.
+	//!	@param[in]	dstCapacity		圧縮データ格納先サイズ(GetCompressBound()以上で必ず成功).
+	//!
+	//!	@return		圧縮後のサイズ(格納先が不足した場合は0).
+	//-----------------------------------------------------------------------
+	static size_t Compress( const void* src, size_t srcBytes, void* dst, size_t dstCapacity );
+
+	//-----------------------------------------------------------------------
+	//! @brief	展開.
+	//!
+	//!	@param[in]	src				圧縮データ.
+	//!	@param[in]	srcBytes		圧縮データサイズ.
+	//!	@param[out]	dst				展開先.
+	//!	@param[in]	dstBytes		展開後のサイズ(圧縮前のサイズと一致する必要があります).
+	//!
+	//!	@retval		true	: 展開成功.
+	//!	@retval		false	: 展開失敗(データ破損).
+	//-----------------------------------------------------------------------
+	static bool Decompress( const void* src, size_t srcBytes, void* dst, size_t dstBytes );
+};
+
+} // namespace data
+} // namespace aroma
@@ -0,0 +1,104 @@
+﻿//===========================================================================
+//!
+//!	@file		MipGenerator.h
+//!	@brief		ミップマップ生成.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <vector>
+#include "DataDef.h"
+#include "DDS.h"
+#include "../common/Scheduler.h"
+
+namespace aroma {
+namespace data {
+
+//---------------------------------------------------------------------------
+//!	@brief		ミップマップ生成フィルター.
+//---------------------------------------------------------------------------
+enum class MipFilter : u32
+{
+	kBox,			//!< ボックス(縮小範囲の面積平均). 最も高速.
+	kKaiser,		//!< カイザー窓付きsinc(半径3). ぼけとリンギングのバランスが良い.
+	kLanczos,		//!< Lanczos3. 最もシャープだがリンギングが出やすい.
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		ミップマップ生成設定.
+//---------------------------------------------------------------------------
+struct MipGenerateDesc
+{
+	MipFilter		filter;					//!< フィルター.
+	bool			srgb;					//!< Unorm形式もsRGBとして線形空間でフィルターする(Srgb形式は常に線形空間).
+	bool			wrap;					//!< 端をラップする(falseの場合はクランプ). タイリングするテクスチャに指定します.
+	bool			preserveAlphaCoverage;	//!< アルファテストで残るテクセルの割合を最上位ミップと揃える.
+	f32				alphaReference;			//!< アルファテストの閾値(preserveAlphaCoverage時).
+	u32				maxMipCount;			//!< 生成する最大ミップ数(最上位を含む. 0の場合は1x1まで).
+	IScheduler*		scheduler;				//!< 生成を実行するスケジューラー(nullptrの場合は呼び出しスレッドのみ).
+
+	//-----------------------------------------------------------------------
+	MipGenerateDesc(){ Default(); }
+	void Default()
+	{
+		filter					= MipFilter::kKaiser;
+		srgb					= false;
+		wrap					= false;
+		preserveAlphaCoverage	= false;
+		alphaReference			= 0.5f;
+		maxMipCount				= 0;
+		scheduler				= nullptr;
+	}
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		1x1までのミップ数取得.
+//---------------------------------------------------------------------------
+u32 GetFullMipCount( u32 width, u32 height );
+
+//---------------------------------------------------------------------------
+//!	@brief		ミップマップ生成に対応したピクセルフォーマットか判定.
+//!
+//! @details
+//!		R8G8B8A8, B8G8R8A8, B8G8R8X8(それぞれSrgbを含む), R8, R8G8, A8 に対応します.
+//---------------------------------------------------------------------------
+bool IsMipGenerationSupported( PixelFormat format );
+
+//---------------------------------------------------------------------------
+//!	@brief		ミップマップ生成.
+//!
+//! @details
+//!		各ミップは1つ上のミップから分離可能フィルターで生成します.
+//!		色はアルファで重み付けしてフィルターするため, 透明なテクセルの色が滲みません.
+//!		各ミップの出力行を帯に分け, 呼び出しスレッドとスケジューラーのワーカースレッドで並列に生成します.
+//!
+//! @param[in]	src			最上位ミップのイメージ.
+//! @param[in]	srcPitch	最上位ミップの1行のバイト数.
+//! @param[in]	width		最上位ミップの幅.
+//! @param[in]	height		最上位ミップの高さ.
+//! @param[in]	format		ピクセルフォーマット.
+//! @param[out]	outImage	最上位を含む全ミップの格納先(上書きされます). 各ミップはCalcSurfaceInfo()のサイズで連続します.
+//! @param[out]	outMipCount	生成したミップ数(最上位を含む).
+//! @param[in]	desc		設定.
+//---------------------------------------------------------------------------
+bool GenerateMips( const void* src, size_t srcPitch, u32 width, u32 height, PixelFormat format, std::vector< u8 >* outImage, u32* outMipCount, const MipGenerateDesc& desc = MipGenerateDesc() );
+
+//---------------------------------------------------------------------------
+//!	@brief		DDSのミップマップ生成.
+//!
+//! @details
+//!		各配列要素の最上位ミップから全ミップを生成し, DX10拡張ヘッダーを持つDDSとして出力します.
+//!		既存のミップは使用しません. GPUが直接扱えない旧形式のDDSはConvertLegacyDDS()で変換してから生成します.
+//!		変換後のデータはDDSAccessorを通してDevice::CreateTexture2DFromDDS()等へそのまま渡せます.
+//!
+//! @param[in]	dds			DDS.
+//! @param[out]	outDDS		生成したDDSデータ格納先(上書きされます).
+//! @param[in]	desc		設定.
+//---------------------------------------------------------------------------
+bool GenerateDDSMips( const DDSAccessor& dds, std::vector< u8 >* outDDS, const MipGenerateDesc& desc = MipGenerateDesc() );
+
+} // namespace data
+} // namespace aroma
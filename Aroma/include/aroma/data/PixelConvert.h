@@ -0,0 +1,99 @@
+﻿//===========================================================================
+//!
+//!	@file		PixelConvert.h
+//!	@brief		ピクセルフォーマット変換.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <vector>
+#include "DataDef.h"
+#include "DDS.h"
+#include "../common/Scheduler.h"
+
+namespace aroma {
+namespace data {
+
+//---------------------------------------------------------------------------
+//!	@name	定数.
+//---------------------------------------------------------------------------
+//! @{
+
+//! 変換後のピクセルフォーマット.
+constexpr PixelFormat	kLegacyConvertFormat	= PixelFormat::kR8G8B8A8Unorm;
+
+//! 並列変換の1ジョブあたりの変換後のバイト数の目安.
+constexpr size_t		kPixelConvertBandBytes	= 64 * 1024;
+
+//! @}
+
+//---------------------------------------------------------------------------
+//!	@brief		R8G8B8A8へ変換可能なDDSフォーマットか判定.
+//!
+//! @details
+//!		R8G8B8, A8R8G8B8, X8R8G8B8, A8B8G8R8, X8B8G8R8,
+//!		R5G6B5, A1R5G5B5, X1R5G5B5, A4R4G4B4, X4R4G4B4, L8, A8L8, A8 に対応します.
+//---------------------------------------------------------------------------
+bool IsConvertibleToRGBA8( DDSDXGIFormat format );
+
+//---------------------------------------------------------------------------
+//!	@brief		DDSフォーマットの1ピクセルのバイト数取得.
+//!
+//! @return		バイト数(変換に対応していないフォーマットは0).
+//---------------------------------------------------------------------------
+u32 GetLegacyBytesPerPixel( DDSDXGIFormat format );
+
+//---------------------------------------------------------------------------
+//!	@brief		1行をR8G8B8A8へ変換.
+//!
+//! @details
+//!		CPUが対応している場合はSSE2, SSSE3, AVX2で変換します.
+//!
+//! @param[in]	format		変換元のフォーマット.
+//! @param[in]	src			変換元.
+//! @param[out]	dst			変換先(pixelCount * 4バイト).
+//! @param[in]	pixelCount	ピクセル数.
+//---------------------------------------------------------------------------
+void ConvertRowToRGBA8( DDSDXGIFormat format, const void* src, void* dst, u32 pixelCount );
+
+//---------------------------------------------------------------------------
+//!	@brief		イメージをR8G8B8A8へ変換.
+//!
+//! @details
+//!		行をkPixelConvertBandBytes程度の帯に分け, 呼び出しスレッドとスケジューラーの
+//!		ワーカースレッドで並列に変換します. 全ての行の変換が完了するまで待機します.
+//!
+//! @param[in]	format		変換元のフォーマット.
+//! @param[in]	src			変換元.
+//! @param[in]	srcPitch	変換元の1行のバイト数.
+//! @param[out]	dst			変換先.
+//! @param[in]	dstPitch	変換先の1行のバイト数(width * 4以上).
+//! @param[in]	width		幅.
+//! @param[in]	height		高さ.
+//! @param[in]	scheduler	変換を実行するスケジューラー(nullptrの場合は呼び出しスレッドのみで変換).
+//---------------------------------------------------------------------------
+void ConvertImageToRGBA8( DDSDXGIFormat format, const void* src, size_t srcPitch, void* dst, size_t dstPitch, u32 width, u32 height, IScheduler* scheduler = nullptr );
+
+//---------------------------------------------------------------------------
+//!	@brief		非FourCCのDDSをR8G8B8A8のDDSへ変換.
+//!
+//! @details
+//!		GPUが直接扱えない(またはBGRA等で扱いにくい)旧形式のDDSを, DX10拡張ヘッダーを持つ
+//!		kLegacyConvertFormatのDDSへ変換します. 全てのミップマップを変換するため,
+//!		変換後のデータはDDSAccessorを通してDevice::CreateTexture2DFromDDS()や
+//!		render::TextureStreamerへそのまま渡せます.
+//!
+//! @param[in]	dds			変換元のDDS.
+//! @param[out]	outDDS		変換後のDDSデータ格納先(上書きされます).
+//! @param[in]	scheduler	変換を実行するスケジューラー(nullptrの場合は呼び出しスレッドのみで変換).
+//!
+//! @retval	true	成功.
+//! @retval	false	変換に対応していないフォーマット, またはデータ不正.
+//---------------------------------------------------------------------------
+bool ConvertLegacyDDS( const DDSAccessor& dds, std::vector< u8 >* outDDS, IScheduler* scheduler = nullptr );
+
+} // namespace data
+} // namespace aroma
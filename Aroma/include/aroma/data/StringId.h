@@ -0,0 +1,159 @@
+﻿//===========================================================================
+//!
+//!	@file		StringId.h
+//!	@brief		文字列ID.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <functional>
+#include "Hash.h"
+
+namespace aroma {
+namespace data {
+
+//---------------------------------------------------------------------------
+//! @brief		文字列ID.
+//!
+//! @details
+//!		文字列をFNV-1a 32bitハッシュ値で識別します.
+//!		文字列リテラルからの生成(_sidリテラル)はコンパイル時に計算されるため,
+//!		セマンティック名, シェーダーパラメーター名, アセット名等の比較を
+//!		strcmpではなく整数比較で行うことができます.
+//!		文字配列等の実行時文字列からはFromString()で生成して下さい.
+//!
+//!		デバッグビルドでは元の文字列をGetDebugName()で逆引きできます.
+//!		実行時生成(FromString)した文字列と, GetDebugName()を呼び出したリテラルは
+//!		逆引きテーブルへ複製して登録され, 異なる文字列で同じハッシュ値になった場合はアサートします.
+//!
+//! @code
+//!	constexpr StringId kPosition = "POSITION"_sid;
+//!	if( StringId::FromString( elm.semanticName ) == kPosition ) { ... }
+//! @endcode
+//---------------------------------------------------------------------------
+class StringId
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		コンストラクタ(無効値).
+	//-----------------------------------------------------------------------
+	constexpr StringId()
+		: _value( 0 )
+#ifdef AROMA_DEBUG
+		, _debugName( nullptr )
+#endif
+	{
+	}
+
+	//-----------------------------------------------------------------------
+	//! @brief		実行時文字列から生成.
+	//-----------------------------------------------------------------------
+	static StringId FromString( const char* str );
+	static StringId FromString( const wchar_t* str );
+
+	//-----------------------------------------------------------------------
+	//! @brief		ハッシュ値から生成.
+	//-----------------------------------------------------------------------
+	static constexpr StringId FromValue( u32 value )
+	{
+		return StringId( ValueTag(), value );
+	}
+
+	//-----------------------------------------------------------------------
+	//! @brief		ハッシュ値取得.
+	//-----------------------------------------------------------------------
+	constexpr u32 GetValue() const { return _value; }
+
+	//-----------------------------------------------------------------------
+	//! @brief		有効判定.
+	//-----------------------------------------------------------------------
+	constexpr bool IsValid() const { return _value != 0; }
+
+	//-----------------------------------------------------------------------
+	//! @brief		元の文字列取得(デバッグ用).
+	//!
+	//! @return		逆引きできない場合やリリースビルドでは空文字列.
+	//-----------------------------------------------------------------------
+	const char* GetDebugName() const;
+
+	constexpr bool operator==( const StringId& rhs ) const { return _value == rhs._value; }
+	constexpr bool operator!=( const StringId& rhs ) const { return _value != rhs._value; }
+	constexpr bool operator< ( const StringId& rhs ) const { return _value <  rhs._value; }
+
+private:
+	struct ValueTag {};
+	struct LiteralTag {};
+
+	friend constexpr StringId operator"" _sid( const char* str, size_t length );
+	friend constexpr StringId operator"" _sid( const wchar_t* str, size_t length );
+
+	// 文字列リテラル(静的記憶域のため参照を保持できる).
+	constexpr StringId( LiteralTag, const char* str )
+		: _value( HashFNV1a32( str ) )
+#ifdef AROMA_DEBUG
+		, _debugName( str )
+#endif
+	{
+	}
+
+	// ワイド文字列リテラル.
+	constexpr StringId( LiteralTag, const wchar_t* str )
+		: _value( HashFNV1a32( str ) )
+#ifdef AROMA_DEBUG
+		, _debugName( nullptr )
+#endif
+	{
+	}
+
+	constexpr StringId( ValueTag, u32 value )
+		: _value( value )
+#ifdef AROMA_DEBUG
+		, _debugName( nullptr )
+#endif
+	{
+	}
+
+	u32				_value;
+#ifdef AROMA_DEBUG
+	const char*		_debugName;		//!< _sidリテラルの文字列(実行時生成の場合はnullptr).
+#endif
+};
+
+//---------------------------------------------------------------------------
+//! @brief		文字列リテラルから生成.
+//!
+//! @details
+//!		リテラル演算子は文字列リテラルにしか適用できないため,
+//!		書き換え可能なバッファを参照したIDは作成できません.
+//!
+//! @note		ASCII文字列のワイド文字列リテラルはcharリテラルと同じIDになります.
+//---------------------------------------------------------------------------
+constexpr StringId operator"" _sid( const char* str, size_t )
+{
+	return StringId( StringId::LiteralTag(), str );
+}
+
+constexpr StringId operator"" _sid( const wchar_t* str, size_t )
+{
+	return StringId( StringId::LiteralTag(), str );
+}
+
+} // namespace data
+} // namespace aroma
+
+//---------------------------------------------------------------------------
+//! @brief		std::unordered_map等のキー用.
+//---------------------------------------------------------------------------
+namespace std {
+template<>
+struct hash< aroma::data::StringId >
+{
+	size_t operator()( const aroma::data::StringId& id ) const
+	{
+		return static_cast< size_t >( id.GetValue() );
+	}
+};
+} // namespace std
@@ -0,0 +1,115 @@
+﻿//===========================================================================
+//!
+//!	@file		ArchiveBuilder.h
+//!	@brief		パックアーカイブ作成.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include "ArchiveFormat.h"
+#include "../common/RefObject.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//!	@brief		パックアーカイブ作成.
+//!
+//! @details
+//!		エントリを追加した順にデータを配置し, ArchiveReaderで読み込めるアーカイブを書き出します.
+//!		ロード時に連続して読み込むアセットは続けて追加して下さい.
+//!
+//! @code
+//!	file::ArchiveBuilder builder;
+//!	builder.AddFile( _T( "resource/texture.dds" ), _T( "../resource/texture.dds" ) );
+//!	builder.WriteToFile( _T( "resource.arpk" ) );
+//! @endcode
+//---------------------------------------------------------------------------
+class ArchiveBuilder final: public RefObject, private util::NonCopyable< ArchiveBuilder >
+{
+public:
+	ArchiveBuilder();
+	~ArchiveBuilder();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		メモリ上のデータをエントリとして追加.
+	//!
+	//! @param[in]	path		アーカイブ内のパス.
+	//! @param[in]	entryData	データ(コピーして保持します).
+	//! @param[in]	size		データサイズ.
+	//! @param[in]	entryFlags	ArchiveEntryFlagの組み合わせ.
+	//!
+	//! @retval		true	: 追加成功.
+	//!	@retval		false	: 追加失敗(同じパスのエントリが存在).
+	//-----------------------------------------------------------------------
+	bool AddEntry( CTStr path, const void* entryData, size_t size, u32 entryFlags = 0 );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ファイルをエントリとして追加.
+	//!
+	//! @details
+	//!		ファイルの内容はWriteToFile()時に読み込みます.
+	//!		kArchiveEntryFlagCompressedを指定した場合は追加時に圧縮してメモリ上に保持します.
+	//!
+	//! @param[in]	path			アーカイブ内のパス.
+	//! @param[in]	sourceFilePath	追加するファイルのパス.
+	//! @param[in]	entryFlags		ArchiveEntryFlagの組み合わせ.
+	//!
+	//! @retval		true	: 追加成功.
+	//!	@retval		false	: 追加失敗(ファイルが開けない, または同じパスのエントリが存在).
+	//-----------------------------------------------------------------------
+	bool AddFile( CTStr path, CTStr sourceFilePath, u32 entryFlags = 0 );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		アーカイブ書き出し.
+	//!
+	//! @details
+	//!		一時ファイルへ書き出してから置き換えるため, 失敗時に既存のアーカイブは壊れません.
+	//!
+	//! @retval		true	: 書き出し成功.
+	//!	@retval		false	: 書き出し失敗.
+	//-----------------------------------------------------------------------
+	bool WriteToFile( CTStr filePath );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		追加したエントリを全て破棄.
+	//-----------------------------------------------------------------------
+	void Clear();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリ数取得.
+	//-----------------------------------------------------------------------
+	u32 GetEntryCount() const;
+
+private:
+	//-----------------------------------------------------------------------
+	//! @brief		追加されたエントリ.
+	//-----------------------------------------------------------------------
+	struct SourceEntry
+	{
+		u64							pathHash;
+		u64							size;
+		u32							crc;
+		u32							flags;
+		std::vector< u8 >			data;				//!< AddEntry()で追加したデータ.
+		std::basic_string< TChar >	sourceFilePath;		//!< AddFile()で追加したファイル.
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		データを保持(圧縮指定時は圧縮).
+	//-----------------------------------------------------------------------
+	static void StoreData( SourceEntry* entry, const void* entryData, size_t size, u32 entryFlags );
+
+	std::vector< SourceEntry >		_entries;
+	std::unordered_set< u64 >		_pathHashes;
+};
+
+} // namespace file
+} // namespace aroma
@@ -0,0 +1,106 @@
+﻿//===========================================================================
+//!
+//!	@file		ArchiveFormat.h
+//!	@brief		パックアーカイブフォーマット.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include "../data/DataDef.h"
+#include "../data/Hash.h"
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//!	@name	定数.
+//---------------------------------------------------------------------------
+//! @{
+
+//! アーカイブ識別子.
+constexpr u32		kArchiveMagic			= data::FourCC< 'A', 'R', 'P', 'K' >::value;
+
+//! アーカイブバージョン(フォーマットを変更した場合は更新すること).
+constexpr u32		kArchiveVersion			= 2;
+
+//! エントリデータのアラインメント(ページサイズ. アンバッファードI/Oのアラインメントも満たす).
+constexpr u32		kArchiveAlignment		= 4096;
+
+//! 空きバケット.
+constexpr u32		kArchiveEmptyBucket		= 0xffffffffu;
+
+//! @}
+
+//---------------------------------------------------------------------------
+//!	@brief		アーカイブエントリフラグ.
+//---------------------------------------------------------------------------
+enum ArchiveEntryFlag : u32
+{
+	kArchiveEntryFlagCompressed	= 1u << 0,	//!< データはチャンク分割圧縮(data::CompressChunked())されている.
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		アーカイブヘッダー.
+//!
+//! @details
+//!		ファイル構成(リトルエンディアン) :
+//!			ArchiveHeader
+//!			ArchiveEntry[ entryCount ]		: 目次.
+//!			u32[ bucketCount ]				: パスハッシュ -> エントリインデックスのハッシュテーブル(線形探査).
+//!			エントリデータ					: kArchiveAlignment毎にアライン.
+//---------------------------------------------------------------------------
+struct ArchiveHeader
+{
+	u32		magic;			//!< kArchiveMagic.
+	u32		version;		//!< kArchiveVersion.
+	u32		entryCount;		//!< エントリ数.
+	u32		bucketCount;	//!< ハッシュテーブルのバケット数(2の累乗).
+	u32		alignment;		//!< エントリデータのアラインメント.
+	u32		tocCRC;			//!< 目次とハッシュテーブルのCRC32.
+	u64		tocOffset;		//!< 目次のオフセット.
+	u64		bucketOffset;	//!< ハッシュテーブルのオフセット.
+	u64		dataOffset;		//!< 最初のエントリデータのオフセット.
+	u64		fileSize;		//!< アーカイブ全体のサイズ(切り詰めの検出用).
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		アーカイブエントリ(目次).
+//---------------------------------------------------------------------------
+struct ArchiveEntry
+{
+	u64		pathHash;		//!< HashArchivePath()によるパスのハッシュ.
+	u64		offset;			//!< データのオフセット(アーカイブ先頭から).
+	u64		size;			//!< データのサイズ(圧縮されている場合は圧縮後のサイズ).
+	u32		crc;			//!< データのCRC32(圧縮されている場合は圧縮後のデータ).
+	u32		flags;			//!< ArchiveEntryFlagの組み合わせ.
+};
+
+static_assert( sizeof( ArchiveHeader ) == 56, "ArchiveHeader layout changed." );
+static_assert( sizeof( ArchiveEntry ) == 32, "ArchiveEntry layout changed." );
+
+//---------------------------------------------------------------------------
+//!	@brief		アーカイブ内パスのハッシュ.
+//!
+//! @details
+//!		'\\'は'/'として, ASCIIの大文字は小文字として扱います.
+//!		"Resource\\Texture.dds"と"resource/texture.dds"は同じエントリを指します.
+//---------------------------------------------------------------------------
+template< typename C >
+inline u64 HashArchivePath( const C* path )
+{
+	u64 hash = data::kFNV64Offset;
+	for( const C* p = path; *p; ++p )
+	{
+		u32 c = data::detail::CharCode( *p );
+		if( c == '\\' )					c = '/';
+		else if( c >= 'A' && c <= 'Z' )	c += 'a' - 'A';
+		hash = data::detail::FNV1a64Char( hash, c );
+	}
+	return hash;
+}
+
+} // namespace file
+} // namespace aroma
@@ -0,0 +1,147 @@
+﻿//===========================================================================
+//!
+//!	@file		ArchiveReader.h
+//!	@brief		パックアーカイブ読み込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include "ArchiveFormat.h"
+#include "MappedFile.h"
+#include "../common/Scheduler.h"
+#include "../common/Task.h"
+#include "../common/RefObject.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//!	@brief		パックアーカイブ読み込み.
+//!
+//! @details
+//!		アーカイブ全体をメモリマップし, エントリをコピー無しで参照します.
+//!		検索はパスハッシュのハッシュテーブルによりO(1)で行います.
+//!		ロード時に多数のファイルをオープンする代わりに,
+//!		1回のオープンとポインタ演算でアセットを取得できます.
+//!
+//! @code
+//!	file::ArchiveReader archive;
+//!	archive.Open( _T( "resource.arpk" ) );
+//!	const file::ArchiveEntry* entry = archive.Find( _T( "resource/texture.dds" ) );
+//!	if( entry )
+//!	{
+//!		data::DDSAccessor dds( archive.GetEntryData( entry ), static_cast< size_t >( entry->size ) );
+//!	}
+//! @endcode
+//---------------------------------------------------------------------------
+class ArchiveReader final: public RefObject, private util::NonCopyable< ArchiveReader >
+{
+public:
+	ArchiveReader();
+	~ArchiveReader();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		アーカイブオープン.
+	//!
+	//! @details
+	//!		ヘッダーと目次を検証します. エントリデータの検証はVerify()で行って下さい.
+	//!
+	//! @retval		true	: オープン成功.
+	//!	@retval		false	: オープン失敗(フォーマット不正を含む).
+	//-----------------------------------------------------------------------
+	bool Open( CTStr filePath );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		アーカイブクローズ.
+	//!
+	//! @details
+	//!		デストラクタ時に自動的にコールされます.
+	//!		クローズ後は取得したエントリとデータを参照しないで下さい.
+	//-----------------------------------------------------------------------
+	void Close();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		オープン済みか.
+	//-----------------------------------------------------------------------
+	bool IsOpened() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリ検索.
+	//!
+	//! @return		エントリ(見つからない場合はnullptr).
+	//-----------------------------------------------------------------------
+	const ArchiveEntry* Find( u64 pathHash ) const;
+	const ArchiveEntry* Find( CTStr path ) const { return Find( HashArchivePath( path ) ); }
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリデータの先頭アドレス取得.
+	//!
+	//! @details
+	//!		アーカイブのマップ内を直接指します(kArchiveAlignmentにアライン済み).
+	//!		kArchiveEntryFlagCompressedのエントリは圧縮されたデータを指します.
+	//-----------------------------------------------------------------------
+	const void* GetEntryData( const ArchiveEntry* entry ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリの展開後のサイズ取得.
+	//!
+	//! @return		展開後のサイズ(無圧縮のエントリはentry->size. 圧縮データが不正な場合は0).
+	//-----------------------------------------------------------------------
+	u64 GetEntryOriginalSize( const ArchiveEntry* entry ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリデータを展開して取得.
+	//!
+	//! @details
+	//!		圧縮されたエントリはチャンク毎にスケジューラーで並列に展開先へ直接展開します.
+	//!		無圧縮のエントリはコピーします.
+	//!
+	//! @param[in]	entry		エントリ.
+	//! @param[out]	dest		展開先.
+	//! @param[in]	destBytes	展開先サイズ(GetEntryOriginalSize()と一致する必要があります).
+	//! @param[in]	scheduler	展開を実行するスケジューラー(nullptrの場合は呼び出しスレッドで展開).
+	//!
+	//! @return		展開に成功した場合にtrueで完了するタスク.
+	//!
+	//! @note		展開先とアーカイブはタスクの完了まで解放, クローズしないで下さい.
+	//-----------------------------------------------------------------------
+	Task< bool > ExtractEntryAsync( const ArchiveEntry* entry, void* dest, size_t destBytes, IScheduler* scheduler ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリデータを展開して取得(完了まで待機).
+	//-----------------------------------------------------------------------
+	bool ExtractEntry( const ArchiveEntry* entry, void* dest, size_t destBytes, IScheduler* scheduler = nullptr ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリデータのCRC検証.
+	//!
+	//! @retval		true	: 一致.
+	//!	@retval		false	: 不一致(データ破損).
+	//-----------------------------------------------------------------------
+	bool Verify( const ArchiveEntry* entry ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリ数取得.
+	//-----------------------------------------------------------------------
+	u32 GetEntryCount() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		エントリ取得.
+	//-----------------------------------------------------------------------
+	const ArchiveEntry* GetEntry( u32 index ) const;
+
+private:
+	MappedFile				_file;
+	const u8*				_data;
+	const ArchiveHeader*	_header;
+	const ArchiveEntry*		_entries;
+	const u32*				_buckets;
+	u32						_bucketMask;
+};
+
+} // namespace file
+} // namespace aroma
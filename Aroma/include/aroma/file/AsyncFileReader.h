@@ -0,0 +1,229 @@
+﻿//===========================================================================
+//!
+//!	@file		AsyncFileReader.h
+//!	@brief		非同期ファイル読み込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "FileIO.h"
+#include "../common/RefObject.h"
+#include "../common/Scheduler.h"
+#include "../common/LockFreeQueue.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//!	@brief		非同期読み込みリクエストハンドル.
+//---------------------------------------------------------------------------
+using AsyncReadHandle = u32;
+constexpr AsyncReadHandle kInvalidAsyncReadHandle = 0xffffffffu;
+
+//---------------------------------------------------------------------------
+//!	@brief		非同期読み込みバックエンド.
+//---------------------------------------------------------------------------
+enum class AsyncReadBackend : u32
+{
+	kAuto,			//!< ネイティブが使用可能ならネイティブ, 不可ならスレッドプール.
+	kNative,		//!< ネイティブ(Windows : I/O完了ポート, Linux : io_uring).
+	kThreadPool,	//!< スケジューラー上でオフセット指定の同期読み込み.
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		非同期読み込み完了情報.
+//---------------------------------------------------------------------------
+struct AsyncReadResult
+{
+	AsyncReadHandle	handle;		//!< Read()で返されたハンドル.
+	void*			userData;	//!< Read()で指定したユーザーデータ.
+	size_t			readBytes;	//!< 読み込んだバイト数(ファイル終端の場合は要求より小さくなります).
+	bool			succeeded;	//!< 読み込み成功したか.
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		非同期ファイル読み込み.
+//!
+//! @details
+//!		Read()で読み込みリクエストを積み, Submit()でまとめて発行します.
+//!		完了したリクエストはPoll()/Wait()でまとめて回収します.
+//!		多数のアセットを読み込む場合でも同期読み込みで直列化されず,
+//!		ディスクのキューを埋めたまま読み込めます.
+//!
+//!		WindowsではkOpenModeFlagAsyncを指定してオープンしたファイルのみI/O完了ポートで読み込み,
+//!		それ以外のファイルはスレッドプールで読み込みます.
+//!		ファイルは最初に読み込んだリーダーの完了ポートに関連付けられるため, 他のリーダーではスレッドプールで読み込みます.
+//!		Linuxではio_uringを使用します(カーネルが未対応の場合はスレッドプール).
+//!
+//! @note		Read(), Submit(), Poll(), Wait()は同じスレッドから呼び出して下さい.
+//!				読み込み先バッファとファイルは完了を回収するまで解放しないで下さい.
+//!
+//! @code
+//!	reader.Read( &file, offset, size, buffer, userData );
+//!	reader.Submit();
+//!	AsyncReadResult results[ 16 ];
+//!	u32 count = reader.Poll( results, 16 );
+//! @endcode
+//---------------------------------------------------------------------------
+class AsyncFileReader final: public RefObject, private util::NonCopyable< AsyncFileReader >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		u32					queueDepth;		//!< 同時に保持できるリクエスト最大数(最大65535).
+		AsyncReadBackend	backend;		//!< バックエンド.
+		IScheduler*			scheduler;		//!< スレッドプール読み込みの実行先(nullptrの場合はSubmit()内で同期読み込み).
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			queueDepth	= 128;
+			backend		= AsyncReadBackend::kAuto;
+			scheduler	= nullptr;
+		}
+	};
+
+public:
+	AsyncFileReader();
+	~AsyncFileReader();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		初期化.
+	//!
+	//! @retval		true	: 初期化成功.
+	//!	@retval		false	: 初期化失敗(kNative指定でネイティブが使用不可の場合を含む).
+	//-----------------------------------------------------------------------
+	bool Initialize( const Desc& desc );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		解放.
+	//!
+	//! @note		発行済みのリクエストは全て完了を待ってから破棄します.
+	//-----------------------------------------------------------------------
+	void Finalize();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		読み込みリクエスト追加.
+	//!
+	//! @param[in]	file		読み込むファイル(読み込み許可有り).
+	//! @param[in]	offset		読み込み開始オフセット.
+	//! @param[in]	size		読み込みバイトサイズ.
+	//! @param[out]	dest		読み込みデータ格納先.
+	//! @param[in]	userData	完了情報に格納するユーザーデータ.
+	//!
+	//! @return		リクエストハンドル(リクエストが満杯の場合はkInvalidAsyncReadHandle).
+	//-----------------------------------------------------------------------
+	AsyncReadHandle Read( File* file, u64 offset, size_t size, void* dest, void* userData = nullptr );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		追加済みのリクエストをまとめて発行.
+	//!
+	//! @return		発行したリクエスト数.
+	//-----------------------------------------------------------------------
+	u32 Submit();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		完了したリクエストを回収(待機しません).
+	//!
+	//! @param[out]	outResults	完了情報格納先.
+	//! @param[in]	maxCount	完了情報格納先の要素数.
+	//!
+	//! @return		回収したリクエスト数.
+	//-----------------------------------------------------------------------
+	u32 Poll( AsyncReadResult* outResults, u32 maxCount );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		完了したリクエストを回収(最低数が完了するまで待機).
+	//!
+	//! @param[out]	outResults	完了情報格納先.
+	//! @param[in]	maxCount	完了情報格納先の要素数.
+	//! @param[in]	minCount	待機する最低完了数(発行済みのリクエスト数で制限されます).
+	//!
+	//! @return		回収したリクエスト数.
+	//-----------------------------------------------------------------------
+	u32 Wait( AsyncReadResult* outResults, u32 maxCount, u32 minCount = 1 );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		未回収のリクエスト数取得(未発行を含む).
+	//-----------------------------------------------------------------------
+	u32 GetPendingCount() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		使用中のバックエンド取得.
+	//!
+	//! @return		kNativeまたはkThreadPool.
+	//-----------------------------------------------------------------------
+	AsyncReadBackend GetBackend() const;
+
+private:
+	//-----------------------------------------------------------------------
+	//! @brief		リクエスト.
+	//-----------------------------------------------------------------------
+	struct Request
+	{
+#ifdef AROMA_WINDOWS
+		OVERLAPPED	overlapped;		//!< 完了通知からリクエストを求めるため先頭に配置.
+#endif
+		File*		file;
+		u64			offset;
+		void*		dest;
+		size_t		size;
+		size_t		readBytes;
+		void*		userData;
+		u32			generation;
+		bool		used;
+		bool		succeeded;
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		ネイティブキュー(プラットフォーム毎に定義).
+	//-----------------------------------------------------------------------
+	struct NativeQueue;
+
+	AsyncReadHandle MakeHandle( u32 index ) const;
+	void ExecuteThreadPoolRead( u32 index );
+	void CompleteRequest( u32 index, bool succeeded, size_t readBytes );
+	u32 CollectResults( AsyncReadResult* outResults, u32 maxCount );
+	u32 ReapThreadPool();
+
+	//-----------------------------------------------------------------------
+	// プラットフォーム毎の実装.
+	//-----------------------------------------------------------------------
+	bool InitializeNative( u32 queueDepth );
+	void FinalizeNative();
+	bool IsNativeReadable( const Request& request ) const;
+	bool SubmitNative( u32 index );
+	void FlushNative();
+	u32 ReapNative( bool wait );
+
+	bool					_initialized;
+	Desc					_desc;
+	AsyncReadBackend		_backend;
+	NativeQueue*			_native;
+	Request*				_requests;
+	u32*					_freeIndices;		//!< 未使用リクエスト.
+	u32						_freeCount;
+	u32*					_queuedIndices;		//!< Submit()待ちリクエスト.
+	u32						_queuedCount;
+	u32*					_completedIndices;	//!< 回収待ちリクエスト.
+	u32						_completedCount;
+	u32						_nativeInFlightCount;
+	u32						_threadPoolInFlightCount;
+	MPMCQueue< u32 >*		_threadPoolCompleted;	//!< ワーカーから完了したリクエストを受け取る.
+	std::mutex				_mutex;
+	std::condition_variable	_condition;
+};
+
+} // namespace file
+} // namespace aroma
@@ -20,11 +20,69 @@ namespace file {
 //---------------------------------------------------------------------------
 enum OpenModeFlag : u32
 {
-	kOpenModeFlagRead	= 1ui32 << 0,	//!< 読み込み許可.
-	kOpenModeFlagWrite	= 1ui32 << 1,	//!< 書き込み許可.
-	// TODO: kOpenModeAppend	= 1ui32 << 2,	//!< 追記書き込み許可.
+	kOpenModeFlagRead	= 1u << 0,	//!< 読み込み許可.
+	kOpenModeFlagWrite	= 1u << 1,	//!< 書き込み許可.
+	// TODO: kOpenModeAppend	= 1u << 2,	//!< 追記書き込み許可.
+	kOpenModeFlagAsync	= 1u << 3,	//!< 非同期I/O(AsyncFileReader)用にオープン.
+	kOpenModeFlagUnbuffered	= 1u << 4,	//!< ページキャッシュを経由しない(大量データのストリーミング用).
+	kOpenModeFlagSequential	= 1u << 5,	//!< 先頭から順に読み書きする(OSの先読み, 書き込みのヒント).
+	kOpenModeFlagTruncate	= 1u << 6,	//!< 書き込み時に既存の内容を破棄.
+	kOpenModeFlagCreateNew	= 1u << 7,	//!< 書き込み時に新規作成のみ許可(既に存在する場合はオープン失敗).
 };
 
+//---------------------------------------------------------------------------
+//!	@brief		ネイティブファイルハンドル.
+//---------------------------------------------------------------------------
+#ifdef AROMA_WINDOWS
+using NativeFileHandle = HANDLE;
+#else
+using NativeFileHandle = int;
+#endif
+
+//---------------------------------------------------------------------------
+//!	@brief		アンバッファードI/Oのアラインメント取得.
+//!
+//! @details
+//!		kOpenModeFlagUnbufferedでオープンしたファイルは,
+//!		読み書きのオフセット, サイズ, バッファのアドレスをこの値にアラインして下さい.
+//!		ファイル終端を越えるサイズを指定した場合は実際に読み込んだサイズが返ります.
+//---------------------------------------------------------------------------
+size_t GetUnbufferedAlignment();
+
+//---------------------------------------------------------------------------
+//!	@brief		アンバッファードI/O用バッファ確保.
+//!
+//! @param[in]	size	確保サイズ(GetUnbufferedAlignment()に切り上げます).
+//!
+//! @return		確保したバッファ(FreeUnbufferedBuffer()で解放して下さい).
+//---------------------------------------------------------------------------
+void* AllocateUnbufferedBuffer( size_t size );
+
+//---------------------------------------------------------------------------
+//!	@brief		アンバッファードI/O用バッファ解放.
+//---------------------------------------------------------------------------
+void FreeUnbufferedBuffer( void* buffer );
+
+//---------------------------------------------------------------------------
+//!	@brief		ファイル名変更.
+//!
+//! @details
+//!		移動先にファイルが存在する場合は置き換えます.
+//!		同じボリューム内では置き換えは不可分に行われます.
+//!
+//! @retval		true	: 変更成功.
+//!	@retval		false	: 変更失敗.
+//---------------------------------------------------------------------------
+bool RenameFile( CTStr srcFilePath, CTStr dstFilePath );
+
+//---------------------------------------------------------------------------
+//!	@brief		ファイル削除.
+//!
+//! @retval		true	: 削除成功.
+//!	@retval		false	: 削除失敗.
+//---------------------------------------------------------------------------
+bool RemoveFile( CTStr filePath );
+
 //---------------------------------------------------------------------------
 //!	@brief		ファイル共有フラグ.
 //!
@@ -34,9 +92,9 @@ enum OpenModeFlag : u32
 //---------------------------------------------------------------------------
 enum ShareFlag : u32
 {
-	kShareFlagDelete	= 1ui32 << 0,	//!< 削除許可.
-	kShareFlagRead		= 1ui32 << 1,	//!< 読み込み許可.
-	kShareFlagWrite		= 1ui32 << 2,	//!< 書き込み許可.
+	kShareFlagDelete	= 1u << 0,	//!< 削除許可.
+	kShareFlagRead		= 1u << 1,	//!< 読み込み許可.
+	kShareFlagWrite		= 1u << 2,	//!< 書き込み許可.
 };
 
 //---------------------------------------------------------------------------
@@ -84,7 +142,7 @@ public:
 	//!	@brief		ファイルデータ読み込み.
 	//!
 	//! @param[out]	outBuf		読み込みデータ格納先.
-	//! @param[in]	readBytes	読み込み最大データバイトサイズ.
+	//! @param[in]	readBytes	読み込み最大データバイトサイズ(4GB以上も可).
 	//! @param[in]	readedBytes	読み込んだデータバイトサイズ格納先(nullptr指定可).
 	//!
 	//! @pre		ファイルがオープン状態かつ読み込み許可有り.
@@ -94,6 +152,25 @@ public:
 	//-----------------------------------------------------------------------
 	bool ReadFile( void* outBuf, size_t readBytes, size_t* readedBytes );
 
+	//-----------------------------------------------------------------------
+	//!	@brief		オフセット指定でファイルデータ読み込み.
+	//!
+	//! @details
+	//!		共有のファイル位置を使用しないため, 複数スレッドから同時に呼び出せます.
+	//!		ReadFile()のファイル位置は呼び出し後に不定となります.
+	//!
+	//! @param[in]	offset		読み込み開始オフセット.
+	//! @param[out]	outBuf		読み込みデータ格納先.
+	//! @param[in]	readBytes	読み込み最大データバイトサイズ.
+	//! @param[in]	readedBytes	読み込んだデータバイトサイズ格納先(nullptr指定可).
+	//!
+	//! @pre		ファイルがオープン状態かつ読み込み許可有り.
+	//!
+	//! @retval		true	: データ読み込み成功(ファイル終端に達した場合を含む).
+	//! @retval		false	: データ読み込み失敗.
+	//-----------------------------------------------------------------------
+	bool ReadFileAt( u64 offset, void* outBuf, size_t readBytes, size_t* readedBytes );
+
 	//-----------------------------------------------------------------------
 	//!	@brief		ファイルデータ書き込み.
 	//!
@@ -105,9 +182,34 @@ public:
 	//! @retval		true	: データ書き込み成功.
 	//! @retval		false	: データ書き込み失敗.
 	//-----------------------------------------------------------------------
-	bool WriteFile( void* outBuf, size_t writeBytes );
+	bool WriteFile( const void* buf, size_t writeBytes );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		書き込んだデータをストレージへ反映.
+	//!
+	//! @details
+	//!		OSのキャッシュに残っているデータを書き出し, 完了まで待機します.
+	//!
+	//! @pre		ファイルがオープン状態かつ書き込み許可有り.
+	//!
+	//! @retval		true	: 反映成功.
+	//! @retval		false	: 反映失敗.
+	//-----------------------------------------------------------------------
+	bool FlushBuffers();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		オープンモードフラグ取得.
+	//-----------------------------------------------------------------------
+	u32 GetOpenFlags() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ネイティブファイルハンドル取得.
+	//-----------------------------------------------------------------------
+	NativeFileHandle GetNativeHandle() const;
 
 private:
+	friend class AsyncFileReader;
+
 	bool	_opened;
 	u32		_openFlags;
 	u32		_shareFlags;
@@ -115,6 +217,9 @@ private:
 
 #ifdef AROMA_WINDOWS
 	HANDLE	_fileHandle;
+	u64		_completionPortId;	//!< 関連付け済みのI/O完了ポートの識別番号(AsyncFileReaderが設定. 0は未関連付け).
+#elif defined( AROMA_POSIX )
+	int		_fileDescriptor;
 #endif
 };
 
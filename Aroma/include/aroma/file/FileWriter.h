@@ -0,0 +1,168 @@
+﻿//===========================================================================
+//!
+//!	@file		FileWriter.h
+//!	@brief		バッファリングファイル書き込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <string>
+#include "FileIO.h"
+#include "../common/RefObject.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//!	@brief		バッファリングファイル書き込み.
+//!
+//! @details
+//!		細かい書き込みをユーザー空間のバッファにまとめ, 大きな単位でファイルへ書き出します.
+//!		backgroundFlushを指定した場合はバッファを2面使用し,
+//!		書き出しをバックグラウンドスレッドで行うため呼び出しスレッドが書き込みで停止しません.
+//!		atomicReplaceを指定した場合は一時ファイルへ書き込み, Close()の成功時にのみ置き換えるため,
+//!		書き込み途中で終了しても元のファイルが壊れません.
+//!		一時ファイル名はプロセスIDと連番で一意にするため, 同じファイルへ複数のライターが同時に書き込めます(最後にClose()した内容が残ります).
+//!
+//! @note		Write(), Flush(), Close()は同じスレッドから呼び出して下さい.
+//!
+//! @code
+//!	file::FileWriter::Desc desc;
+//!	desc.atomicReplace = true;
+//!	file::FileWriter writer;
+//!	if( writer.Open( path, desc ) )
+//!	{
+//!		writer.Write( data, size );
+//!		result = writer.Close();
+//!	}
+//! @endcode
+//---------------------------------------------------------------------------
+class FileWriter final: public RefObject, private util::NonCopyable< FileWriter >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		size_t	bufferSize;			//!< 書き込みバッファサイズ(backgroundFlush時は2面確保).
+		bool	backgroundFlush;	//!< バックグラウンドスレッドでファイルへ書き出す.
+		bool	atomicReplace;		//!< 一時ファイルへ書き込み, Close()時に置き換える.
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			bufferSize		= 4 * 1024 * 1024;
+			backgroundFlush	= false;
+			atomicReplace	= false;
+		}
+	};
+
+public:
+	FileWriter();
+	~FileWriter();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ファイルオープン.
+	//!
+	//! @details
+	//!		既存のファイルの内容は破棄します(atomicReplace時はClose()まで保持).
+	//!
+	//! @param[in]	filePath	ファイルのパス.
+	//! @param[in]	desc		構成設定.
+	//!
+	//! @retval		true	: オープン成功.
+	//!	@retval		false	: オープン失敗.
+	//-----------------------------------------------------------------------
+	bool Open( CTStr filePath, const Desc& desc = Desc() );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		データ書き込み.
+	//!
+	//! @details
+	//!		バッファが一杯になった時点でファイルへ書き出します.
+	//!
+	//! @retval		true	: 書き込み成功.
+	//! @retval		false	: 書き込み失敗(以前の書き出しの失敗を含む).
+	//-----------------------------------------------------------------------
+	bool Write( const void* data, size_t size );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		バッファの内容をファイルへ書き出し.
+	//!
+	//! @note		バックグラウンドでの書き出しの完了を待ちます.
+	//!
+	//! @retval		true	: 書き出し成功.
+	//! @retval		false	: 書き出し失敗.
+	//-----------------------------------------------------------------------
+	bool Flush();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		書き出してファイルクローズ.
+	//!
+	//! @details
+	//!		デストラクタ時に自動的にコールされます.
+	//!		atomicReplace時はストレージへ反映してから元のファイルを置き換えます.
+	//!		失敗した場合は一時ファイルを削除し, 元のファイルはそのまま残ります.
+	//!
+	//! @retval		true	: 全ての書き込みに成功.
+	//! @retval		false	: 書き込み失敗.
+	//-----------------------------------------------------------------------
+	bool Close();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		書き込みを破棄してファイルクローズ.
+	//!
+	//! @details
+	//!		atomicReplace時は元のファイルを変更しません.
+	//-----------------------------------------------------------------------
+	void Abort();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		オープン済みか.
+	//-----------------------------------------------------------------------
+	bool IsOpened() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		Write()したバイト数の合計取得.
+	//-----------------------------------------------------------------------
+	u64 GetWrittenBytes() const;
+
+private:
+	void SubmitBuffer();
+	void WaitFlushIdle();
+	void StopFlushThread();
+	void CloseFile( bool commit );
+	void FlushThreadMain();
+
+	bool						_opened;
+	Desc						_desc;
+	File						_file;
+	std::basic_string< TChar >	_filePath;
+	std::basic_string< TChar >	_tempFilePath;		//!< atomicReplace時の書き込み先.
+	u8*							_buffers[ 2 ];
+	u32							_activeBuffer;
+	size_t						_bufferUsed;
+	u64							_writtenBytes;
+	std::atomic< bool >			_failed;
+
+	// バックグラウンド書き出し.
+	std::thread					_flushThread;
+	std::mutex					_mutex;
+	std::condition_variable		_condition;
+	const u8*					_flushData;			//!< 書き出し中のバッファ.
+	size_t						_flushSize;			//!< 書き出し中のサイズ(0の場合は待機中).
+	bool						_quit;
+};
+
+} // namespace file
+} // namespace aroma
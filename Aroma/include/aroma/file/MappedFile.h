@@ -0,0 +1,92 @@
+﻿//===========================================================================
+//!
+//!	@file		MappedFile.h
+//!	@brief		メモリマップドファイル.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include "../common/BitFlag.h"
+#include "../common/RefObject.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//!	@brief		メモリマップアクセスヒントフラグ.
+//---------------------------------------------------------------------------
+enum MapHintFlag : u32
+{
+	kMapHintFlagSequential	= Bit32(0),		//!< 先頭から順に読み込む.
+	kMapHintFlagWillNeed	= Bit32(1),		//!< 全体をすぐに読み込む(先読みを要求).
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		読み込み専用メモリマップドファイル.
+//!
+//! @details
+//!		ファイル全体を読み込み専用でアドレス空間にマップします.
+//!		ヒープへのコピーを行わずにファイルの内容を直接参照できるため,
+//!		DDSAccessor等に渡すことでページキャッシュから直接テクスチャを作成できます.
+//!
+//! @code
+//!	file::MappedFile ddsFile;
+//!	if( ddsFile.Open( path, file::kMapHintFlagSequential ) )
+//!	{
+//!		texture = device->CreateTexture2DFromDDS( data::DDSAccessor( ddsFile.GetData() ), ... );
+//!	}
+//! @endcode
+//---------------------------------------------------------------------------
+class MappedFile final: public RefObject, private util::NonCopyable< MappedFile >
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ファイルをオープンしてマップ.
+	//!
+	//! @param[in]	filePath	ファイルのパス.
+	//! @param[in]	hintFlags	アクセスヒントフラグ(MapHintFlagの組み合わせ).
+	//!
+	//! @retval		true	: マップ成功.
+	//!	@retval		false	: マップ失敗(空のファイルを含む).
+	//-----------------------------------------------------------------------
+	bool Open( CTStr filePath, u32 hintFlags = 0 );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		マップ解除.
+	//!
+	//! @details
+	//!		デストラクタ時に自動的にコールされます.
+	//!		解除後はGetData()で取得したアドレスを参照しないで下さい.
+	//-----------------------------------------------------------------------
+	void Close();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		マップ済みか.
+	//-----------------------------------------------------------------------
+	bool IsOpened() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		マップしたファイル内容の先頭アドレス取得.
+	//-----------------------------------------------------------------------
+	const void* GetData() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ファイルサイズ取得.
+	//-----------------------------------------------------------------------
+	size_t GetSize() const;
+
+private:
+	bool			_opened;
+	const void*		_data;
+	size_t			_size;
+};
+
+} // namespace file
+} // namespace aroma
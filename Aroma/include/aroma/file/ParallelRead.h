@@ -0,0 +1,62 @@
+﻿//===========================================================================
+//!
+//!	@file		ParallelRead.h
+//!	@brief		分割並列ファイル読み込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include "FileIO.h"
+#include "../common/Scheduler.h"
+#include "../common/Task.h"
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//!	@brief		分割並列読み込み結果.
+//---------------------------------------------------------------------------
+struct ParallelReadResult
+{
+	size_t	readBytes;	//!< 読み込んだバイト数の合計(ファイル終端の場合は要求より小さくなります).
+	bool	succeeded;	//!< 全てのチャンクの読み込みに成功したか.
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		分割並列読み込みの既定のチャンクサイズ.
+//---------------------------------------------------------------------------
+constexpr size_t kParallelReadChunkSize = 8 * 1024 * 1024;
+
+//---------------------------------------------------------------------------
+//!	@brief		大きな範囲をチャンクに分割して並列に読み込み.
+//!
+//! @details
+//!		各チャンクをスケジューラーのワーカースレッドでFile::ReadFileAt()により読み込み,
+//!		全てのチャンクが完了した時点で一度だけタスクを完了させます.
+//!		1スレッドの同期読み込みでは使い切れないNVMe等の帯域を使用できます.
+//!
+//!		チャンクサイズはGetUnbufferedAlignment()に切り上げるため,
+//!		kOpenModeFlagUnbufferedのファイルも先頭オフセットとバッファがアラインされていれば読み込めます.
+//!
+//!		Windowsでは同期オープンのハンドルへのI/OはI/Oマネージャーで直列化されるため,
+//!		スケジューラーを指定する場合はkOpenModeFlagAsyncでオープンしたファイルを渡して下さい.
+//!		(POSIXではpreadが並列に実行されるためフラグは不要です.)
+//!
+//! @param[in]	scheduler	チャンクの読み込みを実行するスケジューラー(nullptrの場合は呼び出しスレッドで順に読み込み).
+//! @param[in]	file		読み込むファイル(読み込み許可有り).
+//! @param[in]	offset		読み込み開始オフセット.
+//! @param[in]	size		読み込みバイトサイズ(4GB以上も可).
+//! @param[out]	dest		読み込みデータ格納先.
+//! @param[in]	chunkSize	チャンクサイズ.
+//!
+//! @return		全チャンクの完了で完了するタスク.
+//!
+//! @note		ファイルと読み込み先バッファはタスクの完了まで解放しないで下さい.
+//---------------------------------------------------------------------------
+Task< ParallelReadResult > ReadFileParallel( IScheduler* scheduler, File* file, u64 offset, size_t size, void* dest, size_t chunkSize = kParallelReadChunkSize );
+
+} // namespace file
+} // namespace aroma
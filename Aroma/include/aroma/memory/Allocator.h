@@ -9,6 +9,8 @@
 //===========================================================================
 #pragma once
 
+#include <cstdlib>
+#include <cstring>
 #include "../common/Typedef.h"
 
 namespace aroma {
@@ -0,0 +1,149 @@
+﻿//===========================================================================
+//!
+//!	@file		BindingGroup.h
+//!	@brief		リソースバインディンググループ.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include "RenderDef.h"
+#include "MemoryAllocator.h"
+#include "SamplerState.h"
+#include "../common/RefObject.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace render {
+
+class Device;
+class TextureView;
+class Buffer;
+
+#ifdef AROMA_RENDER_DX11
+//---------------------------------------------------------------------------
+//!	@brief		ネイティブAPIバインディンググループ.
+//---------------------------------------------------------------------------
+struct D3D11_BINDING_GROUP
+{
+	u32									shaderResourceStart;
+	u32									shaderResourceNum;
+	ID3D11ShaderResourceView* const*	shaderResources;
+	u32									constantBufferStart;
+	u32									constantBufferNum;
+	ID3D11Buffer* const*				constantBuffers;
+	u32									samplerStart;
+	u32									samplerNum;
+	ID3D11SamplerState* const*			samplers;
+};
+using NativeBindingGroup = D3D11_BINDING_GROUP;
+#endif
+
+//---------------------------------------------------------------------------
+//!	@brief		リソースバインディンググループ.
+//!
+//! @details
+//!		連続するスロットのシェーダーリソース, 定数バッファ, サンプラーステートを
+//!		まとめて保持する不変オブジェクトです. マテリアル毎に作成しておき,
+//!		DeferredContext::PSSetBindingGroup()等の1回の呼び出しで全て設定できます.
+//!		保持するリソースの参照カウントはグループ作成時に1度だけ増やすため,
+//!		設定時の参照カウント操作はグループ1つ分のみになります.
+//---------------------------------------------------------------------------
+class BindingGroup : public RefObject, public MemoryAllocator, private util::NonCopyable< BindingGroup >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//!
+	//! @note		各配列は初期化時にコピーされるため, 呼び出し後に破棄できます.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		u32						shaderResourceStart;	//!< シェーダーリソースの先頭スロット.
+		u32						shaderResourceNum;		//!< シェーダーリソース数.
+		TextureView* const*		shaderResources;		//!< シェーダーリソースリスト.
+		u32						constantBufferStart;	//!< 定数バッファの先頭スロット.
+		u32						constantBufferNum;		//!< 定数バッファ数.
+		Buffer* const*			constantBuffers;		//!< 定数バッファリスト.
+		u32						samplerStart;			//!< サンプラーステートの先頭スロット.
+		u32						samplerNum;				//!< サンプラーステート数.
+		const SamplerState*		samplerStates;			//!< サンプラーステートリスト.
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			shaderResourceStart	= 0;
+			shaderResourceNum	= 0;
+			shaderResources		= nullptr;
+			constantBufferStart	= 0;
+			constantBufferNum	= 0;
+			constantBuffers		= nullptr;
+			samplerStart		= 0;
+			samplerNum			= 0;
+			samplerStates		= nullptr;
+		}
+	};
+
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		コンストラクタ.
+	//-----------------------------------------------------------------------
+	BindingGroup();
+
+	//-----------------------------------------------------------------------
+	//! @brief		デストラクタ.
+	//-----------------------------------------------------------------------
+	virtual ~BindingGroup();
+
+	//-----------------------------------------------------------------------
+	//! @brief		初期化.
+	//-----------------------------------------------------------------------
+	void Initialize( Device* device, const Desc& desc );
+
+	//-----------------------------------------------------------------------
+	//! @brief		解放.
+	//-----------------------------------------------------------------------
+	void Finalize();
+
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定取得.
+	//!
+	//! @note		各配列はグループが保持するコピーを指します.
+	//-----------------------------------------------------------------------
+	const Desc& GetDesc() const;
+
+	//-----------------------------------------------------------------------
+	//! @brief		指定スロットがグループの範囲に含まれるか.
+	//-----------------------------------------------------------------------
+	bool ContainsShaderResource( u32 slot ) const;
+	bool ContainsConstantBuffer( u32 slot ) const;
+	bool ContainsSampler( u32 slot ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ネイティブAPIバインディンググループの取得.
+	//-----------------------------------------------------------------------
+#ifdef AROMA_RENDER_DX11
+	const NativeBindingGroup& GetNativeBindingGroup() const;
+#endif
+
+private:
+	bool					_initialized;
+	Device*					_device;
+	Desc					_desc;
+	TextureView**			_shaderResources;
+	Buffer**				_constantBuffers;
+	SamplerState*			_samplerStates;
+
+#ifdef AROMA_RENDER_DX11
+	NativeBindingGroup			_nativeBindingGroup;
+	ID3D11ShaderResourceView**	_d3dShaderResources;
+	ID3D11Buffer**				_d3dConstantBuffers;
+	ID3D11SamplerState**		_d3dSamplers;
+#endif
+};
+
+} // namespace render
+} // namespace aroma
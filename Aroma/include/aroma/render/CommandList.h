@@ -9,8 +9,10 @@
 //===========================================================================
 #pragma once
 
+#include <vector>
 #include "RenderDef.h"
 #include "MemoryAllocator.h"
+#include "CommandStats.h"
 #include "../common/RefObject.h"
 #include "../util/NonCopyable.h"
 
@@ -23,6 +25,21 @@ class TextureView;
 
 //---------------------------------------------------------------------------
 //!	@brief		コマンドリスト.
+//!
+//! @details
+//!		記録したコマンドリストは解放するまで何度でもDevice::ExecuteCommand()で
+//!		再実行できます. 変化しない描画(静的UI, 背景, デバッグ表示等)は
+//!		1度だけ記録し, 以降のフレームは再実行のみにすることで記録コストを省けます.
+//!
+//!		ステートの引き継ぎ.
+//!		- 記録時に記録開始前のステートを引き継がず, 設定済みの全ステートを再設定します.
+//!		- 実行時に実行先のステートを引き継がず, 実行後は実行先のステートを既定値に戻します.
+//!		- Map()で書き込んだ内容は記録時の内容が再実行時にも使われます.
+//!
+//!		参照の保持.
+//!		DeferredContext::Begin()にkRecordFlagRetainを指定して記録した場合,
+//!		コマンドリストは記録中に設定されたリソースの参照を保持するため,
+//!		コマンドリストを保持している間はリソースが解放されません.
 //---------------------------------------------------------------------------
 class CommandList : public RefObject, public MemoryAllocator, private util::NonCopyable< CommandList >
 {
@@ -61,9 +78,36 @@ public:
 	ID3D11CommandList* GetNativeCommandList() const;
 #endif
 
+	//-----------------------------------------------------------------------
+	//!	@brief		参照を保持.
+	//!
+	//! @note		ContextのEnd時に実行されるため, 基本的にコールする必要はありません.
+	//!				各オブジェクトの参照カウンタをインクリメントし, 解放時にデクリメントします.
+	//-----------------------------------------------------------------------
+	void RetainReferences( u32 count, RefObject* const* objects );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		保持している参照数取得.
+	//-----------------------------------------------------------------------
+	u32 GetRetainedReferenceCount() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		統計情報設定.
+	//!
+	//! @note		ContextのEnd時に実行されるため, 基本的にコールする必要はありません.
+	//-----------------------------------------------------------------------
+	void SetStats( const CommandStats& stats );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		記録時の統計情報取得.
+	//-----------------------------------------------------------------------
+	const CommandStats& GetStats() const;
+
 private:
 	bool					_initialized;
 	Device*					_device;
+	std::vector< RefObject* >	_references;
+	CommandStats			_stats;
 
 #ifdef AROMA_RENDER_DX11
 	ID3D11CommandList*		_d3dCommandList;
@@ -0,0 +1,147 @@
+﻿//===========================================================================
+//!
+//!	@file		CommandStats.h
+//!	@brief		描画コマンド統計情報.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include "RenderDef.h"
+
+namespace aroma {
+namespace render {
+
+//---------------------------------------------------------------------------
+//!	@brief		描画コマンド統計情報.
+//!
+//! @details
+//!		DeferredContextで記録時に集計し, コマンドリスト毎に保持します.
+//!		Device::GetFrameStats()で実行したコマンドリストの合計を取得できます.
+//!		バッチング, ソート, キャッシュ等の効果の確認や描画数の増加の検出に使用して下さい.
+//---------------------------------------------------------------------------
+struct CommandStats
+{
+	//-----------------------------------------------------------------------
+	//! @brief		ステート種別.
+	//-----------------------------------------------------------------------
+	enum class StateType : u32
+	{
+		kPipelineState,
+		kInputLayout,
+		kPrimitiveType,
+		kVertexBuffer,
+		kIndexBuffer,
+		kShader,
+		kBindingGroup,
+		kShaderResource,
+		kSamplerState,
+		kConstantBuffer,
+		kRasterizerState,
+		kViewportScissorState,
+		kRenderTarget,
+		kBlendState,
+		kDepthStencilState,
+
+		kNum,
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		ステート種別毎の統計情報.
+	//-----------------------------------------------------------------------
+	struct StateStats
+	{
+		u64		changeCount;	//!< 設定関数でステートが変更された回数.
+		u64		bindCount;		//!< ネイティブAPIへ設定した回数.
+
+		//-------------------------------------------------------------------
+		StateStats(){ Default(); }
+		void Default()
+		{
+			changeCount	= 0;
+			bindCount	= 0;
+		}
+
+		//! 描画までに変更がまとめられ, ネイティブAPIへの設定を省略した回数.
+		u64 GetSkippedCount() const { return changeCount > bindCount ? changeCount - bindCount : 0; }
+	};
+
+	u64				drawCount;				//!< 描画回数(Draw).
+	u64				drawIndexedCount;		//!< インデックス付き描画回数(DrawIndexed).
+	u64				vertexCount;			//!< Drawで描画した頂点数.
+	u64				indexCount;				//!< DrawIndexedで描画したインデックス数.
+	u64				clearCount;				//!< クリア回数.
+	u64				mapCount;				//!< マップ回数(一時定数の書き込みを含む).
+	u64				mappedBytes;			//!< マップしたバイト数(一時定数の書き込みを含む).
+	u64				commandListCount;		//!< 生成したコマンドリスト数(再実行は含みません).
+	u64				executeCount;			//!< コマンドリスト実行回数(Device::GetFrameStats()のみ).
+	StateStats		state[ static_cast< u32 >( StateType::kNum ) ];	//!< StateType順.
+
+	//-----------------------------------------------------------------------
+	CommandStats(){ Default(); }
+	void Default()
+	{
+		drawCount			= 0;
+		drawIndexedCount	= 0;
+		vertexCount			= 0;
+		indexCount			= 0;
+		clearCount			= 0;
+		mapCount			= 0;
+		mappedBytes			= 0;
+		commandListCount	= 0;
+		executeCount		= 0;
+		for( auto& stats : state )
+		{
+			stats.Default();
+		}
+	}
+	const StateStats& Get( StateType stateType ) const { return state[ static_cast< u32 >( stateType ) ]; }
+	StateStats& Get( StateType stateType ) { return state[ static_cast< u32 >( stateType ) ]; }
+
+	//-----------------------------------------------------------------------
+	//! @brief		加算.
+	//-----------------------------------------------------------------------
+	void Add( const CommandStats& other )
+	{
+		drawCount			+= other.drawCount;
+		drawIndexedCount	+= other.drawIndexedCount;
+		vertexCount			+= other.vertexCount;
+		indexCount			+= other.indexCount;
+		clearCount			+= other.clearCount;
+		mapCount			+= other.mapCount;
+		mappedBytes			+= other.mappedBytes;
+		commandListCount	+= other.commandListCount;
+		executeCount		+= other.executeCount;
+		for( u32 i = 0; i < static_cast< u32 >( StateType::kNum ); ++i )
+		{
+			state[ i ].changeCount	+= other.state[ i ].changeCount;
+			state[ i ].bindCount	+= other.state[ i ].bindCount;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//! @brief		全描画回数取得.
+	//-----------------------------------------------------------------------
+	u64 GetTotalDrawCount() const { return drawCount + drawIndexedCount; }
+
+	//-----------------------------------------------------------------------
+	//! @brief		全ステート種別の合計取得.
+	//-----------------------------------------------------------------------
+	u64 GetTotalChangeCount() const
+	{
+		u64 count = 0;
+		for( const auto& stats : state ) count += stats.changeCount;
+		return count;
+	}
+	u64 GetTotalBindCount() const
+	{
+		u64 count = 0;
+		for( const auto& stats : state ) count += stats.bindCount;
+		return count;
+	}
+};
+
+} // namespace render
+} // namespace aroma
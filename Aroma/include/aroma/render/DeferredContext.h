@@ -10,6 +10,7 @@
 #pragma once
 
 #include <bitset>
+#include <vector>
 #include "RenderDef.h"
 #include "MemoryAllocator.h"
 #include "BlendState.h"
@@ -17,6 +18,9 @@
 #include "DepthStencilState.h"
 #include "SamplerState.h"
 #include "ViewportScissorState.h"
+#include "PipelineState.h"
+#include "RenderStateCache.h"
+#include "CommandStats.h"
 #include "../common/RefObject.h"
 #include "../util/NonCopyable.h"
 #include "../data/DataDef.h"
@@ -34,6 +38,7 @@ class CommandList;
 class Shader;
 class InputLayout;
 class Buffer;
+class BindingGroup;
 
 //---------------------------------------------------------------------------
 //!	@brief		遅延コンテキスト.
@@ -41,15 +46,28 @@ class Buffer;
 class DeferredContext final: public RefObject, public MemoryAllocator, private util::NonCopyable< DeferredContext >
 {
 public:
+	//-----------------------------------------------------------------------
+	//! @brief		記録フラグ.
+	//-----------------------------------------------------------------------
+	enum RecordFlag : u32
+	{
+		//! 記録中に設定したリソースの参照をコマンドリストが保持します.
+		//! 複数フレームで再実行するコマンドリストを記録する場合に指定して下さい.
+		kRecordFlagRetain	= Bit32(0),
+	};
+
 	//-----------------------------------------------------------------------
 	//! @brief		構成設定.
 	//-----------------------------------------------------------------------
 	struct Desc
 	{
+		u32		transientConstantsSize;		//!< 一時定数用共有バッファのサイズ(バイト).
+
 		//-------------------------------------------------------------------
 		Desc(){ Default(); }
 		void Default()
 		{
+			transientConstantsSize	= 256 * 1024;
 		}
 	};
 
@@ -76,16 +94,36 @@ public:
 
 	//-----------------------------------------------------------------------
 	//!	@brief		コマンド記録開始.
+	//!	@param[in]	recordFlags		記録フラグ(RecordFlagの組み合わせ).
+	//!
+	//! @details
+	//!		コマンドリストは記録開始前や実行先のステートを引き継ぎません.
+	//!		記録開始時に遅延コンテキストへ設定済みの全ステートを再設定するため,
+	//!		記録されたコマンドリストは単独で完結し, 実行順に関わらず同じ結果になります.
 	//-----------------------------------------------------------------------
-	void Begin();
+	void Begin( u32 recordFlags = 0 );
 
 	//-----------------------------------------------------------------------
 	//!	@brief		コマンド記録終了.
 	//!
 	//! @note		コマンドリストのインスタンスを生成して返却します.
+	//!				kRecordFlagRetainを指定した場合, コマンドリストは記録中に
+	//!				設定されたリソースの参照を保持するため, 保持したまま
+	//!				Device::ExecuteCommand()で何度でも再実行できます.
 	//-----------------------------------------------------------------------
 	void End( CommandList** outCommandList );
 
+	//-----------------------------------------------------------------------
+	//!	@brief		統計情報取得.
+	//!
+	//!	@param[out]	outStats	記録終了したコマンドリストの統計情報の合計.
+	//!	@param[in]	reset		trueの場合はカウンターをリセット.
+	//!
+	//! @note		記録中のコマンドはEnd()の時点で集計されます.
+	//!				コマンドリスト毎の統計情報はCommandList::GetStats()で取得できます.
+	//-----------------------------------------------------------------------
+	void GetStats( CommandStats* outStats, bool reset );
+
 	//=======================================================================
 	//!	@name		コマンド群.
 	//=======================================================================
@@ -110,6 +148,30 @@ public:
 	//-----------------------------------------------------------------------
 	void DrawIndexed( u32 indexNum, u32 startIndex, u32 baseVertexIndex = 0 );
 
+	//-----------------------------------------------------------------------
+	//! @brief		バッファのメモリマッピング(書き込み破棄).
+	//!
+	//! @note		Usage::kDynamicのバッファのみ対応.
+	//!				Buffer::Map()と違いイミディエイトコンテキストを使用しないため,
+	//!				記録スレッドから呼び出すことができます.
+	//-----------------------------------------------------------------------
+	void* Map( Buffer* buffer );
+
+	//-----------------------------------------------------------------------
+	//! @brief		バッファのメモリマッピング解除.
+	//-----------------------------------------------------------------------
+	void Unmap( Buffer* buffer );
+
+	//-----------------------------------------------------------------------
+	//! @brief		パイプラインステート設定.
+	//!
+	//! @details	シェーダー, 入力レイアウト, プリミティブタイプ, ブレンド,
+	//!				ラスタライザー, 深度ステンシルステートを一括で設定します.
+	//!				設定済みと同じハンドルの場合は何もしません.
+	//!				設定後に個別の設定関数で上書きすることもできます.
+	//-----------------------------------------------------------------------
+	void SetPipelineState( PipelineState* pipelineState );
+
 	//=======================================================================
 	//!	@name		IA: 入力アセンブラーステージ.
 	//=======================================================================
@@ -153,6 +215,7 @@ public:
 	//!	@brief		サンプラーステート設定.
 	//-----------------------------------------------------------------------
 	inline void VSSetSamplerState( u32 slot, const SamplerState& value );
+	inline void VSSetSamplerState( u32 slot, const SamplerStateKey& key );
 	inline void VSSetSamplerStateFilter( u32 slot, Filter value );
 	inline void VSSetSamplerStateAddressU( u32 slot, TextureAddress value );
 	inline void VSSetSamplerStateAddressV( u32 slot, TextureAddress value );
@@ -167,6 +230,28 @@ public:
 	//!	@brief		定数バッファ設定.
 	//-----------------------------------------------------------------------
 	void VSSetConstantBuffer( u32 slot, Buffer* cb );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		一時定数設定.
+	//!	@param[in]	slot	定数バッファスロット.
+	//!	@param[in]	data	定数データ.
+	//!	@param[in]	size	定数データサイズ(バイト).
+	//!
+	//! @details	定数データをコピーし, 以降の描画で指定スロットの定数バッファとして使用します.
+	//!				専用の定数バッファを作成せずにオブジェクト毎の定数を設定できます.
+	//!				定数データは遅延コンテキストの共有バッファから切り出されるため,
+	//!				設定した内容は記録中のコマンドリストでのみ有効です.
+	//-----------------------------------------------------------------------
+	void VSSetConstants( u32 slot, const void* data, u32 size );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		バインディンググループ設定.
+	//!
+	//! @details	グループのシェーダーリソース, 定数バッファ, サンプラーステートを
+	//!				一括で設定します. 設定済みと同じグループの場合は何もしません.
+	//!				設定後に個別の設定関数でグループ内のスロットを上書きすることもできます.
+	//-----------------------------------------------------------------------
+	void VSSetBindingGroup( BindingGroup* bindingGroup );
 	//! @}
 
 	//=======================================================================
@@ -187,6 +272,7 @@ public:
 	//!	@brief		サンプラーステート設定.
 	//-----------------------------------------------------------------------
 	inline void PSSetSamplerState( u32 slot, const SamplerState& value );
+	inline void PSSetSamplerState( u32 slot, const SamplerStateKey& key );
 	inline void PSSetSamplerStateFilter( u32 slot, Filter value );
 	inline void PSSetSamplerStateAddressU( u32 slot, TextureAddress value );
 	inline void PSSetSamplerStateAddressV( u32 slot, TextureAddress value );
@@ -201,6 +287,28 @@ public:
 	//!	@brief		定数バッファ設定.
 	//-----------------------------------------------------------------------
 	void PSSetConstantBuffer( u32 slot, Buffer* cb );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		一時定数設定.
+	//!	@param[in]	slot	定数バッファスロット.
+	//!	@param[in]	data	定数データ.
+	//!	@param[in]	size	定数データサイズ(バイト).
+	//!
+	//! @details	定数データをコピーし, 以降の描画で指定スロットの定数バッファとして使用します.
+	//!				専用の定数バッファを作成せずにオブジェクト毎の定数を設定できます.
+	//!				定数データは遅延コンテキストの共有バッファから切り出されるため,
+	//!				設定した内容は記録中のコマンドリストでのみ有効です.
+	//-----------------------------------------------------------------------
+	void PSSetConstants( u32 slot, const void* data, u32 size );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		バインディンググループ設定.
+	//!
+	//! @details	グループのシェーダーリソース, 定数バッファ, サンプラーステートを
+	//!				一括で設定します. 設定済みと同じグループの場合は何もしません.
+	//!				設定後に個別の設定関数でグループ内のスロットを上書きすることもできます.
+	//-----------------------------------------------------------------------
+	void PSSetBindingGroup( BindingGroup* bindingGroup );
 	//! @}
 
 	//=======================================================================
@@ -218,6 +326,7 @@ public:
 	//!	@brief		ラスタライザーステート設定.
 	//-----------------------------------------------------------------------
 	inline void RSSetRasterizerState( const RasterizerState& value );
+	inline void RSSetRasterizerState( const RasterizerStateKey& key );
 	inline void RSSetRasterizerStateFillMode( FillMode value );
 	inline void RSSetRasterizerStateCullMode( CullMode value );
 	inline void RSSetRasterizerStateFrontCounterClockwise( bool value );
@@ -253,6 +362,7 @@ public:
 	//!	@brief		ブレンドステート設定.
 	//-----------------------------------------------------------------------
 	inline void OMSetBlendState( const BlendState& state );
+	inline void OMSetBlendState( const BlendStateKey& key );
 	inline void OMSetBlendStateSampleAlphaToCoverage( bool value );
 	inline void OMSetBlendStateBlendEnable( bool value );
 	inline void OMSetBlendStateRGBSource( Blend value );
@@ -270,6 +380,7 @@ public:
 	//!	@brief		深度ステンシルステート設定.
 	//-----------------------------------------------------------------------
 	inline void OMSetDepthStencilState( const DepthStencilState& value );
+	inline void OMSetDepthStencilState( const DepthStencilStateKey& key );
 	inline void OMSetDepthStencilStateDepthEnable( bool value );
 	inline void OMSetDepthStencilStateDepthWrite( bool value );
 	inline void OMSetDepthStencilStateDepthFunc( ComparisonFunc value );
@@ -302,6 +413,8 @@ private:
 	//-----------------------------------------------------------------------
 	enum PipelineDirtyBitFlag
 	{
+		kPipelineDirtyBitFlagPipelineState,			//!< パイプラインステート.
+
 		kPipelineDirtyBitFlagIAInputLayout,			//!< IAステージ : 入力レイアウト.
 		kPipelineDirtyBitFlagIAPrimitiveType,		//!< IAステージ : プリミティブタイプ.
 		kPipelineDirtyBitFlagIAVertexBuffer,		//!< IAステージ : 頂点バッファ.
@@ -309,6 +422,7 @@ private:
 		kPipelineDirtyBitFlagIAIndexBuffer,			//!< IAステージ : インデックスバッファ.
 
 		kPipelineDirtyBitFlagVSShader,				//!< VSステージ : シェーダー.
+		kPipelineDirtyBitFlagVSBindingGroup,		//!< VSステージ : バインディンググループ.
 		kPipelineDirtyBitFlagVSShaderResource,		//!< VSステージ : シェーダーリソース.
 		kPipelineDirtyBitFlagVSShaderResourceEnd = kPipelineDirtyBitFlagVSShaderResource + kShaderResourceSlotMax - 1,
 		kPipelineDirtyBitFlagVSSamplerState,		//!< VSステージ : サンプラーステート.
@@ -317,6 +431,7 @@ private:
 		kPipelineDirtyBitFlagVSConstantBufferEnd = kPipelineDirtyBitFlagVSConstantBuffer + kShaderUniformBufferSlotMax - 1,
 
 		kPipelineDirtyBitFlagPSShader,				//!< PSステージ : シェーダー.
+		kPipelineDirtyBitFlagPSBindingGroup,		//!< PSステージ : バインディンググループ.
 		kPipelineDirtyBitFlagPSShaderResource,		//!< PSステージ : シェーダーリソース.
 		kPipelineDirtyBitFlagPSShaderResourceEnd = kPipelineDirtyBitFlagPSShaderResource + kShaderResourceSlotMax - 1,
 		kPipelineDirtyBitFlagPSSamplerState,		//!< PSステージ : サンプラーステート.
@@ -336,11 +451,75 @@ private:
 
 	using PiplineDirtyBits = std::bitset< kPipelineDirtyBitFlagNum >;
 
+	//-----------------------------------------------------------------------
+	//! @brief		一時定数.
+	//-----------------------------------------------------------------------
+	struct TransientConstants
+	{
+		Buffer*		buffer;			//!< 書き込み先バッファ(nullptrの場合は未設定).
+		u32			firstConstant;	//!< 先頭位置(16バイト単位).
+		u32			constantNum;	//!< 定数数(16バイト単位). 0の場合はバッファ全体.
+	};
+
+	//! 定数バッファオフセットのアラインメント(16バイト x 16).
+	static constexpr u32 kConstantBufferOffsetAlignment = 256;
+
 	//-----------------------------------------------------------------------
 	//!	@brief		描画パイプラインを構築.
 	//-----------------------------------------------------------------------
 	void SyncDrawPipeline();
 
+	//-----------------------------------------------------------------------
+	//!	@brief		パイプラインステートの内容が個別設定で上書きされているか.
+	//-----------------------------------------------------------------------
+	bool IsPipelineStateOverridden() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		一時定数を書き込み.
+	//!
+	//! @param[in]	fallbackBuffer	共有バッファを使用できない場合のスロット専用バッファ.
+	//-----------------------------------------------------------------------
+	bool WriteTransientConstants( const void* data, u32 size, Buffer** fallbackBuffer, TransientConstants* out );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		サンプラーステート変更時の処理.
+	//-----------------------------------------------------------------------
+	void OnVSSamplerStateChanged( u32 slot );
+	void OnPSSamplerStateChanged( u32 slot );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		レンダーステート変更時の処理.
+	//-----------------------------------------------------------------------
+	inline void OnBlendStateChanged();
+	inline void OnRasterizerStateChanged();
+	inline void OnDepthStencilStateChanged();
+	inline void OnViewportScissorStateChanged();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		保持しているステートのキーを取得.
+	//!
+	//! @note		個別設定で変更された場合のみキーを再構築します.
+	//-----------------------------------------------------------------------
+	inline const BlendStateKey& GetBlendStateKey();
+	inline const RasterizerStateKey& GetRasterizerStateKey();
+	inline const DepthStencilStateKey& GetDepthStencilStateKey();
+	inline const SamplerStateKey& GetVSSamplerStateKey( u32 slot );
+	inline const SamplerStateKey& GetPSSamplerStateKey( u32 slot );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		コマンドリストが保持する参照を記録.
+	//-----------------------------------------------------------------------
+	void Retain( RefObject* object )
+	{
+		if( _retainReferences && object ) _references.push_back( object );
+	}
+
+	//-----------------------------------------------------------------------
+	//!	@brief		統計情報を加算.
+	//-----------------------------------------------------------------------
+	void CountStateChange( CommandStats::StateType stateType )	{ ++_stats.Get( stateType ).changeCount; }
+	void CountNativeBind( CommandStats::StateType stateType )	{ ++_stats.Get( stateType ).bindCount; }
+
 	//-----------------------------------------------------------------------
 	//!	@name		メンバ変数.
 	//-----------------------------------------------------------------------
@@ -351,6 +530,18 @@ private:
 	bool					_begin;
 	PiplineDirtyBits		_pipelineDirtyBits;
 
+	// コマンドリストが保持する参照.
+	bool					_retainReferences;
+	std::vector< RefObject* >	_references;
+
+	// 統計情報.
+	CommandStats			_stats;				//!< 記録中のコマンドリスト.
+	CommandStats			_totalStats;		//!< 記録終了したコマンドリストの合計.
+
+	// パイプラインステート.
+	PipelineState*			_pipelineState;
+	PipelineStateHandle		_pipelineStateHandle;	//!< 個別設定で上書きされた場合は無効値.
+
 	// IAステージ.
 	Buffer*					_vertexBuffers[ kInputStreamsMax ];
 	u32						_vertexBufferStrides[ kInputStreamsMax ];
@@ -364,26 +555,50 @@ private:
 	Shader*					_vsShader;
 	TextureView* 			_vsShaderResources[ kShaderResourceSlotMax ];
 	Buffer*					_vsConstantBuffers[ kShaderUniformBufferSlotMax ];
+	TransientConstants		_vsTransientConstants[ kShaderUniformBufferSlotMax ];
+	Buffer*					_vsTransientConstantBuffers[ kShaderUniformBufferSlotMax ];	//!< 共有バッファを使用できない場合のスロット専用バッファ.
 	SamplerState			_vsSamplerStates[ kSamplerSlotMax ];
+	SamplerStateKey			_vsSamplerStateKeys[ kSamplerSlotMax ];
+	std::bitset< kSamplerSlotMax >	_vsSamplerStateKeyValid;	//!< キーがステートと一致しているか.
+	BindingGroup*			_vsBindingGroup;
+	bool					_vsBindingGroupOverridden;	//!< グループ内のスロットが個別設定で上書きされたか.
 
 	// PSステージ.
 	Shader*					_psShader;
 	TextureView* 			_psShaderResources[ kShaderResourceSlotMax ];
 	Buffer*					_psConstantBuffers[ kShaderUniformBufferSlotMax ];
+	TransientConstants		_psTransientConstants[ kShaderUniformBufferSlotMax ];
+	Buffer*					_psTransientConstantBuffers[ kShaderUniformBufferSlotMax ];	//!< 共有バッファを使用できない場合のスロット専用バッファ.
 	SamplerState			_psSamplerStates[ kSamplerSlotMax ];
+	SamplerStateKey			_psSamplerStateKeys[ kSamplerSlotMax ];
+	std::bitset< kSamplerSlotMax >	_psSamplerStateKeyValid;	//!< キーがステートと一致しているか.
+	BindingGroup*			_psBindingGroup;
+	bool					_psBindingGroupOverridden;	//!< グループ内のスロットが個別設定で上書きされたか.
 
 	// RSステージ.
 	RasterizerState			_rasterizerState;
+	RasterizerStateKey		_rasterizerStateKey;
+	bool					_rasterizerStateKeyValid;	//!< キーがステートと一致しているか.
 	ViewportScissorState	_viewportScissorState;
 
 	// OMステージ.
 	RenderTargetView*		_renderTargets[ kRenderTargetsSlotMax ];
 	DepthStencilView*		_depthStencil;
 	BlendState				_blendState;
+	BlendStateKey			_blendStateKey;
+	bool					_blendStateKeyValid;		//!< キーがステートと一致しているか.
 	DepthStencilState		_depthStencilState;
+	DepthStencilStateKey	_depthStencilStateKey;
+	bool					_depthStencilStateKeyValid;	//!< キーがステートと一致しているか.
+
+	// 一時定数用共有バッファ.
+	Buffer*					_transientBuffer;
+	u32						_transientOffset;
+	bool					_transientDiscarded;	//!< 記録中に書き込み破棄でマップ済みか.
 
 #ifdef AROMA_RENDER_DX11
 	ID3D11DeviceContext*	_d3dContext;
+	ID3D11DeviceContext1*	_d3dContext1;			//!< 定数バッファオフセット指定用(非対応の場合はnullptr).
 #endif
 
 	//! @}
@@ -405,122 +620,140 @@ void DeferredContext::VSSetSamplerState( u32 slot, const SamplerState& value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].Set( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
+}
+void DeferredContext::VSSetSamplerState( u32 slot, const SamplerStateKey& key )
+{
+	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
+	if( GetVSSamplerStateKey( slot ) == key ) return;
+	key.Get( &_vsSamplerStates[ slot ] );
+	OnVSSamplerStateChanged( slot );
+	_vsSamplerStateKeys[ slot ]		= key;
+	_vsSamplerStateKeyValid[ slot ]	= true;
 }
 void DeferredContext::VSSetSamplerStateFilter( u32 slot, Filter value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetFilter( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateAddressU( u32 slot, TextureAddress value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetAddressU( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateAddressV( u32 slot, TextureAddress value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetAddressV( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateAddressW( u32 slot, TextureAddress value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetAddressW( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateMipLODBias( u32 slot, f32 value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetMipLODBias( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateMaxAnisotropy( u32 slot, AnisotropicRatio value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetMaxAnisotropy( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateBorderColor( u32 slot, const data::Color& value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetBorderColor( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateMinLOD( u32 slot, f32 value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetMinLOD( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 void DeferredContext::VSSetSamplerStateMaxLOD( u32 slot, f32 value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _vsSamplerStates[ slot ].SetMaxLOD( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+		OnVSSamplerStateChanged( slot );
 }
 
 void DeferredContext::PSSetSamplerState( u32 slot, const SamplerState& value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].Set( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
+}
+void DeferredContext::PSSetSamplerState( u32 slot, const SamplerStateKey& key )
+{
+	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
+	if( GetPSSamplerStateKey( slot ) == key ) return;
+	key.Get( &_psSamplerStates[ slot ] );
+	OnPSSamplerStateChanged( slot );
+	_psSamplerStateKeys[ slot ]		= key;
+	_psSamplerStateKeyValid[ slot ]	= true;
 }
 void DeferredContext::PSSetSamplerStateFilter( u32 slot, Filter value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetFilter( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateAddressU( u32 slot, TextureAddress value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetAddressU( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateAddressV( u32 slot, TextureAddress value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetAddressV( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateAddressW( u32 slot, TextureAddress value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetAddressW( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateMipLODBias( u32 slot, f32 value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetMipLODBias( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateMaxAnisotropy( u32 slot, AnisotropicRatio value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetMaxAnisotropy( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateBorderColor( u32 slot, const data::Color& value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetBorderColor( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateMinLOD( u32 slot, f32 value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetMinLOD( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 void DeferredContext::PSSetSamplerStateMaxLOD( u32 slot, f32 value )
 {
 	__SAMPLER_SLOT_OUT_RANGE_CHECK( slot );
 	if( _psSamplerStates[ slot ].SetMaxLOD( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+		OnPSSamplerStateChanged( slot );
 }
 
 #undef __SAMPLER_SLOT_OUT_RANGE_CHECK
@@ -528,222 +761,315 @@ void DeferredContext::PSSetSamplerStateMaxLOD( u32 slot, f32 value )
 void DeferredContext::RSSetRasterizerState( const RasterizerState& value )
 {
 	if( _rasterizerState.Set( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
+}
+void DeferredContext::RSSetRasterizerState( const RasterizerStateKey& key )
+{
+	if( GetRasterizerStateKey() == key ) return;
+	key.Get( &_rasterizerState );
+	OnRasterizerStateChanged();
+	_rasterizerStateKey		= key;
+	_rasterizerStateKeyValid	= true;
 }
 void DeferredContext::RSSetRasterizerStateFillMode( FillMode value )
 {
 	if( _rasterizerState.SetFillMode( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateCullMode( CullMode value )
 {
 	if( _rasterizerState.SetCullMode( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateFrontCounterClockwise( bool value )
 {
 	if( _rasterizerState.SetFrontCounterClockwise( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateDepthBias( s32 value )
 {
 	if( _rasterizerState.SetDepthBias( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateDepthBiasClamp( f32 value )
 {
 	if( _rasterizerState.SetDepthBiasClamp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateSlopeScaledDepthBias( f32 value )
 {
 	if( _rasterizerState.SetSlopeScaledDepthBias( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateDepthClipEnable( bool value )
 {
 	if( _rasterizerState.SetDepthClipEnable( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateScissorEnable( bool value )
 {
 	if( _rasterizerState.SetScissorEnable( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateMultisampleEnable( bool value )
 {
 	if( _rasterizerState.SetMultisampleEnable( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 void DeferredContext::RSSetRasterizerStateAntialiasedLineEnable( bool value )
 {
 	if( _rasterizerState.SetAntialiasedLineEnable( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+		OnRasterizerStateChanged();
 }
 
 void DeferredContext::RSSetViewportScissorState( const ViewportScissorState& value )
 {
 	if( _viewportScissorState.Set( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSViewportScissorState ] = true;
+		OnViewportScissorStateChanged();
 }
 void DeferredContext::RSSetViewportScissorStateViewport( u32 slot, const Viewport& value )
 {
 	if( _viewportScissorState.SetViewport( slot, value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSViewportScissorState ] = true;
+		OnViewportScissorStateChanged();
 }
 void DeferredContext::RSSetViewportScissorStateScissor( u32 slot, const ScissorRect& value )
 {
 	if( _viewportScissorState.SetScissor( slot, value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSViewportScissorState ] = true;
+		OnViewportScissorStateChanged();
 }
 
 void DeferredContext::OMSetDepthStencilState( const DepthStencilState& value )
 {
 	if( _depthStencilState.Set( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
+}
+void DeferredContext::OMSetDepthStencilState( const DepthStencilStateKey& key )
+{
+	if( GetDepthStencilStateKey() == key ) return;
+	key.Get( &_depthStencilState );
+	OnDepthStencilStateChanged();
+	_depthStencilStateKey		= key;
+	_depthStencilStateKeyValid	= true;
 }
 void DeferredContext::OMSetDepthStencilStateDepthEnable( bool value )
 {
 	if( _depthStencilState.SetDepthEnable( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateDepthWrite( bool value )
 {
 	if( _depthStencilState.SetDepthWrite( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateDepthFunc( ComparisonFunc value )
 {
 	if( _depthStencilState.SetDepthFunc( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateStencilEnable( bool value )
 {
 	if( _depthStencilState.SetStencilEnable( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateStencilReadMask( u8 value )
 {
 	if( _depthStencilState.SetStencilReadMask( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateStencilWriteMask( u8 value )
 {
 	if( _depthStencilState.SetStencilWriteMask( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateFrontFaceStencilFailOp( StencilOp value )
 {
 	if( _depthStencilState.SetFrontFaceStencilFailOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateFrontFaceStencilDepthFailOp( StencilOp value )
 {
 	if( _depthStencilState.SetFrontFaceStencilDepthFailOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateFrontFaceStencilPassOp( StencilOp value )
 {
 	if( _depthStencilState.SetFrontFaceStencilPassOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateFrontFaceStencilFunc( ComparisonFunc value )
 {
 	if( _depthStencilState.SetFrontFaceStencilFunc( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateBackFaceStencilFailOp( StencilOp value )
 {
 	if( _depthStencilState.SetBackFaceStencilFailOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateBackFaceStencilDepthFailOp( StencilOp value )
 {
 	if( _depthStencilState.SetBackFaceStencilDepthFailOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateBackFaceStencilPassOp( StencilOp value )
 {
 	if( _depthStencilState.SetBackFaceStencilPassOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateBackFaceStencilFunc( ComparisonFunc value )
 {
 	if( _depthStencilState.SetBackFaceStencilFunc( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 void DeferredContext::OMSetDepthStencilStateStencilRef( u32 value )
 {
 	if( _depthStencilState.SetStencilRef( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+		OnDepthStencilStateChanged();
 }
 
 void DeferredContext::OMSetBlendState( const BlendState& value )
 {
 	if( _blendState.Set( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
+}
+void DeferredContext::OMSetBlendState( const BlendStateKey& key )
+{
+	if( GetBlendStateKey() == key ) return;
+	key.Get( &_blendState );
+	OnBlendStateChanged();
+	_blendStateKey		= key;
+	_blendStateKeyValid	= true;
 }
 void DeferredContext::OMSetBlendStateSampleAlphaToCoverage( bool value )
 {
 	if( _blendState.SetSampleAlphaToCoverage( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateBlendEnable( bool value )
 {
 	if( _blendState.SetBlendEnable( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateRGBSource( Blend value )
 {
 	if( _blendState.SetRGBSource( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateRGBDest( Blend value )
 {
 	if( _blendState.SetRGBDest( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateRGBBlendOp( BlendOp value )
 {
 	if( _blendState.SetRGBBlendOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateAlphaSource( Blend value )
 {
 	if( _blendState.SetAlphaSource( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateAlphaDest( Blend value )
 {
 	if( _blendState.SetAlphaDest( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateAlphaBlendOp( BlendOp value )
 {
 	if( _blendState.SetAlphaBlendOp( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateWriteMaskR( bool value )
 {
 	if( _blendState.SetWriteMaskR( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateWriteMaskG( bool value )
 {
 	if( _blendState.SetWriteMaskG( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateWriteMaskB( bool value )
 {
 	if( _blendState.SetWriteMaskB( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 void DeferredContext::OMSetBlendStateWriteMaskA( bool value )
 {
 	if( _blendState.SetWriteMaskA( value ) )
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+		OnBlendStateChanged();
 }
 
+void DeferredContext::OnBlendStateChanged()
+{
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = true;
+	_blendStateKeyValid = false;
+	CountStateChange( CommandStats::StateType::kBlendState );
+}
+void DeferredContext::OnRasterizerStateChanged()
+{
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = true;
+	_rasterizerStateKeyValid = false;
+	CountStateChange( CommandStats::StateType::kRasterizerState );
+}
+void DeferredContext::OnDepthStencilStateChanged()
+{
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = true;
+	_depthStencilStateKeyValid = false;
+	CountStateChange( CommandStats::StateType::kDepthStencilState );
+}
+void DeferredContext::OnViewportScissorStateChanged()
+{
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagRSViewportScissorState ] = true;
+	CountStateChange( CommandStats::StateType::kViewportScissorState );
+}
+
+const BlendStateKey& DeferredContext::GetBlendStateKey()
+{
+	if( !_blendStateKeyValid )
+	{
+		_blendStateKey.Set( _blendState );
+		_blendStateKeyValid = true;
+	}
+	return _blendStateKey;
+}
+const RasterizerStateKey& DeferredContext::GetRasterizerStateKey()
+{
+	if( !_rasterizerStateKeyValid )
+	{
+		_rasterizerStateKey.Set( _rasterizerState );
+		_rasterizerStateKeyValid = true;
+	}
+	return _rasterizerStateKey;
+}
+const DepthStencilStateKey& DeferredContext::GetDepthStencilStateKey()
+{
+	if( !_depthStencilStateKeyValid )
+	{
+		_depthStencilStateKey.Set( _depthStencilState );
+		_depthStencilStateKeyValid = true;
+	}
+	return _depthStencilStateKey;
+}
+const SamplerStateKey& DeferredContext::GetVSSamplerStateKey( u32 slot )
+{
+	if( !_vsSamplerStateKeyValid[ slot ] )
+	{
+		_vsSamplerStateKeys[ slot ].Set( _vsSamplerStates[ slot ] );
+		_vsSamplerStateKeyValid[ slot ] = true;
+	}
+	return _vsSamplerStateKeys[ slot ];
+}
+const SamplerStateKey& DeferredContext::GetPSSamplerStateKey( u32 slot )
+{
+	if( !_psSamplerStateKeyValid[ slot ] )
+	{
+		_psSamplerStateKeys[ slot ].Set( _psSamplerStates[ slot ] );
+		_psSamplerStateKeyValid[ slot ] = true;
+	}
+	return _psSamplerStateKeys[ slot ];
+}
 
 } // namespace render
 } // namespace aroma
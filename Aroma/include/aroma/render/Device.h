@@ -9,15 +9,20 @@
 //===========================================================================
 #pragma once
 
+#include <atomic>
 #include "../common/RefObject.h"
 #include "../util/NonCopyable.h"
 #include "RenderDef.h"
 #include "MemoryAllocator.h"
 #include "SwapChain.h"
 #include "DeferredContext.h"
+#include "ParallelCommandRecorder.h"
 #include "Buffer.h"
 #include "InputLayout.h"
+#include "PipelineState.h"
+#include "BindingGroup.h"
 #include "RenderStateCache.h"
+#include "CommandStats.h"
 #include "Texture.h"
 
 namespace aroma {
@@ -69,9 +74,25 @@ public:
 
 	//---------------------------------------------------------------------------
 	//!	@brief		描画コマンドリスト実行.
+	//!
+	//! @note		同じコマンドリストを複数回実行できます.
+	//!				実行前のステートは引き継がず, 実行後はステートを既定値に戻します.
 	//---------------------------------------------------------------------------
 	void ExecuteCommand( const CommandList* commandList );
 
+	//---------------------------------------------------------------------------
+	//!	@brief		複数の描画コマンドリストを配列順に実行.
+	//!
+	//!	@param[in]	count			コマンドリスト数.
+	//!	@param[in]	commandLists	コマンドリスト配列. nullptrの要素は読み飛ばします.
+	//---------------------------------------------------------------------------
+	void ExecuteCommands( u32 count, const CommandList* const* commandLists );
+
+	//---------------------------------------------------------------------------
+	//!	@brief		マルチスレッドコマンド記録作成.
+	//---------------------------------------------------------------------------
+	ParallelCommandRecorder* CreateParallelCommandRecorder( const ParallelCommandRecorder::Desc& desc );
+
 	//---------------------------------------------------------------------------
 	//! @brief		GPUバッファ作成.
 	//---------------------------------------------------------------------------
@@ -107,6 +128,16 @@ public:
 	//---------------------------------------------------------------------------
 	InputLayout* CreateInputLayout( const InputLayout::Desc& desc );
 
+	//---------------------------------------------------------------------------
+	//!	@brief		パイプラインステートを作成.
+	//---------------------------------------------------------------------------
+	PipelineState* CreatePipelineState( const PipelineState::Desc& desc );
+
+	//---------------------------------------------------------------------------
+	//!	@brief		バインディンググループを作成.
+	//---------------------------------------------------------------------------
+	BindingGroup* CreateBindingGroup( const BindingGroup::Desc& desc );
+
 	//--------------------------------------------------------------------
 	//! @brief		2Dテクスチャ作成.
 	//--------------------------------------------------------------------
@@ -114,14 +145,58 @@ public:
 
 	//--------------------------------------------------------------------
 	//! @brief		DDSデータより2Dテクスチャ作成.
+	//!
+	//!	@param[in]	firstMip	作成する最も詳細なミップレベル(それより詳細なミップは読み込みません).
+	//!
+	//! @note		イメージデータはDDSデータから直接初期データとして渡すため,
+	//!				file::MappedFileのマップ先を指定するとヒープへのコピーを行いません.
+	//!				DDSデータは呼び出し中のみ有効であれば構いません.
+	//!				GPUが直接扱えない旧形式(R8G8B8, R5G6B5, L8等)はR8G8B8A8へ変換して作成します.
+	//!				この変換は呼び出しスレッドのみで行うため, 大きなテクスチャは
+	//!				事前にdata::ConvertLegacyDDS()でスケジューラーを指定して変換して下さい.
 	//--------------------------------------------------------------------
-	Texture* CreateTexture2DFromDDS( const data::DDSAccessor& dds, Usage usage, u32 bindFlags, u32 flags );
+	Texture* CreateTexture2DFromDDS( const data::DDSAccessor& dds, Usage usage, u32 bindFlags, u32 flags, u32 firstMip = 0 );
 
 	//---------------------------------------------------------------------------
 	//! @brief		レンダーステートキャッシュの取得.
 	//---------------------------------------------------------------------------
 	RenderStateCache* GetRenderStateCache();
 
+	//---------------------------------------------------------------------------
+	//! @brief		レンダーステートキャッシュ統計情報の取得.
+	//!
+	//!	@param[out]	outStats	統計情報格納先.
+	//!	@param[in]	reset		trueの場合はカウンターをリセット(フレーム末での呼び出しを想定).
+	//---------------------------------------------------------------------------
+	void GetRenderStateCacheStats( RenderStateCache::Stats* outStats, bool reset );
+
+	//---------------------------------------------------------------------------
+	//! @brief		フレーム統計情報の取得.
+	//!
+	//!	@param[out]	outStats	ExecuteCommand()等で実行したコマンドリストの統計情報の合計.
+	//!	@param[in]	reset		trueの場合はカウンターをリセット(フレーム末での呼び出しを想定).
+	//!
+	//! @note		再実行したコマンドリストは実行回数分加算されます.
+	//!				コマンドリストの実行と同じスレッドから呼び出して下さい.
+	//---------------------------------------------------------------------------
+	void GetFrameStats( CommandStats* outStats, bool reset );
+
+	//---------------------------------------------------------------------------
+	//! @brief		コマンドリスト生成を通知.
+	//!
+	//! @note		DeferredContext::End()で呼び出されるため, 基本的にコールする必要はありません.
+	//!				複数スレッドから同時に呼び出すことができます.
+	//---------------------------------------------------------------------------
+	void NotifyCommandListCreated();
+
+	//---------------------------------------------------------------------------
+	//! @brief		定数バッファのオフセット指定設定に対応しているか.
+	//!
+	//! @note		対応している場合, DeferredContextの一時定数は1つの共有バッファから
+	//!				切り出して設定されます.
+	//---------------------------------------------------------------------------
+	bool IsConstantBufferOffsetSupported() const;
+
 	//---------------------------------------------------------------------------
 	//!	@brief		ネイティブAPIデバイスの取得.
 	//---------------------------------------------------------------------------
@@ -139,12 +214,15 @@ public:
 private:
 	bool					_initialized;
 	RenderStateCache		_renderStateCache;
+	CommandStats			_frameStats;
+	std::atomic< u64 >		_commandListCreateCount;
 
 #ifdef AROMA_RENDER_DX11
 	ID3D11Device*			_d3dDevice;
 	IDXGIFactory*			_d3dFactory;
 	ID3D11DeviceContext*	_d3dImmediateContext;
 	D3D_FEATURE_LEVEL		_d3dFeatureLevel;
+	bool					_constantBufferOffsetSupported;
 #endif
 };
 
@@ -0,0 +1,202 @@
+﻿//===========================================================================
+//!
+//!	@file		ParallelCommandRecorder.h
+//!	@brief		マルチスレッドコマンド記録.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "RenderDef.h"
+#include "MemoryAllocator.h"
+#include "../common/RefObject.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace render {
+
+class Device;
+class DeferredContext;
+class CommandList;
+
+//---------------------------------------------------------------------------
+//!	@brief		マルチスレッドコマンド記録.
+//!
+//! @details
+//!		スレッド毎に遅延コンテキストを保持し, 複数の記録関数を並列に実行します.
+//!		生成されたコマンドリストは呼び出し側が指定した順序でデバイスに投入されます.
+//!
+//!		記録関数内ではBuffer::Map()(イミディエイトコンテキスト使用)ではなく
+//!		DeferredContext::Map()を使用して下さい.
+//---------------------------------------------------------------------------
+class ParallelCommandRecorder final : public RefObject, public MemoryAllocator, private util::NonCopyable< ParallelCommandRecorder >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		記録関数.
+	//!	@param[in]	context		記録先遅延コンテキスト(Begin済み).
+	//!	@param[in]	taskIndex	タスク番号.
+	//-----------------------------------------------------------------------
+	using RecordFunc = std::function< void( DeferredContext* context, u32 taskIndex ) >;
+
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		u32		threadCount;	//!< 記録スレッド数(同時に記録できるタスクの最大数).
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			threadCount	= 4;
+		}
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		スレッド別統計情報.
+	//-----------------------------------------------------------------------
+	struct ThreadStats
+	{
+		u32		taskIndex;		//!< 直近に記録したタスク番号(未使用時はAROMA_UINT32_MAX).
+		u32		submitIndex;	//!< 直近のコマンドリスト投入順.
+		u64		waitTimeUs;		//!< 記録開始要求から記録開始までの時間(マイクロ秒).
+		u64		recordTimeUs;	//!< 記録関数の実行時間(マイクロ秒).
+		u64		finishTimeUs;	//!< コマンドリスト生成時間(マイクロ秒).
+		u64		recordCount;	//!< 累計記録回数.
+
+		//-------------------------------------------------------------------
+		ThreadStats(){ Default(); }
+		void Default()
+		{
+			taskIndex		= AROMA_UINT32_MAX;
+			submitIndex		= AROMA_UINT32_MAX;
+			waitTimeUs		= 0;
+			recordTimeUs	= 0;
+			finishTimeUs	= 0;
+			recordCount		= 0;
+		}
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		フレーム統計情報.
+	//-----------------------------------------------------------------------
+	struct FrameStats
+	{
+		u32		taskCount;		//!< 記録タスク数.
+		u64		recordTimeUs;	//!< 全タスクの記録完了までの時間(マイクロ秒).
+		u64		submitTimeUs;	//!< コマンドリスト投入時間(マイクロ秒).
+
+		//-------------------------------------------------------------------
+		FrameStats(){ Default(); }
+		void Default()
+		{
+			taskCount		= 0;
+			recordTimeUs	= 0;
+			submitTimeUs	= 0;
+		}
+	};
+
+public:
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//-----------------------------------------------------------------------
+	ParallelCommandRecorder();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		デストラクタ.
+	//-----------------------------------------------------------------------
+	virtual ~ParallelCommandRecorder();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		初期化.
+	//-----------------------------------------------------------------------
+	void Initialize( Device* device, const Desc& desc );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		解放.
+	//-----------------------------------------------------------------------
+	void Finalize();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		並列記録してデバイスへ投入.
+	//!
+	//!	@param[in]	taskCount	記録タスク数(スレッド数以下).
+	//!	@param[in]	tasks		記録関数配列. tasks[ i ]はスレッドiで記録されます.
+	//!	@param[in]	submitOrder	投入順のタスク番号配列. nullptrの場合はタスク番号順.
+	//!
+	//! @note		全タスクの記録と投入が完了するまで戻りません.
+	//!				投入はこの関数を呼び出したスレッドで行われます.
+	//-----------------------------------------------------------------------
+	void Execute( u32 taskCount, const RecordFunc* tasks, const u32* submitOrder = nullptr );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		記録スレッド数取得.
+	//-----------------------------------------------------------------------
+	u32 GetThreadCount() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		スレッド別統計情報取得.
+	//-----------------------------------------------------------------------
+	const ThreadStats& GetThreadStats( u32 threadIndex ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		直近フレームの統計情報取得.
+	//-----------------------------------------------------------------------
+	const FrameStats& GetFrameStats() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		遅延コンテキスト取得.
+	//-----------------------------------------------------------------------
+	DeferredContext* GetContext( u32 threadIndex ) const;
+
+private:
+	//-----------------------------------------------------------------------
+	//!	@brief		記録スレッド.
+	//-----------------------------------------------------------------------
+	struct Worker
+	{
+		std::thread			thread;
+		DeferredContext*	context;
+		CommandList*		commandList;
+		ThreadStats			stats;
+
+		Worker()
+			: context( nullptr )
+			, commandList( nullptr )
+		{
+		}
+	};
+
+	//-----------------------------------------------------------------------
+	//!	@brief		記録スレッドメイン.
+	//-----------------------------------------------------------------------
+	void WorkerMain( u32 threadIndex );
+
+	bool					_initialized;
+	Device*					_device;
+	Desc					_desc;
+	Worker*					_workers;
+	FrameStats				_frameStats;
+
+	// スレッド間共有.
+	std::mutex				_mutex;
+	std::condition_variable	_startCondition;
+	std::condition_variable	_doneCondition;
+	const RecordFunc*		_tasks;
+	u32						_taskCount;
+	u32						_pendingCount;
+	u64						_generation;
+	u64						_requestTimeUs;
+	bool					_quit;
+};
+
+} // namespace render
+} // namespace aroma
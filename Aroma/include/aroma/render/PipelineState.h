@@ -0,0 +1,144 @@
+﻿//===========================================================================
+//!
+//!	@file		PipelineState.h
+//!	@brief		パイプラインステート.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include "RenderDef.h"
+#include "MemoryAllocator.h"
+#include "BlendState.h"
+#include "RasterizerState.h"
+#include "DepthStencilState.h"
+#include "../common/RefObject.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace render {
+
+class Device;
+class Shader;
+class InputLayout;
+
+//---------------------------------------------------------------------------
+//!	@brief		パイプラインステートハンドル.
+//!
+//! @details	構成内容から計算した64bitハッシュ値です.
+//!				同じ構成のパイプラインステートは同じハンドルになります.
+//---------------------------------------------------------------------------
+using PipelineStateHandle = u64;
+
+//! 無効なパイプラインステートハンドル.
+constexpr PipelineStateHandle kInvalidPipelineStateHandle = 0;
+
+#ifdef AROMA_RENDER_DX11
+//---------------------------------------------------------------------------
+//!	@brief		ネイティブAPIパイプラインステート.
+//---------------------------------------------------------------------------
+struct D3D11_PIPELINE_STATE
+{
+	ID3D11InputLayout*			inputLayout;
+	D3D11_PRIMITIVE_TOPOLOGY	primitiveTopology;
+	ID3D11VertexShader*			vertexShader;
+	ID3D11PixelShader*			pixelShader;
+	ID3D11RasterizerState*		rasterizerState;
+	ID3D11BlendState*			blendState;
+	ID3D11DepthStencilState*	depthStencilState;
+};
+using NativePipelineState = D3D11_PIPELINE_STATE;
+#endif
+
+//---------------------------------------------------------------------------
+//!	@brief		パイプラインステート.
+//!
+//! @details
+//!		シェーダー, 入力レイアウト, プリミティブタイプ, 各レンダーステートを
+//!		作成時に1度だけネイティブステートへ解決して保持する不変オブジェクトです.
+//!		DeferredContext::SetPipelineState()の1回の呼び出しで全て設定でき,
+//!		描画時はハンドル比較と数回のネイティブAPI呼び出しのみになります.
+//---------------------------------------------------------------------------
+class PipelineState : public RefObject, public MemoryAllocator, private util::NonCopyable< PipelineState >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		Shader*				vertexShader;		//!< 頂点シェーダー.
+		Shader*				pixelShader;		//!< ピクセルシェーダー.
+		InputLayout*		inputLayout;		//!< 入力レイアウト.
+		PrimitiveType		primitiveType;		//!< プリミティブタイプ.
+		BlendState			blendState;			//!< ブレンドステート.
+		RasterizerState		rasterizerState;	//!< ラスタライザーステート.
+		DepthStencilState	depthStencilState;	//!< 深度ステンシルステート.
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			vertexShader		= nullptr;
+			pixelShader			= nullptr;
+			inputLayout			= nullptr;
+			primitiveType		= PrimitiveType::kTriangleList;
+			blendState.Default();
+			rasterizerState.Default();
+			depthStencilState.Default();
+		}
+	};
+
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		コンストラクタ.
+	//-----------------------------------------------------------------------
+	PipelineState();
+
+	//-----------------------------------------------------------------------
+	//! @brief		デストラクタ.
+	//-----------------------------------------------------------------------
+	virtual ~PipelineState();
+
+	//-----------------------------------------------------------------------
+	//! @brief		初期化.
+	//-----------------------------------------------------------------------
+	void Initialize( Device* device, const Desc& desc );
+
+	//-----------------------------------------------------------------------
+	//! @brief		解放.
+	//-----------------------------------------------------------------------
+	void Finalize();
+
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定取得.
+	//-----------------------------------------------------------------------
+	const Desc& GetDesc() const;
+
+	//-----------------------------------------------------------------------
+	//! @brief		ハンドル取得.
+	//-----------------------------------------------------------------------
+	PipelineStateHandle GetHandle() const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ネイティブAPIパイプラインステートの取得.
+	//-----------------------------------------------------------------------
+#ifdef AROMA_RENDER_DX11
+	const NativePipelineState& GetNativePipelineState() const;
+#endif
+
+private:
+	bool					_initialized;
+	Device*					_device;
+	Desc					_desc;
+	PipelineStateHandle		_handle;
+
+#ifdef AROMA_RENDER_DX11
+	NativePipelineState		_nativePipelineState;
+#endif
+};
+
+} // namespace render
+} // namespace aroma
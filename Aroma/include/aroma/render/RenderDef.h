@@ -17,6 +17,7 @@
 //! @{
 #ifdef AROMA_RENDER_DX11
 #include <d3d11.h>
+#include <d3d11_1.h>
 #endif
 //! @}
 
@@ -0,0 +1,246 @@
+﻿//===========================================================================
+//!
+//!	@file		RenderQueue.h
+//!	@brief		描画キュー.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <atomic>
+#include "RenderDef.h"
+#include "MemoryAllocator.h"
+#include "PipelineState.h"
+#include "../common/RefObject.h"
+#include "../common/Scheduler.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace render {
+
+class DeferredContext;
+class Buffer;
+class TextureView;
+class BindingGroup;
+
+//---------------------------------------------------------------------------
+//!	@brief		描画ソートキー.
+//!
+//! @details
+//!		64bitの描画ソートキーを構築します. キーの小さい順に描画されます.
+//!
+//!		不透明 : [63-56]レイヤー [55-32]パイプラインステート [31-16]テクスチャ [15-0]深度(手前から).
+//!		半透明 : [63-56]レイヤー [55-40]深度(奥から) [39-16]パイプラインステート [15-0]テクスチャ.
+//---------------------------------------------------------------------------
+struct DrawSortKey final
+{
+	static constexpr u32 kLayerBits		= 8;
+	static constexpr u32 kPipelineBits	= 24;
+	static constexpr u32 kTextureBits	= 16;
+	static constexpr u32 kDepthBits		= 16;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		不透明描画用キー作成.
+	//!	@param[in]	layer		レイヤー(描画パス等).
+	//!	@param[in]	pipeline	パイプラインステートハンドル.
+	//!	@param[in]	texture		テクスチャID(GetTextureId()).
+	//!	@param[in]	depth		正規化深度[0, 1].
+	//-----------------------------------------------------------------------
+	static u64 MakeOpaque( u32 layer, PipelineStateHandle pipeline, u32 texture, f32 depth );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		半透明描画用キー作成.
+	//-----------------------------------------------------------------------
+	static u64 MakeTranslucent( u32 layer, f32 depth, PipelineStateHandle pipeline, u32 texture );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		テクスチャID取得.
+	//-----------------------------------------------------------------------
+	static u32 GetTextureId( const TextureView* texture );
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		描画パケット.
+//!
+//! @details
+//!		nullptrの項目(インデックスバッファを除く)は遅延コンテキストへ設定せず,
+//!		直前に記録されたパケットの設定を引き継ぎます. ソート後の直前のパケットは
+//!		投入順と一致しないため, シェーダーが使用するスロットは全てのパケットで指定して下さい.
+//!		パケット間で共通の設定はExecute()の前に遅延コンテキストへ設定しておくこともできます.
+//!
+//! @note		参照するオブジェクトの参照カウントは増やしません.
+//!				RenderQueue::Execute()まで解放しないで下さい.
+//---------------------------------------------------------------------------
+struct DrawPacket
+{
+	static constexpr u32 kShaderResourcesMax = 4;	//!< PSシェーダーリソース数.
+
+	PipelineState*	pipelineState;									//!< パイプラインステート(nullptrの場合は変更しない).
+	Buffer*			vertexBuffer;									//!< 頂点バッファ(ストリーム0. nullptrの場合は変更しない).
+	u32				vertexStride;									//!< 頂点ストライド.
+	u32				vertexOffset;									//!< 頂点オフセット.
+	Buffer*			indexBuffer;									//!< インデックスバッファ(nullptrの場合は非インデックス描画).
+	u32				indexOffset;									//!< インデックスオフセット.
+	Buffer*			vsConstantBuffer;								//!< VS定数バッファ(スロット0. nullptrの場合は変更しない).
+	Buffer*			psConstantBuffer;								//!< PS定数バッファ(スロット0. nullptrの場合は変更しない).
+	BindingGroup*	psBindingGroup;									//!< PSバインディンググループ(マテリアル. nullptrの場合は変更しない).
+	TextureView*	psShaderResources[ kShaderResourcesMax ];		//!< PSシェーダーリソース(nullptrのスロットは変更しない).
+	u32				count;											//!< 頂点数 or インデックス数.
+	u32				start;											//!< 先頭の頂点番号 or インデックス番号.
+	u32				baseVertex;										//!< インデックスに加算する値.
+
+	//-----------------------------------------------------------------------
+	DrawPacket(){ Default(); }
+	void Default()
+	{
+		pipelineState		= nullptr;
+		vertexBuffer		= nullptr;
+		vertexStride		= 0;
+		vertexOffset		= 0;
+		indexBuffer			= nullptr;
+		indexOffset			= 0;
+		vsConstantBuffer	= nullptr;
+		psConstantBuffer	= nullptr;
+		psBindingGroup		= nullptr;
+		for( auto& srv : psShaderResources )
+		{
+			srv = nullptr;
+		}
+		count				= 0;
+		start				= 0;
+		baseVertex			= 0;
+	}
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		描画キュー.
+//!
+//! @details
+//!		ソートキー付きの描画パケットを受け付け, Sort()でキー順に並べ替えた後,
+//!		Execute()で遅延コンテキストへ記録します.
+//!		呼び出し順に関わらず同じステートの描画がまとまるため,
+//!		ステート設定は連続する描画毎に1回になります.
+//!
+//!		ソートはLSD基数ソート(8bit x 8パス)で, スケジューラー指定時は
+//!		ワーカースレッドで分割して実行します. 同じキーの描画は投入順が保たれます.
+//!
+//! @code
+//!	queue->Submit( DrawSortKey::MakeOpaque( 0, pso->GetHandle(), DrawSortKey::GetTextureId( srv ), depth ), packet );
+//!	queue->Sort();
+//!	queue->Execute( context );
+//!	queue->Clear();
+//! @endcode
+//---------------------------------------------------------------------------
+class RenderQueue : public RefObject, public MemoryAllocator, private util::NonCopyable< RenderQueue >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		u32				packetCapacity;		//!< 最大パケット数.
+		IScheduler*		scheduler;			//!< ソートを行うスケジューラー(nullptrの場合は呼び出しスレッドのみ).
+		u32				parallelThreshold;	//!< 並列ソートするパケット数の下限.
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			packetCapacity		= 4096;
+			scheduler			= nullptr;
+			parallelThreshold	= 4096;
+		}
+	};
+
+public:
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//-----------------------------------------------------------------------
+	RenderQueue();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		デストラクタ.
+	//-----------------------------------------------------------------------
+	virtual ~RenderQueue();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		初期化.
+	//-----------------------------------------------------------------------
+	void Initialize( const Desc& desc );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		解放.
+	//-----------------------------------------------------------------------
+	void Finalize();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		パケット投入.
+	//!
+	//! @return		最大パケット数を超えた場合はfalse.
+	//! @note		複数スレッドから同時に呼び出すことができます.
+	//-----------------------------------------------------------------------
+	bool Submit( u64 sortKey, const DrawPacket& packet );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ソートキー順に並べ替え.
+	//!
+	//! @pre		全スレッドのSubmit()が完了していること.
+	//-----------------------------------------------------------------------
+	void Sort();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		並べ替えたパケットを遅延コンテキストへ記録.
+	//!
+	//! @note		サンプラーステート, ビューポート, レンダーターゲットは
+	//!				呼び出し前に遅延コンテキストへ設定して下さい.
+	//!				パケットのnullptrの項目はパケット間でリセットされず, 直前の設定を引き継ぎます(DrawPacket参照).
+	//-----------------------------------------------------------------------
+	void Execute( DeferredContext* context ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		全パケット破棄.
+	//-----------------------------------------------------------------------
+	void Clear();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		パケット数取得.
+	//-----------------------------------------------------------------------
+	u32 GetPacketCount() const;
+
+private:
+	//! 並列ソートの最大分割数.
+	static constexpr u32 kSortChunkMax	= 16;
+
+	//! 基数(8bit).
+	static constexpr u32 kRadix			= 256;
+
+	//-----------------------------------------------------------------------
+	//	ソート要素.
+	//-----------------------------------------------------------------------
+	struct SortEntry
+	{
+		u64		key;
+		u32		index;
+		u32		padding;
+	};
+
+	//-----------------------------------------------------------------------
+	//!	@brief		分割した範囲毎に関数を実行.
+	//-----------------------------------------------------------------------
+	template< typename F >
+	void ParallelFor( u32 chunkCount, F func );
+
+	bool					_initialized;
+	Desc					_desc;
+	DrawPacket*				_packets;
+	SortEntry*				_entries;			//!< ソート済み要素(Sort()後).
+	SortEntry*				_sortBuffer;		//!< ソート作業領域.
+	std::atomic< u32 >		_packetCount;
+	u32						_histograms[ kSortChunkMax ][ kRadix ];
+};
+
+} // namespace render
+} // namespace aroma
@@ -10,6 +10,9 @@
 #pragma once
 
 #include <unordered_map>
+#include <list>
+#include <vector>
+#include <atomic>
 #include "RenderDef.h"
 #include "MemoryAllocator.h"
 #include "BlendState.h"
@@ -17,8 +20,10 @@
 #include "DepthStencilState.h"
 #include "SamplerState.h"
 #include "ViewportScissorState.h"
+#include "../common/SyncObject.h"
 #include "../util/NonCopyable.h"
 #include "../data/CRC.h"
+#include "../common/Task.h"
 
 namespace aroma {
 namespace render {
@@ -27,6 +32,7 @@ namespace render {
 
 struct D3D11_VIEWPORT_SCISSOR
 {
+	u32				count;		//!< 有効スロット数.
 	D3D11_VIEWPORT	viewport[ kViewportsSlotMax ];
 	D3D11_RECT		scissor[ kViewportsSlotMax ];
 };
@@ -59,11 +65,20 @@ struct BlendStateKey final
 	u32	colorMaskB				: 1;	//!< boolean
 	u32	colorMaskA				: 1;	//!< boolean
 
+	BlendStateKey();
 	BlendStateKey( const BlendState& state );
 	void Set( const BlendState& state );
+	void Get( BlendState* outState ) const;
 };
-bool operator==( const BlendStateKey& lhs, const BlendStateKey& rhs );
-bool operator!=( const BlendStateKey& lhs, const BlendStateKey& rhs );
+inline bool operator==( const BlendStateKey& lhs, const BlendStateKey& rhs )
+{
+	// 固定長のためmemcmpは整数比較に展開される.
+	return memcmp( &lhs, &rhs, sizeof( BlendStateKey ) ) == 0;
+}
+inline bool operator!=( const BlendStateKey& lhs, const BlendStateKey& rhs )
+{
+	return !( lhs == rhs );
+}
 
 //---------------------------------------------------------------------------
 //!	@brief		ラスタライザーステートハッシュキー.
@@ -83,11 +98,19 @@ struct RasterizerStateKey final
 	u32 multisampleEnable		: 1;	//!< bool
 	u32 antialiasedLineEnable	: 1;	//!< bool
 
+	RasterizerStateKey();
 	RasterizerStateKey( const RasterizerState& state );
 	void Set( const RasterizerState& state );
+	void Get( RasterizerState* outState ) const;
 };
-bool operator==( const RasterizerStateKey& lhs, const RasterizerStateKey& rhs );
-bool operator!=( const RasterizerStateKey& lhs, const RasterizerStateKey& rhs );
+inline bool operator==( const RasterizerStateKey& lhs, const RasterizerStateKey& rhs )
+{
+	return memcmp( &lhs, &rhs, sizeof( RasterizerStateKey ) ) == 0;
+}
+inline bool operator!=( const RasterizerStateKey& lhs, const RasterizerStateKey& rhs )
+{
+	return !( lhs == rhs );
+}
 
 //---------------------------------------------------------------------------
 //!	@brief		深度ステンシルステートハッシュキー.
@@ -113,11 +136,19 @@ struct DepthStencilStateKey final
 	u32 stencilReadMask				: 8;	//!< u8
 	u32 stencilWriteMask			: 8;	//!< u8
 
+	DepthStencilStateKey();
 	DepthStencilStateKey( const DepthStencilState& state );
 	void Set( const DepthStencilState& state );
+	void Get( DepthStencilState* outState ) const;
 };
-bool operator==( const DepthStencilStateKey& lhs, const DepthStencilStateKey& rhs );
-bool operator!=( const DepthStencilStateKey& lhs, const DepthStencilStateKey& rhs );
+inline bool operator==( const DepthStencilStateKey& lhs, const DepthStencilStateKey& rhs )
+{
+	return memcmp( &lhs, &rhs, sizeof( DepthStencilStateKey ) ) == 0;
+}
+inline bool operator!=( const DepthStencilStateKey& lhs, const DepthStencilStateKey& rhs )
+{
+	return !( lhs == rhs );
+}
 
 //---------------------------------------------------------------------------
 //!	@brief		サンプラーステートハッシュキー.
@@ -136,22 +167,48 @@ struct SamplerStateKey final
 	u32	addressW		: 3;	//!< TextureAddress
 	u32	maxAnisotropy	: 3;	//!< AnisotropicRatio
 
+	SamplerStateKey();
 	SamplerStateKey( const SamplerState& state );
 	void Set( const SamplerState& state );
+	void Get( SamplerState* outState ) const;
 };
-bool operator==( const SamplerStateKey& lhs, const SamplerStateKey& rhs );
-bool operator!=( const SamplerStateKey& lhs, const SamplerStateKey& rhs );
+inline bool operator==( const SamplerStateKey& lhs, const SamplerStateKey& rhs )
+{
+	return memcmp( &lhs, &rhs, sizeof( SamplerStateKey ) ) == 0;
+}
+inline bool operator!=( const SamplerStateKey& lhs, const SamplerStateKey& rhs )
+{
+	return !( lhs == rhs );
+}
 
 //---------------------------------------------------------------------------
 //!	@brief		ビューポートシザーステートハッシュキー.
+//!
+//! @details
+//!		既定値以外が設定されている最後のスロットまでを有効スロットとし,
+//!		ハッシュと比較は有効スロット数と有効スロットのみで行います.
+//!		無効スロットは常に0クリアされています.
 //---------------------------------------------------------------------------
 struct ViewportScissorStateKey final
 {
-	Viewport	viewport[ kViewportsSlotMax ];
-	ScissorRect	scissor[ kViewportsSlotMax ];
+	struct Slot
+	{
+		Viewport	viewport;
+		ScissorRect	scissor;
+	};
 
+	u32			activeCount;				//!< 有効スロット数(1以上).
+	Slot		slot[ kViewportsSlotMax ];
+
+	ViewportScissorStateKey();
 	ViewportScissorStateKey( const ViewportScissorState& state );
 	void Set( const ViewportScissorState& state );
+
+	//! ハッシュ対象のバイトサイズ(有効スロット数と有効スロット).
+	size_t GetActiveBytes() const
+	{
+		return offsetof( ViewportScissorStateKey, slot ) + sizeof( Slot ) * activeCount;
+	}
 };
 bool operator==( const ViewportScissorStateKey& lhs, const ViewportScissorStateKey& rhs );
 bool operator!=( const ViewportScissorStateKey& lhs, const ViewportScissorStateKey& rhs );
@@ -220,7 +277,7 @@ struct hash< aroma::render::ViewportScissorStateKey >
 {
 	size_t operator()( const aroma::render::ViewportScissorStateKey& key ) const noexcept
 	{
-		return aroma::data::CRC::GetCRC( &key, sizeof( key ) );
+		return aroma::data::CRC::GetCRC( &key, static_cast< aroma::u32 >( key.GetActiveBytes() ) );
 	}
 };
 
@@ -231,9 +288,92 @@ namespace aroma {
 namespace render {
 //---------------------------------------------------------------------------
 //!	@brief		レンダーステートキャッシュ.
+//!
+//! @note		複数の記録スレッドから同時に参照されるため, 取得処理はスレッドセーフです.
 //---------------------------------------------------------------------------
 class RenderStateCache final : public MemoryAllocator, private util::NonCopyable< RenderStateCache >
 {
+public:
+	//! ステートの想定最大数.
+	static constexpr u32 kStatesMax						= 4096;
+
+	//! ビューポートシザーステートの最大キャッシュ数.
+	static constexpr u32 kViewportScissorStatesMax		= 64;
+
+	//! ビューポートシザーステートのキャッシュ候補として記憶するキー数.
+	static constexpr u32 kViewportScissorCandidatesMax	= 32;
+
+	//! ネイティブステート生成時間ヒストグラムの区間数.
+	static constexpr u32 kCreateTimeHistogramMax		= 8;
+
+	//-----------------------------------------------------------------------
+	//! @brief		ステート種別.
+	//-----------------------------------------------------------------------
+	enum class StateType
+	{
+		kBlend,
+		kRasterizer,
+		kDepthStencil,
+		kSampler,
+		kViewportScissor,
+		kNum,
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		ステート種別毎の統計情報.
+	//-----------------------------------------------------------------------
+	struct TypeStats
+	{
+		u64		lookupCount;	//!< 取得回数.
+		u64		hitCount;		//!< キャッシュヒット回数.
+		u64		missCount;		//!< キャッシュミス回数.
+		u64		createTimeUs;	//!< ネイティブステート生成時間の合計(マイクロ秒).
+
+		//! ネイティブステート生成時間の分布.
+		//! 区間iは[4^(i-1), 4^i)マイクロ秒(区間0は1マイクロ秒未満, 最後の区間は上限無し).
+		u64		createTimeHistogram[ kCreateTimeHistogramMax ];
+
+		u32		currentCount;	//!< 現在のキャッシュ数.
+		u32		peakCount;		//!< 最大キャッシュ数(リセットされません).
+		u32		capacity;		//!< 想定最大数(kStatesMax or kViewportScissorStatesMax).
+
+		//-------------------------------------------------------------------
+		TypeStats(){ Default(); }
+		void Default()
+		{
+			lookupCount		= 0;
+			hitCount		= 0;
+			missCount		= 0;
+			createTimeUs	= 0;
+			for( auto& count : createTimeHistogram )
+			{
+				count = 0;
+			}
+			currentCount	= 0;
+			peakCount		= 0;
+			capacity		= 0;
+		}
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		統計情報.
+	//-----------------------------------------------------------------------
+	struct Stats
+	{
+		TypeStats	type[ static_cast< u32 >( StateType::kNum ) ];	//!< StateType順.
+
+		//-------------------------------------------------------------------
+		Stats(){ Default(); }
+		void Default()
+		{
+			for( auto& stats : type )
+			{
+				stats.Default();
+			}
+		}
+		const TypeStats& Get( StateType stateType ) const { return type[ static_cast< u32 >( stateType ) ]; }
+	};
+
 public:
 	//-----------------------------------------------------------------------
 	//!	@brief		コンストラクタ.
@@ -267,13 +407,129 @@ public:
 
 	//-----------------------------------------------------------------------
 	//!	@brief		ネイティブAPIビューポートシザーステート取得.
+	//!
+	//!	@param[in]	key			キー.
+	//!	@param[out]	outState	ネイティブステート格納先(有効スロットのみ設定されます).
+	//!
+	//! @details
+	//!		キャッシュは最大kViewportScissorStatesMax個で, 超えた場合は最も古いものを破棄します.
+	//!		直近に1度も使用されていないキーは一時的なものとしてキャッシュせず, 直接変換します.
+	//!		破棄されたステートを参照しないよう, 結果は呼び出し側へコピーして返します.
 	//-----------------------------------------------------------------------
-	NativeViewportScissorState* GetNativeViewportScissorState( const ViewportScissorStateKey& key );
+	void GetNativeViewportScissorState( const ViewportScissorStateKey& key, NativeViewportScissorState* outState );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		キャッシュ済みキーのシリアライズ.
+	//!
+	//!	@param[out]	outData		シリアライズデータ格納先.
+	//!
+	//! @details
+	//!		全ステートのキーをバージョン付きバイナリに変換します.
+	//!		ネイティブオブジェクトは含まれないため, Prewarm()で再生成して下さい.
+	//-----------------------------------------------------------------------
+	void Serialize( std::vector< u8 >* outData ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		シリアライズデータからネイティブステートを事前生成.
+	//!
+	//!	@param[in]	data		Serialize()で作成したデータ.
+	//!	@param[in]	dataBytes	データサイズ.
+	//!
+	//! @retval		true	: 事前生成成功.
+	//! @retval		false	: データ不正またはバージョン不一致.
+	//!
+	//! @note		ネイティブステート生成はスレッドセーフなため, ワーカースレッドから呼び出せます.
+	//-----------------------------------------------------------------------
+	bool Prewarm( const void* data, size_t dataBytes );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		キャッシュ済みキーをファイルへ保存.
+	//-----------------------------------------------------------------------
+	bool SaveToFile( CTStr filePath ) const;
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ファイルからネイティブステートを事前生成.
+	//-----------------------------------------------------------------------
+	bool PrewarmFromFile( CTStr filePath );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ファイルからネイティブステートを非同期に事前生成.
+	//!
+	//!	@param[in]	filePath	ファイルのパス(内部でコピーします).
+	//!	@param[in]	scheduler	読み込みと生成を実行するスケジューラー.
+	//!
+	//! @return		PrewarmFromFile()の結果を返すタスク.
+	//!
+	//! @note		タスク完了までデバイスを解放しないで下さい.
+	//-----------------------------------------------------------------------
+	Task< bool > PrewarmFromFileAsync( CTStr filePath, IScheduler* scheduler );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		統計情報取得.
+	//!
+	//!	@param[out]	outStats	統計情報格納先.
+	//!	@param[in]	reset		trueの場合は取得回数等のカウンターをリセット.
+	//!
+	//! @details
+	//!		カウンターはスレッド別に記録され, 取得時に集計されます.
+	//!		毎フレーム末にreset = trueで取得するとフレーム単位の統計になります.
+	//!		毎フレームミスし続ける種別は, ステートが毎フレーム変化している
+	//!		(例: mipLODBiasのアニメーション)可能性があります.
+	//-----------------------------------------------------------------------
+	void GetStats( Stats* outStats, bool reset );
+
+private:
+	//! 統計カウンターのスロット数(スレッド毎に割り当て).
+	static constexpr u32 kStatsSlotMax = 8;
+
+	//-----------------------------------------------------------------------
+	//	統計カウンター.
+	//-----------------------------------------------------------------------
+	struct StatsCounter
+	{
+		std::atomic< u64 >	lookupCount;
+		std::atomic< u64 >	hitCount;
+		std::atomic< u64 >	createTimeUs;
+		std::atomic< u64 >	createTimeHistogram[ kCreateTimeHistogramMax ];
+	};
+	struct StatsSlot
+	{
+		StatsCounter		counter[ static_cast< u32 >( StateType::kNum ) ];
+		u8					_pad[ kCacheLineSize ];		// 別スロットとのフォルスシェアリング回避.
+	};
 
 private:
 	RenderStateCache();
 
-	Device* _device;
+	//-----------------------------------------------------------------------
+	//!	@brief		取得回数を記録.
+	//-----------------------------------------------------------------------
+	void RecordLookup( StateType stateType, bool hit );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ネイティブステート生成時間を記録.
+	//!	@param[in]	beginTimeUs		生成開始時刻.
+	//!	@param[in]	count			生成後のキャッシュ数.
+	//! @pre		stateTypeのロックを排他ロック済み.
+	//-----------------------------------------------------------------------
+	void RecordCreate( StateType stateType, u64 beginTimeUs, size_t count );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ビューポートシザーステート取得.
+	//!	@param[in]	admit		trueの場合は候補判定せずにキャッシュへ追加.
+	//-----------------------------------------------------------------------
+	void GetNativeViewportScissorState( const ViewportScissorStateKey& key, NativeViewportScissorState* outState, bool admit );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ステート種別のロック取得.
+	//-----------------------------------------------------------------------
+	ReadWriteSpinLockObject& GetLock( StateType stateType ) const { return _locks[ static_cast< u32 >( stateType ) ]; }
+
+	Device*							_device;
+
+	// 記録スレッドが同時に取得できるよう, ステート種別毎の読み書きロックで保護する.
+	// ネイティブステートの生成中はロックしない.
+	mutable ReadWriteSpinLockObject	_locks[ static_cast< u32 >( StateType::kNum ) ];
 
 	// TODO: パフォーマンス向上のためコンテナをMRU化.
 	using BlendStateCache = std::unordered_map< BlendStateKey, NativeBlendState* >;
@@ -288,8 +544,21 @@ private:
 	using SamplerStateCache = std::unordered_map< SamplerStateKey, NativeSamplerState* >;
 	SamplerStateCache _samplerStateCache;
 
-	using ViewportScissorStateCache = std::unordered_map< ViewportScissorStateKey, NativeViewportScissorState* >;
+	// ビューポートシザーステートはLRUで上限管理.
+	using ViewportScissorStateLRU = std::list< const ViewportScissorStateKey* >;
+	struct ViewportScissorStateEntry
+	{
+		NativeViewportScissorState			state;
+		ViewportScissorStateLRU::iterator	lru;
+	};
+	using ViewportScissorStateCache = std::unordered_map< ViewportScissorStateKey, ViewportScissorStateEntry >;
 	ViewportScissorStateCache _viewportScissorStateCache;
+	ViewportScissorStateLRU _viewportScissorStateLRU;		//!< 先頭が最近使用したもの.
+	u32 _viewportScissorCandidates[ kViewportScissorCandidatesMax ];	//!< 直近に使用したキーのハッシュ.
+	u32 _viewportScissorCandidateIndex;
+
+	StatsSlot	_statsSlots[ kStatsSlotMax ];
+	u32			_peakCount[ static_cast< u32 >( StateType::kNum ) ];
 };
 
 } // namespace render
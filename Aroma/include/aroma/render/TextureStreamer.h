@@ -0,0 +1,309 @@
+﻿//===========================================================================
+//!
+//!	@file		TextureStreamer.h
+//!	@brief		テクスチャストリーミング.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "RenderDef.h"
+#include "MemoryAllocator.h"
+#include "../common/RefObject.h"
+#include "../common/Scheduler.h"
+#include "../data/DDS.h"
+#include "../util/NonCopyable.h"
+
+namespace aroma {
+namespace render {
+
+class Device;
+class Texture;
+class TextureView;
+class TextureStreamer;
+
+//---------------------------------------------------------------------------
+//!	@brief		ストリーミングテクスチャ.
+//!
+//! @details
+//!		TextureStreamer::Register()で作成します.
+//!		常駐しているミップレベルはTextureStreamer::Update()で入れ替わります.
+//---------------------------------------------------------------------------
+class StreamingTexture final : public RefObject, public MemoryAllocator, private util::NonCopyable< StreamingTexture >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		現在のテクスチャビュー取得.
+	//!
+	//! @details
+	//!		任意のスレッドから呼び出せます.
+	//!		取得したビューは入れ替え後もTextureStreamer::Desc::retireFrameCount回の
+	//!		TextureStreamer::Update()まで有効なため, そのフレームの描画に使用して構いません.
+	//-----------------------------------------------------------------------
+	TextureView* GetView() const;
+
+	//-----------------------------------------------------------------------
+	//! @brief		必要なミップレベルを要求(LODフィードバック).
+	//!
+	//! @details
+	//!		描画で必要な最も詳細なミップレベルを毎フレーム通知して下さい.
+	//!		同じフレームに複数回呼び出した場合は最も詳細なレベルを採用します.
+	//!		要求はLRUの使用履歴も兼ねるため, 要求の無いテクスチャから解放されます.
+	//!		任意のスレッドから呼び出せます.
+	//-----------------------------------------------------------------------
+	void RequestMip( u32 mip );
+
+	//-----------------------------------------------------------------------
+	//! @brief		常駐している最も詳細なミップレベル取得.
+	//-----------------------------------------------------------------------
+	u32 GetResidentMip() const;
+
+	//-----------------------------------------------------------------------
+	//! @brief		ミップマップ数取得.
+	//-----------------------------------------------------------------------
+	u32 GetMipCount() const;
+
+private:
+	friend class TextureStreamer;
+
+	StreamingTexture();
+	virtual ~StreamingTexture();
+
+	data::DDSAccessor				_dds;				//!< ソースデータ(Unregister()まで有効).
+	u32								_mipCount;
+	u32								_tailMip;			//!< 常に常駐させるミップレベル.
+	std::atomic< TextureView* >		_view;
+	std::atomic< u32 >				_residentMip;
+	std::atomic< u32 >				_requestedMip;		//!< 今フレームの要求(未要求時はAROMA_UINT32_MAX).
+	u32								_desiredMip;		//!< 直近の要求.
+	u32								_loadingMip;		//!< 読み込み中のレベル(未読み込み時はAROMA_UINT32_MAX).
+	u64								_lastUsedFrame;
+	u64								_residentBytes;		//!< 現在のビューのメモリ量.
+	u64								_loadingBytes;		//!< 読み込み中のビューのメモリ量(未読み込み時は0).
+	bool							_registered;
+};
+
+//---------------------------------------------------------------------------
+//!	@brief		テクスチャストリーミング.
+//!
+//! @details
+//!		登録時は小さいミップ(ミップテール)のみを作成して直ちに使用可能にし,
+//!		RequestMip()による要求に応じて詳細なミップをワーカースレッドで読み込みます.
+//!		常駐メモリがメモリバジェットを超える場合は, 最後に要求されたフレームが古い
+//!		テクスチャから詳細なミップを解放します(LRU).
+//!		入れ替え中は新旧のテクスチャが同時に存在するため, 読み込み中のテクスチャと
+//!		解放待ちのビューも解放されるまでメモリバジェットに含めます.
+//!
+//!		DirectX11ではテクスチャのミップ数を後から変更できないため, 常駐ミップの変更は
+//!		必要なミップのみを持つテクスチャとビューを作成して入れ替えます.
+//!		入れ替えはUpdate()内でビューのポインタを置き換えるのみで, 描画スレッドを止めません.
+//!
+//! @code
+//!	render::TextureStreamer::Desc desc;
+//!	desc.memoryBudget	= 512 * 1024 * 1024;
+//!	desc.scheduler		= &scheduler;
+//!	streamer.Initialize( device, desc );
+//!	auto texture = streamer.Register( data::DDSAccessor( archive.GetEntryData( entry ), static_cast< size_t >( entry->size ) ) );
+//!
+//!	// 毎フレーム.
+//!	texture->RequestMip( CalcMipLevel( ... ) );
+//!	context->PSSetShaderResource( 0, texture->GetView() );
+//!	streamer.Update();
+//! @endcode
+//---------------------------------------------------------------------------
+class TextureStreamer final : public RefObject, public MemoryAllocator, private util::NonCopyable< TextureStreamer >
+{
+public:
+	//-----------------------------------------------------------------------
+	//! @brief		構成設定.
+	//-----------------------------------------------------------------------
+	struct Desc
+	{
+		u64				memoryBudget;		//!< 常駐テクスチャのメモリバジェット(バイト).
+		u32				mipTailSize;		//!< 登録時に作成するミップの最大幅, 高さ.
+		u32				maxLoadCount;		//!< 同時に読み込むテクスチャの最大数.
+		u32				retireFrameCount;	//!< 入れ替え前のビューを保持するUpdate()回数(GPUで使用中のフレーム数以上).
+		IScheduler*		scheduler;			//!< 読み込みを実行するスケジューラー(nullptrの場合はUpdate()内で読み込み).
+
+		//-------------------------------------------------------------------
+		Desc(){ Default(); }
+		void Default()
+		{
+			memoryBudget		= 256 * 1024 * 1024;
+			mipTailSize			= 64;
+			maxLoadCount		= 4;
+			retireFrameCount	= 3;
+			scheduler			= nullptr;
+		}
+	};
+
+	//-----------------------------------------------------------------------
+	//! @brief		統計情報.
+	//-----------------------------------------------------------------------
+	struct Stats
+	{
+		u64		residentBytes;		//!< テクスチャのメモリ量(読み込み中, 解放待ちを含む).
+		u64		memoryBudget;		//!< メモリバジェット.
+		u32		textureCount;		//!< 登録テクスチャ数.
+		u32		loadingCount;		//!< 読み込み中のテクスチャ数.
+		u32		streamInCount;		//!< 前回のUpdate()で詳細なミップを読み込んだ数.
+		u32		evictCount;			//!< 前回のUpdate()でミップを解放した数.
+
+		//-------------------------------------------------------------------
+		Stats(){ Default(); }
+		void Default()
+		{
+			residentBytes	= 0;
+			memoryBudget	= 0;
+			textureCount	= 0;
+			loadingCount	= 0;
+			streamInCount	= 0;
+			evictCount		= 0;
+		}
+	};
+
+public:
+	//-----------------------------------------------------------------------
+	//!	@brief		コンストラクタ.
+	//-----------------------------------------------------------------------
+	TextureStreamer();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		デストラクタ.
+	//-----------------------------------------------------------------------
+	virtual ~TextureStreamer();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		初期化.
+	//-----------------------------------------------------------------------
+	void Initialize( Device* device, const Desc& desc );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		解放.
+	//!
+	//! @details
+	//!		読み込み中のテクスチャの完了を待ってから全てのテクスチャを解放します.
+	//-----------------------------------------------------------------------
+	void Finalize();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		テクスチャ登録.
+	//!
+	//! @details
+	//!		ミップテールのみを同期して作成します.
+	//!		DDSデータ(file::MappedFile, file::ArchiveReaderのマップ等)はUnregister()まで有効である必要があります.
+	//!		2Dテクスチャ(配列を含む)のみ対応します.
+	//!		GPUが直接扱えない旧形式のDDSはdata::ConvertLegacyDDS()で変換してから登録して下さい.
+	//!
+	//! @return		ストリーミングテクスチャ(失敗時はnullptr). Unregister()で解放して下さい.
+	//-----------------------------------------------------------------------
+	StreamingTexture* Register( const data::DDSAccessor& dds );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		テクスチャ登録解除.
+	//!
+	//! @details
+	//!		ビューは他のテクスチャと同様にretireFrameCount回のUpdate()後に解放します.
+	//-----------------------------------------------------------------------
+	void Unregister( StreamingTexture* texture );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		更新.
+	//!
+	//! @details
+	//!		完了した読み込みの入れ替え, 要求の集計, 読み込みと解放の発行を行います.
+	//!		毎フレーム1回, Register(), Unregister()と同じスレッドから呼び出して下さい.
+	//-----------------------------------------------------------------------
+	void Update();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		メモリバジェット設定.
+	//-----------------------------------------------------------------------
+	void SetMemoryBudget( u64 memoryBudget );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		統計情報取得.
+	//-----------------------------------------------------------------------
+	void GetStats( Stats* outStats ) const;
+
+private:
+	//-----------------------------------------------------------------------
+	//!	@brief		完了した読み込み.
+	//-----------------------------------------------------------------------
+	struct LoadResult
+	{
+		StreamingTexture*	texture;
+		TextureView*		view;			//!< 作成したビュー(失敗時はnullptr).
+		u32					mip;
+	};
+
+	//-----------------------------------------------------------------------
+	//!	@brief		解放待ちのビュー.
+	//-----------------------------------------------------------------------
+	struct RetiredView
+	{
+		TextureView*		view;
+		u64					frame;
+		u64					bytes;			//!< 解放までメモリ量に含める.
+	};
+
+	//-----------------------------------------------------------------------
+	//!	@brief		指定ミップ以降のテクスチャとビューを作成.
+	//-----------------------------------------------------------------------
+	TextureView* CreateView( const StreamingTexture* texture, u32 mip );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		指定ミップ以降を常駐させるメモリ量.
+	//-----------------------------------------------------------------------
+	static u64 CalcResidentBytes( const StreamingTexture* texture, u32 mip );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		テクスチャの先頭にできるミップレベルに補正(圧縮フォーマットはブロック境界).
+	//-----------------------------------------------------------------------
+	static u32 ClampToValidMip( const StreamingTexture* texture, u32 mip );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		読み込み(解放)を発行.
+	//-----------------------------------------------------------------------
+	void StartLoad( StreamingTexture* texture, u32 mip );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		完了した読み込みを反映.
+	//-----------------------------------------------------------------------
+	void ApplyLoadResults();
+
+	//-----------------------------------------------------------------------
+	//!	@brief		ビューを入れ替えて古いビューを解放待ちにする.
+	//-----------------------------------------------------------------------
+	void SwapView( StreamingTexture* texture, TextureView* view, u32 mip, u64 bytes );
+
+	//-----------------------------------------------------------------------
+	//!	@brief		解放待ちのビューを解放.
+	//-----------------------------------------------------------------------
+	void ReleaseRetiredViews( bool releaseAll );
+
+	bool								_initialized;
+	Device*								_device;
+	Desc								_desc;
+	std::vector< StreamingTexture* >	_textures;
+	std::vector< RetiredView >			_retiredViews;
+	u64									_frame;
+	u64									_residentBytes;		//!< メモリ量(読み込み中, 解放待ちを含む).
+	u64									_evictingBytes;		//!< _residentBytesのうち解放予定のメモリ量(入れ替え前, 解放待ちのビュー).
+	u32									_loadingCount;
+	Stats								_stats;
+
+	// ワーカースレッドと共有.
+	mutable std::mutex					_resultMutex;
+	std::condition_variable				_resultCondition;
+	std::vector< LoadResult >			_loadResults;
+};
+
+} // namespace render
+} // namespace aroma
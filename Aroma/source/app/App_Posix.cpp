@@ -0,0 +1,55 @@
+﻿//===========================================================================
+//!
+//!	@file		App_Posix.cpp
+//!	@brief		アプリケーション関連 : POSIX
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_POSIX
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <aroma/app/App.h>
+
+namespace aroma {
+namespace app {
+
+//---------------------------------------------------------------------------
+//	メッセージループ処理.
+//---------------------------------------------------------------------------
+void ProcessMessage()
+{
+	// ウィンドウシステムを使用しないため処理無し.
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		アプリケーションの終了判定.
+//---------------------------------------------------------------------------
+bool IsQuit()
+{
+	return false;
+}
+
+//---------------------------------------------------------------------------
+//	処理の強制停止.
+//---------------------------------------------------------------------------
+void Panic( CTStr file, u32 line, CTStr format, ... )
+{
+	va_list	vaStr;
+	char	tempStr[ 1024 ];
+
+	va_start( vaStr, format );
+	vsnprintf( tempStr, sizeof( tempStr ), format, vaStr );
+	va_end( vaStr );
+
+	fprintf( stderr, "App Panic : file[%s] line[%u]\n%s\n", file, line, tempStr );
+	abort();
+}
+
+} // namespace app
+} // namespace aroma
+
+#endif
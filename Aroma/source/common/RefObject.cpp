@@ -88,12 +88,14 @@ s32 RefObject::GetCount() const
 //	RefObjectManager
 //===========================================================================
 std::list< RefObject* > RefObjectManager::_objs;
+SpinLockObject RefObjectManager::_lock;
 
 //---------------------------------------------------------------------------
 //	全RefObjectインスタンスの参照カウントをデバッグ出力.
 //---------------------------------------------------------------------------
 void RefObjectManager::Dump()
 {
+	ScopedLock lock( _lock );
 	for( const auto& obj : _objs )
 	{
 		AROMA_DEBUG_OUT( "[RefObject] %p : %d Reference\n", obj, obj->GetCount() );
@@ -105,6 +107,7 @@ void RefObjectManager::Dump()
 //---------------------------------------------------------------------------
 void RefObjectManager::AddObj( RefObject* obj )
 {
+	ScopedLock lock( _lock );
 	_objs.push_back( obj );
 }
 
@@ -113,6 +116,7 @@ void RefObjectManager::AddObj( RefObject* obj )
 //---------------------------------------------------------------------------
 void RefObjectManager::DelObj( RefObject* obj )
 {
+	ScopedLock lock( _lock );
 	_objs.remove( obj );
 }
 #endif
@@ -0,0 +1,255 @@
+﻿//===========================================================================
+//!
+//!	@file		Scheduler.cpp
+//!	@brief		ジョブスケジューラー.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <aroma/common/Scheduler.h>
+#include <aroma/common/Algorithm.h>
+
+namespace aroma
+{
+//===========================================================================
+//!	@name		スレッドプールスケジューラー.
+//===========================================================================
+//! @{
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+ThreadPoolScheduler::ThreadPoolScheduler()
+	: _initialized( false )
+	, _queue( nullptr )
+	, _threads( nullptr )
+	, _sleepingCount( 0 )
+	, _quit( false )
+	, _overflowCount( 0 )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+ThreadPoolScheduler::~ThreadPoolScheduler()
+{
+	Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	初期化.
+//---------------------------------------------------------------------------
+void ThreadPoolScheduler::Initialize( const Desc& desc )
+{
+	if( _initialized )
+	{
+		AROMA_ASSERT( false, _T( "Already initialized.\n" ) );
+		Finalize();
+	}
+
+	_desc = desc;
+	if( _desc.threadCount == 0 )
+	{
+		u32 coreCount = static_cast< u32 >( std::thread::hardware_concurrency() );
+		_desc.threadCount = Max( 1u, coreCount > 0 ? coreCount - 1 : 1u );
+	}
+
+	_quit = false;
+	_queue = new MPMCQueue< Job >( Max( 2u, _desc.queueCapacity ) );
+	_threads = new std::thread[ _desc.threadCount ];
+	for( u32 i = 0; i < _desc.threadCount; ++i )
+	{
+		_threads[ i ] = std::thread( &ThreadPoolScheduler::WorkerMain, this );
+	}
+
+	_initialized = true;
+}
+
+//---------------------------------------------------------------------------
+//	解放.
+//---------------------------------------------------------------------------
+void ThreadPoolScheduler::Finalize()
+{
+	if( !_initialized ) return;
+
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		_quit = true;
+	}
+	_condition.notify_all();
+
+	for( u32 i = 0; i < _desc.threadCount; ++i )
+	{
+		if( _threads[ i ].joinable() )
+		{
+			_threads[ i ].join();
+		}
+	}
+	memory::SafeDeleteArray( _threads );
+	memory::SafeDelete( _queue );
+	_overflow.clear();
+	_overflowCount = 0;
+	_desc.Default();
+
+	_initialized = false;
+}
+
+//---------------------------------------------------------------------------
+//	ジョブ登録.
+//---------------------------------------------------------------------------
+void ThreadPoolScheduler::Schedule( Job&& job )
+{
+	if( !_initialized )
+	{
+		AROMA_ASSERT( false, _T( "Not initialized.\n" ) );
+		return;
+	}
+
+	// 退避中のジョブがある場合はキューへ追加しない(退避したジョブが後回しにされ続けないように).
+	if( _overflowCount.load( std::memory_order_acquire ) > 0 || !_queue->TryEnqueue( std::move( job ) ) )
+	{
+		// キューが満杯の場合はオーバーフローリストへ退避(ワーカーからの登録で待機しないように).
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			_overflow.push_back( std::move( job ) );
+			_overflowCount.fetch_add( 1, std::memory_order_release );
+		}
+		_condition.notify_one();
+		return;
+	}
+
+	// 待機中のワーカーがいれば起こす.
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	if( _sleepingCount.load( std::memory_order_relaxed ) > 0 )
+	{
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+		}
+		_condition.notify_one();
+	}
+}
+
+//---------------------------------------------------------------------------
+//	ワーカースレッド数取得.
+//---------------------------------------------------------------------------
+u32 ThreadPoolScheduler::GetThreadCount() const
+{
+	return _desc.threadCount;
+}
+
+//---------------------------------------------------------------------------
+//	ワーカースレッドメイン.
+//---------------------------------------------------------------------------
+void ThreadPoolScheduler::WorkerMain()
+{
+	Job job;
+	while( true )
+	{
+		if( _queue->TryDequeue( &job ) )
+		{
+			job();
+			job = nullptr;
+			continue;
+		}
+
+		// キューが空ならオーバーフローリストから取り出す.
+		std::unique_lock< std::mutex > lock( _mutex );
+		if( !_overflow.empty() )
+		{
+			job = std::move( _overflow.front() );
+			_overflow.pop_front();
+			_overflowCount.fetch_sub( 1, std::memory_order_release );
+			lock.unlock();
+
+			job();
+			job = nullptr;
+			continue;
+		}
+
+		// ジョブが無ければ待機.
+		_sleepingCount.fetch_add( 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		while( !_quit && _queue->GetSizeApprox() == 0 && _overflow.empty() )
+		{
+			_condition.wait( lock );
+		}
+		_sleepingCount.fetch_sub( 1, std::memory_order_relaxed );
+
+		if( _quit && _queue->GetSizeApprox() == 0 && _overflow.empty() )
+		{
+			break;
+		}
+	}
+}
+//! @}
+
+//===========================================================================
+//!	@name		手動実行スケジューラー.
+//===========================================================================
+//! @{
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+ManualScheduler::ManualScheduler( u32 capacity )
+	: _queue( Max( 2u, capacity ) )
+	, _overflowCount( 0 )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+ManualScheduler::~ManualScheduler()
+{
+}
+
+//---------------------------------------------------------------------------
+//	ジョブ登録.
+//---------------------------------------------------------------------------
+void ManualScheduler::Schedule( Job&& job )
+{
+	// 退避中のジョブがある場合は登録順を保つためキューへ追加しない.
+	if( _overflowCount.load( std::memory_order_acquire ) == 0 && _queue.TryEnqueue( std::move( job ) ) )
+	{
+		return;
+	}
+
+	// キューが満杯の場合はオーバーフローリストへ退避(RunPending()を呼ぶスレッドからの登録で待機しないように).
+	std::lock_guard< std::mutex > lock( _overflowMutex );
+	_overflow.push_back( std::move( job ) );
+	_overflowCount.fetch_add( 1, std::memory_order_release );
+}
+
+//---------------------------------------------------------------------------
+//	登録済みジョブの実行.
+//---------------------------------------------------------------------------
+u32 ManualScheduler::RunPending( u32 maxCount )
+{
+	// 実行中に登録されたジョブは次回に回すため, 開始時点の数を上限とする.
+	const size_t pending = _queue.GetSizeApprox() + _overflowCount.load( std::memory_order_acquire );
+	u32 count = static_cast< u32 >( Min( static_cast< size_t >( maxCount ), pending ) );
+
+	Job job;
+	u32 executed = 0;
+	while( executed < count )
+	{
+		// キューのジョブは退避したジョブより先に登録されている.
+		if( !_queue.TryDequeue( &job ) )
+		{
+			std::lock_guard< std::mutex > lock( _overflowMutex );
+			if( _overflow.empty() ) break;
+
+			job = std::move( _overflow.front() );
+			_overflow.pop_front();
+			_overflowCount.fetch_sub( 1, std::memory_order_release );
+		}
+		job();
+		job = nullptr;
+		executed++;
+	}
+	return executed;
+}
+//! @}
+
+} // namespace aroma
@@ -16,6 +16,7 @@ namespace aroma
 //---------------------------------------------------------------------------
 SpinLockObject::SpinLockObject()
 {
+	m_obj.clear( std::memory_order_release );
 }
 
 SpinLockObject::~SpinLockObject()
@@ -35,4 +36,60 @@ void SpinLockObject::Unlock()
 	m_obj.clear( std::memory_order_release );
 }
 
+//---------------------------------------------------------------------------
+//! @brief 読み書きスピンロック.
+//---------------------------------------------------------------------------
+ReadWriteSpinLockObject::ReadWriteSpinLockObject()
+	: m_state( 0 )
+{
+}
+
+ReadWriteSpinLockObject::~ReadWriteSpinLockObject()
+{
+}
+
+void ReadWriteSpinLockObject::Lock()
+{
+	// 先に排他フラグを立てて新たな共有ロックを止め, 既存の共有ロックの解放を待つ.
+	u32 state = m_state.load( std::memory_order_relaxed );
+	for( ;; )
+	{
+		if( !( state & kWriterBit ) && m_state.compare_exchange_weak( state, state | kWriterBit, std::memory_order_acquire, std::memory_order_relaxed ) )
+		{
+			break;
+		}
+		state = m_state.load( std::memory_order_relaxed );
+	}
+	while( m_state.load( std::memory_order_acquire ) != kWriterBit )
+	{
+		;	// Spin-lock.
+	}
+}
+
+void ReadWriteSpinLockObject::Unlock()
+{
+	m_state.store( 0, std::memory_order_release );
+}
+
+void ReadWriteSpinLockObject::LockShared()
+{
+	u32 state = m_state.load( std::memory_order_relaxed );
+	for( ;; )
+	{
+		if( !( state & kWriterBit ) && m_state.compare_exchange_weak( state, state + 1, std::memory_order_acquire, std::memory_order_relaxed ) )
+		{
+			break;
+		}
+		if( state & kWriterBit )
+		{
+			state = m_state.load( std::memory_order_relaxed );
+		}
+	}
+}
+
+void ReadWriteSpinLockObject::UnlockShared()
+{
+	m_state.fetch_sub( 1, std::memory_order_release );
+}
+
 } // namespace aroma
@@ -7,7 +7,23 @@
 //!	@author		d0
 //!
 //===========================================================================
+#include <chrono>
+#include <cstring>
+#include <vector>
 #include <aroma/data/CRC.h>
+#include <aroma/common/Algorithm.h>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define AROMA_CRC_PCLMUL_ENABLE 1
+#define AROMA_CRC_PCLMUL_TARGET
+#elif ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <cpuid.h>
+#include <immintrin.h>
+#define AROMA_CRC_PCLMUL_ENABLE 1
+// PCLMULQDQは実行時に判定して使用するため, ビルド全体ではなく畳み込み関数のみで有効にする.
+#define AROMA_CRC_PCLMUL_TARGET __attribute__(( target( "pclmul,sse4.1" ) ))
+#endif
 
 namespace aroma {
 namespace data {
@@ -102,5 +118,299 @@ const u32 CRC::_CRC32Ktable[ 256 ] =
 	0x76342b77,0xe0a1efbd,0xad8fd171,0x3b1a15bb,0x56c7e8b8,0xc0522c72
 };
 
+
+namespace
+{
+	//! slicing-by-16のテーブル数.
+	constexpr u32 kSliceCount = 16;
+
+	//! PCLMULQDQによる畳み込みを行う最小サイズ.
+	constexpr size_t kFoldBytesMin = 64;
+
+	//-----------------------------------------------------------------------
+	//	slicing-by-16テーブル.
+	//	table[ k ][ i ]はバイトiの後にk個の0バイトが続く場合のCRC.
+	//-----------------------------------------------------------------------
+	struct SliceTable
+	{
+		u32 table[ kSliceCount ][ 256 ];
+
+		explicit SliceTable( const u32* baseTable )
+		{
+			for( u32 i = 0; i < 256; ++i )
+			{
+				table[ 0 ][ i ] = baseTable[ i ];
+			}
+			for( u32 k = 1; k < kSliceCount; ++k )
+			{
+				for( u32 i = 0; i < 256; ++i )
+				{
+					u32 prev = table[ k - 1 ][ i ];
+					table[ k ][ i ] = ( prev >> 8 ) ^ baseTable[ prev & 0xff ];
+				}
+			}
+		}
+	};
+
+	//-----------------------------------------------------------------------
+	//	時間取得(マイクロ秒).
+	//-----------------------------------------------------------------------
+	u64 GetTimeUs()
+	{
+		return static_cast< u64 >( std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+	}
+
+	//-----------------------------------------------------------------------
+	//	リトルエンディアンで32bit読み込み.
+	//-----------------------------------------------------------------------
+	inline u32 LoadLE32( const u8* p )
+	{
+		u32 v;
+		memcpy( &v, p, sizeof( v ) );
+#if !AROMA_ENDIAN_LE
+		v = SwapEndian32( v );
+#endif
+		return v;
+	}
+
+	//-----------------------------------------------------------------------
+	//	slicing-by-16によるCRC32計算.
+	//-----------------------------------------------------------------------
+	u32 UpdateSlice16( u32 crc, const u8* p, size_t bytes, const u32 ( *t )[ 256 ] )
+	{
+		while( bytes >= 16 )
+		{
+			u32 w0 = LoadLE32( p      ) ^ crc;
+			u32 w1 = LoadLE32( p +  4 );
+			u32 w2 = LoadLE32( p +  8 );
+			u32 w3 = LoadLE32( p + 12 );
+
+			crc = t[ 15 ][ w0 & 0xff ] ^ t[ 14 ][ ( w0 >> 8 ) & 0xff ] ^ t[ 13 ][ ( w0 >> 16 ) & 0xff ] ^ t[ 12 ][ w0 >> 24 ]
+				^ t[ 11 ][ w1 & 0xff ] ^ t[ 10 ][ ( w1 >> 8 ) & 0xff ] ^ t[  9 ][ ( w1 >> 16 ) & 0xff ] ^ t[  8 ][ w1 >> 24 ]
+				^ t[  7 ][ w2 & 0xff ] ^ t[  6 ][ ( w2 >> 8 ) & 0xff ] ^ t[  5 ][ ( w2 >> 16 ) & 0xff ] ^ t[  4 ][ w2 >> 24 ]
+				^ t[  3 ][ w3 & 0xff ] ^ t[  2 ][ ( w3 >> 8 ) & 0xff ] ^ t[  1 ][ ( w3 >> 16 ) & 0xff ] ^ t[  0 ][ w3 >> 24 ];
+
+			p		+= 16;
+			bytes	-= 16;
+		}
+
+		while( bytes-- )
+		{
+			crc = ( crc >> 8 ) ^ t[ 0 ][ ( crc ^ *p++ ) & 0xff ];
+		}
+		return crc;
+	}
+
+#ifdef AROMA_CRC_PCLMUL_ENABLE
+	//-----------------------------------------------------------------------
+	//	PCLMULQDQ対応判定.
+	//-----------------------------------------------------------------------
+	bool IsPCLMULSupported()
+	{
+		int info[ 4 ];
+#if defined( _MSC_VER )
+		__cpuid( info, 1 );
+#else
+		unsigned int regs[ 4 ] = {};
+		if( !__get_cpuid( 1, &regs[ 0 ], &regs[ 1 ], &regs[ 2 ], &regs[ 3 ] ) ) return false;
+		for( u32 i = 0; i < 4; ++i ) info[ i ] = static_cast< int >( regs[ i ] );
+#endif
+		const bool sse2		= ( info[ 3 ] & ( 1 << 26 ) ) != 0;
+		const bool pclmul	= ( info[ 2 ] & ( 1 <<  1 ) ) != 0;
+		const bool sse41	= ( info[ 2 ] & ( 1 << 19 ) ) != 0;
+		return sse2 && pclmul && sse41;
+	}
+
+	//-----------------------------------------------------------------------
+	//	PCLMULQDQによる畳み込みCRC32計算.
+	//	bytesは64以上かつ16の倍数であること.
+	//
+	//	Intel "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+	//	Instruction" のビット反転領域の定数を使用.
+	//-----------------------------------------------------------------------
+	AROMA_CRC_PCLMUL_TARGET u32 UpdateFold( u32 crc, const u8* p, size_t bytes )
+	{
+		alignas( 16 ) static const u64 k1k2[ 2 ] = { 0x0154442bd4ull, 0x01c6e41596ull };
+		alignas( 16 ) static const u64 k3k4[ 2 ] = { 0x01751997d0ull, 0x00ccaa009eull };
+		alignas( 16 ) static const u64 k5k0[ 2 ] = { 0x0163cd6124ull, 0x0000000000ull };
+		alignas( 16 ) static const u64 poly[ 2 ] = { 0x01db710641ull, 0x01f7011641ull };
+
+		__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+		// 先頭64バイト.
+		x1 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x00 ) );
+		x2 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x10 ) );
+		x3 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x20 ) );
+		x4 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x30 ) );
+		x1 = _mm_xor_si128( x1, _mm_cvtsi32_si128( static_cast< int >( crc ) ) );
+		x0 = _mm_load_si128( reinterpret_cast< const __m128i* >( k1k2 ) );
+		p		+= 64;
+		bytes	-= 64;
+
+		// 64バイト単位で4並列に畳み込み.
+		while( bytes >= 64 )
+		{
+			x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+			x6 = _mm_clmulepi64_si128( x2, x0, 0x00 );
+			x7 = _mm_clmulepi64_si128( x3, x0, 0x00 );
+			x8 = _mm_clmulepi64_si128( x4, x0, 0x00 );
+
+			x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+			x2 = _mm_clmulepi64_si128( x2, x0, 0x11 );
+			x3 = _mm_clmulepi64_si128( x3, x0, 0x11 );
+			x4 = _mm_clmulepi64_si128( x4, x0, 0x11 );
+
+			y5 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x00 ) );
+			y6 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x10 ) );
+			y7 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x20 ) );
+			y8 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 0x30 ) );
+
+			x1 = _mm_xor_si128( _mm_xor_si128( x1, x5 ), y5 );
+			x2 = _mm_xor_si128( _mm_xor_si128( x2, x6 ), y6 );
+			x3 = _mm_xor_si128( _mm_xor_si128( x3, x7 ), y7 );
+			x4 = _mm_xor_si128( _mm_xor_si128( x4, x8 ), y8 );
+
+			p		+= 64;
+			bytes	-= 64;
+		}
+
+		// 128bitへ畳み込み.
+		x0 = _mm_load_si128( reinterpret_cast< const __m128i* >( k3k4 ) );
+
+		x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+		x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+		x1 = _mm_xor_si128( _mm_xor_si128( x1, x2 ), x5 );
+
+		x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+		x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+		x1 = _mm_xor_si128( _mm_xor_si128( x1, x3 ), x5 );
+
+		x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+		x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+		x1 = _mm_xor_si128( _mm_xor_si128( x1, x4 ), x5 );
+
+		// 残りを16バイト単位で畳み込み.
+		while( bytes >= 16 )
+		{
+			x2 = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) );
+
+			x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+			x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+			x1 = _mm_xor_si128( _mm_xor_si128( x1, x2 ), x5 );
+
+			p		+= 16;
+			bytes	-= 16;
+		}
+
+		// 128bitから64bitへ畳み込み.
+		x2 = _mm_clmulepi64_si128( x1, x0, 0x10 );
+		x3 = _mm_setr_epi32( ~0, 0, ~0, 0 );
+		x1 = _mm_srli_si128( x1, 8 );
+		x1 = _mm_xor_si128( x1, x2 );
+
+		x0 = _mm_loadl_epi64( reinterpret_cast< const __m128i* >( k5k0 ) );
+
+		x2 = _mm_srli_si128( x1, 4 );
+		x1 = _mm_and_si128( x1, x3 );
+		x1 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+		x1 = _mm_xor_si128( x1, x2 );
+
+		// Barrett還元で32bitへ.
+		x0 = _mm_load_si128( reinterpret_cast< const __m128i* >( poly ) );
+
+		x2 = _mm_and_si128( x1, x3 );
+		x2 = _mm_clmulepi64_si128( x2, x0, 0x10 );
+		x2 = _mm_and_si128( x2, x3 );
+		x2 = _mm_clmulepi64_si128( x2, x0, 0x00 );
+		x1 = _mm_xor_si128( x1, x2 );
+
+		return static_cast< u32 >( _mm_cvtsi128_si32( _mm_srli_si128( x1, 4 ) ) );
+	}
+#endif
+}
+
+//---------------------------------------------------------------------------
+//	大容量バッファ用CRC32取得.
+//---------------------------------------------------------------------------
+u32 CRC::GetCRCBulk( const void* pbuf, size_t bytes )
+{
+	return UpdateCRCBulk( kCRCInitial, pbuf, bytes );
+}
+
+//---------------------------------------------------------------------------
+//	大容量バッファ用CRC32継続計算.
+//---------------------------------------------------------------------------
+u32 CRC::UpdateCRCBulk( u32 crc, const void* pbuf, size_t bytes )
+{
+	static const SliceTable sliceTable( _CRCtable );
+
+	const u8* p = static_cast< const u8* >( pbuf );
+
+#ifdef AROMA_CRC_PCLMUL_ENABLE
+	static const bool pclmulSupported = IsPCLMULSupported();
+	if( pclmulSupported && bytes >= kFoldBytesMin )
+	{
+		size_t foldBytes = bytes & ~static_cast< size_t >( 15 );
+		crc		= UpdateFold( crc, p, foldBytes );
+		p		+= foldBytes;
+		bytes	-= foldBytes;
+	}
+#endif
+
+	return UpdateSlice16( crc, p, bytes, sliceTable.table );
+}
+
+//---------------------------------------------------------------------------
+//	CRC32速度計測.
+//---------------------------------------------------------------------------
+bool CRC::Benchmark( u64 bytesPerSize, CRCBenchmarkResult* results )
+{
+	// 圧縮済みアセットに近いよう擬似乱数で埋める.
+	std::vector< u8 > buffer( kCRCBenchmarkSizes[ kCRCBenchmarkSizeCount - 1 ] );
+	u32 seed = 0x12345678;
+	for( auto& value : buffer )
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		value = static_cast< u8 >( seed );
+	}
+
+	bool succeeded = true;
+	for( u32 i = 0; i < kCRCBenchmarkSizeCount; ++i )
+	{
+		const size_t bytes = kCRCBenchmarkSizes[ i ];
+		CRCBenchmarkResult& result = results[ i ];
+		result.bytes		= bytes;
+		result.iterations	= static_cast< u32 >( Max< u64 >( bytesPerSize / bytes, 1 ) );
+
+		// 毎回先頭を書き換えて結果を合計し, 最適化で計算が省かれないようにする.
+		u32 byteWiseCRC	= 0;
+		u32 bulkCRC		= 0;
+
+		// 速度(MB/s)を計測.
+		auto measure = [ & ]( u32* outCRC, u32 ( *func )( const void*, size_t ) ) -> f64
+		{
+			const u64 beginTime = GetTimeUs();
+			for( u32 n = 0; n < result.iterations; ++n )
+			{
+				buffer[ 0 ] = static_cast< u8 >( n );
+				*outCRC += func( buffer.data(), bytes );
+			}
+			const u64 elapsedUs = Max< u64 >( GetTimeUs() - beginTime, 1 );
+			return static_cast< f64 >( bytes ) * result.iterations / static_cast< f64 >( elapsedUs );
+		};
+
+		auto byteWise	= []( const void* p, size_t n ){ return GetCRC( p, static_cast< u32 >( n ) ); };
+		auto bulk		= []( const void* p, size_t n ){ return GetCRCBulk( p, n ); };
+
+		result.byteWiseMBps	= measure( &byteWiseCRC, byteWise );
+		result.bulkMBps		= measure( &bulkCRC, bulk );
+		result.succeeded	= ( byteWiseCRC == bulkCRC );
+		succeeded &= result.succeeded;
+	}
+	return succeeded;
+}
+
 } // namespace data
 } // namespace aroma
@@ -0,0 +1,267 @@
+﻿//===========================================================================
+//!
+//!	@file		ChunkedCompression.cpp
+//! @brief		チャンク分割圧縮.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <aroma/data/ChunkedCompression.h>
+#include <aroma/data/LZ4.h>
+#include <aroma/common/Algorithm.h>
+
+namespace aroma {
+namespace data {
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	チャンク間で共有する展開状態.
+//---------------------------------------------------------------------------
+struct ChunkedDecodeState
+{
+	TaskPromise< bool >		promise;
+	std::atomic< u32 >		remainingCount;
+	std::atomic< bool >		failed;
+};
+
+//---------------------------------------------------------------------------
+//	時間取得(マイクロ秒).
+//---------------------------------------------------------------------------
+u64 GetTimeUs()
+{
+	return static_cast< u64 >( std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+//---------------------------------------------------------------------------
+//	ヘッダーとオフセット表の検証.
+//---------------------------------------------------------------------------
+bool ValidatePayload( const void* payload, size_t payloadBytes, const ChunkedCompressionHeader** outHeader, const u64** outOffsets )
+{
+	if( payload == nullptr || payloadBytes < sizeof( ChunkedCompressionHeader ) )
+	{
+		return false;
+	}
+
+	const ChunkedCompressionHeader* header = static_cast< const ChunkedCompressionHeader* >( payload );
+	if( header->magic != kChunkedCompressionMagic || header->chunkSize == 0 )
+	{
+		return false;
+	}
+	const u64 expectedCount = ( header->originalSize + header->chunkSize - 1 ) / header->chunkSize;
+	if( header->chunkCount != expectedCount )
+	{
+		return false;
+	}
+
+	const u64 tableEnd = sizeof( ChunkedCompressionHeader ) + ( static_cast< u64 >( header->chunkCount ) + 1 ) * sizeof( u64 );
+	if( tableEnd > payloadBytes )
+	{
+		return false;
+	}
+
+	// オフセットは単調増加で, チャンクは元のサイズを超えない.
+	const u64* offsets = reinterpret_cast< const u64* >( header + 1 );
+	if( offsets[ 0 ] != tableEnd || offsets[ header->chunkCount ] > payloadBytes )
+	{
+		return false;
+	}
+	for( u32 i = 0; i < header->chunkCount; ++i )
+	{
+		const u64 rawBytes = Min< u64 >( header->chunkSize, header->originalSize - static_cast< u64 >( i ) * header->chunkSize );
+		if( offsets[ i + 1 ] < offsets[ i ] || offsets[ i + 1 ] - offsets[ i ] > rawBytes )
+		{
+			return false;
+		}
+	}
+
+	*outHeader	= header;
+	*outOffsets	= offsets;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	1チャンクの展開.
+//---------------------------------------------------------------------------
+bool DecompressChunk( const u8* payload, const ChunkedCompressionHeader* header, const u64* offsets, u32 index, u8* dest )
+{
+	const size_t begin		= static_cast< size_t >( static_cast< u64 >( index ) * header->chunkSize );
+	const size_t rawBytes	= static_cast< size_t >( Min< u64 >( header->chunkSize, header->originalSize - begin ) );
+	const size_t storedSize	= static_cast< size_t >( offsets[ index + 1 ] - offsets[ index ] );
+	const u8* stored		= payload + offsets[ index ];
+
+	// 圧縮しても小さくならなかったチャンクはそのまま格納されている.
+	if( storedSize == rawBytes )
+	{
+		memcpy( dest + begin, stored, rawBytes );
+		return true;
+	}
+	return LZ4::Decompress( stored, storedSize, dest + begin, rawBytes );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	チャンク分割圧縮.
+//---------------------------------------------------------------------------
+void CompressChunked( const void* src, size_t srcBytes, std::vector< u8 >* out, u32 chunkSize )
+{
+	AROMA_ASSERT( chunkSize > 0, _T( "Invalid chunk size.\n" ) );
+
+	const u32 chunkCount	= static_cast< u32 >( ( srcBytes + chunkSize - 1 ) / chunkSize );
+	const size_t tableEnd	= sizeof( ChunkedCompressionHeader ) + ( static_cast< size_t >( chunkCount ) + 1 ) * sizeof( u64 );
+
+	ChunkedCompressionHeader header;
+	memory::Clear( header );
+	header.magic		= kChunkedCompressionMagic;
+	header.chunkSize	= chunkSize;
+	header.chunkCount	= chunkCount;
+	header.originalSize	= srcBytes;
+
+	out->clear();
+	out->reserve( tableEnd + LZ4::GetCompressBound( srcBytes ) );
+	out->resize( tableEnd );
+	memcpy( out->data(), &header, sizeof( header ) );
+
+	std::vector< u64 > offsets( static_cast< size_t >( chunkCount ) + 1 );
+	std::vector< u8 > compressed( LZ4::GetCompressBound( chunkSize ) );
+	const u8* source = static_cast< const u8* >( src );
+	for( u32 i = 0; i < chunkCount; ++i )
+	{
+		const size_t begin		= static_cast< size_t >( i ) * chunkSize;
+		const size_t rawBytes	= Min< size_t >( chunkSize, srcBytes - begin );
+		offsets[ i ]			= out->size();
+
+		const size_t compressedBytes = LZ4::Compress( source + begin, rawBytes, compressed.data(), compressed.size() );
+		if( compressedBytes > 0 && compressedBytes < rawBytes )
+		{
+			out->insert( out->end(), compressed.data(), compressed.data() + compressedBytes );
+		}
+		else
+		{
+			out->insert( out->end(), source + begin, source + begin + rawBytes );
+		}
+	}
+	offsets[ chunkCount ] = out->size();
+	memcpy( out->data() + sizeof( header ), offsets.data(), offsets.size() * sizeof( u64 ) );
+}
+
+//---------------------------------------------------------------------------
+//	チャンク分割圧縮データの展開後のサイズ取得.
+//---------------------------------------------------------------------------
+u64 GetChunkedOriginalSize( const void* payload, size_t payloadBytes )
+{
+	const ChunkedCompressionHeader* header = nullptr;
+	const u64* offsets = nullptr;
+	if( !ValidatePayload( payload, payloadBytes, &header, &offsets ) )
+	{
+		return 0;
+	}
+	return header->originalSize;
+}
+
+//---------------------------------------------------------------------------
+//	チャンク分割圧縮データを並列に展開.
+//---------------------------------------------------------------------------
+Task< bool > DecompressChunkedAsync( const void* payload, size_t payloadBytes, void* dest, size_t destBytes, IScheduler* scheduler )
+{
+	auto state = std::make_shared< ChunkedDecodeState >();
+	Task< bool > task = state->promise.GetTask();
+
+	const ChunkedCompressionHeader* header = nullptr;
+	const u64* offsets = nullptr;
+	if( !ValidatePayload( payload, payloadBytes, &header, &offsets ) || header->originalSize != destBytes || ( dest == nullptr && destBytes > 0 ) )
+	{
+		AROMA_ASSERT( false, _T( "Invalid compressed data.\n" ) );
+		state->promise.SetValue( false );
+		return task;
+	}
+	if( header->chunkCount == 0 )
+	{
+		state->promise.SetValue( true );
+		return task;
+	}
+
+	state->remainingCount	= header->chunkCount;
+	state->failed			= false;
+
+	const u8* source	= static_cast< const u8* >( payload );
+	u8* destination		= static_cast< u8* >( dest );
+	for( u32 i = 0; i < header->chunkCount; ++i )
+	{
+		auto job = [ state, source, header, offsets, i, destination ]()
+		{
+			if( !DecompressChunk( source, header, offsets, i, destination ) )
+			{
+				state->failed.store( true, std::memory_order_relaxed );
+			}
+
+			// 最後に完了したチャンクが一度だけ完了を通知する.
+			if( state->remainingCount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+			{
+				state->promise.SetValue( !state->failed.load( std::memory_order_relaxed ) );
+			}
+		};
+
+		if( scheduler )
+		{
+			scheduler->Schedule( std::move( job ) );
+		}
+		else
+		{
+			job();
+		}
+	}
+	return task;
+}
+
+//---------------------------------------------------------------------------
+//	チャンク分割圧縮データを展開(完了まで待機).
+//---------------------------------------------------------------------------
+bool DecompressChunked( const void* payload, size_t payloadBytes, void* dest, size_t destBytes, IScheduler* scheduler )
+{
+	return DecompressChunkedAsync( payload, payloadBytes, dest, destBytes, scheduler ).Get();
+}
+
+//---------------------------------------------------------------------------
+//	チャンク分割圧縮データの展開速度計測.
+//---------------------------------------------------------------------------
+bool BenchmarkChunkedDecode( const void* src, size_t srcBytes, IScheduler* scheduler, u32 iterations, ChunkedDecodeBenchmarkResult* result )
+{
+	memory::Clear( *result );
+	iterations = Max( iterations, 1u );
+
+	std::vector< u8 > compressed;
+	CompressChunked( src, srcBytes, &compressed );
+	result->originalBytes	= srcBytes;
+	result->compressedBytes	= compressed.size();
+
+	std::vector< u8 > decoded( srcBytes );
+	bool succeeded = true;
+
+	// 展開速度(MB/s)を計測.
+	auto measure = [ & ]( IScheduler* decodeScheduler ) -> f64
+	{
+		const u64 beginTime = GetTimeUs();
+		for( u32 i = 0; i < iterations; ++i )
+		{
+			succeeded &= DecompressChunked( compressed.data(), compressed.size(), decoded.data(), decoded.size(), decodeScheduler );
+		}
+		const u64 elapsedUs = Max< u64 >( GetTimeUs() - beginTime, 1 );
+		succeeded &= ( srcBytes == 0 || memcmp( decoded.data(), src, srcBytes ) == 0 );
+		return static_cast< f64 >( srcBytes ) * iterations / static_cast< f64 >( elapsedUs );
+	};
+
+	result->singleThreadMBps	= measure( nullptr );
+	result->multiThreadMBps		= scheduler ? measure( scheduler ) : result->singleThreadMBps;
+	result->succeeded			= succeeded;
+	return succeeded;
+}
+
+} // namespace data
+} // namespace aroma
@@ -7,7 +7,10 @@
 //!	@author		d0
 //!
 //===========================================================================
+#include <cstring>
 #include <aroma/data/DDS.h>
+#include <aroma/data/PixelConvert.h>
+#include <aroma/common/Macro.h>
 
 namespace aroma {
 namespace data {
@@ -18,6 +21,7 @@ namespace
 bool IsValidForNormal( const DDSHeader& ddsHeader );
 bool IsValidForDX10( const DDSHeaderDX10& ddsHeaderDX10 );
 PixelFormat ToAromaPixelFormat( DDSDXGIFormat dxgiFormat );
+PixelFormat LegacyToPixelFormat( DDSDXGIFormat legacyFormat );
 }
 
 //---------------------------------------------------------------------------
@@ -25,6 +29,7 @@ PixelFormat ToAromaPixelFormat( DDSDXGIFormat dxgiFormat );
 //---------------------------------------------------------------------------
 DDSAccessor::DDSAccessor()
 	: _ddsData( nullptr )
+	, _ddsDataSize( 0 )
 	, _ddsHeader( nullptr )
 	, _ddsHeaderDX10( nullptr )
 {
@@ -33,20 +38,28 @@ DDSAccessor::DDSAccessor()
 //---------------------------------------------------------------------------
 //	DDSデータ設定コンストラクタ.
 //---------------------------------------------------------------------------
-DDSAccessor::DDSAccessor( void* ddsData )
+DDSAccessor::DDSAccessor( const void* ddsData, size_t dataSize )
 {
-	Set( ddsData );
+	Set( ddsData, dataSize );
 }
 
 //---------------------------------------------------------------------------
 //	DDSデータ設定.
 //---------------------------------------------------------------------------
-bool DDSAccessor::Set( void* ddsData )
+bool DDSAccessor::Set( const void* ddsData, size_t dataSize )
 {
 	_ddsData		= ddsData;
+	_ddsDataSize	= dataSize;
 	_ddsHeader		= static_cast< const DDSHeader* >( _ddsData );
 	_ddsHeaderDX10	= nullptr;
 
+	if( _ddsDataSize > 0 && _ddsDataSize < sizeof( DDSHeader ) )
+	{
+		// ヘッダーが範囲外.
+		_ddsHeader = nullptr;
+		return false;
+	}
+
 	if( !IsValidForNormal( *_ddsHeader ) )
 	{
 		// 不正データ.
@@ -58,7 +71,15 @@ bool DDSAccessor::Set( void* ddsData )
 		( _ddsHeader->dwPixelFormat.dwFourCC == DDSFormatFourCC::kDX10 ) )
 	{
 		_ddsHeaderDX10 = reinterpret_cast< const DDSHeaderDX10* >(
-			reinterpret_cast< uintptr >( _ddsHeader ) + kDDSHeaderDX10Size );
+			reinterpret_cast< uintptr >( _ddsHeader ) + sizeof( DDSHeader ) );
+	}
+
+	if( _ddsHeaderDX10 && _ddsDataSize > 0 && _ddsDataSize < sizeof( DDSHeader ) + sizeof( DDSHeaderDX10 ) )
+	{
+		// DX10拡張ヘッダーが範囲外.
+		_ddsHeader		= nullptr;
+		_ddsHeaderDX10	= nullptr;
+		return false;
 	}
 
 	if( _ddsHeaderDX10 )
@@ -142,6 +163,14 @@ const void*	DDSAccessor::GetImageTop() const
 	return reinterpret_cast< void* >( addr );
 }
 
+//---------------------------------------------------------------------------
+//	DDSデータサイズ取得.
+//---------------------------------------------------------------------------
+size_t DDSAccessor::GetDataSize() const
+{
+	return _ddsDataSize;
+}
+
 //-----------------------------------------------------------------------
 //	ピクセルフォーマット取得.
 //
@@ -188,17 +217,90 @@ PixelFormat DDSAccessor::GetPixelFormat() const
 			break;
 		case DDSFormatFourCC::kMUTI2_ARGB8:
 			break;
+		default:
+			break;
 		}
 	}
-	else
+
+	// ビットマスク(またはFourCCの数値)から取得.
+	if( format == PixelFormat::kUnknown )
 	{
-		// TODO: 作成.
+		format = LegacyToPixelFormat( GetLegacyFormat() );
 	}
 
-	AROMA_ASSERT( format != PixelFormat::kUnknown, _T( "Unsupport Format.\n" ) );
+	// GPUが直接扱えない旧形式はConvertLegacyDDS()で変換できる.
+	AROMA_ASSERT( format != PixelFormat::kUnknown || IsConvertibleToRGBA8( GetLegacyFormat() ), _T( "Unsupport Format.\n" ) );
 	return format;
 }
 
+//-----------------------------------------------------------------------
+//	旧形式(DX10拡張なし)のフォーマット取得.
+//-----------------------------------------------------------------------
+DDSDXGIFormat DDSAccessor::GetLegacyFormat() const
+{
+	if( GetHeaderDX10() )
+	{
+		return DDSDXGIFormat::kUnknown;
+	}
+
+	const auto& pf		= GetHeader()->dwPixelFormat;
+	const u32	flags	= pf.dwPfFlags;
+
+	if( CheckFlags( flags, kDDSPixelFormatFlagFourCC ) )
+	{
+		// 浮動小数点等はFourCCにD3DFORMATの数値が格納されている.
+		const u32 fourCC = static_cast< u32 >( static_cast< DDSFormatFourCC >( pf.dwFourCC ) );
+		return fourCC < 256 ? static_cast< DDSDXGIFormat >( fourCC ) : DDSDXGIFormat::kUnknown;
+	}
+
+	const u32 bitCount	= pf.dwRGBBitCount;
+	const u32 rMask		= pf.dwRBitMask;
+	const u32 gMask		= pf.dwGBitMask;
+	const u32 bMask		= pf.dwBBitMask;
+	const u32 aMask		= CheckFlags( flags, kDDSPixelFormatFlagAlphaPixels ) ? static_cast< u32 >( pf.dwABitMask ) : 0;
+	auto isMask = [ & ]( u32 r, u32 g, u32 b, u32 a )
+	{
+		return rMask == r && gMask == g && bMask == b && aMask == a;
+	};
+
+	if( CheckFlags( flags, kDDSPixelFormatFlagRGB ) )
+	{
+		switch( bitCount )
+		{
+		case 32:
+			if( isMask( 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 ) )	return DDSDXGIFormat::kA8R8G8B8;
+			if( isMask( 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000 ) )	return DDSDXGIFormat::kX8R8G8B8;
+			if( isMask( 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 ) )	return DDSDXGIFormat::kA8B8G8R8;
+			if( isMask( 0x000000ff, 0x0000ff00, 0x00ff0000, 0x00000000 ) )	return DDSDXGIFormat::kX8B8G8R8;
+			if( isMask( 0x000003ff, 0x000ffc00, 0x3ff00000, 0xc0000000 ) )	return DDSDXGIFormat::kA2B10G10R10;
+			if( isMask( 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000 ) )	return DDSDXGIFormat::kG16R16;
+			break;
+		case 24:
+			if( isMask( 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000 ) )	return DDSDXGIFormat::kR8G8B8;
+			break;
+		case 16:
+			if( isMask( 0xf800, 0x07e0, 0x001f, 0x0000 ) )					return DDSDXGIFormat::kR5G6B5;
+			if( isMask( 0x7c00, 0x03e0, 0x001f, 0x8000 ) )					return DDSDXGIFormat::kA1R5G5B5;
+			if( isMask( 0x7c00, 0x03e0, 0x001f, 0x0000 ) )					return DDSDXGIFormat::kX1R5G5B5;
+			if( isMask( 0x0f00, 0x00f0, 0x000f, 0xf000 ) )					return DDSDXGIFormat::kA4R4G4B4;
+			if( isMask( 0x0f00, 0x00f0, 0x000f, 0x0000 ) )					return DDSDXGIFormat::kX4R4G4B4;
+			break;
+		}
+	}
+	else if( CheckFlags( flags, kDDSPixelFormatFlagLuminance ) )
+	{
+		if( bitCount ==  8 && isMask( 0x00ff, 0, 0, 0x0000 ) )				return DDSDXGIFormat::kL8;
+		if( bitCount == 16 && isMask( 0x00ff, 0, 0, 0xff00 ) )				return DDSDXGIFormat::kA8L8;
+		if( bitCount == 16 && isMask( 0xffff, 0, 0, 0x0000 ) )				return DDSDXGIFormat::kL16;
+	}
+	else if( CheckFlags( flags, kDDSPixelFormatFlagAlpha ) )
+	{
+		if( bitCount == 8 && pf.dwABitMask == 0xff )						return DDSDXGIFormat::kA8;
+	}
+
+	return DDSDXGIFormat::kUnknown;
+}
+
 //---------------------------------------------------------------------------
 //	ミップマップ数取得.
 //---------------------------------------------------------------------------
@@ -240,6 +342,43 @@ bool DDSAccessor::IsVolumeTexture() const
 	return false;
 }
 
+//---------------------------------------------------------------------------
+//	DX10拡張ヘッダー付きの2DテクスチャのDDSヘッダー書き込み.
+//---------------------------------------------------------------------------
+void WriteDDSHeaderDX10( void* dest, u32 width, u32 height, u32 mipCount, u32 arrayCount, PixelFormat format )
+{
+	SurfaceInfo info;
+	CalcSurfaceInfo( &info, width, height, format );
+	ImageSize blockSize;
+	GetPixelBlockSize( &blockSize, format );
+	const bool compressed = blockSize.width > 1 || blockSize.height > 1;
+
+	DDSHeader header;
+	memory::Clear( header );
+	header.dwMagic					= kDDSMagicID;
+	header.dwSize					= kDDSHeaderSize;
+	header.dwFlags					= kDDSHeaderFlagTexture | ( compressed ? kDDSHeaderFlagLinerSize : kDDSHeaderFlagPitch ) | ( mipCount > 1 ? kDDSHeaderFlagMipMap : 0 );
+	header.dwHeight					= height;
+	header.dwWidth					= width;
+	header.dwPitchOrLinearSize		= compressed ? info.bytes : info.pitchBytes;
+	header.dwMipMapCount			= mipCount;
+	header.dwPixelFormat.dwPfSize	= kDDSPixelFormatSize;
+	header.dwPixelFormat.dwPfFlags	= kDDSPixelFormatFlagFourCC;
+	header.dwPixelFormat.dwFourCC	= DDSFormatFourCC::kDX10;
+	header.dwCaps					= kDDSCapFlagTexture | ( mipCount > 1 ? kDDSCapFlagMipMap : 0 );
+
+	// dxgiFormatにはDXGI_FORMATの値(PixelFormatと同じ並び)を格納する.
+	DDSHeaderDX10 headerDX10;
+	memory::Clear( headerDX10 );
+	headerDX10.dxgiFormat	= static_cast< DDSDXGIFormat >( format );
+	headerDX10.resourceType	= DDSResourceType::kTexture2D;
+	headerDX10.arraySize	= arrayCount;
+
+	u8* out = static_cast< u8* >( dest );
+	memcpy( out, &header, sizeof( header ) );
+	memcpy( out + sizeof( header ), &headerDX10, sizeof( headerDX10 ) );
+}
+
 namespace
 {
 //---------------------------------------------------------------------------
@@ -284,6 +423,7 @@ bool IsValidForNormal( const DDSHeader& ddsHeader )
 bool IsValidForDX10( const DDSHeaderDX10& ddsHeaderDX10 )
 {
 	// TODO: 作成.
+	AROMA_UNUSED( ddsHeaderDX10 );
 	return true;
 }
 
@@ -292,7 +432,42 @@ bool IsValidForDX10( const DDSHeaderDX10& ddsHeaderDX10 )
 //---------------------------------------------------------------------------
 PixelFormat ToAromaPixelFormat( DDSDXGIFormat dxgiFormat )
 {
-	AROMA_ASSERT( false, _T( "Unsupport Format.\n" ) );
+	// DX10拡張ヘッダーにはDXGI_FORMATの値が格納されており,
+	// PixelFormatはDXGI_FORMATと同じ並びで定義している.
+	const u32 value = static_cast< u32 >( dxgiFormat );
+	if( value == 0 || value >= static_cast< u32 >( PixelFormat::kNum ) )
+	{
+		AROMA_ASSERT( false, _T( "Unsupport Format.\n" ) );
+		return PixelFormat::kUnknown;
+	}
+	return static_cast< PixelFormat >( value );
+}
+
+//---------------------------------------------------------------------------
+//	旧形式のフォーマットからGPUが直接扱えるピクセルフォーマットに変換.
+//	変換が必要なフォーマットはPixelFormat::kUnknown.
+//---------------------------------------------------------------------------
+PixelFormat LegacyToPixelFormat( DDSDXGIFormat legacyFormat )
+{
+	switch( legacyFormat )
+	{
+	case DDSDXGIFormat::kA8R8G8B8:			return PixelFormat::kB8G8R8A8Unorm;
+	case DDSDXGIFormat::kX8R8G8B8:			return PixelFormat::kB8G8R8X8Unorm;
+	case DDSDXGIFormat::kA8B8G8R8:			return PixelFormat::kR8G8B8A8Unorm;
+	case DDSDXGIFormat::kA2B10G10R10:		return PixelFormat::kR10G10B10A2Unorm;
+	case DDSDXGIFormat::kG16R16:			return PixelFormat::kR16G16Unorm;
+	case DDSDXGIFormat::kA8:				return PixelFormat::kA8Unorm;
+	case DDSDXGIFormat::kA16B16G16R16:		return PixelFormat::kR16G16B16A16Unorm;
+	case DDSDXGIFormat::kQ16W16V16U16:		return PixelFormat::kR16G16B16A16Snorm;
+	case DDSDXGIFormat::kR16F:				return PixelFormat::kR16Float;
+	case DDSDXGIFormat::kG16R16F:			return PixelFormat::kR16G16Float;
+	case DDSDXGIFormat::kA16B16G16R16F:		return PixelFormat::kR16G16B16A16Float;
+	case DDSDXGIFormat::kR32F:				return PixelFormat::kR32Float;
+	case DDSDXGIFormat::kG32R32F:			return PixelFormat::kR32G32Float;
+	case DDSDXGIFormat::kA32B32G32R32F:		return PixelFormat::kR32G32B32A32Float;
+	default:
+		break;
+	}
 	return PixelFormat::kUnknown;
 }
 
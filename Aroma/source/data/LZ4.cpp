@@ -0,0 +1,251 @@
+﻿//===========================================================================
+//!
+//!	@file		LZ4.cpp
+//!	@brief		LZ4ブロック圧縮.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <cstring>
+#include <vector>
+#include <aroma/data/LZ4.h>
+
+namespace aroma {
+namespace data {
+
+namespace
+{
+	//! 最小一致長.
+	constexpr size_t kMinMatch		= 4;
+
+	//! 末尾はこのバイト数をリテラルとする(フォーマットの制約).
+	constexpr size_t kLastLiterals	= 5;
+
+	//! 末尾からこのバイト数以内では一致を開始しない(フォーマットの制約).
+	constexpr size_t kMatchLimit	= 12;
+
+	//! 一致検索の最大距離.
+	constexpr size_t kMaxDistance	= 65535;
+
+	//! ハッシュテーブルのビット数.
+	constexpr u32 kHashBits			= 14;
+
+	//-----------------------------------------------------------------------
+	//	4バイト読み込み(非アライン).
+	//-----------------------------------------------------------------------
+	u32 Read32( const u8* p )
+	{
+		u32 value;
+		memcpy( &value, p, sizeof( value ) );
+		return value;
+	}
+
+	//-----------------------------------------------------------------------
+	//	4バイトのハッシュ.
+	//-----------------------------------------------------------------------
+	u32 Hash4( u32 sequence )
+	{
+		return ( sequence * 2654435761u ) >> ( 32 - kHashBits );
+	}
+
+	//-----------------------------------------------------------------------
+	//	長さの追加バイト書き込み.
+	//-----------------------------------------------------------------------
+	u8* WriteLength( u8* op, size_t length )
+	{
+		while( length >= 255 )
+		{
+			*op++ = 255;
+			length -= 255;
+		}
+		*op++ = static_cast< u8 >( length );
+		return op;
+	}
+
+	//-----------------------------------------------------------------------
+	//	長さの追加バイト読み込み.
+	//-----------------------------------------------------------------------
+	bool ReadLength( const u8** ip, const u8* ipEnd, size_t* length )
+	{
+		u8 value;
+		do
+		{
+			if( *ip >= ipEnd ) return false;
+			value = *(*ip)++;
+			*length += value;
+		} while( value == 255 );
+		return true;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	圧縮後の最大サイズ取得.
+//---------------------------------------------------------------------------
+size_t LZ4::GetCompressBound( size_t srcBytes )
+{
+	return srcBytes + srcBytes / 255 + 16;
+}
+
+//---------------------------------------------------------------------------
+//	圧縮.
+//---------------------------------------------------------------------------
+size_t LZ4::Compress( const void* src, size_t srcBytes, void* dst, size_t dstCapacity )
+{
+	const u8* const	base	= static_cast< const u8* >( src );
+	const u8* const	ipEnd	= base + srcBytes;
+	u8* const		opBegin	= static_cast< u8* >( dst );
+	u8* const		opEnd	= opBegin + dstCapacity;
+	u8*				op		= opBegin;
+	const u8*		anchor	= base;
+
+	// 一致の書き出し(リテラル + オフセット + 一致長).
+	auto emitSequence = [ & ]( const u8* literal, size_t literalLength, size_t offset, size_t matchLength ) -> bool
+	{
+		const size_t required = 1 + literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1;
+		if( static_cast< size_t >( opEnd - op ) < required ) return false;
+
+		u8* token = op++;
+		*token = static_cast< u8 >( ( literalLength < 15 ? literalLength : 15 ) << 4 );
+		if( literalLength >= 15 ) op = WriteLength( op, literalLength - 15 );
+		// 空の入力ではliteralがnullptrの場合があるため, 0バイトのコピーも行わない.
+		if( literalLength > 0 ) memcpy( op, literal, literalLength );
+		op += literalLength;
+		if( matchLength == 0 ) return true;
+
+		*op++ = static_cast< u8 >( offset );
+		*op++ = static_cast< u8 >( offset >> 8 );
+		const size_t code = matchLength - kMinMatch;
+		*token |= static_cast< u8 >( code < 15 ? code : 15 );
+		if( code >= 15 ) op = WriteLength( op, code - 15 );
+		return true;
+	};
+
+	if( srcBytes > kMatchLimit )
+	{
+		// 位置はbaseからのオフセット+1で保持する(0は未登録).
+		std::vector< u32 > table( 1u << kHashBits, 0 );
+		const u8* const matchStartLimit	= ipEnd - kMatchLimit;
+		const u8* const matchEndLimit	= ipEnd - kLastLiterals;
+		const u8* ip = base;
+		u32 searchCount = 0;
+		while( ip < matchStartLimit )
+		{
+			const u32 sequence	= Read32( ip );
+			const u32 hash		= Hash4( sequence );
+			const u32 entry		= table[ hash ];
+			table[ hash ]		= static_cast< u32 >( ip - base ) + 1;
+
+			// 未登録(0)からbase - 1を作らないよう, 登録済みの場合のみ参照位置を求める.
+			const u8* ref = entry != 0 ? base + ( entry - 1 ) : nullptr;
+			if( ref == nullptr || static_cast< size_t >( ip - ref ) > kMaxDistance || Read32( ref ) != sequence )
+			{
+				// 一致しない区間が続く場合は探索間隔を広げる.
+				ip += 1 + ( searchCount++ >> 6 );
+				continue;
+			}
+			searchCount = 0;
+
+			// 一致を前後に伸ばす.
+			while( ip > anchor && ref > base && ip[ -1 ] == ref[ -1 ] )
+			{
+				--ip;
+				--ref;
+			}
+			size_t matchLength = kMinMatch;
+			while( ip + matchLength < matchEndLimit && ip[ matchLength ] == ref[ matchLength ] )
+			{
+				++matchLength;
+			}
+
+			if( !emitSequence( anchor, static_cast< size_t >( ip - anchor ), static_cast< size_t >( ip - ref ), matchLength ) )
+			{
+				return 0;
+			}
+			ip		+= matchLength;
+			anchor	= ip;
+
+			// 一致の末尾付近も登録して次の一致を見つけやすくする.
+			if( ip - 2 > base && ip < matchStartLimit )
+			{
+				table[ Hash4( Read32( ip - 2 ) ) ] = static_cast< u32 >( ip - 2 - base ) + 1;
+			}
+		}
+	}
+
+	// 残りは全てリテラル.
+	if( !emitSequence( anchor, static_cast< size_t >( ipEnd - anchor ), 0, 0 ) )
+	{
+		return 0;
+	}
+	return static_cast< size_t >( op - opBegin );
+}
+
+//---------------------------------------------------------------------------
+//	展開.
+//---------------------------------------------------------------------------
+bool LZ4::Decompress( const void* src, size_t srcBytes, void* dst, size_t dstBytes )
+{
+	const u8*		ip		= static_cast< const u8* >( src );
+	const u8* const	ipEnd	= ip + srcBytes;
+	u8* const		opBegin	= static_cast< u8* >( dst );
+	u8*				op		= opBegin;
+	u8* const		opEnd	= opBegin + dstBytes;
+
+	while( ip < ipEnd )
+	{
+		const u32 token = *ip++;
+
+		// リテラル.
+		size_t literalLength = token >> 4;
+		if( literalLength == 15 && !ReadLength( &ip, ipEnd, &literalLength ) ) return false;
+		if( literalLength > static_cast< size_t >( ipEnd - ip ) || literalLength > static_cast< size_t >( opEnd - op ) ) return false;
+		// 空の出力ではopがnullptrの場合があるため, 0バイトのコピーも行わない.
+		if( literalLength > 0 ) memcpy( op, ip, literalLength );
+		ip += literalLength;
+		op += literalLength;
+
+		// 最後のシーケンスはリテラルのみ.
+		if( ip == ipEnd ) break;
+
+		// 一致.
+		if( ipEnd - ip < 2 ) return false;
+		const size_t offset = static_cast< size_t >( ip[ 0 ] ) | ( static_cast< size_t >( ip[ 1 ] ) << 8 );
+		ip += 2;
+		if( offset == 0 || offset > static_cast< size_t >( op - opBegin ) ) return false;
+
+		size_t matchLength = token & 15;
+		if( matchLength == 15 && !ReadLength( &ip, ipEnd, &matchLength ) ) return false;
+		matchLength += kMinMatch;
+		if( matchLength > static_cast< size_t >( opEnd - op ) ) return false;
+
+		const u8* match = op - offset;
+		if( offset >= matchLength )
+		{
+			memcpy( op, match, matchLength );
+			op += matchLength;
+		}
+		else if( offset >= 8 )
+		{
+			// 重なりが8バイト以上離れていれば8バイト単位で複製できる.
+			u8* const copyEnd = op + matchLength;
+			while( op + 8 <= copyEnd )
+			{
+				memcpy( op, match, 8 );
+				op		+= 8;
+				match	+= 8;
+			}
+			while( op < copyEnd ) *op++ = *match++;
+		}
+		else
+		{
+			// 短い周期の繰り返し.
+			for( size_t i = 0; i < matchLength; ++i ) *op++ = *match++;
+		}
+	}
+
+	return op == opEnd;
+}
+
+} // namespace data
+} // namespace aroma
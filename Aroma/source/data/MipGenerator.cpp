@@ -0,0 +1,924 @@
+﻿//===========================================================================
+//!
+//!	@file		MipGenerator.cpp
+//!	@brief		ミップマップ生成.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <aroma/data/MipGenerator.h>
+#include <aroma/data/PixelConvert.h>
+#include <aroma/common/Algorithm.h>
+#include <aroma/common/Task.h>
+
+// x86/x64ではSSE2が常に使用できる.
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define AROMA_MIP_SIMD_ENABLE 1
+#elif defined( __SSE2__ )
+#include <emmintrin.h>
+#define AROMA_MIP_SIMD_ENABLE 1
+#endif
+
+namespace aroma {
+namespace data {
+
+namespace
+{
+	//! 円周率.
+	constexpr f64 kPi				= 3.14159265358979323846;
+
+	//! sinc系フィルターの半径(出力ピクセル単位).
+	constexpr f64 kFilterRadius		= 3.0;
+
+	//! カイザー窓のα.
+	constexpr f64 kKaiserAlpha		= 4.0;
+
+	//! 1ジョブで生成する最小の行数(帯毎に重複する縦フィルターの入力行を抑える).
+	constexpr u32 kBandRowsMin		= 16;
+
+	//! 1ジョブで生成するピクセル数の目安.
+	constexpr u32 kBandPixels		= 64 * 1024;
+
+	//! sRGB量子化表の最小の指数(2^-13. これ未満の線形値は常に0へ量子化される).
+	constexpr u32 kSrgbEncodeExponentMin	= 127 - 13;
+
+	//! sRGB量子化表の仮数の分割ビット数.
+	constexpr u32 kSrgbEncodeMantissaBits	= 8;
+
+	//! sRGB量子化表の要素数(2^-13から1.0未満までの区間と1.0).
+	constexpr u32 kSrgbEncodeBucketCount	= ( ( 127 - kSrgbEncodeExponentMin ) << kSrgbEncodeMantissaBits ) + 1;
+
+	//-----------------------------------------------------------------------
+	//	フォーマット情報.
+	//-----------------------------------------------------------------------
+	struct FormatInfo
+	{
+		u32		channelCount;		// 1ピクセルのチャンネル数(各8bit).
+		s32		alphaIndex;			// アルファのチャンネル(無い場合は-1).
+		bool	srgb;				// 色チャンネルをsRGBとして扱う.
+	};
+
+	//-----------------------------------------------------------------------
+	//	フィルターの入力ピクセルと重み.
+	//-----------------------------------------------------------------------
+	struct Tap
+	{
+		u32		index;
+		f32		weight;
+	};
+
+	//-----------------------------------------------------------------------
+	//	1方向のフィルター表.
+	//-----------------------------------------------------------------------
+	struct FilterTable
+	{
+		std::vector< u32 >	offsets;		// 出力ピクセル毎のtapsの開始位置(出力数+1).
+		std::vector< Tap >	taps;
+	};
+
+	//-----------------------------------------------------------------------
+	//	1ミップの生成に必要な情報.
+	//-----------------------------------------------------------------------
+	struct LevelContext
+	{
+		const u8*			src;
+		size_t				srcPitch;
+		u32					srcWidth;
+		u32					srcHeight;
+		u8*					dst;
+		size_t				dstPitch;
+		u32					dstWidth;
+		u32					dstHeight;
+		FormatInfo			format;
+		const FilterTable*	horizontal;
+		const FilterTable*	vertical;
+	};
+
+	//-----------------------------------------------------------------------
+	//	並列生成で共有する状態.
+	//-----------------------------------------------------------------------
+	struct GenerateState
+	{
+		TaskPromise< bool >		promise;
+		std::atomic< u32 >		nextBand;
+		std::atomic< u32 >		remainingCount;
+	};
+
+	//-----------------------------------------------------------------------
+	//	sRGB変換表.
+	//
+	//	量子化は線形値のビット列の上位(指数と仮数の上位8bit)で区間を引き,
+	//	区間の先頭の量子化値と次の閾値を1回比較して求める.
+	//	隣接する閾値の比は1 + 1/113以上, 区間の幅は区間の先頭の1/256のため, 1区間に閾値は高々1つ.
+	//-----------------------------------------------------------------------
+	struct SrgbTable
+	{
+		f32		toLinear[ 256 ];
+		f32		threshold[ 256 ];							// 線形値がthreshold[ i ]以上ならi + 1以上に量子化される(threshold[ 255 ]は番兵).
+		u8		encodeBase[ kSrgbEncodeBucketCount ];		// 区間の先頭の量子化値.
+
+		SrgbTable()
+		{
+			for( u32 i = 0; i < 256; ++i )
+			{
+				toLinear[ i ] = ToLinear( i / 255.0 );
+			}
+			for( u32 i = 0; i < 255; ++i )
+			{
+				threshold[ i ] = ToLinear( ( i + 0.5 ) / 255.0 );
+			}
+			threshold[ 255 ] = FLT_MAX;
+
+			u32 value = 0;
+			for( u32 i = 0; i < kSrgbEncodeBucketCount; ++i )
+			{
+				const u32 bits = ( i + ( kSrgbEncodeExponentMin << kSrgbEncodeMantissaBits ) ) << ( 23 - kSrgbEncodeMantissaBits );
+				f32 begin;
+				memcpy( &begin, &bits, sizeof( begin ) );
+				while( begin >= threshold[ value ] ) ++value;
+				encodeBase[ i ] = static_cast< u8 >( value );
+			}
+		}
+
+		static f32 ToLinear( f64 value )
+		{
+			return static_cast< f32 >( value <= 0.04045 ? value / 12.92 : pow( ( value + 0.055 ) / 1.055, 2.4 ) );
+		}
+	};
+
+	const SrgbTable& GetSrgbTable()
+	{
+		static const SrgbTable table;
+		return table;
+	}
+
+	//-----------------------------------------------------------------------
+	//	量子化表の区間.
+	//-----------------------------------------------------------------------
+	u32 GetSrgbEncodeBucket( f32 value )
+	{
+		u32 bits;
+		memcpy( &bits, &value, sizeof( bits ) );
+		const s32 bucket = static_cast< s32 >( bits >> ( 23 - kSrgbEncodeMantissaBits ) ) - static_cast< s32 >( kSrgbEncodeExponentMin << kSrgbEncodeMantissaBits );
+		return static_cast< u32 >( Max( bucket, 0 ) );
+	}
+
+	//-----------------------------------------------------------------------
+	//	[0, 1]の線形値をsRGBへ量子化(sRGB空間で最も近い値).
+	//-----------------------------------------------------------------------
+	u8 EncodeSrgb( const SrgbTable& table, f32 value )
+	{
+		const u32 base = table.encodeBase[ GetSrgbEncodeBucket( value ) ];
+		return static_cast< u8 >( base + ( value >= table.threshold[ base ] ? 1 : 0 ) );
+	}
+
+	//-----------------------------------------------------------------------
+	//	4チャンネル演算.
+	//	横フィルターはピクセル毎にタップが異なるため, 1ピクセルのRGBAを1レジスタで扱う.
+	//-----------------------------------------------------------------------
+#ifdef AROMA_MIP_SIMD_ENABLE
+	using Vec4 = __m128;
+
+	Vec4 VecZero()								{ return _mm_setzero_ps(); }
+	Vec4 VecLoad( const f32* p )				{ return _mm_loadu_ps( p ); }
+	void VecStore( f32* p, Vec4 v )				{ _mm_storeu_ps( p, v ); }
+	Vec4 VecMulAdd( Vec4 sum, Vec4 v, f32 w )	{ return _mm_add_ps( sum, _mm_mul_ps( v, _mm_set1_ps( w ) ) ); }
+#else
+	struct Vec4
+	{
+		f32 v[ 4 ];
+	};
+
+	Vec4 VecZero()								{ Vec4 r = { { 0.0f, 0.0f, 0.0f, 0.0f } }; return r; }
+	Vec4 VecLoad( const f32* p )				{ Vec4 r = { { p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ] } }; return r; }
+	void VecStore( f32* p, Vec4 v )				{ memcpy( p, v.v, sizeof( v.v ) ); }
+	Vec4 VecMulAdd( Vec4 sum, Vec4 v, f32 w )
+	{
+		for( u32 i = 0; i < 4; ++i ) sum.v[ i ] += v.v[ i ] * w;
+		return sum;
+	}
+#endif // AROMA_MIP_SIMD_ENABLE
+
+	//-----------------------------------------------------------------------
+	//	フォーマット情報取得.
+	//-----------------------------------------------------------------------
+	bool GetFormatInfo( PixelFormat format, bool srgb, FormatInfo* outInfo )
+	{
+		switch( format )
+		{
+		case PixelFormat::kR8G8B8A8Unorm:
+		case PixelFormat::kB8G8R8A8Unorm:		*outInfo = { 4,  3, srgb };		return true;
+		case PixelFormat::kR8G8B8A8UnormSrgb:
+		case PixelFormat::kB8G8R8A8UnormSrgb:	*outInfo = { 4,  3, true };		return true;
+		case PixelFormat::kB8G8R8X8Unorm:		*outInfo = { 4, -1, srgb };		return true;
+		case PixelFormat::kB8G8R8X8UnormSrgb:	*outInfo = { 4, -1, true };		return true;
+		case PixelFormat::kR8G8Unorm:			*outInfo = { 2, -1, false };	return true;
+		case PixelFormat::kR8Unorm:				*outInfo = { 1, -1, false };	return true;
+		case PixelFormat::kA8Unorm:				*outInfo = { 1,  0, false };	return true;
+		default:
+			break;
+		}
+		return false;
+	}
+
+	//-----------------------------------------------------------------------
+	//	フィルター関数.
+	//-----------------------------------------------------------------------
+	f64 Sinc( f64 x )
+	{
+		if( fabs( x ) < 1.0e-9 ) return 1.0;
+		x *= kPi;
+		return sin( x ) / x;
+	}
+
+	f64 BesselI0( f64 x )
+	{
+		// 0次の第1種変形ベッセル関数(級数展開).
+		const f64 q = x * x * 0.25;
+		f64 sum		= 1.0;
+		f64 term	= 1.0;
+		for( u32 k = 1; k < 64 && term > sum * 1.0e-12; ++k )
+		{
+			term *= q / ( static_cast< f64 >( k ) * k );
+			sum += term;
+		}
+		return sum;
+	}
+
+	f64 EvaluateFilter( MipFilter filter, f64 t )
+	{
+		if( fabs( t ) >= kFilterRadius ) return 0.0;
+
+		const f64 r = t / kFilterRadius;
+		switch( filter )
+		{
+		case MipFilter::kKaiser:
+			return Sinc( t ) * BesselI0( kKaiserAlpha * sqrt( 1.0 - r * r ) ) / BesselI0( kKaiserAlpha );
+		case MipFilter::kLanczos:
+			return Sinc( t ) * Sinc( r );
+		default:
+			break;
+		}
+		return 0.0;
+	}
+
+	//-----------------------------------------------------------------------
+	//	フィルター表作成.
+	//	奇数サイズ等の縮小率が2でない場合も縮小率に合わせて重みを求める.
+	//-----------------------------------------------------------------------
+	void BuildFilterTable( u32 srcSize, u32 dstSize, MipFilter filter, bool wrap, FilterTable* outTable )
+	{
+		outTable->offsets.clear();
+		outTable->taps.clear();
+		outTable->offsets.reserve( dstSize + 1 );
+
+		const s64 size = srcSize;
+		auto addTap = [ & ]( s64 index, f64 weight )
+		{
+			index = wrap ? ( ( index % size ) + size ) % size : Min( Max< s64 >( index, 0 ), size - 1 );
+			Tap tap = { static_cast< u32 >( index ), static_cast< f32 >( weight ) };
+			outTable->taps.push_back( tap );
+		};
+
+		const f64 scale = static_cast< f64 >( srcSize ) / dstSize;
+		for( u32 d = 0; d < dstSize; ++d )
+		{
+			const size_t first = outTable->taps.size();
+			outTable->offsets.push_back( static_cast< u32 >( first ) );
+
+			if( srcSize == dstSize )
+			{
+				// 縮小しない方向(幅または高さが1)はそのまま.
+				addTap( d, 1.0 );
+				continue;
+			}
+
+			if( filter == MipFilter::kBox )
+			{
+				// 出力ピクセルが覆う入力の面積.
+				const f64 lo = d * scale;
+				const f64 hi = ( d + 1 ) * scale;
+				for( s64 i = static_cast< s64 >( floor( lo ) ); i < hi; ++i )
+				{
+					const f64 weight = Min( hi, i + 1.0 ) - Max( lo, static_cast< f64 >( i ) );
+					if( weight > 0.0 ) addTap( i, weight );
+				}
+			}
+			else
+			{
+				// 入力ピクセルの中心で出力側の間隔に伸ばしたフィルターを評価.
+				const f64 center = ( d + 0.5 ) * scale;
+				const f64 radius = kFilterRadius * scale;
+				const s64 begin	= static_cast< s64 >( floor( center - radius ) );
+				const s64 end	= static_cast< s64 >( ceil( center + radius ) );
+				for( s64 i = begin; i <= end; ++i )
+				{
+					const f64 weight = EvaluateFilter( filter, ( i + 0.5 - center ) / scale );
+					if( weight != 0.0 ) addTap( i, weight );
+				}
+			}
+
+			// 重みの合計を1に正規化.
+			f64 sum = 0.0;
+			for( size_t i = first; i < outTable->taps.size(); ++i ) sum += outTable->taps[ i ].weight;
+			for( size_t i = first; i < outTable->taps.size(); ++i ) outTable->taps[ i ].weight = static_cast< f32 >( outTable->taps[ i ].weight / sum );
+		}
+		outTable->offsets.push_back( static_cast< u32 >( outTable->taps.size() ) );
+	}
+
+#ifdef AROMA_MIP_SIMD_ENABLE
+	//-----------------------------------------------------------------------
+	//	4チャンネル形式の1行を4ピクセルずつ展開(展開したピクセル数を返す. 残りはスカラー版で展開).
+	//	4ピクセルをチャンネル毎のレジスタへ転置して演算する.
+	//-----------------------------------------------------------------------
+	u32 DecodeRowSimd( const FormatInfo& format, const u8* src, u32 width, f32* dst )
+	{
+		const SrgbTable& table	= GetSrgbTable();
+		const __m128i zero		= _mm_setzero_si128();
+		const __m128 scale		= _mm_set1_ps( 1.0f / 255.0f );
+
+		u32 x = 0;
+		for( ; x + 4 <= width; x += 4, src += 16, dst += 16 )
+		{
+			const __m128i bytes	= _mm_loadu_si128( reinterpret_cast< const __m128i* >( src ) );
+			const __m128i lo	= _mm_unpacklo_epi8( bytes, zero );
+			const __m128i hi	= _mm_unpackhi_epi8( bytes, zero );
+			__m128 p0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) );
+			__m128 p1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) );
+			__m128 p2 = _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) );
+			__m128 p3 = _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) );
+			_MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+
+			// p0-p3はR, G, B, Aの4ピクセル分.
+			if( format.srgb )
+			{
+				p0 = _mm_setr_ps( table.toLinear[ src[ 0 ] ], table.toLinear[ src[ 4 ] ], table.toLinear[ src[  8 ] ], table.toLinear[ src[ 12 ] ] );
+				p1 = _mm_setr_ps( table.toLinear[ src[ 1 ] ], table.toLinear[ src[ 5 ] ], table.toLinear[ src[  9 ] ], table.toLinear[ src[ 13 ] ] );
+				p2 = _mm_setr_ps( table.toLinear[ src[ 2 ] ], table.toLinear[ src[ 6 ] ], table.toLinear[ src[ 10 ] ], table.toLinear[ src[ 14 ] ] );
+			}
+			else
+			{
+				p0 = _mm_mul_ps( p0, scale );
+				p1 = _mm_mul_ps( p1, scale );
+				p2 = _mm_mul_ps( p2, scale );
+			}
+			p3 = _mm_mul_ps( p3, scale );
+			if( format.alphaIndex == 3 )
+			{
+				p0 = _mm_mul_ps( p0, p3 );
+				p1 = _mm_mul_ps( p1, p3 );
+				p2 = _mm_mul_ps( p2, p3 );
+			}
+
+			_MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+			_mm_storeu_ps( dst +  0, p0 );
+			_mm_storeu_ps( dst +  4, p1 );
+			_mm_storeu_ps( dst +  8, p2 );
+			_mm_storeu_ps( dst + 12, p3 );
+		}
+		return x;
+	}
+
+	//-----------------------------------------------------------------------
+	//	[0, 1]の線形値4つをsRGBへ量子化.
+	//	区間の計算と閾値の比較はSIMDで行い, 表の参照のみスカラーで行う.
+	//-----------------------------------------------------------------------
+	__m128i EncodeSrgbSimd( const SrgbTable& table, __m128 value )
+	{
+		__m128i bucket = _mm_sub_epi32( _mm_srli_epi32( _mm_castps_si128( value ), 23 - kSrgbEncodeMantissaBits ), _mm_set1_epi32( kSrgbEncodeExponentMin << kSrgbEncodeMantissaBits ) );
+		bucket = _mm_and_si128( bucket, _mm_cmpgt_epi32( bucket, _mm_set1_epi32( -1 ) ) );
+
+		const u32 base0 = table.encodeBase[ _mm_cvtsi128_si32( bucket ) ];
+		const u32 base1 = table.encodeBase[ _mm_cvtsi128_si32( _mm_shuffle_epi32( bucket, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) ];
+		const u32 base2 = table.encodeBase[ _mm_cvtsi128_si32( _mm_shuffle_epi32( bucket, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) ];
+		const u32 base3 = table.encodeBase[ _mm_cvtsi128_si32( _mm_shuffle_epi32( bucket, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ) ];
+
+		// 閾値以上のレーンは比較結果(-1)を引いて1つ上の値にする.
+		const __m128i base		= _mm_setr_epi32( base0, base1, base2, base3 );
+		const __m128 threshold	= _mm_setr_ps( table.threshold[ base0 ], table.threshold[ base1 ], table.threshold[ base2 ], table.threshold[ base3 ] );
+		return _mm_sub_epi32( base, _mm_castps_si128( _mm_cmpge_ps( value, threshold ) ) );
+	}
+
+	//-----------------------------------------------------------------------
+	//	4チャンネル形式の1行を4ピクセルずつ量子化(量子化したピクセル数を返す. 残りはスカラー版で量子化).
+	//-----------------------------------------------------------------------
+	u32 EncodeRowSimd( const FormatInfo& format, const f32* src, u32 width, u8* dst )
+	{
+		const SrgbTable& table	= GetSrgbTable();
+		const __m128 zero		= _mm_setzero_ps();
+		const __m128 one		= _mm_set1_ps( 1.0f );
+		const __m128 epsilon	= _mm_set1_ps( 1.0e-6f );
+		const __m128 scale		= _mm_set1_ps( 255.0f );
+		const __m128 half		= _mm_set1_ps( 0.5f );
+
+		u32 x = 0;
+		for( ; x + 4 <= width; x += 4, src += 16, dst += 16 )
+		{
+			__m128 r = _mm_loadu_ps( src +  0 );
+			__m128 g = _mm_loadu_ps( src +  4 );
+			__m128 b = _mm_loadu_ps( src +  8 );
+			__m128 a = _mm_loadu_ps( src + 12 );
+			_MM_TRANSPOSE4_PS( r, g, b, a );
+
+			if( format.alphaIndex == 3 )
+			{
+				// アルファの乗算を戻す(負のローブでアルファが0以下になった場合は色も0).
+				const __m128 inverse = _mm_and_ps( _mm_cmpgt_ps( a, epsilon ), _mm_div_ps( one, a ) );
+				r = _mm_mul_ps( r, inverse );
+				g = _mm_mul_ps( g, inverse );
+				b = _mm_mul_ps( b, inverse );
+			}
+			r = _mm_min_ps( _mm_max_ps( r, zero ), one );
+			g = _mm_min_ps( _mm_max_ps( g, zero ), one );
+			b = _mm_min_ps( _mm_max_ps( b, zero ), one );
+			a = _mm_min_ps( _mm_max_ps( a, zero ), one );
+
+			__m128i r8, g8, b8;
+			if( format.srgb )
+			{
+				r8 = EncodeSrgbSimd( table, r );
+				g8 = EncodeSrgbSimd( table, g );
+				b8 = EncodeSrgbSimd( table, b );
+			}
+			else
+			{
+				r8 = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( r, scale ), half ) );
+				g8 = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( g, scale ), half ) );
+				b8 = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( b, scale ), half ) );
+			}
+			const __m128i a8 = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( a, scale ), half ) );
+
+			// チャンネルcをバイトcへ詰める(x86はリトルエンディアン).
+			const __m128i packed = _mm_or_si128( _mm_or_si128( r8, _mm_slli_epi32( g8, 8 ) ), _mm_or_si128( _mm_slli_epi32( b8, 16 ), _mm_slli_epi32( a8, 24 ) ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( dst ), packed );
+		}
+		return x;
+	}
+#endif // AROMA_MIP_SIMD_ENABLE
+
+	//-----------------------------------------------------------------------
+	//	1行を線形空間のRGBA(色はアルファを乗算済み)へ展開.
+	//-----------------------------------------------------------------------
+	void DecodeRow( const FormatInfo& format, const u8* src, u32 width, f32* dst )
+	{
+		u32 x = 0;
+#ifdef AROMA_MIP_SIMD_ENABLE
+		if( format.channelCount == 4 )
+		{
+			x = DecodeRowSimd( format, src, width, dst );
+			src += x * 4;
+			dst += x * 4;
+		}
+#endif
+
+		const SrgbTable& table = GetSrgbTable();
+		for( ; x < width; ++x, src += format.channelCount, dst += 4 )
+		{
+			dst[ 0 ] = dst[ 1 ] = dst[ 2 ] = dst[ 3 ] = 0.0f;
+			for( u32 c = 0; c < format.channelCount; ++c )
+			{
+				const bool srgb = format.srgb && c < 3;
+				dst[ c ] = srgb ? table.toLinear[ src[ c ] ] : src[ c ] * ( 1.0f / 255.0f );
+			}
+			if( format.alphaIndex == 3 )
+			{
+				dst[ 0 ] *= dst[ 3 ];
+				dst[ 1 ] *= dst[ 3 ];
+				dst[ 2 ] *= dst[ 3 ];
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//	1行を量子化して書き込み.
+	//-----------------------------------------------------------------------
+	void EncodeRow( const FormatInfo& format, const f32* src, u32 width, u8* dst )
+	{
+		u32 x = 0;
+#ifdef AROMA_MIP_SIMD_ENABLE
+		if( format.channelCount == 4 )
+		{
+			x = EncodeRowSimd( format, src, width, dst );
+			src += x * 4;
+			dst += x * 4;
+		}
+#endif
+
+		const SrgbTable& table = GetSrgbTable();
+		for( ; x < width; ++x, src += 4, dst += format.channelCount )
+		{
+			f32 pixel[ 4 ] = { src[ 0 ], src[ 1 ], src[ 2 ], src[ 3 ] };
+			if( format.alphaIndex == 3 )
+			{
+				// アルファの乗算を戻す(負のローブでアルファが0以下になった場合は色も0).
+				const f32 scale = pixel[ 3 ] > 1.0e-6f ? 1.0f / pixel[ 3 ] : 0.0f;
+				pixel[ 0 ] *= scale;
+				pixel[ 1 ] *= scale;
+				pixel[ 2 ] *= scale;
+			}
+			for( u32 c = 0; c < format.channelCount; ++c )
+			{
+				const f32 value = Min( Max( pixel[ c ], 0.0f ), 1.0f );
+				const bool srgb = format.srgb && c < 3;
+				dst[ c ] = srgb ? EncodeSrgb( table, value ) : static_cast< u8 >( value * 255.0f + 0.5f );
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//	横方向のフィルター.
+	//-----------------------------------------------------------------------
+	void FilterRowHorizontal( const FilterTable& table, const f32* src, u32 dstWidth, f32* dst )
+	{
+		for( u32 x = 0; x < dstWidth; ++x )
+		{
+			Vec4 sum = VecZero();
+			for( u32 i = table.offsets[ x ]; i < table.offsets[ x + 1 ]; ++i )
+			{
+				const Tap& tap = table.taps[ i ];
+				sum = VecMulAdd( sum, VecLoad( src + tap.index * 4 ), tap.weight );
+			}
+			VecStore( dst + x * 4, sum );
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//	縦方向のフィルター(1入力行分を加算).
+	//	全要素に同じ重みを掛けるため, ピクセルの境界に関係なく連続したfloatとして扱う.
+	//-----------------------------------------------------------------------
+	void AccumulateRow( const f32* src, f32 weight, u32 width, f32* dst )
+	{
+		const size_t count = static_cast< size_t >( width ) * 4;
+		size_t i = 0;
+#ifdef AROMA_MIP_SIMD_ENABLE
+		const __m128 w = _mm_set1_ps( weight );
+		for( ; i + 16 <= count; i += 16 )
+		{
+			_mm_storeu_ps( dst + i +  0, _mm_add_ps( _mm_loadu_ps( dst + i +  0 ), _mm_mul_ps( _mm_loadu_ps( src + i +  0 ), w ) ) );
+			_mm_storeu_ps( dst + i +  4, _mm_add_ps( _mm_loadu_ps( dst + i +  4 ), _mm_mul_ps( _mm_loadu_ps( src + i +  4 ), w ) ) );
+			_mm_storeu_ps( dst + i +  8, _mm_add_ps( _mm_loadu_ps( dst + i +  8 ), _mm_mul_ps( _mm_loadu_ps( src + i +  8 ), w ) ) );
+			_mm_storeu_ps( dst + i + 12, _mm_add_ps( _mm_loadu_ps( dst + i + 12 ), _mm_mul_ps( _mm_loadu_ps( src + i + 12 ), w ) ) );
+		}
+#endif
+		for( ; i < count; ++i )
+		{
+			dst[ i ] += src[ i ] * weight;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//	出力行の帯を生成.
+	//-----------------------------------------------------------------------
+	void FilterBand( const LevelContext& context, u32 rowBegin, u32 rowEnd )
+	{
+		const FilterTable& vertical = *context.vertical;
+
+		// 帯で使用する入力行に横フィルター済みの行を割り当てる.
+		std::vector< s32 > slots( context.srcHeight, -1 );
+		u32 slotCount = 0;
+		for( u32 i = vertical.offsets[ rowBegin ]; i < vertical.offsets[ rowEnd ]; ++i )
+		{
+			const u32 row = vertical.taps[ i ].index;
+			if( slots[ row ] < 0 ) slots[ row ] = static_cast< s32 >( slotCount++ );
+		}
+
+		const size_t rowFloats = static_cast< size_t >( context.dstWidth ) * 4;
+		std::vector< f32 > filtered( slotCount * rowFloats );
+		std::vector< f32 > decoded( static_cast< size_t >( context.srcWidth ) * 4 );
+		for( u32 row = 0; row < context.srcHeight; ++row )
+		{
+			if( slots[ row ] < 0 ) continue;
+			DecodeRow( context.format, context.src + row * context.srcPitch, context.srcWidth, decoded.data() );
+			FilterRowHorizontal( *context.horizontal, decoded.data(), context.dstWidth, filtered.data() + slots[ row ] * rowFloats );
+		}
+
+		std::vector< f32 > sum( rowFloats );
+		for( u32 y = rowBegin; y < rowEnd; ++y )
+		{
+			std::fill( sum.begin(), sum.end(), 0.0f );
+			for( u32 i = vertical.offsets[ y ]; i < vertical.offsets[ y + 1 ]; ++i )
+			{
+				const Tap& tap = vertical.taps[ i ];
+				AccumulateRow( filtered.data() + slots[ tap.index ] * rowFloats, tap.weight, context.dstWidth, sum.data() );
+			}
+			EncodeRow( context.format, sum.data(), context.dstWidth, context.dst + y * context.dstPitch );
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//	1ミップを生成.
+	//-----------------------------------------------------------------------
+	void GenerateLevel( const LevelContext& context, IScheduler* scheduler )
+	{
+		const u32 bandRows	= Max( kBandRowsMin, kBandPixels / context.dstWidth );
+		const u32 bandCount	= ( context.dstHeight + bandRows - 1 ) / bandRows;
+
+		auto filterBand = [ context, bandRows ]( u32 band )
+		{
+			const u32 rowBegin = band * bandRows;
+			FilterBand( context, rowBegin, Min( rowBegin + bandRows, context.dstHeight ) );
+		};
+
+		if( scheduler == nullptr || bandCount == 1 )
+		{
+			for( u32 band = 0; band < bandCount; ++band )
+			{
+				filterBand( band );
+			}
+			return;
+		}
+
+		// ワーカーと呼び出しスレッドが未処理の帯を順に取り合う.
+		auto state = std::make_shared< GenerateState >();
+		Task< bool > task		= state->promise.GetTask();
+		state->nextBand			= 0;
+		state->remainingCount	= bandCount;
+
+		auto work = [ state, filterBand, bandCount ]()
+		{
+			for( ;; )
+			{
+				const u32 band = state->nextBand.fetch_add( 1, std::memory_order_relaxed );
+				if( band >= bandCount ) break;
+
+				filterBand( band );
+
+				// 最後に完了した帯が一度だけ完了を通知する.
+				if( state->remainingCount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+				{
+					state->promise.SetValue( true );
+				}
+			}
+		};
+
+		for( u32 i = 1; i < bandCount; ++i )
+		{
+			scheduler->Schedule( work );
+		}
+		work();
+		task.Wait();
+	}
+
+	//-----------------------------------------------------------------------
+	//	アルファのヒストグラム作成.
+	//-----------------------------------------------------------------------
+	void BuildAlphaHistogram( const u8* image, size_t pitch, u32 width, u32 height, const FormatInfo& format, u64* histogram )
+	{
+		memset( histogram, 0, sizeof( u64 ) * 256 );
+		for( u32 y = 0; y < height; ++y )
+		{
+			const u8* pixel = image + y * pitch + format.alphaIndex;
+			for( u32 x = 0; x < width; ++x, pixel += format.channelCount )
+			{
+				++histogram[ *pixel ];
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//	アルファテストで残るテクセルの割合.
+	//-----------------------------------------------------------------------
+	f64 CalcAlphaCoverage( const u8* image, size_t pitch, u32 width, u32 height, const FormatInfo& format, f32 alphaReference )
+	{
+		u64 histogram[ 256 ];
+		BuildAlphaHistogram( image, pitch, width, height, format, histogram );
+
+		const f64 reference = alphaReference * 255.0;
+		u64 covered = 0;
+		for( u32 alpha = 0; alpha < 256; ++alpha )
+		{
+			if( alpha > reference ) covered += histogram[ alpha ];
+		}
+		return static_cast< f64 >( covered ) / ( static_cast< f64 >( width ) * height );
+	}
+
+	//-----------------------------------------------------------------------
+	//	アルファテストで残るテクセルの割合が指定値に近づくようアルファを拡大.
+	//-----------------------------------------------------------------------
+	void ScaleAlphaToCoverage( u8* image, size_t pitch, u32 width, u32 height, const FormatInfo& format, f32 alphaReference, f64 coverage )
+	{
+		u64 histogram[ 256 ];
+		BuildAlphaHistogram( image, pitch, width, height, format, histogram );
+
+		// alpha >= kのテクセル数が目標に最も近いkを求める.
+		const f64 target = coverage * width * height;
+		u64 count		= 0;
+		u32 bestAlpha	= 255;
+		f64 bestError	= -1.0;
+		for( u32 k = 255; k >= 1; --k )
+		{
+			count += histogram[ k ];
+			const f64 error = fabs( static_cast< f64 >( count ) - target );
+			if( bestError < 0.0 || error < bestError )
+			{
+				bestError = error;
+				bestAlpha = k;
+			}
+		}
+
+		// bestAlpha以上が閾値を超え, それ未満は超えない倍率.
+		const f64 scale = alphaReference * 255.0 / ( bestAlpha - 0.5 );
+		if( scale <= 0.0 ) return;
+
+		for( u32 y = 0; y < height; ++y )
+		{
+			u8* pixel = image + y * pitch + format.alphaIndex;
+			for( u32 x = 0; x < width; ++x, pixel += format.channelCount )
+			{
+				*pixel = static_cast< u8 >( Min( floor( *pixel * scale + 0.5 ), 255.0 ) );
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+//	1x1までのミップ数取得.
+//---------------------------------------------------------------------------
+u32 GetFullMipCount( u32 width, u32 height )
+{
+	u32 mipCount	= 1;
+	u32 size		= Max( width, height );
+	while( size > 1 )
+	{
+		size >>= 1;
+		++mipCount;
+	}
+	return mipCount;
+}
+
+//---------------------------------------------------------------------------
+//	ミップマップ生成に対応したピクセルフォーマットか判定.
+//---------------------------------------------------------------------------
+bool IsMipGenerationSupported( PixelFormat format )
+{
+	FormatInfo info;
+	return GetFormatInfo( format, false, &info );
+}
+
+//---------------------------------------------------------------------------
+//	ミップマップ生成.
+//---------------------------------------------------------------------------
+bool GenerateMips( const void* src, size_t srcPitch, u32 width, u32 height, PixelFormat format, std::vector< u8 >* outImage, u32* outMipCount, const MipGenerateDesc& desc )
+{
+	FormatInfo info;
+	if( !GetFormatInfo( format, desc.srgb, &info ) )
+	{
+		AROMA_ASSERT( false, _T( "Unsupport Format.\n" ) );
+		return false;
+	}
+	if( src == nullptr || width == 0 || height == 0 )
+	{
+		AROMA_ASSERT( false, _T( "Invalid image.\n" ) );
+		return false;
+	}
+
+	u32 mipCount = GetFullMipCount( width, height );
+	if( desc.maxMipCount > 0 )
+	{
+		mipCount = Min( mipCount, desc.maxMipCount );
+	}
+
+	// 各ミップの配置.
+	std::vector< SurfaceInfo >	surfaces( mipCount );
+	std::vector< size_t >		offsets( mipCount + 1, 0 );
+	for( u32 mip = 0; mip < mipCount; ++mip )
+	{
+		CalcSurfaceInfo( &surfaces[ mip ], Max( 1u, width >> mip ), Max( 1u, height >> mip ), format );
+		offsets[ mip + 1 ] = offsets[ mip ] + surfaces[ mip ].bytes;
+	}
+	outImage->resize( offsets[ mipCount ] );
+	u8* image = outImage->data();
+
+	// 最上位ミップはそのままコピー.
+	const u8* source = static_cast< const u8* >( src );
+	for( u32 y = 0; y < height; ++y )
+	{
+		memcpy( image + y * surfaces[ 0 ].pitchBytes, source + y * srcPitch, surfaces[ 0 ].pitchBytes );
+	}
+
+	const bool preserveCoverage = desc.preserveAlphaCoverage && info.alphaIndex >= 0;
+	const f64 coverage = preserveCoverage ? CalcAlphaCoverage( image, surfaces[ 0 ].pitchBytes, width, height, info, desc.alphaReference ) : 0.0;
+
+	FilterTable horizontal;
+	FilterTable vertical;
+	for( u32 mip = 1; mip < mipCount; ++mip )
+	{
+		LevelContext context;
+		context.src			= image + offsets[ mip - 1 ];
+		context.srcPitch	= surfaces[ mip - 1 ].pitchBytes;
+		context.srcWidth	= Max( 1u, width >> ( mip - 1 ) );
+		context.srcHeight	= Max( 1u, height >> ( mip - 1 ) );
+		context.dst			= image + offsets[ mip ];
+		context.dstPitch	= surfaces[ mip ].pitchBytes;
+		context.dstWidth	= Max( 1u, width >> mip );
+		context.dstHeight	= Max( 1u, height >> mip );
+		context.format		= info;
+		context.horizontal	= &horizontal;
+		context.vertical	= &vertical;
+
+		BuildFilterTable( context.srcWidth, context.dstWidth, desc.filter, desc.wrap, &horizontal );
+		BuildFilterTable( context.srcHeight, context.dstHeight, desc.filter, desc.wrap, &vertical );
+		GenerateLevel( context, desc.scheduler );
+
+		// 補正が次のミップへ累積しないよう, 生成に使い終わったミップのアルファを補正する.
+		if( preserveCoverage && mip >= 2 )
+		{
+			ScaleAlphaToCoverage( const_cast< u8* >( context.src ), context.srcPitch, context.srcWidth, context.srcHeight, info, desc.alphaReference, coverage );
+		}
+	}
+	if( preserveCoverage && mipCount >= 2 )
+	{
+		const u32 last = mipCount - 1;
+		ScaleAlphaToCoverage( image + offsets[ last ], surfaces[ last ].pitchBytes, Max( 1u, width >> last ), Max( 1u, height >> last ), info, desc.alphaReference, coverage );
+	}
+
+	*outMipCount = mipCount;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	DDSのミップマップ生成.
+//---------------------------------------------------------------------------
+bool GenerateDDSMips( const DDSAccessor& dds, std::vector< u8 >* outDDS, const MipGenerateDesc& desc )
+{
+	if( !dds.IsValid() )
+	{
+		AROMA_ASSERT( false, _T( "Invalid DDS data.\n" ) );
+		return false;
+	}
+
+	// GPUが直接扱えない旧形式は先に変換する.
+	if( dds.GetPixelFormat() == PixelFormat::kUnknown && IsConvertibleToRGBA8( dds.GetLegacyFormat() ) )
+	{
+		std::vector< u8 > converted;
+		if( !ConvertLegacyDDS( dds, &converted, desc.scheduler ) )
+		{
+			return false;
+		}
+		return GenerateDDSMips( DDSAccessor( converted.data(), converted.size() ), outDDS, desc );
+	}
+
+	const PixelFormat format = dds.GetPixelFormat();
+	if( !IsMipGenerationSupported( format ) )
+	{
+		AROMA_ASSERT( false, _T( "Unsupport Format.\n" ) );
+		return false;
+	}
+	if( dds.IsCubeMap() || dds.IsVolumeTexture() )
+	{
+		AROMA_ASSERT( false, _T( "This DDS is not 2D Texture.\n" ) );
+		return false;
+	}
+
+	const u32 width			= dds.GetWidth();
+	const u32 height		= dds.GetHeight();
+	const u32 srcMipCount	= dds.GetMipMapCount();
+	const u32 arrayCount	= dds.GetArrayCount();
+
+	// 配列要素毎の元データのサイズ(既存のミップを含む).
+	size_t srcSliceBytes = 0;
+	for( u32 mip = 0; mip < srcMipCount; ++mip )
+	{
+		SurfaceInfo surface;
+		CalcSurfaceInfo( &surface, Max( 1u, width >> mip ), Max( 1u, height >> mip ), format );
+		srcSliceBytes += surface.bytes;
+	}
+
+	// サイズ指定時はイメージデータがDDSデータの範囲内か確認.
+	const size_t srcHeaderBytes = reinterpret_cast< uintptr >( dds.GetImageTop() ) - reinterpret_cast< uintptr >( dds.GetHeader() );
+	if( dds.GetDataSize() > 0 && srcHeaderBytes + srcSliceBytes * arrayCount > dds.GetDataSize() )
+	{
+		AROMA_ASSERT( false, _T( "DDS image data is truncated.\n" ) );
+		return false;
+	}
+
+	SurfaceInfo top;
+	CalcSurfaceInfo( &top, width, height, format );
+
+	const size_t headerBytes = sizeof( DDSHeader ) + sizeof( DDSHeaderDX10 );
+	const u8* source = static_cast< const u8* >( dds.GetImageTop() );
+	std::vector< u8 > image;
+	u32 mipCount = 0;
+	outDDS->resize( headerBytes );
+	for( u32 index = 0; index < arrayCount; ++index )
+	{
+		if( !GenerateMips( source + index * srcSliceBytes, top.pitchBytes, width, height, format, &image, &mipCount, desc ) )
+		{
+			return false;
+		}
+		outDDS->insert( outDDS->end(), image.begin(), image.end() );
+	}
+	WriteDDSHeaderDX10( outDDS->data(), width, height, mipCount, arrayCount, format );
+	return true;
+}
+
+} // namespace data
+} // namespace aroma
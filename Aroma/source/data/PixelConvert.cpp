@@ -0,0 +1,719 @@
+﻿//===========================================================================
+//!
+//!	@file		PixelConvert.cpp
+//!	@brief		ピクセルフォーマット変換.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <aroma/data/PixelConvert.h>
+#include <aroma/common/Algorithm.h>
+#include <aroma/common/Task.h>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define AROMA_PIXEL_CONVERT_SIMD_ENABLE 1
+#define AROMA_PIXEL_CONVERT_TARGET( isa )
+#elif ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <cpuid.h>
+#include <immintrin.h>
+#define AROMA_PIXEL_CONVERT_SIMD_ENABLE 1
+// 命令セットは実行時に判定して選択するため, ビルド全体ではなく関数毎に有効にする.
+#define AROMA_PIXEL_CONVERT_TARGET( isa ) __attribute__(( target( isa ) ))
+#endif
+
+namespace aroma {
+namespace data {
+
+namespace
+{
+	//! SIMD変換(変換したピクセル数を返す. 残りはスカラー版で変換).
+	using SimdRowFunc	= u32 (*)( const u8* src, u8* dst, u32 count );
+
+	//! スカラー変換.
+	using ScalarRowFunc	= void (*)( const u8* src, u8* dst, u32 count );
+
+	//-----------------------------------------------------------------------
+	//	1フォーマットの行変換関数.
+	//-----------------------------------------------------------------------
+	struct RowConverter
+	{
+		u32				srcBytes;		// 変換元の1ピクセルのバイト数.
+		ScalarRowFunc	scalar;
+		SimdRowFunc		simd;			// nullptrの場合はスカラー版のみ.
+	};
+
+	//-----------------------------------------------------------------------
+	//	並列変換で共有する状態.
+	//-----------------------------------------------------------------------
+	struct ConvertState
+	{
+		TaskPromise< bool >		promise;
+		std::atomic< u32 >		nextBand;
+		std::atomic< u32 >		remainingCount;
+	};
+
+	//-----------------------------------------------------------------------
+	//	16bit読み込み(非アライン).
+	//-----------------------------------------------------------------------
+	u32 Read16( const u8* p )
+	{
+		return static_cast< u32 >( p[ 0 ] ) | ( static_cast< u32 >( p[ 1 ] ) << 8 );
+	}
+
+	//-----------------------------------------------------------------------
+	//	nビットのチャンネルを8bitに拡張.
+	//-----------------------------------------------------------------------
+	u8 Expand4( u32 value ) { return static_cast< u8 >( value * 17 ); }
+	u8 Expand5( u32 value ) { return static_cast< u8 >( ( value << 3 ) | ( value >> 2 ) ); }
+	u8 Expand6( u32 value ) { return static_cast< u8 >( ( value << 2 ) | ( value >> 4 ) ); }
+
+	//-----------------------------------------------------------------------
+	//	1ピクセル書き込み.
+	//-----------------------------------------------------------------------
+	void WriteRGBA( u8* dst, u8 r, u8 g, u8 b, u8 a )
+	{
+		dst[ 0 ] = r;
+		dst[ 1 ] = g;
+		dst[ 2 ] = b;
+		dst[ 3 ] = a;
+	}
+
+	//-----------------------------------------------------------------------
+	//	スカラー変換.
+	//	D3DFORMATの名前は上位ビットからの並びのため, メモリ上はBGRの順になる.
+	//-----------------------------------------------------------------------
+	void ConvertRowR8G8B8( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 3, dst += 4 ) WriteRGBA( dst, src[ 2 ], src[ 1 ], src[ 0 ], 0xff );
+	}
+
+	void ConvertRowA8R8G8B8( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 4, dst += 4 ) WriteRGBA( dst, src[ 2 ], src[ 1 ], src[ 0 ], src[ 3 ] );
+	}
+
+	void ConvertRowX8R8G8B8( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 4, dst += 4 ) WriteRGBA( dst, src[ 2 ], src[ 1 ], src[ 0 ], 0xff );
+	}
+
+	void ConvertRowA8B8G8R8( const u8* src, u8* dst, u32 count )
+	{
+		memcpy( dst, src, static_cast< size_t >( count ) * 4 );
+	}
+
+	void ConvertRowX8B8G8R8( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 4, dst += 4 ) WriteRGBA( dst, src[ 0 ], src[ 1 ], src[ 2 ], 0xff );
+	}
+
+	void ConvertRowR5G6B5( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 2, dst += 4 )
+		{
+			const u32 v = Read16( src );
+			WriteRGBA( dst, Expand5( v >> 11 ), Expand6( ( v >> 5 ) & 0x3f ), Expand5( v & 0x1f ), 0xff );
+		}
+	}
+
+	template< bool kAlpha >
+	void ConvertRowX1R5G5B5( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 2, dst += 4 )
+		{
+			const u32 v = Read16( src );
+			const u8 a = ( !kAlpha || ( v & 0x8000 ) ) ? 0xff : 0x00;
+			WriteRGBA( dst, Expand5( ( v >> 10 ) & 0x1f ), Expand5( ( v >> 5 ) & 0x1f ), Expand5( v & 0x1f ), a );
+		}
+	}
+
+	template< bool kAlpha >
+	void ConvertRowX4R4G4B4( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 2, dst += 4 )
+		{
+			const u32 v = Read16( src );
+			const u8 a = kAlpha ? Expand4( v >> 12 ) : 0xff;
+			WriteRGBA( dst, Expand4( ( v >> 8 ) & 0xf ), Expand4( ( v >> 4 ) & 0xf ), Expand4( v & 0xf ), a );
+		}
+	}
+
+	void ConvertRowL8( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 1, dst += 4 ) WriteRGBA( dst, src[ 0 ], src[ 0 ], src[ 0 ], 0xff );
+	}
+
+	void ConvertRowA8L8( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 2, dst += 4 ) WriteRGBA( dst, src[ 0 ], src[ 0 ], src[ 0 ], src[ 1 ] );
+	}
+
+	void ConvertRowA8( const u8* src, u8* dst, u32 count )
+	{
+		for( u32 i = 0; i < count; ++i, src += 1, dst += 4 ) WriteRGBA( dst, 0x00, 0x00, 0x00, src[ 0 ] );
+	}
+
+#ifdef AROMA_PIXEL_CONVERT_SIMD_ENABLE
+	//-----------------------------------------------------------------------
+	//	SIMD命令セット.
+	//-----------------------------------------------------------------------
+	enum class SimdLevel : u32
+	{
+		kNone,
+		kSSE2,
+		kSSSE3,
+		kAVX2,
+	};
+
+	//-----------------------------------------------------------------------
+	//	CPUID.
+	//-----------------------------------------------------------------------
+	void CpuId( int info[ 4 ], int leaf, int subLeaf )
+	{
+#if defined( _MSC_VER )
+		__cpuidex( info, leaf, subLeaf );
+#else
+		unsigned int regs[ 4 ] = {};
+		__cpuid_count( leaf, subLeaf, regs[ 0 ], regs[ 1 ], regs[ 2 ], regs[ 3 ] );
+		for( u32 i = 0; i < 4; ++i ) info[ i ] = static_cast< int >( regs[ i ] );
+#endif
+	}
+
+	//-----------------------------------------------------------------------
+	//	OSが保存する拡張レジスタ(XCR0).
+	//-----------------------------------------------------------------------
+	u64 GetEnabledXStateFeatures()
+	{
+#if defined( _MSC_VER )
+		return _xgetbv( 0 );
+#else
+		u32 lo, hi;
+		__asm__ __volatile__( "xgetbv" : "=a"( lo ), "=d"( hi ) : "c"( 0 ) );
+		return ( static_cast< u64 >( hi ) << 32 ) | lo;
+#endif
+	}
+
+	//-----------------------------------------------------------------------
+	//	使用可能なSIMD命令セット判定.
+	//-----------------------------------------------------------------------
+	SimdLevel DetectSimdLevel()
+	{
+		int info[ 4 ];
+		CpuId( info, 0, 0 );
+		const int maxLeaf = info[ 0 ];
+
+		CpuId( info, 1, 0 );
+		const bool sse2		= ( info[ 3 ] & ( 1 << 26 ) ) != 0;
+		const bool ssse3	= ( info[ 2 ] & ( 1 <<  9 ) ) != 0;
+		const bool osxsave	= ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+		const bool avx		= ( info[ 2 ] & ( 1 << 28 ) ) != 0;
+
+		// AVX2はOSがYMMレジスタを保存する場合のみ使用できる.
+		bool avx2 = false;
+		if( maxLeaf >= 7 && osxsave && avx && ( GetEnabledXStateFeatures() & 0x6 ) == 0x6 )
+		{
+			CpuId( info, 7, 0 );
+			avx2 = ( info[ 1 ] & ( 1 << 5 ) ) != 0;
+		}
+
+		if( !sse2 )		return SimdLevel::kNone;
+		if( !ssse3 )	return SimdLevel::kSSE2;
+		if( !avx2 )		return SimdLevel::kSSSE3;
+		return SimdLevel::kAVX2;
+	}
+
+	//-----------------------------------------------------------------------
+	//	8bitへ拡張(16bitレーン毎, 値はbits以下).
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) __m128i Expand4_SSE2( __m128i v ) { return _mm_or_si128( v, _mm_slli_epi16( v, 4 ) ); }
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) __m128i Expand5_SSE2( __m128i v ) { return _mm_or_si128( _mm_slli_epi16( v, 3 ), _mm_srli_epi16( v, 2 ) ); }
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) __m128i Expand6_SSE2( __m128i v ) { return _mm_or_si128( _mm_slli_epi16( v, 2 ), _mm_srli_epi16( v, 4 ) ); }
+
+	//-----------------------------------------------------------------------
+	//	16bitレーンのR, G, B, Aを8ピクセルのRGBAとして書き込み.
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) void StoreRGBA16_SSE2( u8* dst, __m128i r, __m128i g, __m128i b, __m128i a )
+	{
+		const __m128i rg = _mm_or_si128( r, _mm_slli_epi16( g, 8 ) );
+		const __m128i ba = _mm_or_si128( b, _mm_slli_epi16( a, 8 ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( dst +  0 ), _mm_unpacklo_epi16( rg, ba ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( dst + 16 ), _mm_unpackhi_epi16( rg, ba ) );
+	}
+
+	//-----------------------------------------------------------------------
+	//	32bit BGRA -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	template< bool kAlpha >
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowA8R8G8B8_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i agMask	= _mm_set1_epi32( static_cast< int >( 0xff00ff00 ) );
+		const __m128i byteMask	= _mm_set1_epi32( 0x000000ff );
+		const __m128i alpha		= _mm_set1_epi32( kAlpha ? 0 : static_cast< int >( 0xff000000 ) );
+		u32 i = 0;
+		for( ; i + 4 <= count; i += 4 )
+		{
+			const __m128i v		= _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 4 ) );
+			const __m128i ag	= _mm_and_si128( v, agMask );
+			const __m128i b		= _mm_and_si128( _mm_srli_epi32( v, 16 ), byteMask );
+			const __m128i r		= _mm_slli_epi32( _mm_and_si128( v, byteMask ), 16 );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( dst + i * 4 ), _mm_or_si128( _mm_or_si128( ag, alpha ), _mm_or_si128( r, b ) ) );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	32bit RGBX -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowX8B8G8R8_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i alpha = _mm_set1_epi32( static_cast< int >( 0xff000000 ) );
+		u32 i = 0;
+		for( ; i + 4 <= count; i += 4 )
+		{
+			const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 4 ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( dst + i * 4 ), _mm_or_si128( v, alpha ) );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	R5G6B5 -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowR5G6B5_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i mask5	= _mm_set1_epi16( 0x1f );
+		const __m128i mask6	= _mm_set1_epi16( 0x3f );
+		const __m128i alpha	= _mm_set1_epi16( 0xff );
+		u32 i = 0;
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 2 ) );
+			const __m128i r = Expand5_SSE2( _mm_srli_epi16( v, 11 ) );
+			const __m128i g = Expand6_SSE2( _mm_and_si128( _mm_srli_epi16( v, 5 ), mask6 ) );
+			const __m128i b = Expand5_SSE2( _mm_and_si128( v, mask5 ) );
+			StoreRGBA16_SSE2( dst + i * 4, r, g, b, alpha );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	A1R5G5B5, X1R5G5B5 -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	template< bool kAlpha >
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowX1R5G5B5_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i mask5	= _mm_set1_epi16( 0x1f );
+		const __m128i mask8	= _mm_set1_epi16( 0xff );
+		u32 i = 0;
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 2 ) );
+			const __m128i r = Expand5_SSE2( _mm_and_si128( _mm_srli_epi16( v, 10 ), mask5 ) );
+			const __m128i g = Expand5_SSE2( _mm_and_si128( _mm_srli_epi16( v, 5 ), mask5 ) );
+			const __m128i b = Expand5_SSE2( _mm_and_si128( v, mask5 ) );
+
+			// 最上位ビットを算術シフトで全ビットに広げる.
+			const __m128i a = kAlpha ? _mm_and_si128( _mm_srai_epi16( v, 15 ), mask8 ) : mask8;
+			StoreRGBA16_SSE2( dst + i * 4, r, g, b, a );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	A4R4G4B4, X4R4G4B4 -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	template< bool kAlpha >
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowX4R4G4B4_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i mask4	= _mm_set1_epi16( 0xf );
+		const __m128i mask8	= _mm_set1_epi16( 0xff );
+		u32 i = 0;
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 2 ) );
+			const __m128i r = Expand4_SSE2( _mm_and_si128( _mm_srli_epi16( v, 8 ), mask4 ) );
+			const __m128i g = Expand4_SSE2( _mm_and_si128( _mm_srli_epi16( v, 4 ), mask4 ) );
+			const __m128i b = Expand4_SSE2( _mm_and_si128( v, mask4 ) );
+			const __m128i a = kAlpha ? Expand4_SSE2( _mm_srli_epi16( v, 12 ) ) : mask8;
+			StoreRGBA16_SSE2( dst + i * 4, r, g, b, a );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	L8 -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowL8_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i alpha = _mm_set1_epi8( static_cast< char >( 0xff ) );
+		u32 i = 0;
+		for( ; i + 16 <= count; i += 16 )
+		{
+			const __m128i l		= _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i ) );
+			const __m128i llLo	= _mm_unpacklo_epi8( l, l );
+			const __m128i llHi	= _mm_unpackhi_epi8( l, l );
+			const __m128i laLo	= _mm_unpacklo_epi8( l, alpha );
+			const __m128i laHi	= _mm_unpackhi_epi8( l, alpha );
+			u8* out = dst + i * 4;
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out +  0 ), _mm_unpacklo_epi16( llLo, laLo ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out + 16 ), _mm_unpackhi_epi16( llLo, laLo ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out + 32 ), _mm_unpacklo_epi16( llHi, laHi ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out + 48 ), _mm_unpackhi_epi16( llHi, laHi ) );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	A8L8 -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowA8L8_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i mask8 = _mm_set1_epi16( 0xff );
+		u32 i = 0;
+		for( ; i + 8 <= count; i += 8 )
+		{
+			// 16bitレーンは(L, A)の並びなので, (L, L)と組み合わせれば(L, L, L, A)になる.
+			const __m128i la	= _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 2 ) );
+			const __m128i l		= _mm_and_si128( la, mask8 );
+			const __m128i ll	= _mm_or_si128( l, _mm_slli_epi16( l, 8 ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( dst + i * 4 +  0 ), _mm_unpacklo_epi16( ll, la ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( dst + i * 4 + 16 ), _mm_unpackhi_epi16( ll, la ) );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	A8 -> RGBA (SSE2).
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "sse2" ) u32 ConvertRowA8_SSE2( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i zero = _mm_setzero_si128();
+		u32 i = 0;
+		for( ; i + 16 <= count; i += 16 )
+		{
+			const __m128i a		= _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i ) );
+			const __m128i zaLo	= _mm_unpacklo_epi8( zero, a );
+			const __m128i zaHi	= _mm_unpackhi_epi8( zero, a );
+			u8* out = dst + i * 4;
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out +  0 ), _mm_unpacklo_epi16( zero, zaLo ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out + 16 ), _mm_unpackhi_epi16( zero, zaLo ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out + 32 ), _mm_unpacklo_epi16( zero, zaHi ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( out + 48 ), _mm_unpackhi_epi16( zero, zaHi ) );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	24bit BGR -> RGBA (SSSE3).
+	//	16バイト読み込みで4ピクセル(12バイト)を変換するため, 末尾の2ピクセル未満は残す.
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "ssse3" ) u32 ConvertRowR8G8B8_SSSE3( const u8* src, u8* dst, u32 count )
+	{
+		const __m128i shuffle	= _mm_setr_epi8( 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 );
+		const __m128i alpha		= _mm_set1_epi32( static_cast< int >( 0xff000000 ) );
+		u32 i = 0;
+		for( ; i + 6 <= count; i += 4 )
+		{
+			const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 3 ) );
+			_mm_storeu_si128( reinterpret_cast< __m128i* >( dst + i * 4 ), _mm_or_si128( _mm_shuffle_epi8( v, shuffle ), alpha ) );
+		}
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	32bit BGRA -> RGBA (AVX2).
+	//-----------------------------------------------------------------------
+	template< bool kAlpha >
+	AROMA_PIXEL_CONVERT_TARGET( "avx2" ) u32 ConvertRowA8R8G8B8_AVX2( const u8* src, u8* dst, u32 count )
+	{
+		const __m256i shuffle	= _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+		const __m256i alpha		= _mm256_set1_epi32( kAlpha ? 0 : static_cast< int >( 0xff000000 ) );
+		u32 i = 0;
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const __m256i v = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( src + i * 4 ) );
+			_mm256_storeu_si256( reinterpret_cast< __m256i* >( dst + i * 4 ), _mm256_or_si256( _mm256_shuffle_epi8( v, shuffle ), alpha ) );
+		}
+		_mm256_zeroupper();
+		return i;
+	}
+
+	//-----------------------------------------------------------------------
+	//	24bit BGR -> RGBA (AVX2).
+	//	12バイトずつ各レーンへ読み込み, レーン毎に並べ替える.
+	//-----------------------------------------------------------------------
+	AROMA_PIXEL_CONVERT_TARGET( "avx2" ) u32 ConvertRowR8G8B8_AVX2( const u8* src, u8* dst, u32 count )
+	{
+		const __m256i shuffle	= _mm256_setr_epi8(
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 );
+		const __m256i alpha		= _mm256_set1_epi32( static_cast< int >( 0xff000000 ) );
+		u32 i = 0;
+		for( ; i + 10 <= count; i += 8 )
+		{
+			const __m128i lo	= _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 3 ) );
+			const __m128i hi	= _mm_loadu_si128( reinterpret_cast< const __m128i* >( src + i * 3 + 12 ) );
+			const __m256i v		= _mm256_inserti128_si256( _mm256_castsi128_si256( lo ), hi, 1 );
+			_mm256_storeu_si256( reinterpret_cast< __m256i* >( dst + i * 4 ), _mm256_or_si256( _mm256_shuffle_epi8( v, shuffle ), alpha ) );
+		}
+		_mm256_zeroupper();
+		return i;
+	}
+#endif // AROMA_PIXEL_CONVERT_SIMD_ENABLE
+
+	//-----------------------------------------------------------------------
+	//	フォーマットに対応する行変換関数取得.
+	//-----------------------------------------------------------------------
+	bool GetRowConverter( DDSDXGIFormat format, RowConverter* outConverter )
+	{
+		RowConverter converter = { 0, nullptr, nullptr };
+		switch( format )
+		{
+		case DDSDXGIFormat::kR8G8B8:	converter = { 3, ConvertRowR8G8B8, nullptr };			break;
+		case DDSDXGIFormat::kA8R8G8B8:	converter = { 4, ConvertRowA8R8G8B8, nullptr };			break;
+		case DDSDXGIFormat::kX8R8G8B8:	converter = { 4, ConvertRowX8R8G8B8, nullptr };			break;
+		case DDSDXGIFormat::kA8B8G8R8:	converter = { 4, ConvertRowA8B8G8R8, nullptr };			break;
+		case DDSDXGIFormat::kX8B8G8R8:	converter = { 4, ConvertRowX8B8G8R8, nullptr };			break;
+		case DDSDXGIFormat::kR5G6B5:	converter = { 2, ConvertRowR5G6B5, nullptr };			break;
+		case DDSDXGIFormat::kA1R5G5B5:	converter = { 2, ConvertRowX1R5G5B5< true >, nullptr };	break;
+		case DDSDXGIFormat::kX1R5G5B5:	converter = { 2, ConvertRowX1R5G5B5< false >, nullptr };	break;
+		case DDSDXGIFormat::kA4R4G4B4:	converter = { 2, ConvertRowX4R4G4B4< true >, nullptr };	break;
+		case DDSDXGIFormat::kX4R4G4B4:	converter = { 2, ConvertRowX4R4G4B4< false >, nullptr };	break;
+		case DDSDXGIFormat::kL8:		converter = { 1, ConvertRowL8, nullptr };				break;
+		case DDSDXGIFormat::kA8L8:		converter = { 2, ConvertRowA8L8, nullptr };				break;
+		case DDSDXGIFormat::kA8:		converter = { 1, ConvertRowA8, nullptr };				break;
+		default:
+			return false;
+		}
+
+#ifdef AROMA_PIXEL_CONVERT_SIMD_ENABLE
+		// 使用可能な最も新しい命令セットの関数を選択.
+		static const SimdLevel simdLevel = DetectSimdLevel();
+		const bool sse2		= simdLevel >= SimdLevel::kSSE2;
+		const bool ssse3	= simdLevel >= SimdLevel::kSSSE3;
+		const bool avx2		= simdLevel >= SimdLevel::kAVX2;
+		switch( format )
+		{
+		case DDSDXGIFormat::kR8G8B8:
+			converter.simd = avx2 ? ConvertRowR8G8B8_AVX2 : ( ssse3 ? ConvertRowR8G8B8_SSSE3 : nullptr );
+			break;
+		case DDSDXGIFormat::kA8R8G8B8:
+			converter.simd = avx2 ? ConvertRowA8R8G8B8_AVX2< true > : ( sse2 ? ConvertRowA8R8G8B8_SSE2< true > : nullptr );
+			break;
+		case DDSDXGIFormat::kX8R8G8B8:
+			converter.simd = avx2 ? ConvertRowA8R8G8B8_AVX2< false > : ( sse2 ? ConvertRowA8R8G8B8_SSE2< false > : nullptr );
+			break;
+		case DDSDXGIFormat::kX8B8G8R8:	converter.simd = sse2 ? ConvertRowX8B8G8R8_SSE2 : nullptr;				break;
+		case DDSDXGIFormat::kR5G6B5:	converter.simd = sse2 ? ConvertRowR5G6B5_SSE2 : nullptr;				break;
+		case DDSDXGIFormat::kA1R5G5B5:	converter.simd = sse2 ? ConvertRowX1R5G5B5_SSE2< true > : nullptr;		break;
+		case DDSDXGIFormat::kX1R5G5B5:	converter.simd = sse2 ? ConvertRowX1R5G5B5_SSE2< false > : nullptr;	break;
+		case DDSDXGIFormat::kA4R4G4B4:	converter.simd = sse2 ? ConvertRowX4R4G4B4_SSE2< true > : nullptr;		break;
+		case DDSDXGIFormat::kX4R4G4B4:	converter.simd = sse2 ? ConvertRowX4R4G4B4_SSE2< false > : nullptr;	break;
+		case DDSDXGIFormat::kL8:		converter.simd = sse2 ? ConvertRowL8_SSE2 : nullptr;					break;
+		case DDSDXGIFormat::kA8L8:		converter.simd = sse2 ? ConvertRowA8L8_SSE2 : nullptr;					break;
+		case DDSDXGIFormat::kA8:		converter.simd = sse2 ? ConvertRowA8_SSE2 : nullptr;					break;
+		default:
+			break;
+		}
+#endif // AROMA_PIXEL_CONVERT_SIMD_ENABLE
+
+		*outConverter = converter;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------
+	//	1行の変換.
+	//-----------------------------------------------------------------------
+	void ConvertRow( const RowConverter& converter, const u8* src, u8* dst, u32 count )
+	{
+		const u32 converted = converter.simd ? converter.simd( src, dst, count ) : 0;
+		converter.scalar( src + static_cast< size_t >( converted ) * converter.srcBytes, dst + static_cast< size_t >( converted ) * 4, count - converted );
+	}
+}
+
+//---------------------------------------------------------------------------
+//	R8G8B8A8へ変換可能なDDSフォーマットか判定.
+//---------------------------------------------------------------------------
+bool IsConvertibleToRGBA8( DDSDXGIFormat format )
+{
+	RowConverter converter;
+	return GetRowConverter( format, &converter );
+}
+
+//---------------------------------------------------------------------------
+//	DDSフォーマットの1ピクセルのバイト数取得.
+//---------------------------------------------------------------------------
+u32 GetLegacyBytesPerPixel( DDSDXGIFormat format )
+{
+	RowConverter converter;
+	return GetRowConverter( format, &converter ) ? converter.srcBytes : 0;
+}
+
+//---------------------------------------------------------------------------
+//	1行をR8G8B8A8へ変換.
+//---------------------------------------------------------------------------
+void ConvertRowToRGBA8( DDSDXGIFormat format, const void* src, void* dst, u32 pixelCount )
+{
+	RowConverter converter;
+	if( !GetRowConverter( format, &converter ) )
+	{
+		AROMA_ASSERT( false, _T( "Unsupport Format.\n" ) );
+		return;
+	}
+	ConvertRow( converter, static_cast< const u8* >( src ), static_cast< u8* >( dst ), pixelCount );
+}
+
+//---------------------------------------------------------------------------
+//	イメージをR8G8B8A8へ変換.
+//---------------------------------------------------------------------------
+void ConvertImageToRGBA8( DDSDXGIFormat format, const void* src, size_t srcPitch, void* dst, size_t dstPitch, u32 width, u32 height, IScheduler* scheduler )
+{
+	RowConverter converter;
+	if( !GetRowConverter( format, &converter ) )
+	{
+		AROMA_ASSERT( false, _T( "Unsupport Format.\n" ) );
+		return;
+	}
+	if( width == 0 || height == 0 )
+	{
+		return;
+	}
+
+	const u8* source	= static_cast< const u8* >( src );
+	u8* destination		= static_cast< u8* >( dst );
+	const u32 bandRows	= static_cast< u32 >( Max< size_t >( kPixelConvertBandBytes / ( static_cast< size_t >( width ) * 4 ), 1 ) );
+	const u32 bandCount	= ( height + bandRows - 1 ) / bandRows;
+
+	auto convertBand = [ = ]( u32 band )
+	{
+		const u32 rowBegin	= band * bandRows;
+		const u32 rowEnd	= Min( rowBegin + bandRows, height );
+		for( u32 y = rowBegin; y < rowEnd; ++y )
+		{
+			ConvertRow( converter, source + y * srcPitch, destination + y * dstPitch, width );
+		}
+	};
+
+	if( scheduler == nullptr || bandCount == 1 )
+	{
+		for( u32 band = 0; band < bandCount; ++band )
+		{
+			convertBand( band );
+		}
+		return;
+	}
+
+	// ワーカーと呼び出しスレッドが未処理の帯を順に取り合う.
+	// ワーカーが遅れて開始した場合も呼び出しスレッドが残りを変換するため, 待機で止まらない.
+	auto state = std::make_shared< ConvertState >();
+	Task< bool > task		= state->promise.GetTask();
+	state->nextBand			= 0;
+	state->remainingCount	= bandCount;
+
+	auto work = [ state, convertBand, bandCount ]()
+	{
+		for( ;; )
+		{
+			const u32 band = state->nextBand.fetch_add( 1, std::memory_order_relaxed );
+			if( band >= bandCount ) break;
+
+			convertBand( band );
+
+			// 最後に完了した帯が一度だけ完了を通知する.
+			if( state->remainingCount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+			{
+				state->promise.SetValue( true );
+			}
+		}
+	};
+
+	for( u32 i = 1; i < bandCount; ++i )
+	{
+		scheduler->Schedule( work );
+	}
+	work();
+	task.Wait();
+}
+
+//---------------------------------------------------------------------------
+//	非FourCCのDDSをR8G8B8A8のDDSへ変換.
+//---------------------------------------------------------------------------
+bool ConvertLegacyDDS( const DDSAccessor& dds, std::vector< u8 >* outDDS, IScheduler* scheduler )
+{
+	if( !dds.IsValid() )
+	{
+		AROMA_ASSERT( false, _T( "Invalid DDS data.\n" ) );
+		return false;
+	}
+
+	const DDSDXGIFormat format	= dds.GetLegacyFormat();
+	const u32 srcBytes			= GetLegacyBytesPerPixel( format );
+	if( srcBytes == 0 )
+	{
+		AROMA_ASSERT( false, _T( "Unsupport Format.\n" ) );
+		return false;
+	}
+	if( dds.IsCubeMap() || dds.IsVolumeTexture() )
+	{
+		AROMA_ASSERT( false, _T( "This DDS is not 2D Texture.\n" ) );
+		return false;
+	}
+
+	const u32 width		= dds.GetWidth();
+	const u32 height	= dds.GetHeight();
+	const u32 mipCount	= dds.GetMipMapCount();
+	const u32 arrayCount	= dds.GetArrayCount();
+
+	// 変換前後のイメージサイズ.
+	u64 srcImageBytes = 0;
+	u64 dstImageBytes = 0;
+	for( u32 mip = 0; mip < mipCount; ++mip )
+	{
+		const u64 pixelCount = static_cast< u64 >( Max( 1u, width >> mip ) ) * Max( 1u, height >> mip );
+		srcImageBytes += pixelCount * srcBytes;
+		dstImageBytes += pixelCount * 4;
+	}
+	srcImageBytes *= arrayCount;
+	dstImageBytes *= arrayCount;
+
+	// サイズ指定時はイメージデータがDDSデータの範囲内か確認.
+	const size_t srcHeaderBytes = reinterpret_cast< uintptr >( dds.GetImageTop() ) - reinterpret_cast< uintptr >( dds.GetHeader() );
+	if( dds.GetDataSize() > 0 && srcHeaderBytes + srcImageBytes > dds.GetDataSize() )
+	{
+		AROMA_ASSERT( false, _T( "DDS image data is truncated.\n" ) );
+		return false;
+	}
+
+	// DX10拡張ヘッダーでフォーマットを指定する.
+	const size_t headerBytes = sizeof( DDSHeader ) + sizeof( DDSHeaderDX10 );
+	outDDS->resize( headerBytes + static_cast< size_t >( dstImageBytes ) );
+	WriteDDSHeaderDX10( outDDS->data(), width, height, mipCount, arrayCount, kLegacyConvertFormat );
+
+	// 配列, ミップの順に並んだサーフェイスを順に変換.
+	const u8* source	= static_cast< const u8* >( dds.GetImageTop() );
+	u8* destination		= outDDS->data() + headerBytes;
+	for( u32 index = 0; index < arrayCount; ++index )
+	{
+		for( u32 mip = 0; mip < mipCount; ++mip )
+		{
+			const u32 mipWidth	= Max( 1u, width >> mip );
+			const u32 mipHeight	= Max( 1u, height >> mip );
+			const size_t srcPitch = static_cast< size_t >( mipWidth ) * srcBytes;
+			const size_t dstPitch = static_cast< size_t >( mipWidth ) * 4;
+			ConvertImageToRGBA8( format, source, srcPitch, destination, dstPitch, mipWidth, mipHeight, scheduler );
+			source		+= srcPitch * mipHeight;
+			destination	+= dstPitch * mipHeight;
+		}
+	}
+	return true;
+}
+
+} // namespace data
+} // namespace aroma
@@ -7,7 +7,7 @@
 //!	@author		d0
 //!
 //===========================================================================
-#ifdef AROMA_WINDOWS
+#if defined( AROMA_WINDOWS ) || defined( AROMA_POSIX )
 
 #include <aroma/data/String.h>
 #include <string.h>
@@ -20,10 +20,12 @@ namespace data {
 //---------------------------------------------------------------------------
 TStr StrCopy( CTStr srcStr )
 {
-#ifdef AROMA_UNICODE
+#if defined( AROMA_UNICODE )
 	TStr retStr = _wcsdup( srcStr );
-#else
+#elif defined( AROMA_WINDOWS )
 	TStr retStr = _strdup( srcStr );
+#else
+	TStr retStr = strdup( srcStr );
 #endif
 	AROMA_ASSERT( retStr, "Failed to memory allocation." );
 	return retStr;
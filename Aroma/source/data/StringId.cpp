@@ -0,0 +1,129 @@
+﻿//===========================================================================
+//!
+//!	@file		StringId.cpp
+//!	@brief		文字列ID.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <aroma/data/StringId.h>
+#ifdef AROMA_DEBUG
+#include <cwchar>
+#include <string>
+#include <unordered_map>
+#include <aroma/common/SyncObject.h>
+#endif
+
+namespace aroma {
+namespace data {
+
+#ifdef AROMA_DEBUG
+namespace
+{
+	//-----------------------------------------------------------------------
+	//	逆引きテーブル.
+	//-----------------------------------------------------------------------
+	struct DebugNameTable
+	{
+		SpinLockObject							lock;
+		std::unordered_map< u32, std::string >	names;
+	};
+
+	DebugNameTable& GetDebugNameTable()
+	{
+		static DebugNameTable table;
+		return table;
+	}
+
+	//-----------------------------------------------------------------------
+	//	逆引きテーブルへ複製して登録.
+	//	要素は削除しないため, 戻り値はロック外でも有効.
+	//-----------------------------------------------------------------------
+	const char* RegisterDebugName( u32 value, const std::string& name )
+	{
+		auto& table = GetDebugNameTable();
+		ScopedLock lock( table.lock );
+
+		auto it = table.names.find( value );
+		if( it == table.names.end() )
+		{
+			it = table.names.emplace( value, name ).first;
+		}
+		AROMA_ASSERT( it->second == name, _T( "StringId hash collision.\n" ) );
+		return it->second.c_str();
+	}
+
+	//-----------------------------------------------------------------------
+	//	ワイド文字列を逆引き用に変換(非ASCII文字は'?').
+	//-----------------------------------------------------------------------
+	std::string ToDebugName( const wchar_t* str )
+	{
+		std::string name;
+		name.reserve( wcslen( str ) );
+		for( const wchar_t* p = str; *p; ++p )
+		{
+			name.push_back( *p < 0x80 ? static_cast< char >( *p ) : '?' );
+		}
+		return name;
+	}
+}
+#endif
+
+//---------------------------------------------------------------------------
+//	実行時文字列から生成.
+//---------------------------------------------------------------------------
+StringId StringId::FromString( const char* str )
+{
+	AROMA_ASSERT( str, _T( "str is null.\n" ) );
+
+	const char* end = str;
+	while( *end ) ++end;
+
+	StringId id = FromValue( HashFNV1a32( str, end ) );
+#ifdef AROMA_DEBUG
+	RegisterDebugName( id._value, std::string( str, end ) );
+#endif
+	return id;
+}
+
+StringId StringId::FromString( const wchar_t* str )
+{
+	AROMA_ASSERT( str, _T( "str is null.\n" ) );
+
+	const wchar_t* end = str;
+	while( *end ) ++end;
+
+	StringId id = FromValue( HashFNV1a32( str, end ) );
+#ifdef AROMA_DEBUG
+	RegisterDebugName( id._value, ToDebugName( str ) );
+#endif
+	return id;
+}
+
+//---------------------------------------------------------------------------
+//	元の文字列取得(デバッグ用).
+//---------------------------------------------------------------------------
+const char* StringId::GetDebugName() const
+{
+#ifdef AROMA_DEBUG
+	if( _debugName )
+	{
+		// リテラルも実行時生成と同様に登録し, 衝突を検出する.
+		return RegisterDebugName( _value, _debugName );
+	}
+
+	auto& table = GetDebugNameTable();
+	ScopedLock lock( table.lock );
+	auto it = table.names.find( _value );
+	if( it != table.names.end() )
+	{
+		// 要素は削除しないため, ロック外でも参照は有効.
+		return it->second.c_str();
+	}
+#endif
+	return "";
+}
+
+} // namespace data
+} // namespace aroma
@@ -0,0 +1,36 @@
+﻿//===========================================================================
+//!
+//!	@file		Debug_Posix.cpp
+//!	@brief		デバッグ関連 : POSIX.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_POSIX
+#ifdef AROMA_DEBUG
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <aroma/debug/Debug.h>
+
+namespace aroma {
+namespace debug {
+
+//===========================================================================
+//!	@brief		デバッグ文字列出力.
+//===========================================================================
+void StringOut( CTStr format, ... )
+{
+	va_list	vaStr;
+
+	va_start( vaStr, format );
+	vfprintf( stderr, format, vaStr );
+	va_end( vaStr );
+}
+
+} // namespace debug
+} // namespace aroma
+
+#endif
+#endif
@@ -0,0 +1,279 @@
+﻿//===========================================================================
+//!
+//!	@file		ArchiveBuilder.cpp
+//! @brief		パックアーカイブ作成.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <aroma/file/ArchiveBuilder.h>
+#include <aroma/file/FileWriter.h>
+#include <aroma/file/MappedFile.h>
+#include <aroma/data/CRC.h>
+#include <aroma/data/ChunkedCompression.h>
+
+namespace aroma {
+namespace file {
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	アーカイブ内オフセットの切り上げ(32bit環境でも4GB以上を扱う).
+//---------------------------------------------------------------------------
+u64 AlignOffset( u64 offset )
+{
+	return ( offset + ( kArchiveAlignment - 1 ) ) & ~static_cast< u64 >( kArchiveAlignment - 1 );
+}
+
+//---------------------------------------------------------------------------
+//	アラインメントまでゼロで埋める.
+//---------------------------------------------------------------------------
+void WritePadding( FileWriter* writer )
+{
+	static const u8 kZero[ kArchiveAlignment ] = {};
+	const u64 position = writer->GetWrittenBytes();
+	writer->Write( kZero, static_cast< size_t >( AlignOffset( position ) - position ) );
+}
+
+//---------------------------------------------------------------------------
+//	ファイルの内容を参照(空のファイルはマップできないため別途確認).
+//---------------------------------------------------------------------------
+bool MapSourceFile( MappedFile* mappedFile, CTStr filePath, const void** outData, size_t* outSize )
+{
+	if( mappedFile->Open( filePath, kMapHintFlagSequential ) )
+	{
+		*outData = mappedFile->GetData();
+		*outSize = mappedFile->GetSize();
+		return true;
+	}
+
+	File file;
+	size_t fileSize = 0;
+	if( file.Open( filePath, kOpenModeFlagRead, kShareFlagRead ) && file.GetFileSize( &fileSize ) && fileSize == 0 )
+	{
+		*outData = nullptr;
+		*outSize = 0;
+		return true;
+	}
+	return false;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	デフォルトコンストラクタ.
+//---------------------------------------------------------------------------
+ArchiveBuilder::ArchiveBuilder()
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+ArchiveBuilder::~ArchiveBuilder()
+{
+}
+
+//---------------------------------------------------------------------------
+//	メモリ上のデータをエントリとして追加.
+//---------------------------------------------------------------------------
+bool ArchiveBuilder::AddEntry( CTStr path, const void* entryData, size_t size, u32 entryFlags )
+{
+	const u64 pathHash = HashArchivePath( path );
+	if( !_pathHashes.insert( pathHash ).second )
+	{
+		AROMA_ASSERT( false, _T( "Duplicate archive path.\n" ) );
+		return false;
+	}
+
+	SourceEntry entry;
+	entry.pathHash	= pathHash;
+	StoreData( &entry, entryData, size, entryFlags );
+	_entries.push_back( std::move( entry ) );
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ファイルをエントリとして追加.
+//---------------------------------------------------------------------------
+bool ArchiveBuilder::AddFile( CTStr path, CTStr sourceFilePath, u32 entryFlags )
+{
+	const u64 pathHash = HashArchivePath( path );
+	if( _pathHashes.count( pathHash ) != 0 )
+	{
+		AROMA_ASSERT( false, _T( "Duplicate archive path.\n" ) );
+		return false;
+	}
+
+	// 目次に書き込むサイズとCRCを先に求めておく.
+	MappedFile mappedFile;
+	const void* sourceData = nullptr;
+	size_t sourceSize = 0;
+	if( !MapSourceFile( &mappedFile, sourceFilePath, &sourceData, &sourceSize ) )
+	{
+		return false;
+	}
+
+	SourceEntry entry;
+	entry.pathHash = pathHash;
+	if( entryFlags & kArchiveEntryFlagCompressed )
+	{
+		StoreData( &entry, sourceData, sourceSize, entryFlags );
+	}
+	else
+	{
+		entry.size				= sourceSize;
+		entry.crc				= data::CRC::GetCRCBulk( sourceData, sourceSize );
+		entry.flags				= entryFlags;
+		entry.sourceFilePath	= sourceFilePath;
+	}
+	_entries.push_back( std::move( entry ) );
+	_pathHashes.insert( pathHash );
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	アーカイブ書き出し.
+//---------------------------------------------------------------------------
+bool ArchiveBuilder::WriteToFile( CTStr filePath )
+{
+	const u32 entryCount = static_cast< u32 >( _entries.size() );
+
+	// 線形探査が短くなるよう使用率を50%以下にする.
+	u32 bucketCount = 2;
+	while( bucketCount < entryCount * 2 )
+	{
+		bucketCount <<= 1;
+	}
+
+	ArchiveHeader header;
+	memory::Clear( header );
+	header.magic		= kArchiveMagic;
+	header.version		= kArchiveVersion;
+	header.entryCount	= entryCount;
+	header.bucketCount	= bucketCount;
+	header.alignment	= kArchiveAlignment;
+	header.tocOffset	= sizeof( ArchiveHeader );
+	header.bucketOffset	= header.tocOffset + static_cast< u64 >( entryCount ) * sizeof( ArchiveEntry );
+	header.dataOffset	= AlignOffset( header.bucketOffset + static_cast< u64 >( bucketCount ) * sizeof( u32 ) );
+
+	// 追加順にページ境界へ配置.
+	std::vector< ArchiveEntry > toc( entryCount );
+	u64 position = header.dataOffset;
+	for( u32 i = 0; i < entryCount; ++i )
+	{
+		ArchiveEntry& entry = toc[ i ];
+		memory::Clear( entry );
+		entry.pathHash	= _entries[ i ].pathHash;
+		entry.offset	= position;
+		entry.size		= _entries[ i ].size;
+		entry.crc		= _entries[ i ].crc;
+		entry.flags		= _entries[ i ].flags;
+		position		= AlignOffset( position + entry.size );
+	}
+	header.fileSize = position;
+
+	std::vector< u32 > buckets( bucketCount, kArchiveEmptyBucket );
+	const u32 bucketMask = bucketCount - 1;
+	for( u32 i = 0; i < entryCount; ++i )
+	{
+		u32 bucket = static_cast< u32 >( toc[ i ].pathHash ) & bucketMask;
+		while( buckets[ bucket ] != kArchiveEmptyBucket )
+		{
+			bucket = ( bucket + 1 ) & bucketMask;
+		}
+		buckets[ bucket ] = i;
+	}
+
+	u32 tocCRC		= data::CRC::UpdateCRCBulk( data::kCRCInitial, toc.data(), toc.size() * sizeof( ArchiveEntry ) );
+	tocCRC			= data::CRC::UpdateCRCBulk( tocCRC, buckets.data(), buckets.size() * sizeof( u32 ) );
+	header.tocCRC	= tocCRC;
+
+	FileWriter::Desc desc;
+	desc.backgroundFlush	= true;
+	desc.atomicReplace		= true;
+	FileWriter writer;
+	if( !writer.Open( filePath, desc ) )
+	{
+		return false;
+	}
+
+	writer.Write( &header, sizeof( ArchiveHeader ) );
+	writer.Write( toc.data(), toc.size() * sizeof( ArchiveEntry ) );
+	writer.Write( buckets.data(), buckets.size() * sizeof( u32 ) );
+	WritePadding( &writer );
+
+	for( u32 i = 0; i < entryCount; ++i )
+	{
+		const SourceEntry& source = _entries[ i ];
+		if( source.sourceFilePath.empty() )
+		{
+			writer.Write( source.data.data(), source.data.size() );
+		}
+		else
+		{
+			MappedFile mappedFile;
+			const void* sourceData = nullptr;
+			size_t sourceSize = 0;
+			if( !MapSourceFile( &mappedFile, source.sourceFilePath.c_str(), &sourceData, &sourceSize ) || sourceSize != source.size )
+			{
+				// 追加後にファイルが変更された.
+				AROMA_ASSERT( false, _T( "Source file changed.\n" ) );
+				writer.Abort();
+				return false;
+			}
+			writer.Write( sourceData, sourceSize );
+		}
+		WritePadding( &writer );
+	}
+
+	AROMA_ASSERT( writer.GetWrittenBytes() == header.fileSize, _T( "Archive size mismatch.\n" ) );
+	return writer.Close();
+}
+
+//---------------------------------------------------------------------------
+//	追加したエントリを全て破棄.
+//---------------------------------------------------------------------------
+void ArchiveBuilder::Clear()
+{
+	_entries.clear();
+	_pathHashes.clear();
+}
+
+//---------------------------------------------------------------------------
+//	データを保持(圧縮指定時は圧縮).
+//---------------------------------------------------------------------------
+void ArchiveBuilder::StoreData( SourceEntry* entry, const void* entryData, size_t size, u32 entryFlags )
+{
+	if( entryFlags & kArchiveEntryFlagCompressed )
+	{
+		data::CompressChunked( entryData, size, &entry->data );
+
+		// 小さくならない場合は無圧縮で格納する.
+		if( entry->data.size() >= size )
+		{
+			entryFlags &= ~kArchiveEntryFlagCompressed;
+		}
+	}
+	if( !( entryFlags & kArchiveEntryFlagCompressed ) )
+	{
+		entry->data.assign( static_cast< const u8* >( entryData ), static_cast< const u8* >( entryData ) + size );
+	}
+
+	// CRCは格納するデータに対して求める(展開せずに検証できる).
+	entry->size		= entry->data.size();
+	entry->crc		= data::CRC::GetCRCBulk( entry->data.data(), entry->data.size() );
+	entry->flags	= entryFlags;
+}
+
+//---------------------------------------------------------------------------
+//	エントリ数取得.
+//---------------------------------------------------------------------------
+u32 ArchiveBuilder::GetEntryCount() const
+{
+	return static_cast< u32 >( _entries.size() );
+}
+
+} // namespace file
+} // namespace aroma
@@ -0,0 +1,227 @@
+﻿//===========================================================================
+//!
+//!	@file		ArchiveReader.cpp
+//! @brief		パックアーカイブ読み込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <cstring>
+#include <aroma/file/ArchiveReader.h>
+#include <aroma/data/CRC.h>
+#include <aroma/data/ChunkedCompression.h>
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//	デフォルトコンストラクタ.
+//---------------------------------------------------------------------------
+ArchiveReader::ArchiveReader()
+	: _data( nullptr )
+	, _header( nullptr )
+	, _entries( nullptr )
+	, _buckets( nullptr )
+	, _bucketMask( 0 )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+ArchiveReader::~ArchiveReader()
+{
+	Close();
+}
+
+//---------------------------------------------------------------------------
+//	アーカイブオープン.
+//---------------------------------------------------------------------------
+bool ArchiveReader::Open( CTStr filePath )
+{
+	if( IsOpened() )
+	{
+		AROMA_ASSERT( false, _T( "Already opened.\n" ) );
+		Close();
+	}
+
+	if( !_file.Open( filePath ) )
+	{
+		// ファイルオープン失敗.
+		return false;
+	}
+
+	const u8* fileData	= static_cast< const u8* >( _file.GetData() );
+	const u64 fileSize	= _file.GetSize();
+	const ArchiveHeader* header = reinterpret_cast< const ArchiveHeader* >( fileData );
+	if( fileSize < sizeof( ArchiveHeader ) || header->magic != kArchiveMagic || header->version != kArchiveVersion )
+	{
+		AROMA_ASSERT( false, _T( "Invalid archive.\n" ) );
+		_file.Close();
+		return false;
+	}
+
+	// 目次とハッシュテーブルがファイル内に収まっているか.
+	const u64 tocBytes		= static_cast< u64 >( header->entryCount ) * sizeof( ArchiveEntry );
+	const u64 bucketBytes	= static_cast< u64 >( header->bucketCount ) * sizeof( u32 );
+	const bool validLayout	=
+		header->fileSize == fileSize &&
+		header->bucketCount != 0 && ( header->bucketCount & ( header->bucketCount - 1 ) ) == 0 &&
+		header->bucketCount > header->entryCount &&
+		header->tocOffset <= fileSize &&
+		tocBytes + bucketBytes <= fileSize - header->tocOffset &&
+		header->bucketOffset == header->tocOffset + tocBytes &&
+		( header->tocOffset % sizeof( u64 ) ) == 0;
+	if( !validLayout || data::CRC::GetCRCBulk( fileData + header->tocOffset, static_cast< size_t >( tocBytes + bucketBytes ) ) != header->tocCRC )
+	{
+		AROMA_ASSERT( false, _T( "Archive is truncated or corrupted.\n" ) );
+		_file.Close();
+		return false;
+	}
+
+	const ArchiveEntry* entries = reinterpret_cast< const ArchiveEntry* >( fileData + header->tocOffset );
+	for( u32 i = 0; i < header->entryCount; ++i )
+	{
+		if( entries[ i ].offset > fileSize || entries[ i ].size > fileSize - entries[ i ].offset )
+		{
+			AROMA_ASSERT( false, _T( "Archive entry out of range.\n" ) );
+			_file.Close();
+			return false;
+		}
+	}
+
+	_data		= fileData;
+	_header		= header;
+	_entries	= entries;
+	_buckets	= reinterpret_cast< const u32* >( fileData + header->bucketOffset );
+	_bucketMask	= header->bucketCount - 1;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	アーカイブクローズ.
+//---------------------------------------------------------------------------
+void ArchiveReader::Close()
+{
+	_file.Close();
+	_data		= nullptr;
+	_header		= nullptr;
+	_entries	= nullptr;
+	_buckets	= nullptr;
+	_bucketMask	= 0;
+}
+
+//---------------------------------------------------------------------------
+//	オープン済みか.
+//---------------------------------------------------------------------------
+bool ArchiveReader::IsOpened() const
+{
+	return _header != nullptr;
+}
+
+//---------------------------------------------------------------------------
+//	エントリ検索.
+//---------------------------------------------------------------------------
+const ArchiveEntry* ArchiveReader::Find( u64 pathHash ) const
+{
+	if( !IsOpened() ) return nullptr;
+
+	// 正しいアーカイブはバケット数がエントリ数より多く空きバケットで終了するが,
+	// 空きバケットの無い不正なハッシュテーブルでも停止するよう全バケットで打ち切る.
+	u32 bucket = static_cast< u32 >( pathHash ) & _bucketMask;
+	for( u32 probe = 0; probe <= _bucketMask; ++probe, bucket = ( bucket + 1 ) & _bucketMask )
+	{
+		const u32 index = _buckets[ bucket ];
+		if( index == kArchiveEmptyBucket )
+		{
+			return nullptr;
+		}
+		if( index < _header->entryCount && _entries[ index ].pathHash == pathHash )
+		{
+			return &_entries[ index ];
+		}
+	}
+	return nullptr;
+}
+
+//---------------------------------------------------------------------------
+//	エントリデータの先頭アドレス取得.
+//---------------------------------------------------------------------------
+const void* ArchiveReader::GetEntryData( const ArchiveEntry* entry ) const
+{
+	AROMA_ASSERT( entry >= _entries && entry < _entries + GetEntryCount(), _T( "Entry is not in this archive.\n" ) );
+	return _data + entry->offset;
+}
+
+//---------------------------------------------------------------------------
+//	エントリの展開後のサイズ取得.
+//---------------------------------------------------------------------------
+u64 ArchiveReader::GetEntryOriginalSize( const ArchiveEntry* entry ) const
+{
+	if( !( entry->flags & kArchiveEntryFlagCompressed ) )
+	{
+		return entry->size;
+	}
+	return data::GetChunkedOriginalSize( GetEntryData( entry ), static_cast< size_t >( entry->size ) );
+}
+
+//---------------------------------------------------------------------------
+//	エントリデータを展開して取得.
+//---------------------------------------------------------------------------
+Task< bool > ArchiveReader::ExtractEntryAsync( const ArchiveEntry* entry, void* dest, size_t destBytes, IScheduler* scheduler ) const
+{
+	if( entry->flags & kArchiveEntryFlagCompressed )
+	{
+		return data::DecompressChunkedAsync( GetEntryData( entry ), static_cast< size_t >( entry->size ), dest, destBytes, scheduler );
+	}
+
+	TaskPromise< bool > promise;
+	Task< bool > task = promise.GetTask();
+	if( destBytes != entry->size )
+	{
+		AROMA_ASSERT( false, _T( "Destination size mismatch.\n" ) );
+		promise.SetValue( false );
+		return task;
+	}
+	// 空のエントリではdestがnullptrの場合があるため, 0バイトのコピーも行わない.
+	if( destBytes > 0 ) memcpy( dest, GetEntryData( entry ), destBytes );
+	promise.SetValue( true );
+	return task;
+}
+
+//---------------------------------------------------------------------------
+//	エントリデータを展開して取得(完了まで待機).
+//---------------------------------------------------------------------------
+bool ArchiveReader::ExtractEntry( const ArchiveEntry* entry, void* dest, size_t destBytes, IScheduler* scheduler ) const
+{
+	return ExtractEntryAsync( entry, dest, destBytes, scheduler ).Get();
+}
+
+//---------------------------------------------------------------------------
+//	エントリデータのCRC検証.
+//---------------------------------------------------------------------------
+bool ArchiveReader::Verify( const ArchiveEntry* entry ) const
+{
+	return data::CRC::GetCRCBulk( GetEntryData( entry ), static_cast< size_t >( entry->size ) ) == entry->crc;
+}
+
+//---------------------------------------------------------------------------
+//	エントリ数取得.
+//---------------------------------------------------------------------------
+u32 ArchiveReader::GetEntryCount() const
+{
+	return _header ? _header->entryCount : 0;
+}
+
+//---------------------------------------------------------------------------
+//	エントリ取得.
+//---------------------------------------------------------------------------
+const ArchiveEntry* ArchiveReader::GetEntry( u32 index ) const
+{
+	AROMA_ASSERT( index < GetEntryCount(), _T( "Index out of range.\n" ) );
+	return &_entries[ index ];
+}
+
+} // namespace file
+} // namespace aroma
@@ -0,0 +1,378 @@
+﻿//===========================================================================
+//!
+//!	@file		AsyncFileReader.cpp
+//! @brief		非同期ファイル読み込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <aroma/file/AsyncFileReader.h>
+#include <aroma/common/Algorithm.h>
+
+namespace aroma {
+namespace file {
+
+namespace {
+
+constexpr u32 kHandleIndexBits		= 16;
+constexpr u32 kHandleIndexMask		= ( 1u << kHandleIndexBits ) - 1;
+constexpr u32 kHandleGenerationMask	= 0x7fffu;	// kInvalidAsyncReadHandleと重複しないよう最上位ビットは使用しない.
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	デフォルトコンストラクタ.
+//---------------------------------------------------------------------------
+AsyncFileReader::AsyncFileReader()
+	: _initialized( false )
+	, _backend( AsyncReadBackend::kThreadPool )
+	, _native( nullptr )
+	, _requests( nullptr )
+	, _freeIndices( nullptr )
+	, _freeCount( 0 )
+	, _queuedIndices( nullptr )
+	, _queuedCount( 0 )
+	, _completedIndices( nullptr )
+	, _completedCount( 0 )
+	, _nativeInFlightCount( 0 )
+	, _threadPoolInFlightCount( 0 )
+	, _threadPoolCompleted( nullptr )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+AsyncFileReader::~AsyncFileReader()
+{
+	Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	初期化.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::Initialize( const Desc& desc )
+{
+	if( _initialized )
+	{
+		AROMA_ASSERT( false, _T( "Already initialized.\n" ) );
+		Finalize();
+	}
+	if( desc.queueDepth == 0 || desc.queueDepth > kHandleIndexMask )
+	{
+		AROMA_ASSERT( false, _T( "Invalid queue depth.\n" ) );
+		return false;
+	}
+
+	_desc		= desc;
+	_backend	= AsyncReadBackend::kThreadPool;
+	if( _desc.backend != AsyncReadBackend::kThreadPool )
+	{
+		if( InitializeNative( _desc.queueDepth ) )
+		{
+			_backend = AsyncReadBackend::kNative;
+		}
+		else if( _desc.backend == AsyncReadBackend::kNative )
+		{
+			// ネイティブが必須の場合は失敗.
+			return false;
+		}
+	}
+
+	const u32 queueDepth = _desc.queueDepth;
+	_requests			= new Request[ queueDepth ];
+	_freeIndices		= new u32[ queueDepth ];
+	_queuedIndices		= new u32[ queueDepth ];
+	_completedIndices	= new u32[ queueDepth ];
+	_threadPoolCompleted	= new MPMCQueue< u32 >( queueDepth );
+	for( u32 i = 0; i < queueDepth; ++i )
+	{
+		memory::Clear( _requests[ i ] );
+		// 若いインデックスから使用する.
+		_freeIndices[ i ] = queueDepth - 1 - i;
+	}
+	_freeCount					= queueDepth;
+	_queuedCount				= 0;
+	_completedCount				= 0;
+	_nativeInFlightCount		= 0;
+	_threadPoolInFlightCount	= 0;
+
+	_initialized = true;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	解放.
+//---------------------------------------------------------------------------
+void AsyncFileReader::Finalize()
+{
+	if( !_initialized ) return;
+
+	// 発行済みのリクエストは読み込み先へ書き込むため完了を待つ.
+	AsyncReadResult results[ 16 ];
+	while( _nativeInFlightCount + _threadPoolInFlightCount > 0 )
+	{
+		Wait( results, 16 );
+	}
+
+	if( _backend == AsyncReadBackend::kNative )
+	{
+		FinalizeNative();
+	}
+
+	memory::SafeDelete( _threadPoolCompleted );
+	memory::SafeDeleteArray( _completedIndices );
+	memory::SafeDeleteArray( _queuedIndices );
+	memory::SafeDeleteArray( _freeIndices );
+	memory::SafeDeleteArray( _requests );
+	_freeCount		= 0;
+	_queuedCount	= 0;
+	_completedCount	= 0;
+	_initialized	= false;
+}
+
+//---------------------------------------------------------------------------
+//	読み込みリクエスト追加.
+//---------------------------------------------------------------------------
+AsyncReadHandle AsyncFileReader::Read( File* file, u64 offset, size_t size, void* dest, void* userData )
+{
+	AROMA_ASSERT( _initialized, _T( "Not initialized.\n" ) );
+	if( file == nullptr || dest == nullptr || !( file->GetOpenFlags() & kOpenModeFlagRead ) )
+	{
+		AROMA_ASSERT( false, _T( "Invalid read request.\n" ) );
+		return kInvalidAsyncReadHandle;
+	}
+	if( _freeCount == 0 )
+	{
+		// 満杯の場合は呼び出し側でPoll()/Wait()してから再度追加する.
+		return kInvalidAsyncReadHandle;
+	}
+
+	const u32 index = _freeIndices[ --_freeCount ];
+	Request& request = _requests[ index ];
+#ifdef AROMA_WINDOWS
+	memory::Clear( request.overlapped );
+#endif
+	request.file		= file;
+	request.offset		= offset;
+	request.dest		= dest;
+	request.size		= size;
+	request.readBytes	= 0;
+	request.userData	= userData;
+	request.used		= true;
+	request.succeeded	= false;
+
+	_queuedIndices[ _queuedCount++ ] = index;
+	return MakeHandle( index );
+}
+
+//---------------------------------------------------------------------------
+//	追加済みのリクエストをまとめて発行.
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::Submit()
+{
+	const u32 count = _queuedCount;
+	if( count == 0 ) return 0;
+	_queuedCount = 0;
+
+	bool nativeSubmitted = false;
+	for( u32 i = 0; i < count; ++i )
+	{
+		const u32 index = _queuedIndices[ i ];
+		if( _backend == AsyncReadBackend::kNative && IsNativeReadable( _requests[ index ] ) )
+		{
+			// 発行に失敗したリクエストはSubmitNative()内で完了済みとなる.
+			if( SubmitNative( index ) )
+			{
+				++_nativeInFlightCount;
+				nativeSubmitted = true;
+			}
+			continue;
+		}
+
+		++_threadPoolInFlightCount;
+		if( _desc.scheduler )
+		{
+			_desc.scheduler->Schedule( [ this, index ](){ ExecuteThreadPoolRead( index ); } );
+		}
+		else
+		{
+			ExecuteThreadPoolRead( index );
+		}
+	}
+
+	// ネイティブのリクエストは一度のシステムコールでまとめて発行する.
+	if( nativeSubmitted )
+	{
+		FlushNative();
+	}
+	return count;
+}
+
+//---------------------------------------------------------------------------
+//	完了したリクエストを回収(待機しません).
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::Poll( AsyncReadResult* outResults, u32 maxCount )
+{
+	if( !_initialized ) return 0;
+
+	ReapThreadPool();
+	if( _nativeInFlightCount > 0 )
+	{
+		ReapNative( false );
+	}
+	return CollectResults( outResults, maxCount );
+}
+
+//---------------------------------------------------------------------------
+//	完了したリクエストを回収(最低数が完了するまで待機).
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::Wait( AsyncReadResult* outResults, u32 maxCount, u32 minCount )
+{
+	if( !_initialized ) return 0;
+
+	// 発行済みのリクエストが全て完了しても満たせない最低数は待たない.
+	minCount = Min( minCount, maxCount );
+	minCount = Min( minCount, _completedCount + _nativeInFlightCount + _threadPoolInFlightCount );
+
+	while( true )
+	{
+		ReapThreadPool();
+		if( _nativeInFlightCount > 0 )
+		{
+			ReapNative( false );
+		}
+		if( _completedCount >= minCount )
+		{
+			break;
+		}
+
+		if( _threadPoolInFlightCount == 0 )
+		{
+			// ネイティブのみ発行中の場合はカーネル側で待機.
+			ReapNative( true );
+		}
+		else
+		{
+			// スレッドプールの完了を待つ. ネイティブも発行中の場合は定期的に確認する.
+			std::unique_lock< std::mutex > lock( _mutex );
+			auto predicate = [ this ](){ return _threadPoolCompleted->GetSizeApprox() > 0; };
+			if( _nativeInFlightCount > 0 )
+			{
+				_condition.wait_for( lock, std::chrono::milliseconds( 1 ), predicate );
+			}
+			else
+			{
+				_condition.wait( lock, predicate );
+			}
+		}
+	}
+	return CollectResults( outResults, maxCount );
+}
+
+//---------------------------------------------------------------------------
+//	未回収のリクエスト数取得(未発行を含む).
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::GetPendingCount() const
+{
+	return _initialized ? _desc.queueDepth - _freeCount : 0;
+}
+
+//---------------------------------------------------------------------------
+//	使用中のバックエンド取得.
+//---------------------------------------------------------------------------
+AsyncReadBackend AsyncFileReader::GetBackend() const
+{
+	return _backend;
+}
+
+//---------------------------------------------------------------------------
+//	リクエストハンドル作成.
+//---------------------------------------------------------------------------
+AsyncReadHandle AsyncFileReader::MakeHandle( u32 index ) const
+{
+	return ( ( _requests[ index ].generation & kHandleGenerationMask ) << kHandleIndexBits ) | index;
+}
+
+//---------------------------------------------------------------------------
+//	スレッドプールでの読み込み(ワーカースレッドから呼び出し).
+//---------------------------------------------------------------------------
+void AsyncFileReader::ExecuteThreadPoolRead( u32 index )
+{
+	Request& request = _requests[ index ];
+	size_t readBytes = 0;
+	request.succeeded = request.file->ReadFileAt( request.offset, request.dest, request.size, &readBytes );
+	request.readBytes = readBytes;
+
+	// 全リクエストが格納できる容量のため失敗しない.
+	bool result = _threadPoolCompleted->TryEnqueue( index );
+	AROMA_ASSERT( result, _T( "Completion queue overflow.\n" ) );
+	(void)result;
+
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+	}
+	_condition.notify_one();
+}
+
+//---------------------------------------------------------------------------
+//	リクエスト完了(ネイティブの完了を回収したスレッドから呼び出し).
+//---------------------------------------------------------------------------
+void AsyncFileReader::CompleteRequest( u32 index, bool succeeded, size_t readBytes )
+{
+	Request& request = _requests[ index ];
+	request.succeeded	= succeeded;
+	request.readBytes	= readBytes;
+	_completedIndices[ _completedCount++ ] = index;
+}
+
+//---------------------------------------------------------------------------
+//	回収待ちリクエストを完了情報へ格納して解放.
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::CollectResults( AsyncReadResult* outResults, u32 maxCount )
+{
+	const u32 count = Min( maxCount, _completedCount );
+	for( u32 i = 0; i < count; ++i )
+	{
+		const u32 index = _completedIndices[ i ];
+		Request& request = _requests[ index ];
+
+		AsyncReadResult& result = outResults[ i ];
+		result.handle		= MakeHandle( index );
+		result.userData		= request.userData;
+		result.readBytes	= request.readBytes;
+		result.succeeded	= request.succeeded;
+
+		// 再利用時に古いハンドルと区別できるよう世代を進める.
+		request.used	= false;
+		request.file	= nullptr;
+		request.dest	= nullptr;
+		++request.generation;
+		_freeIndices[ _freeCount++ ] = index;
+	}
+
+	// 完了順を保つため残りを詰める.
+	_completedCount -= count;
+	for( u32 i = 0; i < _completedCount; ++i )
+	{
+		_completedIndices[ i ] = _completedIndices[ count + i ];
+	}
+	return count;
+}
+
+//---------------------------------------------------------------------------
+//	スレッドプールで完了したリクエストを回収.
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::ReapThreadPool()
+{
+	if( _threadPoolInFlightCount == 0 ) return 0;
+
+	const u32 count = static_cast< u32 >( _threadPoolCompleted->TryDequeueBulk( _completedIndices + _completedCount, _threadPoolInFlightCount ) );
+	_completedCount				+= count;
+	_threadPoolInFlightCount	-= count;
+	return count;
+}
+
+} // namespace file
+} // namespace aroma
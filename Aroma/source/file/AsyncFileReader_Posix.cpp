@@ -0,0 +1,287 @@
+﻿//===========================================================================
+//!
+//!	@file		AsyncFileReader_Posix.cpp
+//! @brief		非同期ファイル読み込み : POSIX(Linuxはio_uring).
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_POSIX
+
+#include <aroma/file/AsyncFileReader.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <aroma/common/Algorithm.h>
+#endif
+
+namespace aroma {
+namespace file {
+
+#ifdef __linux__
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	io_uringシステムコール(liburingは使用しない).
+//---------------------------------------------------------------------------
+int IoUringSetup( u32 entries, io_uring_params* params )
+{
+	return static_cast< int >( syscall( __NR_io_uring_setup, entries, params ) );
+}
+int IoUringEnter( int ringFd, u32 toSubmit, u32 minComplete, u32 flags )
+{
+	return static_cast< int >( syscall( __NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0 ) );
+}
+int IoUringRegister( int ringFd, u32 opcode, void* arg, u32 argCount )
+{
+	return static_cast< int >( syscall( __NR_io_uring_register, ringFd, opcode, arg, argCount ) );
+}
+
+//---------------------------------------------------------------------------
+//	カーネルと共有するリングの読み書き.
+//---------------------------------------------------------------------------
+u32 LoadAcquire( const u32* p ) { return __atomic_load_n( p, __ATOMIC_ACQUIRE ); }
+void StoreRelease( u32* p, u32 value ) { __atomic_store_n( p, value, __ATOMIC_RELEASE ); }
+
+//---------------------------------------------------------------------------
+//	オペコードに対応しているか.
+//---------------------------------------------------------------------------
+bool IsOpSupported( int ringFd, u8 opcode )
+{
+	// IORING_REGISTER_PROBE自体が未対応のカーネルはIORING_OP_READにも未対応.
+	const u32 opCount = 256;
+	const size_t probeSize = sizeof( io_uring_probe ) + opCount * sizeof( io_uring_probe_op );
+	io_uring_probe* probe = static_cast< io_uring_probe* >( malloc( probeSize ) );
+	memory::Clear( probe, probeSize );
+
+	bool supported = false;
+	if( IoUringRegister( ringFd, IORING_REGISTER_PROBE, probe, opCount ) >= 0 && opcode <= probe->last_op )
+	{
+		supported = ( probe->ops[ opcode ].flags & IO_URING_OP_SUPPORTED ) != 0;
+	}
+	free( probe );
+	return supported;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	ネイティブキュー.
+//---------------------------------------------------------------------------
+struct AsyncFileReader::NativeQueue
+{
+	int				ringFd;
+	void*			sqRing;
+	size_t			sqRingSize;
+	void*			cqRing;
+	size_t			cqRingSize;
+	io_uring_sqe*	sqes;
+	size_t			sqesSize;
+
+	u32*			sqHead;
+	u32*			sqTail;
+	u32				sqMask;
+	u32*			sqArray;
+	u32*			cqHead;
+	u32*			cqTail;
+	u32				cqMask;
+	io_uring_cqe*	cqes;
+
+	u32				unsubmittedCount;	//!< リングに積んだがカーネルへ未送信のリクエスト数.
+};
+
+//---------------------------------------------------------------------------
+//	ネイティブキュー初期化.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::InitializeNative( u32 queueDepth )
+{
+	io_uring_params params;
+	memory::Clear( params );
+	int ringFd = IoUringSetup( queueDepth, &params );
+	if( ringFd < 0 )
+	{
+		// 未対応のカーネル, または無効化されている.
+		return false;
+	}
+	if( !IsOpSupported( ringFd, IORING_OP_READ ) )
+	{
+		close( ringFd );
+		return false;
+	}
+
+	NativeQueue* native = new NativeQueue;
+	memory::Clear( *native );
+	native->ringFd		= ringFd;
+	native->sqRingSize	= params.sq_off.array + params.sq_entries * sizeof( u32 );
+	native->cqRingSize	= params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+	native->sqesSize	= params.sq_entries * sizeof( io_uring_sqe );
+
+	// 対応カーネルではSQとCQのリングを一度にマップできる.
+	const bool singleMap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+	if( singleMap )
+	{
+		native->sqRingSize = native->cqRingSize = Max( native->sqRingSize, native->cqRingSize );
+	}
+
+	void* sqRing = mmap( nullptr, native->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING );
+	void* cqRing = singleMap ? sqRing : mmap( nullptr, native->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING );
+	void* sqes = mmap( nullptr, native->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES );
+	native->sqRing	= sqRing != MAP_FAILED ? sqRing : nullptr;
+	native->cqRing	= cqRing != MAP_FAILED ? cqRing : nullptr;
+	native->sqes	= sqes != MAP_FAILED ? static_cast< io_uring_sqe* >( sqes ) : nullptr;
+	_native = native;
+	if( native->sqRing == nullptr || native->cqRing == nullptr || native->sqes == nullptr )
+	{
+		FinalizeNative();
+		return false;
+	}
+
+	u8* sq = static_cast< u8* >( native->sqRing );
+	native->sqHead	= reinterpret_cast< u32* >( sq + params.sq_off.head );
+	native->sqTail	= reinterpret_cast< u32* >( sq + params.sq_off.tail );
+	native->sqMask	= *reinterpret_cast< u32* >( sq + params.sq_off.ring_mask );
+	native->sqArray	= reinterpret_cast< u32* >( sq + params.sq_off.array );
+
+	u8* cq = static_cast< u8* >( native->cqRing );
+	native->cqHead	= reinterpret_cast< u32* >( cq + params.cq_off.head );
+	native->cqTail	= reinterpret_cast< u32* >( cq + params.cq_off.tail );
+	native->cqMask	= *reinterpret_cast< u32* >( cq + params.cq_off.ring_mask );
+	native->cqes	= reinterpret_cast< io_uring_cqe* >( cq + params.cq_off.cqes );
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブキュー解放.
+//---------------------------------------------------------------------------
+void AsyncFileReader::FinalizeNative()
+{
+	if( _native == nullptr ) return;
+
+	if( _native->sqes )		munmap( _native->sqes, _native->sqesSize );
+	if( _native->cqRing && _native->cqRing != _native->sqRing )	munmap( _native->cqRing, _native->cqRingSize );
+	if( _native->sqRing )	munmap( _native->sqRing, _native->sqRingSize );
+	close( _native->ringFd );
+	memory::SafeDelete( _native );
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブで読み込めるか.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::IsNativeReadable( const Request& request ) const
+{
+	// 1回の読み込みサイズは32bitまで. 超える場合は残りを再発行する.
+	(void)request;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブでリクエスト発行.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::SubmitNative( u32 index )
+{
+	// リクエスト数はSQのエントリ数以下のため満杯にならない.
+	Request& request = _requests[ index ];
+	const u32 tail = *_native->sqTail;
+	const u32 slot = tail & _native->sqMask;
+
+	io_uring_sqe& sqe = _native->sqes[ slot ];
+	memory::Clear( sqe );
+	sqe.opcode		= IORING_OP_READ;
+	sqe.fd			= request.file->GetNativeHandle();
+	sqe.off			= request.offset + request.readBytes;
+	sqe.addr		= reinterpret_cast< u64 >( static_cast< u8* >( request.dest ) + request.readBytes );
+	sqe.len			= static_cast< u32 >( Min< size_t >( request.size - request.readBytes, 0x7ffff000 ) );
+	sqe.user_data	= index;
+
+	_native->sqArray[ slot ] = slot;
+	StoreRelease( _native->sqTail, tail + 1 );
+	++_native->unsubmittedCount;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブで発行したリクエストの送信.
+//---------------------------------------------------------------------------
+void AsyncFileReader::FlushNative()
+{
+	if( _native->unsubmittedCount == 0 ) return;
+
+	// 送信できなかった分はリングに残り, 次回の送信または待機時に送信される.
+	int submitted = IoUringEnter( _native->ringFd, _native->unsubmittedCount, 0, 0 );
+	if( submitted > 0 )
+	{
+		_native->unsubmittedCount -= Min( _native->unsubmittedCount, static_cast< u32 >( submitted ) );
+	}
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブで完了したリクエストを回収.
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::ReapNative( bool wait )
+{
+	if( wait && *_native->cqHead == LoadAcquire( _native->cqTail ) )
+	{
+		int submitted = IoUringEnter( _native->ringFd, _native->unsubmittedCount, 1, IORING_ENTER_GETEVENTS );
+		if( submitted > 0 )
+		{
+			_native->unsubmittedCount -= Min( _native->unsubmittedCount, static_cast< u32 >( submitted ) );
+		}
+	}
+
+	u32 head = *_native->cqHead;
+	const u32 tail = LoadAcquire( _native->cqTail );
+	u32 completedCount = 0;
+	bool resubmitted = false;
+	for( ; head != tail; ++head )
+	{
+		const io_uring_cqe& cqe = _native->cqes[ head & _native->cqMask ];
+		const u32 index = static_cast< u32 >( cqe.user_data );
+		Request& request = _requests[ index ];
+		if( cqe.res > 0 )
+		{
+			request.readBytes += static_cast< size_t >( cqe.res );
+			if( request.readBytes < request.size )
+			{
+				// 部分読み込みの場合は残りを再発行(ファイル終端では0が返る).
+				SubmitNative( index );
+				resubmitted = true;
+				continue;
+			}
+		}
+		CompleteRequest( index, cqe.res >= 0, request.readBytes );
+		++completedCount;
+	}
+	StoreRelease( _native->cqHead, head );
+	_nativeInFlightCount -= completedCount;
+
+	if( resubmitted )
+	{
+		FlushNative();
+	}
+	return completedCount;
+}
+
+#else
+
+//---------------------------------------------------------------------------
+//	ネイティブ未対応のプラットフォームはスレッドプールで読み込む.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::InitializeNative( u32 ) { return false; }
+void AsyncFileReader::FinalizeNative() {}
+bool AsyncFileReader::IsNativeReadable( const Request& ) const { return false; }
+bool AsyncFileReader::SubmitNative( u32 ) { return false; }
+void AsyncFileReader::FlushNative() {}
+u32 AsyncFileReader::ReapNative( bool ) { return 0; }
+
+#endif
+
+} // namespace file
+} // namespace aroma
+
+#endif
@@ -0,0 +1,158 @@
+﻿//===========================================================================
+//!
+//!	@file		AsyncFileReader_Win.cpp
+//! @brief		非同期ファイル読み込み : Windows(I/O完了ポート).
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_WINDOWS
+
+#include <aroma/file/AsyncFileReader.h>
+
+namespace aroma {
+namespace file {
+
+namespace {
+
+// 完了ポートの識別番号. ハンドル値はCloseHandle()後に再利用されるため, 再利用しない番号で識別する.
+std::atomic< u64 > g_completionPortIdCounter( 0 );
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	ネイティブキュー.
+//---------------------------------------------------------------------------
+struct AsyncFileReader::NativeQueue
+{
+	static constexpr u32 kReapCountMax = 64;	//!< 一度に回収する完了通知数.
+
+	HANDLE				completionPort;
+	u64					completionPortId;
+	OVERLAPPED_ENTRY	entries[ kReapCountMax ];
+};
+
+//---------------------------------------------------------------------------
+//	ネイティブキュー初期化.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::InitializeNative( u32 queueDepth )
+{
+	(void)queueDepth;
+
+	// 完了は所有スレッドのみで回収するため同時実行数は1.
+	HANDLE completionPort = CreateIoCompletionPort( INVALID_HANDLE_VALUE, nullptr, 0, 1 );
+	if( completionPort == nullptr )
+	{
+		return false;
+	}
+
+	_native = new NativeQueue;
+	_native->completionPort = completionPort;
+	_native->completionPortId = ++g_completionPortIdCounter;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブキュー解放.
+//---------------------------------------------------------------------------
+void AsyncFileReader::FinalizeNative()
+{
+	if( _native == nullptr ) return;
+
+	BOOL result = CloseHandle( _native->completionPort );
+	AROMA_ASSERT( result, _T( "Failed to CloseHandle.\n" ) );
+	memory::SafeDelete( _native );
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブで読み込めるか.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::IsNativeReadable( const Request& request ) const
+{
+	// オーバーラップI/Oのファイルのみ. ファイルハンドルは一つの完了ポートにしか関連付けできず,
+	// 完了ポートを閉じた後も関連付けは解除されないため, 他のリーダーで使用したファイルはスレッドプールで読み込む.
+	const File* file = request.file;
+	if( !( file->GetOpenFlags() & kOpenModeFlagAsync ) ) return false;
+	if( file->_completionPortId != 0 && file->_completionPortId != _native->completionPortId ) return false;
+	return request.size <= MAXDWORD;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブでリクエスト発行.
+//---------------------------------------------------------------------------
+bool AsyncFileReader::SubmitNative( u32 index )
+{
+	Request& request = _requests[ index ];
+	File* file = request.file;
+
+	if( file->_completionPortId == 0 )
+	{
+		HANDLE result = CreateIoCompletionPort( file->_fileHandle, _native->completionPort, 0, 0 );
+		if( result == nullptr )
+		{
+			CompleteRequest( index, false, 0 );
+			return false;
+		}
+		file->_completionPortId = _native->completionPortId;
+	}
+
+	request.overlapped.Offset		= static_cast< DWORD >( request.offset );
+	request.overlapped.OffsetHigh	= static_cast< DWORD >( request.offset >> 32 );
+	BOOL result = ::ReadFile( file->_fileHandle, request.dest, static_cast< DWORD >( request.size ), nullptr, &request.overlapped );
+	if( result == FALSE )
+	{
+		DWORD error = GetLastError();
+		if( error != ERROR_IO_PENDING )
+		{
+			// 即時失敗した場合は完了通知されない. ファイル終端は成功扱い.
+			CompleteRequest( index, error == ERROR_HANDLE_EOF, 0 );
+			return false;
+		}
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブで発行したリクエストの送信.
+//---------------------------------------------------------------------------
+void AsyncFileReader::FlushNative()
+{
+	// ReadFile()の時点で発行済み.
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブで完了したリクエストを回収.
+//---------------------------------------------------------------------------
+u32 AsyncFileReader::ReapNative( bool wait )
+{
+	ULONG removedCount = 0;
+	BOOL result = GetQueuedCompletionStatusEx( _native->completionPort, _native->entries, NativeQueue::kReapCountMax, &removedCount, wait ? INFINITE : 0, FALSE );
+	if( result == FALSE )
+	{
+		// タイムアウト.
+		return 0;
+	}
+
+	for( ULONG i = 0; i < removedCount; ++i )
+	{
+		const OVERLAPPED_ENTRY& entry = _native->entries[ i ];
+		Request* request = reinterpret_cast< Request* >( entry.lpOverlapped );
+		const u32 index = static_cast< u32 >( request - _requests );
+
+		DWORD transferredBytes = 0;
+		BOOL succeeded = GetOverlappedResult( request->file->_fileHandle, &request->overlapped, &transferredBytes, FALSE );
+		if( succeeded == FALSE && GetLastError() == ERROR_HANDLE_EOF )
+		{
+			succeeded = TRUE;
+		}
+		CompleteRequest( index, succeeded != FALSE, transferredBytes );
+	}
+	_nativeInFlightCount -= removedCount;
+	return removedCount;
+}
+
+} // namespace file
+} // namespace aroma
+
+#endif
@@ -0,0 +1,343 @@
+﻿//===========================================================================
+//!
+//!	@file		FileIO_Posix.cpp
+//! @brief		ファイルI/O : POSIX.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_POSIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <aroma/file/FileIO.h>
+#include <aroma/common/Algorithm.h>
+#include <aroma/common/Alignment.h>
+
+namespace aroma {
+namespace file {
+
+namespace {
+
+// O_DIRECTの論理ブロックサイズとページサイズを満たせる値.
+constexpr size_t kUnbufferedAlignment = 4096;
+
+// 1回のシステムコールで読み書きする最大サイズ(Linuxの上限).
+constexpr size_t kTransferBytesMax = 0x7ffff000;
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	アンバッファードI/Oのアラインメント取得.
+//---------------------------------------------------------------------------
+size_t GetUnbufferedAlignment()
+{
+	return kUnbufferedAlignment;
+}
+
+//---------------------------------------------------------------------------
+//	アンバッファードI/O用バッファ確保.
+//---------------------------------------------------------------------------
+void* AllocateUnbufferedBuffer( size_t size )
+{
+	void* buffer = nullptr;
+	if( posix_memalign( &buffer, kUnbufferedAlignment, AlignUp( Max< size_t >( size, 1 ), kUnbufferedAlignment ) ) != 0 )
+	{
+		return nullptr;
+	}
+	return buffer;
+}
+
+//---------------------------------------------------------------------------
+//	アンバッファードI/O用バッファ解放.
+//---------------------------------------------------------------------------
+void FreeUnbufferedBuffer( void* buffer )
+{
+	free( buffer );
+}
+
+//---------------------------------------------------------------------------
+//	ファイル名変更.
+//---------------------------------------------------------------------------
+bool RenameFile( CTStr srcFilePath, CTStr dstFilePath )
+{
+	return rename( srcFilePath, dstFilePath ) == 0;
+}
+
+//---------------------------------------------------------------------------
+//	ファイル削除.
+//---------------------------------------------------------------------------
+bool RemoveFile( CTStr filePath )
+{
+	return unlink( filePath ) == 0;
+}
+
+//---------------------------------------------------------------------------
+//	デフォルトコンストラクタ.
+//---------------------------------------------------------------------------
+File::File()
+	: _opened( false )
+	, _openFlags( 0 )
+	, _shareFlags( 0 )
+	, _filePath( nullptr )
+	, _fileDescriptor( -1 )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+File::~File()
+{
+	Close();
+}
+
+//---------------------------------------------------------------------------
+//	ファイルオープン.
+//---------------------------------------------------------------------------
+bool File::Open( CTStr filePath, u32 openflags, u32 shareFlags )
+{
+	if( _opened )
+	{
+		AROMA_ASSERT( false, _T( "Already opened.\n" ) );
+		Close();
+	}
+
+	// POSIXには共有モードが無いため共有フラグは保持のみ.
+	// kOpenModeFlagAsyncはio_uringが通常のディスクリプタで動作するため指定不要.
+	int flags = O_CLOEXEC;
+	if( ( openflags & kOpenModeFlagRead ) && ( openflags & kOpenModeFlagWrite ) )	flags |= O_RDWR | O_CREAT;
+	else if( openflags & kOpenModeFlagWrite )										flags |= O_WRONLY | O_CREAT;
+	else																			flags |= O_RDONLY;
+	if( ( openflags & kOpenModeFlagWrite ) && ( openflags & kOpenModeFlagTruncate ) )	flags |= O_TRUNC;
+	if( ( openflags & kOpenModeFlagWrite ) && ( openflags & kOpenModeFlagCreateNew ) )	flags |= O_EXCL;
+
+	int fileDescriptor = -1;
+#ifdef O_DIRECT
+	if( openflags & kOpenModeFlagUnbuffered )
+	{
+		fileDescriptor = open( filePath, flags | O_DIRECT, 0644 );
+		// tmpfs等のO_DIRECT未対応のファイルシステムは通常のオープンで代替.
+		if( fileDescriptor < 0 && errno != EINVAL )
+		{
+			return false;
+		}
+	}
+#endif
+	if( fileDescriptor < 0 )
+	{
+		fileDescriptor = open( filePath, flags, 0644 );
+		if( fileDescriptor < 0 )
+		{
+			// ファイルオープン失敗.
+			return false;
+		}
+	}
+
+#if defined( F_NOCACHE )
+	if( openflags & kOpenModeFlagUnbuffered )
+	{
+		fcntl( fileDescriptor, F_NOCACHE, 1 );
+	}
+#endif
+#if defined( POSIX_FADV_RANDOM )
+	if( !( openflags & kOpenModeFlagUnbuffered ) )
+	{
+		// Windows版のFILE_FLAG_SEQUENTIAL_SCAN, FILE_FLAG_RANDOM_ACCESSに合わせる.
+		posix_fadvise( fileDescriptor, 0, 0, ( openflags & kOpenModeFlagSequential ) ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_RANDOM );
+	}
+#endif
+
+	_openFlags		= openflags;
+	_shareFlags		= shareFlags;
+	_filePath		= data::StrCopy( filePath );
+	_fileDescriptor	= fileDescriptor;
+	_opened			= true;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ファイルクローズ.
+//---------------------------------------------------------------------------
+void File::Close()
+{
+	if( !_opened ) return;
+
+	int result = close( _fileDescriptor );
+	AROMA_ASSERT( result == 0, _T( "Failed to close.\n" ) );
+	(void)result;
+	_fileDescriptor = -1;
+	memory::SafeFree( _filePath );
+	_opened = false;
+}
+
+//---------------------------------------------------------------------------
+//	ファイルサイズ取得.
+//---------------------------------------------------------------------------
+bool File::GetFileSize( size_t* outSize )
+{
+	struct stat fileStat;
+	if( fstat( _fileDescriptor, &fileStat ) != 0 )
+	{
+		// ファイルサイズ取得失敗.
+		return false;
+	}
+	*outSize = static_cast< size_t >( fileStat.st_size );
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	ファイルデータ読み込み.
+//---------------------------------------------------------------------------
+bool File::ReadFile( void* outBuf, size_t readBytes, size_t* readedBytes )
+{
+	if( !( _openFlags & kOpenModeFlagRead ) )
+	{
+		AROMA_ASSERT( false, _T( "FileIO not READ mode.\n" ) );
+		return false;
+	}
+
+	u8* dst = static_cast< u8* >( outBuf );
+	size_t totalBytes = 0;
+	bool succeeded = true;
+	while( totalBytes < readBytes )
+	{
+		ssize_t result = read( _fileDescriptor, dst + totalBytes, Min( readBytes - totalBytes, kTransferBytesMax ) );
+		if( result < 0 )
+		{
+			if( errno == EINTR ) continue;
+			// ファイルデータ読み込み失敗.
+			succeeded = false;
+			break;
+		}
+		if( result == 0 )
+		{
+			// ファイル終端.
+			break;
+		}
+		totalBytes += static_cast< size_t >( result );
+	}
+
+	// 読み取ったバイト数を格納.
+	if( readedBytes )
+	{
+		(*readedBytes) = totalBytes;
+	}
+
+	return succeeded;
+}
+
+//---------------------------------------------------------------------------
+//	オフセット指定でファイルデータ読み込み.
+//---------------------------------------------------------------------------
+bool File::ReadFileAt( u64 offset, void* outBuf, size_t readBytes, size_t* readedBytes )
+{
+	if( !( _openFlags & kOpenModeFlagRead ) )
+	{
+		AROMA_ASSERT( false, _T( "FileIO not READ mode.\n" ) );
+		return false;
+	}
+	AROMA_ASSERT( !( _openFlags & kOpenModeFlagUnbuffered ) || ( ( offset | readBytes | reinterpret_cast< uintptr >( outBuf ) ) & ( kUnbufferedAlignment - 1 ) ) == 0,
+		_T( "Unbuffered read must be aligned.\n" ) );
+
+	// preadはファイル位置を共有しないため複数スレッドから同時に読み込める.
+	u8* dst = static_cast< u8* >( outBuf );
+	size_t totalBytes = 0;
+	bool succeeded = true;
+	while( totalBytes < readBytes )
+	{
+		ssize_t result = pread( _fileDescriptor, dst + totalBytes, Min( readBytes - totalBytes, kTransferBytesMax ), static_cast< off_t >( offset + totalBytes ) );
+		if( result < 0 )
+		{
+			if( errno == EINTR ) continue;
+			// ファイルデータ読み込み失敗.
+			succeeded = false;
+			break;
+		}
+		if( result == 0 )
+		{
+			// ファイル終端.
+			break;
+		}
+		totalBytes += static_cast< size_t >( result );
+	}
+
+	// 読み取ったバイト数を格納.
+	if( readedBytes )
+	{
+		(*readedBytes) = totalBytes;
+	}
+
+	return succeeded;
+}
+
+//---------------------------------------------------------------------------
+//	ファイルデータ書き込み.
+//---------------------------------------------------------------------------
+bool File::WriteFile( const void* buf, size_t writeBytes )
+{
+	if( !( _openFlags & kOpenModeFlagWrite ) )
+	{
+		AROMA_ASSERT( false, _T( "FileIO not WRITE mode.\n" ) );
+		return false;
+	}
+
+	const u8* src = static_cast< const u8* >( buf );
+	while( writeBytes > 0 )
+	{
+		ssize_t writtenBytes = write( _fileDescriptor, src, Min( writeBytes, kTransferBytesMax ) );
+		if( writtenBytes < 0 && errno == EINTR )
+		{
+			continue;
+		}
+		if( writtenBytes <= 0 )
+		{
+			// ファイルデータ書き込み失敗.
+			return false;
+		}
+		src			+= writtenBytes;
+		writeBytes	-= static_cast< size_t >( writtenBytes );
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	書き込んだデータをストレージへ反映.
+//---------------------------------------------------------------------------
+bool File::FlushBuffers()
+{
+	if( !( _openFlags & kOpenModeFlagWrite ) )
+	{
+		AROMA_ASSERT( false, _T( "FileIO not WRITE mode.\n" ) );
+		return false;
+	}
+	return fsync( _fileDescriptor ) == 0;
+}
+
+//---------------------------------------------------------------------------
+//	オープンモードフラグ取得.
+//---------------------------------------------------------------------------
+u32 File::GetOpenFlags() const
+{
+	return _openFlags;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブファイルハンドル取得.
+//---------------------------------------------------------------------------
+NativeFileHandle File::GetNativeHandle() const
+{
+	return _fileDescriptor;
+}
+
+
+} // namespace file
+} // namespace aroma
+
+#endif
@@ -9,11 +9,65 @@
 //===========================================================================
 #ifdef AROMA_WINDOWS
 
+#include <malloc.h>
 #include <aroma/file/FileIO.h>
+#include <aroma/common/Algorithm.h>
+#include <aroma/common/Alignment.h>
 
 namespace aroma {
 namespace file {
 
+namespace {
+
+// セクターサイズ4KBのドライブを含め満たせる値.
+constexpr size_t kUnbufferedAlignment = 4096;
+
+// 1回のReadFile/WriteFileの最大バイト数.
+// MAXDWORDのままではアンバッファードI/Oの分割位置がセクター境界からずれるためアラインする.
+constexpr DWORD kMaxTransferBytes = static_cast< DWORD >( MAXDWORD & ~( kUnbufferedAlignment - 1 ) );
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	アンバッファードI/Oのアラインメント取得.
+//---------------------------------------------------------------------------
+size_t GetUnbufferedAlignment()
+{
+	return kUnbufferedAlignment;
+}
+
+//---------------------------------------------------------------------------
+//	アンバッファードI/O用バッファ確保.
+//---------------------------------------------------------------------------
+void* AllocateUnbufferedBuffer( size_t size )
+{
+	return _aligned_malloc( AlignUp( Max< size_t >( size, 1 ), kUnbufferedAlignment ), kUnbufferedAlignment );
+}
+
+//---------------------------------------------------------------------------
+//	アンバッファードI/O用バッファ解放.
+//---------------------------------------------------------------------------
+void FreeUnbufferedBuffer( void* buffer )
+{
+	_aligned_free( buffer );
+}
+
+//---------------------------------------------------------------------------
+//	ファイル名変更.
+//---------------------------------------------------------------------------
+bool RenameFile( CTStr srcFilePath, CTStr dstFilePath )
+{
+	return MoveFileEx( srcFilePath, dstFilePath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != FALSE;
+}
+
+//---------------------------------------------------------------------------
+//	ファイル削除.
+//---------------------------------------------------------------------------
+bool RemoveFile( CTStr filePath )
+{
+	return ::DeleteFile( filePath ) != FALSE;
+}
+
 //---------------------------------------------------------------------------
 //	デフォルトコンストラクタ.
 //---------------------------------------------------------------------------
@@ -23,6 +77,7 @@ File::File()
 	, _shareFlags( 0 )
 	, _filePath( nullptr )
 	, _fileHandle( INVALID_HANDLE_VALUE )
+	, _completionPortId( 0 )
 {
 }
 
@@ -58,9 +113,14 @@ bool File::Open( CTStr filePath, u32 openflags, u32 shareFlags )
 	if( shareFlags & kShareFlagWrite )		shareMode |= FILE_SHARE_WRITE;
 
 	DWORD creationDisposition = OPEN_EXISTING;
-	if( openflags & kOpenModeFlagWrite ) creationDisposition = OPEN_ALWAYS;
+	if( openflags & kOpenModeFlagWrite ) creationDisposition = ( openflags & kOpenModeFlagTruncate ) ? CREATE_ALWAYS : OPEN_ALWAYS;
+	if( ( openflags & kOpenModeFlagWrite ) && ( openflags & kOpenModeFlagCreateNew ) ) creationDisposition = CREATE_NEW;
 
-	_fileHandle = CreateFile( filePath, desiredAccess, shareMode, nullptr, creationDisposition, FILE_FLAG_RANDOM_ACCESS, nullptr );
+	DWORD flagsAndAttributes = ( openflags & kOpenModeFlagSequential ) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+	if( openflags & kOpenModeFlagAsync )		flagsAndAttributes |= FILE_FLAG_OVERLAPPED;
+	if( openflags & kOpenModeFlagUnbuffered )	flagsAndAttributes |= FILE_FLAG_NO_BUFFERING;
+
+	_fileHandle = CreateFile( filePath, desiredAccess, shareMode, nullptr, creationDisposition, flagsAndAttributes, nullptr );
 	if( _fileHandle == INVALID_HANDLE_VALUE )
 	{
 		// ファイルオープン失敗.
@@ -81,6 +141,7 @@ void File::Close()
 	BOOL result = CloseHandle( _fileHandle );
 	AROMA_ASSERT( result, _T( "Failed to CloseHandle.\n" ) );
 	_fileHandle = INVALID_HANDLE_VALUE;
+	_completionPortId = 0;
 	memory::SafeFree( _filePath );
 	_opened = false;
 }
@@ -112,34 +173,182 @@ bool File::ReadFile( void* outBuf, size_t readBytes, size_t* readedBytes )
 		AROMA_ASSERT( false, _T( "FileIO not READ mode.\n" ) );
 		return false;
 	}
-
-	DWORD tempReadedBytes;
-	BOOL result = ::ReadFile( _fileHandle, outBuf, static_cast< DWORD >( readBytes ), &tempReadedBytes, nullptr );
-	if( result == FALSE )
+	if( _openFlags & kOpenModeFlagAsync )
 	{
-		// ファイルデータ読み込み失敗.
+		AROMA_ASSERT( false, _T( "Use ReadFileAt for async file.\n" ) );
 		return false;
 	}
+	AROMA_ASSERT( !( _openFlags & kOpenModeFlagUnbuffered ) || ( ( readBytes | reinterpret_cast< uintptr >( outBuf ) ) & ( kUnbufferedAlignment - 1 ) ) == 0,
+		_T( "Unbuffered read must be aligned.\n" ) );
+
+	// ReadFileはDWORD単位のため分割して読み込む.
+	u8* dst = static_cast< u8* >( outBuf );
+	size_t totalBytes = 0;
+	while( totalBytes < readBytes )
+	{
+		DWORD requestBytes = static_cast< DWORD >( Min< size_t >( readBytes - totalBytes, kMaxTransferBytes ) );
+		DWORD tempReadedBytes = 0;
+		BOOL result = ::ReadFile( _fileHandle, dst + totalBytes, requestBytes, &tempReadedBytes, nullptr );
+		if( result == FALSE )
+		{
+			// ファイルデータ読み込み失敗.
+			return false;
+		}
+		totalBytes += tempReadedBytes;
+		if( tempReadedBytes < requestBytes )
+		{
+			// ファイル終端.
+			break;
+		}
+	}
 
 	// 読み取ったバイト数を格納.
 	if( readedBytes )
 	{
-		(*readedBytes) = tempReadedBytes;
+		(*readedBytes) = totalBytes;
 	}
 
 	return true;
 }
 
+//---------------------------------------------------------------------------
+//	オフセット指定でファイルデータ読み込み.
+//---------------------------------------------------------------------------
+bool File::ReadFileAt( u64 offset, void* outBuf, size_t readBytes, size_t* readedBytes )
+{
+	if( !( _openFlags & kOpenModeFlagRead ) )
+	{
+		AROMA_ASSERT( false, _T( "FileIO not READ mode.\n" ) );
+		return false;
+	}
+	AROMA_ASSERT( !( _openFlags & kOpenModeFlagUnbuffered ) || ( ( offset | readBytes | reinterpret_cast< uintptr >( outBuf ) ) & ( kUnbufferedAlignment - 1 ) ) == 0,
+		_T( "Unbuffered read must be aligned.\n" ) );
+
+	// 非同期オープンの場合は完了を待つイベントが必要.
+	// イベントハンドルの下位ビットを立てると完了ポートへ通知されない.
+	HANDLE eventHandle = nullptr;
+	if( _openFlags & kOpenModeFlagAsync )
+	{
+		eventHandle = CreateEvent( nullptr, TRUE, FALSE, nullptr );
+		if( eventHandle == nullptr )
+		{
+			return false;
+		}
+	}
+
+	// ReadFileはDWORD単位のため分割して読み込む.
+	u8* dst = static_cast< u8* >( outBuf );
+	size_t totalBytes = 0;
+	bool succeeded = true;
+	while( totalBytes < readBytes )
+	{
+		const u64 position = offset + totalBytes;
+		OVERLAPPED overlapped;
+		memory::Clear( overlapped );
+		overlapped.Offset		= static_cast< DWORD >( position );
+		overlapped.OffsetHigh	= static_cast< DWORD >( position >> 32 );
+		overlapped.hEvent		= eventHandle ? reinterpret_cast< HANDLE >( reinterpret_cast< uintptr >( eventHandle ) | 1 ) : nullptr;
+
+		DWORD requestBytes = static_cast< DWORD >( Min< size_t >( readBytes - totalBytes, kMaxTransferBytes ) );
+		DWORD tempReadedBytes = 0;
+		BOOL result = ::ReadFile( _fileHandle, dst + totalBytes, requestBytes, nullptr, &overlapped );
+		if( result != FALSE || GetLastError() == ERROR_IO_PENDING )
+		{
+			result = GetOverlappedResult( _fileHandle, &overlapped, &tempReadedBytes, TRUE );
+		}
+		if( result == FALSE )
+		{
+			// ファイル終端は成功扱い.
+			succeeded = ( GetLastError() == ERROR_HANDLE_EOF );
+			break;
+		}
+		if( tempReadedBytes == 0 )
+		{
+			break;
+		}
+		totalBytes += tempReadedBytes;
+	}
+
+	if( eventHandle )
+	{
+		CloseHandle( eventHandle );
+	}
+
+	// 読み取ったバイト数を格納.
+	if( readedBytes )
+	{
+		(*readedBytes) = totalBytes;
+	}
+
+	return succeeded;
+}
+
 //---------------------------------------------------------------------------
 //	ファイルデータ書き込み.
 //---------------------------------------------------------------------------
-bool File::WriteFile( void* outBuf, size_t writeBytes )
+bool File::WriteFile( const void* buf, size_t writeBytes )
 {
-	// TODO: 実装.
-	AROMA_ASSERT( false, _T( "Unimplemented.\n" ) );
+	if( !( _openFlags & kOpenModeFlagWrite ) )
+	{
+		AROMA_ASSERT( false, _T( "FileIO not WRITE mode.\n" ) );
+		return false;
+	}
+	if( _openFlags & kOpenModeFlagAsync )
+	{
+		AROMA_ASSERT( false, _T( "Async file does not support WriteFile.\n" ) );
+		return false;
+	}
+	AROMA_ASSERT( !( _openFlags & kOpenModeFlagUnbuffered ) || ( ( writeBytes | reinterpret_cast< uintptr >( buf ) ) & ( kUnbufferedAlignment - 1 ) ) == 0,
+		_T( "Unbuffered write must be aligned.\n" ) );
+
+	// WriteFileはDWORD単位のため分割して書き込む.
+	const u8* src = static_cast< const u8* >( buf );
+	while( writeBytes > 0 )
+	{
+		DWORD requestBytes = static_cast< DWORD >( Min< size_t >( writeBytes, kMaxTransferBytes ) );
+		DWORD writtenBytes = 0;
+		BOOL result = ::WriteFile( _fileHandle, src, requestBytes, &writtenBytes, nullptr );
+		if( result == FALSE || writtenBytes == 0 )
+		{
+			// ファイルデータ書き込み失敗.
+			return false;
+		}
+		src			+= writtenBytes;
+		writeBytes	-= writtenBytes;
+	}
+
 	return true;
 }
 
+//---------------------------------------------------------------------------
+//	書き込んだデータをストレージへ反映.
+//---------------------------------------------------------------------------
+bool File::FlushBuffers()
+{
+	if( !( _openFlags & kOpenModeFlagWrite ) )
+	{
+		AROMA_ASSERT( false, _T( "FileIO not WRITE mode.\n" ) );
+		return false;
+	}
+	return FlushFileBuffers( _fileHandle ) != FALSE;
+}
+
+//---------------------------------------------------------------------------
+//	オープンモードフラグ取得.
+//---------------------------------------------------------------------------
+u32 File::GetOpenFlags() const
+{
+	return _openFlags;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブファイルハンドル取得.
+//---------------------------------------------------------------------------
+NativeFileHandle File::GetNativeHandle() const
+{
+	return _fileHandle;
+}
+
 
 } // namespace file
 } // namespace aroma
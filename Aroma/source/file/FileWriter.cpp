@@ -0,0 +1,359 @@
+﻿//===========================================================================
+//!
+//!	@file		FileWriter.cpp
+//! @brief		バッファリングファイル書き込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <cstring>
+#ifdef AROMA_POSIX
+#include <unistd.h>
+#endif
+#include <aroma/file/FileWriter.h>
+#include <aroma/common/Algorithm.h>
+
+namespace aroma {
+namespace file {
+
+namespace {
+
+//! 一時ファイルの作成を試行する最大回数(残っている古い一時ファイルとの衝突時に次の名前で再試行).
+constexpr u32 kTempFileRetryCount = 16;
+
+//! 一時ファイル名の連番(プロセス内で一意).
+std::atomic< u32 > g_tempFileSerial( 0 );
+
+//---------------------------------------------------------------------------
+//	16進数の追加.
+//---------------------------------------------------------------------------
+void AppendHex( std::basic_string< TChar >* str, u32 value )
+{
+	TChar digits[ 8 ];
+	u32 count = 0;
+	do
+	{
+		digits[ count++ ] = static_cast< TChar >( _T( "0123456789abcdef" )[ value & 0xf ] );
+		value >>= 4;
+	} while( value != 0 );
+	while( count > 0 ) str->push_back( digits[ --count ] );
+}
+
+//---------------------------------------------------------------------------
+//	一時ファイルパスの生成.
+//	同じファイルへの同時書き込みで衝突しないよう, プロセスIDと連番を付ける.
+//---------------------------------------------------------------------------
+std::basic_string< TChar > MakeTempFilePath( const std::basic_string< TChar >& filePath )
+{
+#ifdef AROMA_WINDOWS
+	const u32 processId = static_cast< u32 >( GetCurrentProcessId() );
+#else
+	const u32 processId = static_cast< u32 >( getpid() );
+#endif
+	std::basic_string< TChar > tempFilePath = filePath;
+	tempFilePath += _T( "." );
+	AppendHex( &tempFilePath, processId );
+	tempFilePath += _T( "-" );
+	AppendHex( &tempFilePath, g_tempFileSerial.fetch_add( 1, std::memory_order_relaxed ) );
+	tempFilePath += _T( ".tmp" );
+	return tempFilePath;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	デフォルトコンストラクタ.
+//---------------------------------------------------------------------------
+FileWriter::FileWriter()
+	: _opened( false )
+	, _activeBuffer( 0 )
+	, _bufferUsed( 0 )
+	, _writtenBytes( 0 )
+	, _failed( false )
+	, _flushData( nullptr )
+	, _flushSize( 0 )
+	, _quit( false )
+{
+	_buffers[ 0 ] = nullptr;
+	_buffers[ 1 ] = nullptr;
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+FileWriter::~FileWriter()
+{
+	Close();
+}
+
+//---------------------------------------------------------------------------
+//	ファイルオープン.
+//---------------------------------------------------------------------------
+bool FileWriter::Open( CTStr filePath, const Desc& desc )
+{
+	if( _opened )
+	{
+		AROMA_ASSERT( false, _T( "Already opened.\n" ) );
+		Close();
+	}
+
+	_desc		= desc;
+	_filePath	= filePath;
+	_tempFilePath.clear();
+	if( _desc.atomicReplace )
+	{
+		// 既存のファイルを開くと他のライターの一時ファイルを壊すため, 新規作成のみ許可する.
+		bool opened = false;
+		for( u32 i = 0; i < kTempFileRetryCount && !opened; ++i )
+		{
+			_tempFilePath	= MakeTempFilePath( _filePath );
+			opened			= _file.Open( _tempFilePath.c_str(), kOpenModeFlagWrite | kOpenModeFlagSequential | kOpenModeFlagCreateNew, 0 );
+		}
+		if( !opened )
+		{
+			// ファイルオープン失敗.
+			_tempFilePath.clear();
+			return false;
+		}
+	}
+	else if( !_file.Open( _filePath.c_str(), kOpenModeFlagWrite | kOpenModeFlagSequential | kOpenModeFlagTruncate, 0 ) )
+	{
+		// ファイルオープン失敗.
+		return false;
+	}
+
+	_desc.bufferSize	= Max< size_t >( _desc.bufferSize, 4096 );
+	_buffers[ 0 ]		= new u8[ _desc.bufferSize ];
+	_buffers[ 1 ]		= _desc.backgroundFlush ? new u8[ _desc.bufferSize ] : nullptr;
+	_activeBuffer		= 0;
+	_bufferUsed			= 0;
+	_writtenBytes		= 0;
+	_failed				= false;
+	_flushData			= nullptr;
+	_flushSize			= 0;
+	_quit				= false;
+	if( _desc.backgroundFlush )
+	{
+		_flushThread = std::thread( &FileWriter::FlushThreadMain, this );
+	}
+
+	_opened = true;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	データ書き込み.
+//---------------------------------------------------------------------------
+bool FileWriter::Write( const void* data, size_t size )
+{
+	if( !_opened )
+	{
+		AROMA_ASSERT( false, _T( "Not opened.\n" ) );
+		return false;
+	}
+
+	const u8* src = static_cast< const u8* >( data );
+	_writtenBytes += size;
+
+	// 同期書き出しでバッファより大きい場合はコピーせず直接書き込む.
+	if( !_desc.backgroundFlush && size >= _desc.bufferSize )
+	{
+		SubmitBuffer();
+		if( !_file.WriteFile( src, size ) )
+		{
+			_failed = true;
+		}
+		return !_failed;
+	}
+
+	while( size > 0 )
+	{
+		const size_t copyBytes = Min( size, _desc.bufferSize - _bufferUsed );
+		memcpy( _buffers[ _activeBuffer ] + _bufferUsed, src, copyBytes );
+		_bufferUsed	+= copyBytes;
+		src			+= copyBytes;
+		size		-= copyBytes;
+		if( _bufferUsed == _desc.bufferSize )
+		{
+			SubmitBuffer();
+		}
+	}
+	return !_failed;
+}
+
+//---------------------------------------------------------------------------
+//	バッファの内容をファイルへ書き出し.
+//---------------------------------------------------------------------------
+bool FileWriter::Flush()
+{
+	if( !_opened ) return false;
+
+	SubmitBuffer();
+	WaitFlushIdle();
+	return !_failed;
+}
+
+//---------------------------------------------------------------------------
+//	書き出してファイルクローズ.
+//---------------------------------------------------------------------------
+bool FileWriter::Close()
+{
+	if( !_opened ) return false;
+
+	Flush();
+	StopFlushThread();
+
+	// 置き換え前にストレージへ反映しないと, 電源断時に空のファイルへ置き換わる場合がある.
+	if( _desc.atomicReplace && !_failed && !_file.FlushBuffers() )
+	{
+		_failed = true;
+	}
+	CloseFile( !_failed );
+	return !_failed;
+}
+
+//---------------------------------------------------------------------------
+//	書き込みを破棄してファイルクローズ.
+//---------------------------------------------------------------------------
+void FileWriter::Abort()
+{
+	if( !_opened ) return;
+
+	_bufferUsed = 0;
+	WaitFlushIdle();
+	StopFlushThread();
+	CloseFile( false );
+}
+
+//---------------------------------------------------------------------------
+//	オープン済みか.
+//---------------------------------------------------------------------------
+bool FileWriter::IsOpened() const
+{
+	return _opened;
+}
+
+//---------------------------------------------------------------------------
+//	Write()したバイト数の合計取得.
+//---------------------------------------------------------------------------
+u64 FileWriter::GetWrittenBytes() const
+{
+	return _writtenBytes;
+}
+
+//---------------------------------------------------------------------------
+//	使用中のバッファを書き出し.
+//---------------------------------------------------------------------------
+void FileWriter::SubmitBuffer()
+{
+	if( _bufferUsed == 0 ) return;
+
+	if( !_desc.backgroundFlush )
+	{
+		if( !_file.WriteFile( _buffers[ _activeBuffer ], _bufferUsed ) )
+		{
+			_failed = true;
+		}
+		_bufferUsed = 0;
+		return;
+	}
+
+	// もう一方のバッファの書き出し完了を待ってから渡し, 使用するバッファを切り替える.
+	{
+		std::unique_lock< std::mutex > lock( _mutex );
+		_condition.wait( lock, [ this ](){ return _flushSize == 0; } );
+		_flushData = _buffers[ _activeBuffer ];
+		_flushSize = _bufferUsed;
+	}
+	_condition.notify_all();
+	_activeBuffer ^= 1;
+	_bufferUsed = 0;
+}
+
+//---------------------------------------------------------------------------
+//	バックグラウンドでの書き出し完了待ち.
+//---------------------------------------------------------------------------
+void FileWriter::WaitFlushIdle()
+{
+	if( !_desc.backgroundFlush ) return;
+
+	std::unique_lock< std::mutex > lock( _mutex );
+	_condition.wait( lock, [ this ](){ return _flushSize == 0; } );
+}
+
+//---------------------------------------------------------------------------
+//	書き出しスレッド終了.
+//---------------------------------------------------------------------------
+void FileWriter::StopFlushThread()
+{
+	if( !_flushThread.joinable() ) return;
+
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		_quit = true;
+	}
+	_condition.notify_all();
+	_flushThread.join();
+}
+
+//---------------------------------------------------------------------------
+//	ファイルクローズ.
+//---------------------------------------------------------------------------
+void FileWriter::CloseFile( bool commit )
+{
+	_file.Close();
+	if( _desc.atomicReplace )
+	{
+		if( commit )
+		{
+			if( !RenameFile( _tempFilePath.c_str(), _filePath.c_str() ) )
+			{
+				_failed = true;
+				RemoveFile( _tempFilePath.c_str() );
+			}
+		}
+		else
+		{
+			RemoveFile( _tempFilePath.c_str() );
+		}
+	}
+
+	memory::SafeDeleteArray( _buffers[ 0 ] );
+	memory::SafeDeleteArray( _buffers[ 1 ] );
+	_bufferUsed	= 0;
+	_opened		= false;
+}
+
+//---------------------------------------------------------------------------
+//	書き出しスレッドメイン.
+//---------------------------------------------------------------------------
+void FileWriter::FlushThreadMain()
+{
+	std::unique_lock< std::mutex > lock( _mutex );
+	while( true )
+	{
+		_condition.wait( lock, [ this ](){ return _flushSize > 0 || _quit; } );
+		if( _flushSize == 0 )
+		{
+			// 終了要求.
+			break;
+		}
+
+		const u8* data = _flushData;
+		const size_t size = _flushSize;
+		lock.unlock();
+		if( !_file.WriteFile( data, size ) )
+		{
+			_failed = true;
+		}
+		lock.lock();
+
+		_flushData = nullptr;
+		_flushSize = 0;
+		_condition.notify_all();
+	}
+}
+
+} // namespace file
+} // namespace aroma
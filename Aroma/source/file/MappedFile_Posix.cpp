@@ -0,0 +1,125 @@
+﻿//===========================================================================
+//!
+//!	@file		MappedFile_Posix.cpp
+//! @brief		メモリマップドファイル : POSIX.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_POSIX
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <aroma/file/MappedFile.h>
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//	デフォルトコンストラクタ.
+//---------------------------------------------------------------------------
+MappedFile::MappedFile()
+	: _opened( false )
+	, _data( nullptr )
+	, _size( 0 )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//---------------------------------------------------------------------------
+//	ファイルをオープンしてマップ.
+//---------------------------------------------------------------------------
+bool MappedFile::Open( CTStr filePath, u32 hintFlags )
+{
+	if( _opened )
+	{
+		AROMA_ASSERT( false, _T( "Already opened.\n" ) );
+		Close();
+	}
+
+	int fd = open( filePath, O_RDONLY | O_CLOEXEC );
+	if( fd < 0 )
+	{
+		// ファイルオープン失敗.
+		return false;
+	}
+
+	struct stat fileStat;
+	if( fstat( fd, &fileStat ) != 0 || fileStat.st_size <= 0 )
+	{
+		// 空のファイルはマップできない.
+		close( fd );
+		return false;
+	}
+
+	// マップはファイルディスクリプタを参照するため, マップ後に閉じてよい.
+	const size_t size = static_cast< size_t >( fileStat.st_size );
+	void* view = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( view == MAP_FAILED )
+	{
+		return false;
+	}
+
+	if( hintFlags & kMapHintFlagSequential )	madvise( view, size, MADV_SEQUENTIAL );
+	if( hintFlags & kMapHintFlagWillNeed )		madvise( view, size, MADV_WILLNEED );
+
+	_data	= view;
+	_size	= size;
+	_opened	= true;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	マップ解除.
+//---------------------------------------------------------------------------
+void MappedFile::Close()
+{
+	if( !_opened ) return;
+
+	int result = munmap( const_cast< void* >( _data ), _size );
+	AROMA_ASSERT( result == 0, _T( "Failed to munmap.\n" ) );
+	(void)result;
+	_data	= nullptr;
+	_size	= 0;
+	_opened	= false;
+}
+
+//---------------------------------------------------------------------------
+//	マップ済みか.
+//---------------------------------------------------------------------------
+bool MappedFile::IsOpened() const
+{
+	return _opened;
+}
+
+//---------------------------------------------------------------------------
+//	マップしたファイル内容の先頭アドレス取得.
+//---------------------------------------------------------------------------
+const void* MappedFile::GetData() const
+{
+	return _data;
+}
+
+//---------------------------------------------------------------------------
+//	ファイルサイズ取得.
+//---------------------------------------------------------------------------
+size_t MappedFile::GetSize() const
+{
+	return _size;
+}
+
+} // namespace file
+} // namespace aroma
+
+#endif
@@ -0,0 +1,127 @@
+﻿//===========================================================================
+//!
+//!	@file		MappedFile_Win.cpp
+//! @brief		メモリマップドファイル : Windows.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_WINDOWS
+
+#include <aroma/file/MappedFile.h>
+
+namespace aroma {
+namespace file {
+
+//---------------------------------------------------------------------------
+//	デフォルトコンストラクタ.
+//---------------------------------------------------------------------------
+MappedFile::MappedFile()
+	: _opened( false )
+	, _data( nullptr )
+	, _size( 0 )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//---------------------------------------------------------------------------
+//	ファイルをオープンしてマップ.
+//---------------------------------------------------------------------------
+bool MappedFile::Open( CTStr filePath, u32 hintFlags )
+{
+	if( _opened )
+	{
+		AROMA_ASSERT( false, _T( "Already opened.\n" ) );
+		Close();
+	}
+
+	DWORD flagsAndAttributes = FILE_ATTRIBUTE_NORMAL;
+	if( hintFlags & kMapHintFlagSequential )	flagsAndAttributes |= FILE_FLAG_SEQUENTIAL_SCAN;
+
+	HANDLE fileHandle = CreateFile( filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flagsAndAttributes, nullptr );
+	if( fileHandle == INVALID_HANDLE_VALUE )
+	{
+		// ファイルオープン失敗.
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if( GetFileSizeEx( fileHandle, &fileSize ) == FALSE || fileSize.QuadPart == 0 )
+	{
+		// 空のファイルはマップできない.
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMapping( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if( mappingHandle == nullptr )
+	{
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	// ビューがマッピングオブジェクトを参照するため, ハンドルはマップ後に閉じてよい.
+	void* view = MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mappingHandle );
+	CloseHandle( fileHandle );
+	if( view == nullptr )
+	{
+		return false;
+	}
+
+	_data	= view;
+	_size	= static_cast< size_t >( fileSize.QuadPart );
+	_opened	= true;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	マップ解除.
+//---------------------------------------------------------------------------
+void MappedFile::Close()
+{
+	if( !_opened ) return;
+
+	BOOL result = UnmapViewOfFile( _data );
+	AROMA_ASSERT( result, _T( "Failed to UnmapViewOfFile.\n" ) );
+	_data	= nullptr;
+	_size	= 0;
+	_opened	= false;
+}
+
+//---------------------------------------------------------------------------
+//	マップ済みか.
+//---------------------------------------------------------------------------
+bool MappedFile::IsOpened() const
+{
+	return _opened;
+}
+
+//---------------------------------------------------------------------------
+//	マップしたファイル内容の先頭アドレス取得.
+//---------------------------------------------------------------------------
+const void* MappedFile::GetData() const
+{
+	return _data;
+}
+
+//---------------------------------------------------------------------------
+//	ファイルサイズ取得.
+//---------------------------------------------------------------------------
+size_t MappedFile::GetSize() const
+{
+	return _size;
+}
+
+} // namespace file
+} // namespace aroma
+
+#endif
@@ -0,0 +1,102 @@
+﻿//===========================================================================
+//!
+//!	@file		ParallelRead.cpp
+//! @brief		分割並列ファイル読み込み.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <memory>
+#include <aroma/file/ParallelRead.h>
+#include <aroma/common/Algorithm.h>
+#include <aroma/common/Alignment.h>
+
+namespace aroma {
+namespace file {
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	チャンク間で共有する読み込み状態.
+//---------------------------------------------------------------------------
+struct ParallelReadState
+{
+	TaskPromise< ParallelReadResult >	promise;
+	std::atomic< size_t >				remainingCount;
+	std::atomic< size_t >				readBytes;
+	std::atomic< bool >					failed;
+};
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	大きな範囲をチャンクに分割して並列に読み込み.
+//---------------------------------------------------------------------------
+Task< ParallelReadResult > ReadFileParallel( IScheduler* scheduler, File* file, u64 offset, size_t size, void* dest, size_t chunkSize )
+{
+	auto state = std::make_shared< ParallelReadState >();
+	Task< ParallelReadResult > task = state->promise.GetTask();
+
+	if( file == nullptr || dest == nullptr || !( file->GetOpenFlags() & kOpenModeFlagRead ) )
+	{
+		AROMA_ASSERT( false, _T( "Invalid read request.\n" ) );
+		state->promise.SetValue( ParallelReadResult{ 0, false } );
+		return task;
+	}
+	if( size == 0 )
+	{
+		state->promise.SetValue( ParallelReadResult{ 0, true } );
+		return task;
+	}
+#ifdef AROMA_WINDOWS
+	// 同期オープンのハンドルは読み込みが直列化され並列化の効果が無い.
+	AROMA_ASSERT( scheduler == nullptr || ( file->GetOpenFlags() & kOpenModeFlagAsync ),
+		_T( "ReadFileParallel requires kOpenModeFlagAsync to read in parallel.\n" ) );
+#endif
+
+	const size_t alignment	= GetUnbufferedAlignment();
+	chunkSize				= AlignUp( Max( chunkSize, alignment ), alignment );
+	const size_t chunkCount	= ( size + chunkSize - 1 ) / chunkSize;
+	state->remainingCount	= chunkCount;
+	state->readBytes		= 0;
+	state->failed			= false;
+
+	for( size_t i = 0; i < chunkCount; ++i )
+	{
+		const size_t begin		= i * chunkSize;
+		const size_t chunkBytes	= Min( chunkSize, size - begin );
+		auto job = [ state, file, offset, dest, begin, chunkBytes ]()
+		{
+			size_t readBytes = 0;
+			if( !file->ReadFileAt( offset + begin, static_cast< u8* >( dest ) + begin, chunkBytes, &readBytes ) )
+			{
+				state->failed.store( true, std::memory_order_relaxed );
+			}
+			state->readBytes.fetch_add( readBytes, std::memory_order_relaxed );
+
+			// 最後に完了したチャンクが一度だけ完了を通知する.
+			if( state->remainingCount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+			{
+				ParallelReadResult result;
+				result.readBytes	= state->readBytes.load( std::memory_order_relaxed );
+				result.succeeded	= !state->failed.load( std::memory_order_relaxed );
+				state->promise.SetValue( result );
+			}
+		};
+
+		if( scheduler )
+		{
+			scheduler->Schedule( std::move( job ) );
+		}
+		else
+		{
+			job();
+		}
+	}
+	return task;
+}
+
+} // namespace file
+} // namespace aroma
@@ -0,0 +1,186 @@
+﻿//===========================================================================
+//!
+//!	@file		BindingGroup_DX11.cpp
+//!	@brief		リソースバインディンググループ : DirectX11.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_RENDER_DX11
+
+#include <aroma/render/BindingGroup.h>
+#include <aroma/render/Device.h>
+#include <aroma/render/TextureView.h>
+#include <aroma/render/Buffer.h>
+#include <aroma/render/RenderStateCache.h>
+
+namespace aroma {
+namespace render {
+
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+BindingGroup::BindingGroup()
+	: _initialized( false )
+	, _device( nullptr )
+	, _shaderResources( nullptr )
+	, _constantBuffers( nullptr )
+	, _samplerStates( nullptr )
+	, _d3dShaderResources( nullptr )
+	, _d3dConstantBuffers( nullptr )
+	, _d3dSamplers( nullptr )
+{
+	memory::Clear( _nativeBindingGroup );
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+BindingGroup::~BindingGroup()
+{
+	Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	初期化.
+//---------------------------------------------------------------------------
+void BindingGroup::Initialize( Device* device, const Desc& desc )
+{
+	if( _initialized )
+	{
+		AROMA_ASSERT( false, _T( "Already initialized.\n" ) );
+		Finalize();
+	}
+	AROMA_ASSERT( desc.shaderResourceStart + desc.shaderResourceNum <= kShaderResourceSlotMax, _T( "Shader resource slot is out of range.\n" ) );
+	AROMA_ASSERT( desc.constantBufferStart + desc.constantBufferNum <= kShaderUniformBufferSlotMax, _T( "Constant buffer slot is out of range.\n" ) );
+	AROMA_ASSERT( desc.samplerStart + desc.samplerNum <= kSamplerSlotMax, _T( "Sampler slot is out of range.\n" ) );
+
+	_device = device;
+	_device->AddRef();
+	_desc = desc;
+
+	// シェーダーリソース.
+	if( _desc.shaderResourceNum > 0 )
+	{
+		_shaderResources	= new TextureView*[ _desc.shaderResourceNum ];
+		_d3dShaderResources	= new ID3D11ShaderResourceView*[ _desc.shaderResourceNum ];
+		for( u32 i = 0; i < _desc.shaderResourceNum; ++i )
+		{
+			auto srv = desc.shaderResources[ i ];
+			AROMA_ASSERT( srv, _T( "Shader resource is null.\n" ) );
+			srv->AddRef();
+			_shaderResources[ i ]		= srv;
+			_d3dShaderResources[ i ]	= srv->GetNativeShaderResourceView();
+		}
+	}
+	_desc.shaderResources = _shaderResources;
+
+	// 定数バッファ.
+	if( _desc.constantBufferNum > 0 )
+	{
+		_constantBuffers	= new Buffer*[ _desc.constantBufferNum ];
+		_d3dConstantBuffers	= new ID3D11Buffer*[ _desc.constantBufferNum ];
+		for( u32 i = 0; i < _desc.constantBufferNum; ++i )
+		{
+			auto cb = desc.constantBuffers[ i ];
+			AROMA_ASSERT( cb, _T( "Constant buffer is null.\n" ) );
+			cb->AddRef();
+			_constantBuffers[ i ]		= cb;
+			_d3dConstantBuffers[ i ]	= cb->GetNativeBuffer();
+		}
+	}
+	_desc.constantBuffers = _constantBuffers;
+
+	// サンプラーステート.
+	// ネイティブステートはデバイスのキャッシュが所有するため参照のみ保持.
+	if( _desc.samplerNum > 0 )
+	{
+		auto renderStateCache = _device->GetRenderStateCache();
+		_samplerStates	= new SamplerState[ _desc.samplerNum ];
+		_d3dSamplers	= new ID3D11SamplerState*[ _desc.samplerNum ];
+		for( u32 i = 0; i < _desc.samplerNum; ++i )
+		{
+			_samplerStates[ i ].Set( desc.samplerStates[ i ] );
+			SamplerStateKey key( _samplerStates[ i ] );
+			_d3dSamplers[ i ] = renderStateCache->GetNativeSamplerState( key );
+		}
+	}
+	_desc.samplerStates = _samplerStates;
+
+	_nativeBindingGroup.shaderResourceStart	= _desc.shaderResourceStart;
+	_nativeBindingGroup.shaderResourceNum	= _desc.shaderResourceNum;
+	_nativeBindingGroup.shaderResources		= _d3dShaderResources;
+	_nativeBindingGroup.constantBufferStart	= _desc.constantBufferStart;
+	_nativeBindingGroup.constantBufferNum	= _desc.constantBufferNum;
+	_nativeBindingGroup.constantBuffers		= _d3dConstantBuffers;
+	_nativeBindingGroup.samplerStart		= _desc.samplerStart;
+	_nativeBindingGroup.samplerNum			= _desc.samplerNum;
+	_nativeBindingGroup.samplers			= _d3dSamplers;
+
+	_initialized = true;
+}
+
+//---------------------------------------------------------------------------
+//	解放.
+//---------------------------------------------------------------------------
+void BindingGroup::Finalize()
+{
+	if( !_initialized ) return;
+
+	for( u32 i = 0; i < _desc.shaderResourceNum; ++i )
+	{
+		memory::SafeRelease( _shaderResources[ i ] );
+	}
+	for( u32 i = 0; i < _desc.constantBufferNum; ++i )
+	{
+		memory::SafeRelease( _constantBuffers[ i ] );
+	}
+	memory::SafeDeleteArray( _shaderResources );
+	memory::SafeDeleteArray( _constantBuffers );
+	memory::SafeDeleteArray( _samplerStates );
+	memory::SafeDeleteArray( _d3dShaderResources );
+	memory::SafeDeleteArray( _d3dConstantBuffers );
+	memory::SafeDeleteArray( _d3dSamplers );
+	memory::Clear( _nativeBindingGroup );
+	memory::SafeRelease( _device );
+	_desc.Default();
+	_initialized = false;
+}
+
+//---------------------------------------------------------------------------
+//	構成設定取得.
+//---------------------------------------------------------------------------
+const BindingGroup::Desc& BindingGroup::GetDesc() const
+{
+	return _desc;
+}
+
+//---------------------------------------------------------------------------
+//	指定スロットがグループの範囲に含まれるか.
+//---------------------------------------------------------------------------
+bool BindingGroup::ContainsShaderResource( u32 slot ) const
+{
+	return slot >= _desc.shaderResourceStart && slot < _desc.shaderResourceStart + _desc.shaderResourceNum;
+}
+bool BindingGroup::ContainsConstantBuffer( u32 slot ) const
+{
+	return slot >= _desc.constantBufferStart && slot < _desc.constantBufferStart + _desc.constantBufferNum;
+}
+bool BindingGroup::ContainsSampler( u32 slot ) const
+{
+	return slot >= _desc.samplerStart && slot < _desc.samplerStart + _desc.samplerNum;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブAPIバインディンググループの取得.
+//---------------------------------------------------------------------------
+const NativeBindingGroup& BindingGroup::GetNativeBindingGroup() const
+{
+	return _nativeBindingGroup;
+}
+
+} // namespace render
+} // namespace aroma
+
+#endif
@@ -65,6 +65,12 @@ void CommandList::Finalize()
 {
 	if( !_initialized ) return;
 
+	for( auto reference : _references )
+	{
+		reference->Release();
+	}
+	_references.clear();
+	_stats.Default();
 	memory::SafeRelease( _d3dCommandList );
 	memory::SafeRelease( _device );
 
@@ -79,6 +85,45 @@ ID3D11CommandList* CommandList::GetNativeCommandList() const
 	return _d3dCommandList;
 }
 
+//---------------------------------------------------------------------------
+//!	@brief		参照を保持.
+//---------------------------------------------------------------------------
+void CommandList::RetainReferences( u32 count, RefObject* const* objects )
+{
+	AROMA_ASSERT( _initialized, _T( "Not initialized.\n" ) );
+
+	_references.reserve( _references.size() + count );
+	for( u32 i = 0; i < count; ++i )
+	{
+		objects[ i ]->AddRef();
+		_references.push_back( objects[ i ] );
+	}
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		保持している参照数取得.
+//---------------------------------------------------------------------------
+u32 CommandList::GetRetainedReferenceCount() const
+{
+	return static_cast< u32 >( _references.size() );
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		統計情報設定.
+//---------------------------------------------------------------------------
+void CommandList::SetStats( const CommandStats& stats )
+{
+	_stats = stats;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		記録時の統計情報取得.
+//---------------------------------------------------------------------------
+const CommandStats& CommandList::GetStats() const
+{
+	return _stats;
+}
+
 } // namespace render
 } // namespace aroma
 
@@ -9,9 +9,11 @@
 //===========================================================================
 #ifdef AROMA_RENDER_DX11
 
+#include <algorithm>
 #include <aroma/render/DeferredContext.h>
 #include <aroma/render/Render.h>
 #include <aroma/render/Device.h>
+#include <aroma/render/BindingGroup.h>
 #include <aroma/render/Texture.h>
 #include <aroma/render/TextureView.h>
 #include <aroma/render/RenderTargetView.h>
@@ -38,13 +40,27 @@ DeferredContext::DeferredContext()
 	, _device( nullptr )
 	, _d3dContext( nullptr )
 	, _begin( false )
+	, _retainReferences( false )
+	, _pipelineState( nullptr )
+	, _pipelineStateHandle( kInvalidPipelineStateHandle )
 	, _indexBuffer( nullptr )
 	, _indexBufferOffset( 0 )
 	, _primitiveType( PrimitiveType::kUndefined )
 	, _inputLayout( nullptr )
 	, _vsShader( nullptr )
+	, _vsBindingGroup( nullptr )
+	, _vsBindingGroupOverridden( false )
 	, _psShader( nullptr )
+	, _psBindingGroup( nullptr )
+	, _psBindingGroupOverridden( false )
+	, _rasterizerStateKeyValid( false )
 	, _depthStencil( nullptr )
+	, _blendStateKeyValid( false )
+	, _depthStencilStateKeyValid( false )
+	, _transientBuffer( nullptr )
+	, _transientOffset( 0 )
+	, _transientDiscarded( false )
+	, _d3dContext1( nullptr )
 {
 	memory::Clear( _vertexBuffers );
 	memory::Clear( _vertexBufferStrides );
@@ -53,6 +69,10 @@ DeferredContext::DeferredContext()
 	memory::Clear( _vsConstantBuffers );
 	memory::Clear( _psShaderResources );
 	memory::Clear( _psConstantBuffers );
+	memory::Clear( _vsTransientConstants );
+	memory::Clear( _vsTransientConstantBuffers );
+	memory::Clear( _psTransientConstants );
+	memory::Clear( _psTransientConstantBuffers );
 	memory::Clear( _renderTargets );
 }
 
@@ -85,6 +105,22 @@ void DeferredContext::Initialize( Device* device, const Desc& desc )
 	hr = d3dDevice->CreateDeferredContext( 0, &_d3dContext );
 	AROMA_ASSERT( SUCCEEDED( hr ), _T( "Failed to CreateDeferredContext.\n" ) );
 
+	// 一時定数用共有バッファ.
+	// オフセット指定設定に非対応の場合はスロット毎に専用バッファを使用する.
+	if( _device->IsConstantBufferOffsetSupported() && _desc.transientConstantsSize > 0 )
+	{
+		hr = _d3dContext->QueryInterface( __uuidof( ID3D11DeviceContext1 ), reinterpret_cast< void** >( &_d3dContext1 ) );
+		if( SUCCEEDED( hr ) )
+		{
+			const u32 size = static_cast< u32 >( AlignUp( _desc.transientConstantsSize, kConstantBufferOffsetAlignment ) );
+			_transientBuffer = _device->CreateConstantBuffer( size, Usage::kDynamic, nullptr, 0, 0 );
+		}
+		else
+		{
+			_d3dContext1 = nullptr;
+		}
+	}
+
 	_initialized = true;
 	return;
 }
@@ -96,6 +132,10 @@ void DeferredContext::Finalize()
 {
 	if( !_initialized ) return;
 
+	// パイプラインステート.
+	memory::SafeRelease( _pipelineState );
+	_pipelineStateHandle = kInvalidPipelineStateHandle;
+
 	// IAステージ.
 	for( auto& vtxBuf : _vertexBuffers )
 	{
@@ -106,6 +146,8 @@ void DeferredContext::Finalize()
 
 	// VSステージ.
 	memory::SafeRelease( _vsShader );
+	memory::SafeRelease( _vsBindingGroup );
+	_vsBindingGroupOverridden = false;
 	for( auto& srv : _vsShaderResources )
 	{
 		memory::SafeRelease( srv );
@@ -114,9 +156,16 @@ void DeferredContext::Finalize()
 	{
 		memory::SafeRelease( cb );
 	}
+	for( auto& cb : _vsTransientConstantBuffers )
+	{
+		memory::SafeRelease( cb );
+	}
+	memory::Clear( _vsTransientConstants );
 
 	// PSステージ.
 	memory::SafeRelease( _psShader );
+	memory::SafeRelease( _psBindingGroup );
+	_psBindingGroupOverridden = false;
 	for( auto& srv : _psShaderResources )
 	{
 		memory::SafeRelease( srv );
@@ -125,6 +174,11 @@ void DeferredContext::Finalize()
 	{
 		memory::SafeRelease( cb );
 	}
+	for( auto& cb : _psTransientConstantBuffers )
+	{
+		memory::SafeRelease( cb );
+	}
+	memory::Clear( _psTransientConstants );
 
 	// OMステージ.
 	for( auto& rtv : _renderTargets )
@@ -133,7 +187,13 @@ void DeferredContext::Finalize()
 	}
 	memory::SafeRelease( _depthStencil );
 
+	// 一時定数.
+	memory::SafeRelease( _transientBuffer );
+	_transientOffset	= 0;
+	_transientDiscarded	= false;
+
 	// デバイス.
+	memory::SafeRelease( _d3dContext1 );
 	memory::SafeRelease( _d3dContext );
 	memory::SafeRelease( _device );
 	_desc.Default();
@@ -144,7 +204,7 @@ void DeferredContext::Finalize()
 //---------------------------------------------------------------------------
 //	コマンド記録開始.
 //---------------------------------------------------------------------------
-void DeferredContext::Begin()
+void DeferredContext::Begin( u32 recordFlags )
 {
 	if( _begin )
 	{
@@ -153,10 +213,34 @@ void DeferredContext::Begin()
 	};
 
 	// 描画パイプラインの復元.
+	const bool restorePipelineState = _pipelineStateHandle != kInvalidPipelineStateHandle && !IsPipelineStateOverridden();
 	for( u32 i = 0; i < kPipelineDirtyBitFlagNum; ++i )
 	{
 		_pipelineDirtyBits[ i ] = true;
 	}
+	if( restorePipelineState )
+	{
+		// パイプラインステートの内容は一括で復元.
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAInputLayout ]		= false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAPrimitiveType ]		= false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSShader ]				= false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSShader ]				= false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ]	= false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ]			= false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ]	= false;
+	}
+	else
+	{
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagPipelineState ]		= false;
+	}
+
+	// 一時定数は記録したコマンドリストでのみ有効なため引き継がない.
+	memory::Clear( _vsTransientConstants );
+	memory::Clear( _psTransientConstants );
+	_transientDiscarded = false;
+
+	_retainReferences = CheckFlags( recordFlags, kRecordFlagRetain );
+	_references.clear();
 
 	_begin = true;
 }
@@ -179,12 +263,43 @@ void DeferredContext::End( CommandList** outCommandList )
 		CommandList* commandList = new render::CommandList();
 		commandList->Initialize( _device, d3dCommandList );
 		d3dCommandList->Release();
+		if( _retainReferences )
+		{
+			// 重複を除いて参照を保持させる.
+			std::sort( _references.begin(), _references.end() );
+			_references.erase( std::unique( _references.begin(), _references.end() ), _references.end() );
+			commandList->RetainReferences( static_cast< u32 >( _references.size() ), _references.data() );
+		}
+
+		// 統計情報はコマンドリスト毎に保持させる.
+		++_stats.commandListCount;
+		commandList->SetStats( _stats );
+		_totalStats.Add( _stats );
+		_device->NotifyCommandListCreated();
+
 		(*outCommandList) = commandList;
 	}
 
+	_stats.Default();
+	_retainReferences = false;
+	_references.clear();
 	_begin = false;
 }
 
+//---------------------------------------------------------------------------
+//	統計情報取得.
+//---------------------------------------------------------------------------
+void DeferredContext::GetStats( CommandStats* outStats, bool reset )
+{
+	AROMA_ASSERT( outStats, _T( "outStats is null.\n" ) );
+
+	*outStats = _totalStats;
+	if( reset )
+	{
+		_totalStats.Default();
+	}
+}
+
 //===========================================================================
 //!	@name		コマンド群.
 //===========================================================================
@@ -196,6 +311,8 @@ void DeferredContext::End( CommandList** outCommandList )
 void DeferredContext::ClearRenderTarget( RenderTargetView* rtv, const data::Color& color )
 {
 	BEGIN_ERROR_CHECK();
+	Retain( rtv );
+	++_stats.clearCount;
 	_d3dContext->ClearRenderTargetView( rtv->GetNativeRenderTargetView(), color.rgba );
 }
 
@@ -208,6 +325,8 @@ void DeferredContext::Draw( u32 vertexNum, u32 startVertexIndex )
 {
 	BEGIN_ERROR_CHECK();
 	SyncDrawPipeline();
+	++_stats.drawCount;
+	_stats.vertexCount += vertexNum;
 	_d3dContext->Draw( vertexNum, startVertexIndex );
 }
 
@@ -221,9 +340,113 @@ void DeferredContext::DrawIndexed( u32 indexNum, u32 startIndex, u32 baseVertexI
 {
 	BEGIN_ERROR_CHECK();
 	SyncDrawPipeline();
+	++_stats.drawIndexedCount;
+	_stats.indexCount += indexNum;
 	_d3dContext->DrawIndexed( indexNum, startIndex, baseVertexIndex );
 }
 
+//---------------------------------------------------------------------------
+//	バッファのメモリマッピング(書き込み破棄).
+//---------------------------------------------------------------------------
+void* DeferredContext::Map( Buffer* buffer )
+{
+	if( !_begin )
+	{
+		AROMA_ASSERT( false, _T( "Command recording has not began." ) );
+		return nullptr;
+	}
+	if( buffer->GetDesc().usage != Usage::kDynamic )
+	{
+		AROMA_ASSERT( false, _T( "Only dynamic buffer can be mapped on deferred context.\n" ) );
+		return nullptr;
+	}
+
+	// 書き込んだ内容はコマンドリストに記録され, 再実行時も同じ内容になる.
+	Retain( buffer );
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	HRESULT hr = _d3dContext->Map( buffer->GetNativeBuffer(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
+	if( FAILED( hr ) )
+	{
+		AROMA_ASSERT( false, _T( "Failed to Map.\n" ) );
+		return nullptr;
+	}
+	++_stats.mapCount;
+	_stats.mappedBytes += buffer->GetDesc().size;
+	return mapped.pData;
+}
+
+//---------------------------------------------------------------------------
+//	バッファのメモリマッピング解除.
+//---------------------------------------------------------------------------
+void DeferredContext::Unmap( Buffer* buffer )
+{
+	BEGIN_ERROR_CHECK();
+	_d3dContext->Unmap( buffer->GetNativeBuffer(), 0 );
+}
+
+//---------------------------------------------------------------------------
+//	パイプラインステート設定.
+//---------------------------------------------------------------------------
+void DeferredContext::SetPipelineState( PipelineState* pipelineState )
+{
+	AROMA_ASSERT( pipelineState, _T( "pipelineState is null.\n" ) );
+
+	const PipelineStateHandle handle = pipelineState->GetHandle();
+	if( handle == _pipelineStateHandle && !IsPipelineStateOverridden() )
+	{
+		// 設定済み.
+		return;
+	}
+
+	if( _pipelineState != pipelineState )
+	{
+		memory::SafeRelease( _pipelineState );
+		_pipelineState = pipelineState;
+		_pipelineState->AddRef();
+	}
+	_pipelineStateHandle = handle;
+	CountStateChange( CommandStats::StateType::kPipelineState );
+
+	// 個別設定関数と整合を取るため, 保持しているステートも更新.
+	const auto& desc = pipelineState->GetDesc();
+	if( _inputLayout != desc.inputLayout )
+	{
+		memory::SafeRelease( _inputLayout );
+		_inputLayout = desc.inputLayout;
+		_inputLayout->AddRef();
+	}
+	if( _vsShader != desc.vertexShader )
+	{
+		memory::SafeRelease( _vsShader );
+		_vsShader = desc.vertexShader;
+		_vsShader->AddRef();
+	}
+	if( _psShader != desc.pixelShader )
+	{
+		memory::SafeRelease( _psShader );
+		_psShader = desc.pixelShader;
+		_psShader->AddRef();
+	}
+	_primitiveType = desc.primitiveType;
+	_rasterizerState.Set( desc.rasterizerState );
+	_blendState.Set( desc.blendState );
+	_depthStencilState.Set( desc.depthStencilState );
+	_rasterizerStateKeyValid	= false;
+	_blendStateKeyValid			= false;
+	_depthStencilStateKeyValid	= false;
+
+	// ネイティブAPIへは描画時に一括で設定.
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagPipelineState ]		= true;
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagIAInputLayout ]		= false;
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagIAPrimitiveType ]		= false;
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagVSShader ]				= false;
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagPSShader ]				= false;
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ]	= false;
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ]			= false;
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ]	= false;
+}
+
 //===========================================================================
 //	IA: 入力アセンブラーステージ.
 //===========================================================================
@@ -239,6 +462,7 @@ void DeferredContext::IASetInputLayout( InputLayout* inputLayout )
 		_inputLayout->AddRef();
 
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAInputLayout ] = true;
+		CountStateChange( CommandStats::StateType::kInputLayout );
 	}
 }
 
@@ -251,6 +475,7 @@ void DeferredContext::IASetPrimitiveType( PrimitiveType primitiveType )
 	{
 		_primitiveType = primitiveType;
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAPrimitiveType ] = true;
+		CountStateChange( CommandStats::StateType::kPrimitiveType );
 	}
 }
 
@@ -265,28 +490,35 @@ void DeferredContext::IASetVertexBuffer( u32 slot, Buffer* vb, u32 stride, u32 o
 		return;
 	}
 
+	bool changed = false;
+
 	// 頂点バッファ.
 	if( _vertexBuffers[ slot ] != vb )
 	{
 		memory::SafeRelease( _vertexBuffers[ slot ] );
 		_vertexBuffers[ slot ] = vb;
 		_vertexBuffers[ slot ]->AddRef();
-
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAVertexBuffer + slot ] = true;
+		changed = true;
 	}
 
 	// ストライド.
 	if( _vertexBufferStrides[ slot ] != stride )
 	{
 		_vertexBufferStrides[ slot ] = stride;
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAVertexBuffer + slot ] = true;
+		changed = true;
 	}
 
 	// オフセット.
 	if( _vertexBufferOffsets[ slot ] != offset )
 	{
 		_vertexBufferOffsets[ slot ] = offset;
+		changed = true;
+	}
+
+	if( changed )
+	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAVertexBuffer + slot ] = true;
+		CountStateChange( CommandStats::StateType::kVertexBuffer );
 	}
 }
 
@@ -295,19 +527,26 @@ void DeferredContext::IASetVertexBuffer( u32 slot, Buffer* vb, u32 stride, u32 o
 //---------------------------------------------------------------------------
 void DeferredContext::IASetIndexBuffer( Buffer* indexBuffer, u32 offset )
 {
+	bool changed = false;
+
 	if( _indexBuffer != indexBuffer )
 	{
 		memory::SafeRelease( _indexBuffer );
 		_indexBuffer = indexBuffer;
 		_indexBuffer->AddRef();
-
-		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAIndexBuffer ] = true;
+		changed = true;
 	}
 
 	if( _indexBufferOffset != offset )
 	{
 		_indexBufferOffset = offset;
+		changed = true;
+	}
+
+	if( changed )
+	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAIndexBuffer ] = true;
+		CountStateChange( CommandStats::StateType::kIndexBuffer );
 	}
 }
 
@@ -327,6 +566,7 @@ void DeferredContext::VSSetShader( Shader* vs )
 		_vsShader->AddRef();
 
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSShader ] = true;
+		CountStateChange( CommandStats::StateType::kShader );
 	}
 }
 
@@ -349,6 +589,11 @@ void DeferredContext::VSSetShaderResource( u32 slot, TextureView* srv )
 		contextSRV->AddRef();
 
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSShaderResource + slot ] = true;
+		CountStateChange( CommandStats::StateType::kShaderResource );
+		if( _vsBindingGroup && _vsBindingGroup->ContainsShaderResource( slot ) )
+		{
+			_vsBindingGroupOverridden = true;
+		}
 	}
 }
 
@@ -366,11 +611,108 @@ void DeferredContext::VSSetConstantBuffer( u32 slot, Buffer* cb )
 	auto& constantBuffer = _vsConstantBuffers[ slot ];
 	if( constantBuffer != cb )
 	{
+		_vsTransientConstants[ slot ].buffer = nullptr;
 		memory::SafeRelease( constantBuffer );
 		constantBuffer = cb;
 		constantBuffer->AddRef();
 
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSConstantBuffer + slot ] = true;
+		CountStateChange( CommandStats::StateType::kConstantBuffer );
+		if( _vsBindingGroup && _vsBindingGroup->ContainsConstantBuffer( slot ) )
+		{
+			_vsBindingGroupOverridden = true;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+//	一時定数設定.
+//---------------------------------------------------------------------------
+void DeferredContext::VSSetConstants( u32 slot, const void* data, u32 size )
+{
+	BEGIN_ERROR_CHECK();
+	if( slot >= kShaderUniformBufferSlotMax )
+	{
+		AROMA_ASSERT( false, _T( "Slot is out of range.\n" ) );
+		return;
+	}
+
+	if( !WriteTransientConstants( data, size, &_vsTransientConstantBuffers[ slot ], &_vsTransientConstants[ slot ] ) )
+	{
+		return;
+	}
+
+	// 定数バッファの個別設定は解除.
+	memory::SafeRelease( _vsConstantBuffers[ slot ] );
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagVSConstantBuffer + slot ] = true;
+	CountStateChange( CommandStats::StateType::kConstantBuffer );
+	if( _vsBindingGroup && _vsBindingGroup->ContainsConstantBuffer( slot ) )
+	{
+		_vsBindingGroupOverridden = true;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	バインディンググループ設定.
+//---------------------------------------------------------------------------
+void DeferredContext::VSSetBindingGroup( BindingGroup* bindingGroup )
+{
+	AROMA_ASSERT( bindingGroup, _T( "bindingGroup is null.\n" ) );
+
+	if( _vsBindingGroup == bindingGroup && !_vsBindingGroupOverridden )
+	{
+		// 設定済み.
+		return;
+	}
+
+	if( _vsBindingGroup != bindingGroup )
+	{
+		memory::SafeRelease( _vsBindingGroup );
+		_vsBindingGroup = bindingGroup;
+		_vsBindingGroup->AddRef();
+	}
+	_vsBindingGroupOverridden = false;
+
+	// グループの範囲は個別設定を解除してグループで設定する.
+	const auto& desc = bindingGroup->GetDesc();
+	for( u32 i = 0; i < desc.shaderResourceNum; ++i )
+	{
+		const u32 slot = desc.shaderResourceStart + i;
+		memory::SafeRelease( _vsShaderResources[ slot ] );
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSShaderResource + slot ] = false;
+	}
+	for( u32 i = 0; i < desc.constantBufferNum; ++i )
+	{
+		const u32 slot = desc.constantBufferStart + i;
+		memory::SafeRelease( _vsConstantBuffers[ slot ] );
+		_vsTransientConstants[ slot ].buffer = nullptr;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSConstantBuffer + slot ] = false;
+	}
+	for( u32 i = 0; i < desc.samplerNum; ++i )
+	{
+		// 個別設定関数は保持しているステートを部分的に変更するため, グループの値を保持.
+		const u32 slot = desc.samplerStart + i;
+		_vsSamplerStates[ slot ].Set( desc.samplerStates[ i ] );
+		_vsSamplerStateKeyValid[ slot ] = false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = false;
+	}
+
+	// ネイティブAPIへは描画時に一括で設定.
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagVSBindingGroup ] = true;
+	CountStateChange( CommandStats::StateType::kBindingGroup );
+}
+
+//---------------------------------------------------------------------------
+//	サンプラーステート変更時の処理.
+//---------------------------------------------------------------------------
+void DeferredContext::OnVSSamplerStateChanged( u32 slot )
+{
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagVSSamplerState + slot ] = true;
+	_vsSamplerStateKeyValid[ slot ] = false;
+	CountStateChange( CommandStats::StateType::kSamplerState );
+	if( _vsBindingGroup && _vsBindingGroup->ContainsSampler( slot ) )
+	{
+		_vsBindingGroupOverridden = true;
 	}
 }
 
@@ -389,6 +731,7 @@ void DeferredContext::PSSetShader( Shader* ps )
 		_psShader->AddRef();
 
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSShader ] = true;
+		CountStateChange( CommandStats::StateType::kShader );
 	}
 }
 
@@ -411,6 +754,11 @@ void DeferredContext::PSSetShaderResource( u32 slot, TextureView* srv )
 		contextSRV->AddRef();
 
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSShaderResource + slot ] = true;
+		CountStateChange( CommandStats::StateType::kShaderResource );
+		if( _psBindingGroup && _psBindingGroup->ContainsShaderResource( slot ) )
+		{
+			_psBindingGroupOverridden = true;
+		}
 	}
 }
 
@@ -428,11 +776,108 @@ void DeferredContext::PSSetConstantBuffer( u32 slot, Buffer* cb )
 	auto& constantBuffer = _psConstantBuffers[ slot ];
 	if( constantBuffer != cb )
 	{
+		_psTransientConstants[ slot ].buffer = nullptr;
 		memory::SafeRelease( constantBuffer );
 		constantBuffer = cb;
 		constantBuffer->AddRef();
 
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSConstantBuffer + slot ] = true;
+		CountStateChange( CommandStats::StateType::kConstantBuffer );
+		if( _psBindingGroup && _psBindingGroup->ContainsConstantBuffer( slot ) )
+		{
+			_psBindingGroupOverridden = true;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+//	一時定数設定.
+//---------------------------------------------------------------------------
+void DeferredContext::PSSetConstants( u32 slot, const void* data, u32 size )
+{
+	BEGIN_ERROR_CHECK();
+	if( slot >= kShaderUniformBufferSlotMax )
+	{
+		AROMA_ASSERT( false, _T( "Slot is out of range.\n" ) );
+		return;
+	}
+
+	if( !WriteTransientConstants( data, size, &_psTransientConstantBuffers[ slot ], &_psTransientConstants[ slot ] ) )
+	{
+		return;
+	}
+
+	// 定数バッファの個別設定は解除.
+	memory::SafeRelease( _psConstantBuffers[ slot ] );
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagPSConstantBuffer + slot ] = true;
+	CountStateChange( CommandStats::StateType::kConstantBuffer );
+	if( _psBindingGroup && _psBindingGroup->ContainsConstantBuffer( slot ) )
+	{
+		_psBindingGroupOverridden = true;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	バインディンググループ設定.
+//---------------------------------------------------------------------------
+void DeferredContext::PSSetBindingGroup( BindingGroup* bindingGroup )
+{
+	AROMA_ASSERT( bindingGroup, _T( "bindingGroup is null.\n" ) );
+
+	if( _psBindingGroup == bindingGroup && !_psBindingGroupOverridden )
+	{
+		// 設定済み.
+		return;
+	}
+
+	if( _psBindingGroup != bindingGroup )
+	{
+		memory::SafeRelease( _psBindingGroup );
+		_psBindingGroup = bindingGroup;
+		_psBindingGroup->AddRef();
+	}
+	_psBindingGroupOverridden = false;
+
+	// グループの範囲は個別設定を解除してグループで設定する.
+	const auto& desc = bindingGroup->GetDesc();
+	for( u32 i = 0; i < desc.shaderResourceNum; ++i )
+	{
+		const u32 slot = desc.shaderResourceStart + i;
+		memory::SafeRelease( _psShaderResources[ slot ] );
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSShaderResource + slot ] = false;
+	}
+	for( u32 i = 0; i < desc.constantBufferNum; ++i )
+	{
+		const u32 slot = desc.constantBufferStart + i;
+		memory::SafeRelease( _psConstantBuffers[ slot ] );
+		_psTransientConstants[ slot ].buffer = nullptr;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSConstantBuffer + slot ] = false;
+	}
+	for( u32 i = 0; i < desc.samplerNum; ++i )
+	{
+		// 個別設定関数は保持しているステートを部分的に変更するため, グループの値を保持.
+		const u32 slot = desc.samplerStart + i;
+		_psSamplerStates[ slot ].Set( desc.samplerStates[ i ] );
+		_psSamplerStateKeyValid[ slot ] = false;
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = false;
+	}
+
+	// ネイティブAPIへは描画時に一括で設定.
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagPSBindingGroup ] = true;
+	CountStateChange( CommandStats::StateType::kBindingGroup );
+}
+
+//---------------------------------------------------------------------------
+//	サンプラーステート変更時の処理.
+//---------------------------------------------------------------------------
+void DeferredContext::OnPSSamplerStateChanged( u32 slot )
+{
+	_pipelineDirtyBits[ kPipelineDirtyBitFlagPSSamplerState + slot ] = true;
+	_psSamplerStateKeyValid[ slot ] = false;
+	CountStateChange( CommandStats::StateType::kSamplerState );
+	if( _psBindingGroup && _psBindingGroup->ContainsSampler( slot ) )
+	{
+		_psBindingGroupOverridden = true;
 	}
 }
 
@@ -453,6 +898,8 @@ void DeferredContext::OMSetRenderTargets( u32 rtvNum, RenderTargetView* const* r
 	AROMA_ASSERT( rtvNum >= 1, _T( "The number of render targets to be set must be 1 or more." ) );
 	AROMA_ASSERT( rtvs, _T( "Be sure to specify the render target list." ) );
 
+	bool changed = false;
+
 	for( u32 i = 0; i < rtvNum; ++i )
 	{
 		auto& rtv = _renderTargets[ i ];
@@ -461,8 +908,7 @@ void DeferredContext::OMSetRenderTargets( u32 rtvNum, RenderTargetView* const* r
 			memory::SafeRelease( rtv );
 			rtv = rtvs[ i ];
 			if( rtv ) rtv->AddRef();
-
-			_pipelineDirtyBits[ kPipelineDirtyBitFlagOMRenderTarget ] = true;
+			changed = true;
 		}
 	}
 
@@ -471,8 +917,13 @@ void DeferredContext::OMSetRenderTargets( u32 rtvNum, RenderTargetView* const* r
 		memory::SafeRelease( _depthStencil );
 		_depthStencil = dsv;
 		if( _depthStencil ) _depthStencil->AddRef();
+		changed = true;
+	}
 
+	if( changed )
+	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMRenderTarget ] = true;
+		CountStateChange( CommandStats::StateType::kRenderTarget );
 	}
 }
 
@@ -531,6 +982,33 @@ void DeferredContext::SyncDrawPipeline()
 
 	auto renderStateCache = _device->GetRenderStateCache();
 
+	//-----------------------------------------------------------------------
+	// パイプラインステート.
+	//-----------------------------------------------------------------------
+	if( IsPipelineStateOverridden() )
+	{
+		// 以降は個別設定で構築されるため, 同じパイプラインステートの再設定を有効にする.
+		_pipelineStateHandle = kInvalidPipelineStateHandle;
+	}
+
+	if( _pipelineDirtyBits[ kPipelineDirtyBitFlagPipelineState ] )
+	{
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagPipelineState ] = false;
+
+		Retain( _pipelineState );
+		const auto& d3dPipelineState = _pipelineState->GetNativePipelineState();
+		f32 blendFactor[ 4 ] = {};
+		_d3dContext->IASetInputLayout( d3dPipelineState.inputLayout );
+		_d3dContext->IASetPrimitiveTopology( d3dPipelineState.primitiveTopology );
+		_d3dContext->VSSetShader( d3dPipelineState.vertexShader, nullptr, 0 );
+		_d3dContext->PSSetShader( d3dPipelineState.pixelShader, nullptr, 0 );
+		_d3dContext->RSSetState( d3dPipelineState.rasterizerState );
+		_d3dContext->OMSetBlendState( d3dPipelineState.blendState, blendFactor, 0xffffffff );
+		// TODO: 0は仮, 参照ステンシル値を設定.
+		_d3dContext->OMSetDepthStencilState( d3dPipelineState.depthStencilState, 0 );
+		CountNativeBind( CommandStats::StateType::kPipelineState );
+	}
+
 	//-----------------------------------------------------------------------
 	// IAステージ.
 	//-----------------------------------------------------------------------
@@ -538,7 +1016,9 @@ void DeferredContext::SyncDrawPipeline()
 	if( _pipelineDirtyBits[ kPipelineDirtyBitFlagIAInputLayout ] )
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAInputLayout ] = false;
+		Retain( _inputLayout );
 		_d3dContext->IASetInputLayout( _inputLayout->GetNativeInputLayout() );
+		CountNativeBind( CommandStats::StateType::kInputLayout );
 	}
 
 	// プリミティブタイプ.
@@ -546,6 +1026,7 @@ void DeferredContext::SyncDrawPipeline()
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagIAPrimitiveType ] = false;
 		_d3dContext->IASetPrimitiveTopology( ToNativePrimitiveType( _primitiveType ) );
+		CountNativeBind( CommandStats::StateType::kPrimitiveType );
 	}
 
 	// 頂点バッファ.
@@ -558,10 +1039,12 @@ void DeferredContext::SyncDrawPipeline()
 			auto& vertexBuffer = _vertexBuffers[ i ];
 			if( vertexBuffer )
 			{
+				Retain( vertexBuffer );
 				ID3D11Buffer*	d3dBuffers[] = { vertexBuffer->GetNativeBuffer() };
 				u32				strides[] = { _vertexBufferStrides[ i ] };
 				u32				offset[] = { _vertexBufferOffsets[ i ] };
 				_d3dContext->IASetVertexBuffers( i, 1, d3dBuffers, strides, offset );
+				CountNativeBind( CommandStats::StateType::kVertexBuffer );
 			}
 		}
 	}
@@ -587,7 +1070,9 @@ void DeferredContext::SyncDrawPipeline()
 					break;
 			}
 
+			Retain( _indexBuffer );
 			_d3dContext->IASetIndexBuffer( _indexBuffer->GetNativeBuffer(), d3dFortmat, _indexBufferOffset );
+			CountNativeBind( CommandStats::StateType::kIndexBuffer );
 		}
 	}
 
@@ -598,7 +1083,35 @@ void DeferredContext::SyncDrawPipeline()
 	if( _pipelineDirtyBits[ kPipelineDirtyBitFlagVSShader ] )
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSShader ] = false;
+		Retain( _vsShader );
 		_d3dContext->VSSetShader( _vsShader->GetNativeVertexShader(), nullptr, 0 );
+		CountNativeBind( CommandStats::StateType::kShader );
+	}
+
+	// バインディンググループ.
+	// 個別設定で上書きされたスロットは以降で設定される.
+	if( _pipelineDirtyBits[ kPipelineDirtyBitFlagVSBindingGroup ] )
+	{
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagVSBindingGroup ] = false;
+
+		if( _vsBindingGroup )
+		{
+			Retain( _vsBindingGroup );
+			CountNativeBind( CommandStats::StateType::kBindingGroup );
+			const auto& d3dBindingGroup = _vsBindingGroup->GetNativeBindingGroup();
+			if( d3dBindingGroup.shaderResourceNum > 0 )
+			{
+				_d3dContext->VSSetShaderResources( d3dBindingGroup.shaderResourceStart, d3dBindingGroup.shaderResourceNum, d3dBindingGroup.shaderResources );
+			}
+			if( d3dBindingGroup.constantBufferNum > 0 )
+			{
+				_d3dContext->VSSetConstantBuffers( d3dBindingGroup.constantBufferStart, d3dBindingGroup.constantBufferNum, d3dBindingGroup.constantBuffers );
+			}
+			if( d3dBindingGroup.samplerNum > 0 )
+			{
+				_d3dContext->VSSetSamplers( d3dBindingGroup.samplerStart, d3dBindingGroup.samplerNum, d3dBindingGroup.samplers );
+			}
+		}
 	}
 
 	// シェーダーリソース.
@@ -612,8 +1125,10 @@ void DeferredContext::SyncDrawPipeline()
 
 			if( !_vsShaderResources[ i ] ) continue;
 
+			Retain( _vsShaderResources[ i ] );
 			ID3D11ShaderResourceView* const srvs[] = { _vsShaderResources[ i ]->GetNativeShaderResourceView() };
 			_d3dContext->VSSetShaderResources( i, 1, srvs );
+			CountNativeBind( CommandStats::StateType::kShaderResource );
 		}
 	}
 
@@ -626,9 +1141,9 @@ void DeferredContext::SyncDrawPipeline()
 		{
 			_pipelineDirtyBits[ flagIdx ] = false;
 
-			SamplerStateKey key( _vsSamplerStates[ i ] );
-			auto	d3dSamplerState = renderStateCache->GetNativeSamplerState( key );
+			auto	d3dSamplerState = renderStateCache->GetNativeSamplerState( GetVSSamplerStateKey( i ) );
 			_d3dContext->VSSetSamplers( i, 1, &d3dSamplerState );
+			CountNativeBind( CommandStats::StateType::kSamplerState );
 		}
 	}
 
@@ -640,10 +1155,28 @@ void DeferredContext::SyncDrawPipeline()
 		{
 			_pipelineDirtyBits[ flagIdx ] = false;
 
-			if( !_vsConstantBuffers[ i ] ) continue;
-
-			ID3D11Buffer* const cbs[] = { _vsConstantBuffers[ i ]->GetNativeBuffer() };
-			_d3dContext->VSSetConstantBuffers( i, 1, cbs );
+			if( _vsConstantBuffers[ i ] )
+			{
+				Retain( _vsConstantBuffers[ i ] );
+				CountNativeBind( CommandStats::StateType::kConstantBuffer );
+				ID3D11Buffer* const cbs[] = { _vsConstantBuffers[ i ]->GetNativeBuffer() };
+				_d3dContext->VSSetConstantBuffers( i, 1, cbs );
+			}
+			else if( _vsTransientConstants[ i ].buffer )
+			{
+				const auto& transient = _vsTransientConstants[ i ];
+				Retain( transient.buffer );
+				CountNativeBind( CommandStats::StateType::kConstantBuffer );
+				ID3D11Buffer* const cbs[] = { transient.buffer->GetNativeBuffer() };
+				if( transient.constantNum > 0 )
+				{
+					_d3dContext1->VSSetConstantBuffers1( i, 1, cbs, &transient.firstConstant, &transient.constantNum );
+				}
+				else
+				{
+					_d3dContext->VSSetConstantBuffers( i, 1, cbs );
+				}
+			}
 		}
 	}
 
@@ -654,7 +1187,35 @@ void DeferredContext::SyncDrawPipeline()
 	if( _pipelineDirtyBits[ kPipelineDirtyBitFlagPSShader ] )
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSShader ] = false;
+		Retain( _psShader );
 		_d3dContext->PSSetShader( _psShader->GetNativePixelShader(), nullptr, 0 );
+		CountNativeBind( CommandStats::StateType::kShader );
+	}
+
+	// バインディンググループ.
+	// 個別設定で上書きされたスロットは以降で設定される.
+	if( _pipelineDirtyBits[ kPipelineDirtyBitFlagPSBindingGroup ] )
+	{
+		_pipelineDirtyBits[ kPipelineDirtyBitFlagPSBindingGroup ] = false;
+
+		if( _psBindingGroup )
+		{
+			Retain( _psBindingGroup );
+			CountNativeBind( CommandStats::StateType::kBindingGroup );
+			const auto& d3dBindingGroup = _psBindingGroup->GetNativeBindingGroup();
+			if( d3dBindingGroup.shaderResourceNum > 0 )
+			{
+				_d3dContext->PSSetShaderResources( d3dBindingGroup.shaderResourceStart, d3dBindingGroup.shaderResourceNum, d3dBindingGroup.shaderResources );
+			}
+			if( d3dBindingGroup.constantBufferNum > 0 )
+			{
+				_d3dContext->PSSetConstantBuffers( d3dBindingGroup.constantBufferStart, d3dBindingGroup.constantBufferNum, d3dBindingGroup.constantBuffers );
+			}
+			if( d3dBindingGroup.samplerNum > 0 )
+			{
+				_d3dContext->PSSetSamplers( d3dBindingGroup.samplerStart, d3dBindingGroup.samplerNum, d3dBindingGroup.samplers );
+			}
+		}
 	}
 
 	// シェーダーリソース.
@@ -668,8 +1229,10 @@ void DeferredContext::SyncDrawPipeline()
 
 			if( !_psShaderResources[ i ] ) continue;
 
+			Retain( _psShaderResources[ i ] );
 			ID3D11ShaderResourceView* const srvs[] = { _psShaderResources[ i ]->GetNativeShaderResourceView() };
 			_d3dContext->PSSetShaderResources( i, 1, srvs );
+			CountNativeBind( CommandStats::StateType::kShaderResource );
 		}
 	}
 
@@ -682,9 +1245,9 @@ void DeferredContext::SyncDrawPipeline()
 		{
 			_pipelineDirtyBits[ flagIdx ] = false;
 
-			SamplerStateKey key( _psSamplerStates[ i ] );
-			auto	d3dSamplerState = renderStateCache->GetNativeSamplerState( key );
+			auto	d3dSamplerState = renderStateCache->GetNativeSamplerState( GetPSSamplerStateKey( i ) );
 			_d3dContext->PSSetSamplers( i, 1, &d3dSamplerState );
+			CountNativeBind( CommandStats::StateType::kSamplerState );
 		}
 	}
 
@@ -696,10 +1259,28 @@ void DeferredContext::SyncDrawPipeline()
 		{
 			_pipelineDirtyBits[ flagIdx ] = false;
 
-			if( !_psConstantBuffers[ i ] ) continue;
-
-			ID3D11Buffer* const cbs[] = { _psConstantBuffers[ i ]->GetNativeBuffer() };
-			_d3dContext->PSSetConstantBuffers( i, 1, cbs );
+			if( _psConstantBuffers[ i ] )
+			{
+				Retain( _psConstantBuffers[ i ] );
+				CountNativeBind( CommandStats::StateType::kConstantBuffer );
+				ID3D11Buffer* const cbs[] = { _psConstantBuffers[ i ]->GetNativeBuffer() };
+				_d3dContext->PSSetConstantBuffers( i, 1, cbs );
+			}
+			else if( _psTransientConstants[ i ].buffer )
+			{
+				const auto& transient = _psTransientConstants[ i ];
+				Retain( transient.buffer );
+				CountNativeBind( CommandStats::StateType::kConstantBuffer );
+				ID3D11Buffer* const cbs[] = { transient.buffer->GetNativeBuffer() };
+				if( transient.constantNum > 0 )
+				{
+					_d3dContext1->PSSetConstantBuffers1( i, 1, cbs, &transient.firstConstant, &transient.constantNum );
+				}
+				else
+				{
+					_d3dContext->PSSetConstantBuffers( i, 1, cbs );
+				}
+			}
 		}
 	}
 
@@ -711,9 +1292,9 @@ void DeferredContext::SyncDrawPipeline()
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ] = false;
 
-		RasterizerStateKey key( _rasterizerState );
-		auto	d3dRasterizerState = renderStateCache->GetNativeRasterizerState( key );
+		auto	d3dRasterizerState = renderStateCache->GetNativeRasterizerState( GetRasterizerStateKey() );
 		_d3dContext->RSSetState( d3dRasterizerState );
+		CountNativeBind( CommandStats::StateType::kRasterizerState );
 	}
 
 	// ビューポートシザーステート.
@@ -721,11 +1302,14 @@ void DeferredContext::SyncDrawPipeline()
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagRSViewportScissorState ] = false;
 
-		ViewportScissorStateKey key( _viewportScissorState );
-		auto	d3dViewportScissorState = renderStateCache->GetNativeViewportScissorState( key );
+		ViewportScissorStateKey		key( _viewportScissorState );
+		NativeViewportScissorState	d3dViewportScissorState;
+		renderStateCache->GetNativeViewportScissorState( key, &d3dViewportScissorState );
 
-		_d3dContext->RSSetViewports( kViewportsSlotMax, d3dViewportScissorState->viewport );
-		_d3dContext->RSSetScissorRects( kViewportsSlotMax, d3dViewportScissorState->scissor );
+		// 有効スロット以降は解除される.
+		_d3dContext->RSSetViewports( d3dViewportScissorState.count, d3dViewportScissorState.viewport );
+		_d3dContext->RSSetScissorRects( d3dViewportScissorState.count, d3dViewportScissorState.scissor );
+		CountNativeBind( CommandStats::StateType::kViewportScissorState );
 	}
 
 	//-----------------------------------------------------------------------
@@ -744,16 +1328,19 @@ void DeferredContext::SyncDrawPipeline()
 			auto& rtv = _renderTargets[ i ];
 			if( rtv )
 			{
+				Retain( rtv );
 				d3dRTVs[ i ] = rtv->GetNativeRenderTargetView();
 			}
 		}
 
 		if( _depthStencil )
 		{
+			Retain( _depthStencil );
 			d3dDSV = _depthStencil->GetNativeDepthStencilView();
 		}
 
 		_d3dContext->OMSetRenderTargets( kRenderTargetsSlotMax, d3dRTVs, d3dDSV );
+		CountNativeBind( CommandStats::StateType::kRenderTarget );
 	}
 
 	// ブレンドステート.
@@ -761,10 +1348,10 @@ void DeferredContext::SyncDrawPipeline()
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ] = false;
 
-		BlendStateKey key( _blendState );
-		auto	d3dBlendState = renderStateCache->GetNativeBlendState( key );
+		auto	d3dBlendState = renderStateCache->GetNativeBlendState( GetBlendStateKey() );
 		f32		blendFactor[ 4 ] = {};
 		_d3dContext->OMSetBlendState( d3dBlendState, blendFactor, 0xffffffff );
+		CountNativeBind( CommandStats::StateType::kBlendState );
 	}
 
 	// 深度ステンシルステート.
@@ -772,13 +1359,101 @@ void DeferredContext::SyncDrawPipeline()
 	{
 		_pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ] = false;
 
-		DepthStencilStateKey key( _depthStencilState );
-		auto	d3dDepthStencilState = renderStateCache->GetNativeDepthStencilState( key );
+		auto	d3dDepthStencilState = renderStateCache->GetNativeDepthStencilState( GetDepthStencilStateKey() );
 		// TODO: 0は仮, 参照ステンシル値を設定.
 		_d3dContext->OMSetDepthStencilState( d3dDepthStencilState, 0 );
+		CountNativeBind( CommandStats::StateType::kDepthStencilState );
 	}
 }
 
+//---------------------------------------------------------------------------
+//	一時定数を書き込み.
+//---------------------------------------------------------------------------
+bool DeferredContext::WriteTransientConstants( const void* data, u32 size, Buffer** fallbackBuffer, TransientConstants* out )
+{
+	AROMA_ASSERT( data && size > 0, _T( "Constants data is empty.\n" ) );
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	HRESULT hr;
+
+	if( _transientBuffer )
+	{
+		// 共有バッファから切り出し, オフセット指定で設定.
+		const u32 capacity		= static_cast< u32 >( _transientBuffer->GetDesc().size );
+		const u32 alignedSize	= static_cast< u32 >( AlignUp( size, kConstantBufferOffsetAlignment ) );
+		if( alignedSize > capacity )
+		{
+			AROMA_ASSERT( false, _T( "Constants size exceeds transient buffer size.\n" ) );
+			return false;
+		}
+
+		// 記録中の最初の書き込みと末尾に達した場合は書き込み破棄(新しい領域に切り替わる).
+		// それ以外は書き込み済みの領域を残すため上書きなしでマップする.
+		D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		if( !_transientDiscarded || _transientOffset + alignedSize > capacity )
+		{
+			mapType				= D3D11_MAP_WRITE_DISCARD;
+			_transientOffset	= 0;
+			_transientDiscarded	= true;
+		}
+
+		hr = _d3dContext->Map( _transientBuffer->GetNativeBuffer(), 0, mapType, 0, &mapped );
+		if( FAILED( hr ) )
+		{
+			AROMA_ASSERT( false, _T( "Failed to Map.\n" ) );
+			return false;
+		}
+		memcpy( static_cast< u8* >( mapped.pData ) + _transientOffset, data, size );
+		_d3dContext->Unmap( _transientBuffer->GetNativeBuffer(), 0 );
+		++_stats.mapCount;
+		_stats.mappedBytes += size;
+
+		out->buffer			= _transientBuffer;
+		out->firstConstant	= _transientOffset / 16;
+		out->constantNum	= alignedSize / 16;
+		_transientOffset	+= alignedSize;
+		return true;
+	}
+
+	// スロット専用バッファに書き込み破棄で書き込む.
+	const u32 alignedSize = static_cast< u32 >( AlignUp( size, 16 ) );
+	if( !( *fallbackBuffer ) || ( *fallbackBuffer )->GetDesc().size < alignedSize )
+	{
+		memory::SafeRelease( *fallbackBuffer );
+		*fallbackBuffer = _device->CreateConstantBuffer( alignedSize, Usage::kDynamic, nullptr, 0, 0 );
+	}
+
+	hr = _d3dContext->Map( ( *fallbackBuffer )->GetNativeBuffer(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
+	if( FAILED( hr ) )
+	{
+		AROMA_ASSERT( false, _T( "Failed to Map.\n" ) );
+		return false;
+	}
+	memcpy( mapped.pData, data, size );
+	_d3dContext->Unmap( ( *fallbackBuffer )->GetNativeBuffer(), 0 );
+	++_stats.mapCount;
+	_stats.mappedBytes += size;
+
+	out->buffer			= *fallbackBuffer;
+	out->firstConstant	= 0;
+	out->constantNum	= 0;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	パイプラインステートの内容が個別設定で上書きされているか.
+//---------------------------------------------------------------------------
+bool DeferredContext::IsPipelineStateOverridden() const
+{
+	return _pipelineDirtyBits[ kPipelineDirtyBitFlagIAInputLayout ]
+		|| _pipelineDirtyBits[ kPipelineDirtyBitFlagIAPrimitiveType ]
+		|| _pipelineDirtyBits[ kPipelineDirtyBitFlagVSShader ]
+		|| _pipelineDirtyBits[ kPipelineDirtyBitFlagPSShader ]
+		|| _pipelineDirtyBits[ kPipelineDirtyBitFlagRSRasterizerState ]
+		|| _pipelineDirtyBits[ kPipelineDirtyBitFlagOMBlendState ]
+		|| _pipelineDirtyBits[ kPipelineDirtyBitFlagOMDepthStencilState ];
+}
+
 } // namespace render
 } // namespace aroma
 
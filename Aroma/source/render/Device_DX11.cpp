@@ -17,6 +17,7 @@
 #include <aroma/render/Shader.h>
 #include <aroma/render/Texture.h>
 #include <aroma/data/DDS.h>
+#include <aroma/data/PixelConvert.h>
 
 namespace aroma {
 namespace render {
@@ -27,10 +28,12 @@ namespace render {
 Device::Device()
 	: _initialized( false )
 	, _renderStateCache( this )
+	, _commandListCreateCount( 0 )
 	, _d3dDevice( nullptr )
 	, _d3dFactory( nullptr )
 	, _d3dImmediateContext( nullptr )
 	, _d3dFeatureLevel( D3D_FEATURE_LEVEL_11_1 )
+	, _constantBufferOffsetSupported( false )
 {
 }
 
@@ -86,6 +89,14 @@ void	Device::Initialize()
 		&_d3dImmediateContext );
 	AROMA_ASSERT( SUCCEEDED( hr ), _T( "Failed to D3D11CreateDevice.\n" ) );
 
+	// 定数バッファのオフセット指定設定(D3D11.1).
+	// 遅延コンテキストで書き込み破棄以外のマップを行うため上書きなしマップの対応も必要.
+	D3D11_FEATURE_DATA_D3D11_OPTIONS d3dOptions = {};
+	hr = _d3dDevice->CheckFeatureSupport( D3D11_FEATURE_D3D11_OPTIONS, &d3dOptions, sizeof( d3dOptions ) );
+	_constantBufferOffsetSupported = SUCCEEDED( hr )
+		&& d3dOptions.ConstantBufferOffsetting
+		&& d3dOptions.MapNoOverwriteOnDynamicConstantBuffer;
+
 	// ファクトリーの生成.
 	hr = CreateDXGIFactory( __uuidof( IDXGIFactory ), ( void** )( &_d3dFactory ) );
 	AROMA_ASSERT( SUCCEEDED( hr ), _T( "Failed to CreateDXGIFactory.\n" ) );
@@ -103,6 +114,7 @@ void Device::Finalize()
 	memory::SafeRelease( _d3dImmediateContext );
 	memory::SafeRelease( _d3dFactory );
 	memory::SafeRelease( _d3dDevice );
+	_constantBufferOffsetSupported = false;
 
 	_initialized = false;
 }
@@ -133,6 +145,34 @@ DeferredContext* Device::CreateDeferredContext( const DeferredContext::Desc& des
 void Device::ExecuteCommand( const CommandList* commandList )
 {
 	_d3dImmediateContext->ExecuteCommandList( commandList->GetNativeCommandList(), FALSE );
+	_frameStats.Add( commandList->GetStats() );
+	++_frameStats.executeCount;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		複数の描画コマンドリストを配列順に実行.
+//---------------------------------------------------------------------------
+void Device::ExecuteCommands( u32 count, const CommandList* const* commandLists )
+{
+	AROMA_ASSERT( count == 0 || commandLists, _T( "commandLists is null.\n" ) );
+
+	for( u32 i = 0; i < count; ++i )
+	{
+		if( !commandLists[ i ] ) continue;
+		_d3dImmediateContext->ExecuteCommandList( commandLists[ i ]->GetNativeCommandList(), FALSE );
+		_frameStats.Add( commandLists[ i ]->GetStats() );
+		++_frameStats.executeCount;
+	}
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		マルチスレッドコマンド記録作成.
+//---------------------------------------------------------------------------
+ParallelCommandRecorder* Device::CreateParallelCommandRecorder( const ParallelCommandRecorder::Desc& desc )
+{
+	ParallelCommandRecorder* recorder = new render::ParallelCommandRecorder();
+	recorder->Initialize( this, desc );
+	return recorder;
 }
 
 //---------------------------------------------------------------------------
@@ -244,6 +284,26 @@ InputLayout* Device::CreateInputLayout( const InputLayout::Desc& desc )
 	return inputLayout;
 }
 
+//---------------------------------------------------------------------------
+//!	@brief		パイプラインステートを作成.
+//---------------------------------------------------------------------------
+PipelineState* Device::CreatePipelineState( const PipelineState::Desc& desc )
+{
+	PipelineState*	pipelineState = new PipelineState();
+	pipelineState->Initialize( this, desc );
+	return pipelineState;
+}
+
+//---------------------------------------------------------------------------
+//!	@brief		バインディンググループを作成.
+//---------------------------------------------------------------------------
+BindingGroup* Device::CreateBindingGroup( const BindingGroup::Desc& desc )
+{
+	BindingGroup*	bindingGroup = new BindingGroup();
+	bindingGroup->Initialize( this, desc );
+	return bindingGroup;
+}
+
 //--------------------------------------------------------------------
 //! @brief		2Dテクスチャ作成.
 //--------------------------------------------------------------------
@@ -257,7 +317,7 @@ Texture* Device::CreateTexture2D( const Texture::Desc& desc )
 //--------------------------------------------------------------------
 //! @brief		DDSデータより2Dテクスチャ作成.
 //--------------------------------------------------------------------
-Texture* Device::CreateTexture2DFromDDS( const data::DDSAccessor& dds, Usage usage, u32 bindFlags, u32 flags )
+Texture* Device::CreateTexture2DFromDDS( const data::DDSAccessor& dds, Usage usage, u32 bindFlags, u32 flags, u32 firstMip )
 {
 	if( !dds.IsValid() )
 	{
@@ -265,6 +325,17 @@ Texture* Device::CreateTexture2DFromDDS( const data::DDSAccessor& dds, Usage usa
 		return nullptr;
 	}
 
+	// GPUが直接扱えない旧形式はR8G8B8A8へ変換して作成.
+	if( dds.GetPixelFormat() == data::PixelFormat::kUnknown && data::IsConvertibleToRGBA8( dds.GetLegacyFormat() ) )
+	{
+		std::vector< u8 > converted;
+		if( !data::ConvertLegacyDDS( dds, &converted ) )
+		{
+			return nullptr;
+		}
+		return CreateTexture2DFromDDS( data::DDSAccessor( converted.data(), converted.size() ), usage, bindFlags, flags, firstMip );
+	}
+
 	// パラメータ取得.
 	u32					arrayCount	= dds.GetArrayCount();
 	u32					mipCount	= dds.GetMipMapCount();
@@ -285,10 +356,17 @@ Texture* Device::CreateTexture2DFromDDS( const data::DDSAccessor& dds, Usage usa
 			AROMA_ASSERT( false, "This mipmap count is unsupported." ); 
 			return nullptr;
 		}
+
+		if( firstMip >= mipCount )
+		{
+			AROMA_ASSERT( false, _T( "firstMip is out of range.\n" ) );
+			return nullptr;
+		}
 	}
 
 	// 初期データ作成.
-	SubResource* initData = new SubResource[ mipCount * arrayCount ];
+	const u32 createMipCount = mipCount - firstMip;
+	SubResource* initData = new SubResource[ createMipCount * arrayCount ];
 	AROMA_ASSERT( initData, _T( "Failed to memory allocate.\n" ) ); 
 	{
 		u32		idx		= 0;
@@ -302,18 +380,34 @@ Texture* Device::CreateTexture2DFromDDS( const data::DDSAccessor& dds, Usage usa
 
 			data::SurfaceInfo info;
 			data::CalcSurfaceInfo( &info, mipWidth, mipHeight, format );
-			initData[ idx ].dataConst	= pImg;
-			initData[ idx ].pitch		= info.pitchBytes;
-			initData[ idx ].slicePitch	= 0;
-			idx++;
+
+			// firstMipより詳細なミップは読み飛ばす.
+			if( iMip >= firstMip )
+			{
+				initData[ idx ].dataConst	= pImg;
+				initData[ idx ].pitch		= info.pitchBytes;
+				initData[ idx ].slicePitch	= 0;
+				idx++;
+			}
 			pImg = reinterpret_cast< void* >( reinterpret_cast< uintptr >( pImg ) + info.bytes );
 		}
+
+		// サイズ指定時はイメージデータがDDSデータの範囲内か確認.
+		const size_t dataSize = dds.GetDataSize();
+		if( dataSize > 0 && reinterpret_cast< uintptr >( pImg ) - reinterpret_cast< uintptr >( dds.GetHeader() ) > dataSize )
+		{
+			AROMA_ASSERT( false, _T( "DDS image data is truncated.\n" ) );
+			memory::SafeDeleteArray( initData );
+			return nullptr;
+		}
 	}
 
 	// 2Dテクスチャ作成.
 	Texture::Desc desc;
 	dds.GetImageSize( &desc.size );
-	desc.mipCount		= mipCount;
+	desc.size.width		= Max( 1ui32, desc.size.width >> firstMip );
+	desc.size.height	= Max( 1ui32, desc.size.height >> firstMip );
+	desc.mipCount		= createMipCount;
 	desc.format			= format;
 	desc.usage			= usage;
 	desc.arrayCount		= arrayCount;
@@ -334,6 +428,47 @@ RenderStateCache* Device::GetRenderStateCache()
 	return &_renderStateCache;
 }
 
+//---------------------------------------------------------------------------
+//! @brief		レンダーステートキャッシュ統計情報の取得.
+//---------------------------------------------------------------------------
+void Device::GetRenderStateCacheStats( RenderStateCache::Stats* outStats, bool reset )
+{
+	_renderStateCache.GetStats( outStats, reset );
+}
+
+//---------------------------------------------------------------------------
+//! @brief		フレーム統計情報の取得.
+//---------------------------------------------------------------------------
+void Device::GetFrameStats( CommandStats* outStats, bool reset )
+{
+	AROMA_ASSERT( outStats, _T( "outStats is null.\n" ) );
+
+	*outStats = _frameStats;
+	if( reset )
+	{
+		_frameStats.Default();
+	}
+
+	// コマンドリストの生成数は再実行分を含まないよう生成時に集計.
+	outStats->commandListCount = reset ? _commandListCreateCount.exchange( 0, std::memory_order_relaxed ) : _commandListCreateCount.load( std::memory_order_relaxed );
+}
+
+//---------------------------------------------------------------------------
+//! @brief		コマンドリスト生成を通知.
+//---------------------------------------------------------------------------
+void Device::NotifyCommandListCreated()
+{
+	_commandListCreateCount.fetch_add( 1, std::memory_order_relaxed );
+}
+
+//---------------------------------------------------------------------------
+//! @brief		定数バッファのオフセット指定設定に対応しているか.
+//---------------------------------------------------------------------------
+bool Device::IsConstantBufferOffsetSupported() const
+{
+	return _constantBufferOffsetSupported;
+}
+
 //---------------------------------------------------------------------------
 //!	@brief		D3Dデバイスの取得.
 //---------------------------------------------------------------------------
@@ -0,0 +1,294 @@
+﻿//===========================================================================
+//!
+//!	@file		ParallelCommandRecorder.cpp
+//!	@brief		マルチスレッドコマンド記録.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <chrono>
+#include <aroma/common/Algorithm.h>
+#include <aroma/render/ParallelCommandRecorder.h>
+#include <aroma/render/Device.h>
+#include <aroma/render/DeferredContext.h>
+#include <aroma/render/CommandList.h>
+
+namespace aroma {
+namespace render {
+
+namespace
+{
+	//! 投入順の最大数.
+	constexpr u32 kTaskCountMax = 64;
+
+	//-----------------------------------------------------------------------
+	//	現在時刻取得(マイクロ秒).
+	//-----------------------------------------------------------------------
+	u64 GetTimeUs()
+	{
+		using namespace std::chrono;
+		return static_cast< u64 >( duration_cast< microseconds >( steady_clock::now().time_since_epoch() ).count() );
+	}
+}
+
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+ParallelCommandRecorder::ParallelCommandRecorder()
+	: _initialized( false )
+	, _device( nullptr )
+	, _workers( nullptr )
+	, _tasks( nullptr )
+	, _taskCount( 0 )
+	, _pendingCount( 0 )
+	, _generation( 0 )
+	, _requestTimeUs( 0 )
+	, _quit( false )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+ParallelCommandRecorder::~ParallelCommandRecorder()
+{
+	Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	初期化.
+//---------------------------------------------------------------------------
+void ParallelCommandRecorder::Initialize( Device* device, const Desc& desc )
+{
+	if( _initialized )
+	{
+		AROMA_ASSERT( false, _T( "Already initialized.\n" ) );
+		Finalize();
+	}
+
+	AROMA_ASSERT( desc.threadCount > 0 && desc.threadCount <= kTaskCountMax, _T( "threadCount is out of range.\n" ) );
+
+	_device = device;
+	_device->AddRef();
+	_desc = desc;
+	_desc.threadCount = Min( Max( _desc.threadCount, 1ui32 ), kTaskCountMax );
+	_quit = false;
+	_generation = 0;
+
+	// スレッド毎の遅延コンテキスト作成.
+	_workers = new Worker[ _desc.threadCount ];
+	for( u32 i = 0; i < _desc.threadCount; ++i )
+	{
+		DeferredContext::Desc contextDesc;
+		_workers[ i ].context = _device->CreateDeferredContext( contextDesc );
+	}
+
+	// 記録スレッド起動.
+	for( u32 i = 0; i < _desc.threadCount; ++i )
+	{
+		_workers[ i ].thread = std::thread( &ParallelCommandRecorder::WorkerMain, this, i );
+	}
+
+	_initialized = true;
+}
+
+//---------------------------------------------------------------------------
+//	解放.
+//---------------------------------------------------------------------------
+void ParallelCommandRecorder::Finalize()
+{
+	if( !_initialized ) return;
+
+	// 記録スレッド終了.
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		_quit = true;
+	}
+	_startCondition.notify_all();
+
+	for( u32 i = 0; i < _desc.threadCount; ++i )
+	{
+		auto& worker = _workers[ i ];
+		if( worker.thread.joinable() )
+		{
+			worker.thread.join();
+		}
+		memory::SafeRelease( worker.commandList );
+		memory::SafeRelease( worker.context );
+	}
+	memory::SafeDeleteArray( _workers );
+
+	memory::SafeRelease( _device );
+	_desc.Default();
+	_frameStats.Default();
+	_tasks = nullptr;
+	_taskCount = 0;
+	_pendingCount = 0;
+
+	_initialized = false;
+}
+
+//---------------------------------------------------------------------------
+//	並列記録してデバイスへ投入.
+//---------------------------------------------------------------------------
+void ParallelCommandRecorder::Execute( u32 taskCount, const RecordFunc* tasks, const u32* submitOrder )
+{
+	if( !_initialized )
+	{
+		AROMA_ASSERT( false, _T( "Not initialized.\n" ) );
+		return;
+	}
+	if( taskCount > _desc.threadCount )
+	{
+		AROMA_ASSERT( false, _T( "taskCount exceeds threadCount.\n" ) );
+		return;
+	}
+	if( taskCount == 0 ) return;
+
+#ifdef AROMA_DEBUG
+	// 投入順の検証(全タスクが1回ずつ指定されていること).
+	if( submitOrder )
+	{
+		bool used[ kTaskCountMax ] = {};
+		for( u32 i = 0; i < taskCount; ++i )
+		{
+			AROMA_ASSERT( submitOrder[ i ] < taskCount, _T( "submitOrder[ %u ] is out of range.\n" ), i );
+			AROMA_ASSERT( !used[ submitOrder[ i ] ], _T( "submitOrder[ %u ] is duplicated.\n" ), i );
+			used[ submitOrder[ i ] ] = true;
+		}
+	}
+#endif
+
+	const u64 beginTimeUs = GetTimeUs();
+
+	// 記録開始.
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		_tasks			= tasks;
+		_taskCount		= taskCount;
+		_pendingCount	= taskCount;
+		_requestTimeUs	= beginTimeUs;
+		_generation++;
+	}
+	_startCondition.notify_all();
+
+	// 全タスクの記録完了待ち.
+	{
+		std::unique_lock< std::mutex > lock( _mutex );
+		_doneCondition.wait( lock, [ this ]{ return _pendingCount == 0; } );
+		_tasks = nullptr;
+	}
+
+	const u64 recordedTimeUs = GetTimeUs();
+
+	// 指定順で投入.
+	CommandList* commandLists[ kTaskCountMax ];
+	for( u32 i = 0; i < taskCount; ++i )
+	{
+		u32 taskIndex = submitOrder ? submitOrder[ i ] : i;
+		auto& worker = _workers[ taskIndex ];
+		commandLists[ i ] = worker.commandList;
+		worker.stats.submitIndex = i;
+	}
+	_device->ExecuteCommands( taskCount, commandLists );
+
+	for( u32 i = 0; i < taskCount; ++i )
+	{
+		memory::SafeRelease( _workers[ i ].commandList );
+	}
+
+	_frameStats.taskCount		= taskCount;
+	_frameStats.recordTimeUs	= recordedTimeUs - beginTimeUs;
+	_frameStats.submitTimeUs	= GetTimeUs() - recordedTimeUs;
+}
+
+//---------------------------------------------------------------------------
+//	記録スレッド数取得.
+//---------------------------------------------------------------------------
+u32 ParallelCommandRecorder::GetThreadCount() const
+{
+	return _desc.threadCount;
+}
+
+//---------------------------------------------------------------------------
+//	スレッド別統計情報取得.
+//---------------------------------------------------------------------------
+const ParallelCommandRecorder::ThreadStats& ParallelCommandRecorder::GetThreadStats( u32 threadIndex ) const
+{
+	AROMA_ASSERT( threadIndex < _desc.threadCount, _T( "threadIndex is out of range.\n" ) );
+	return _workers[ threadIndex ].stats;
+}
+
+//---------------------------------------------------------------------------
+//	直近フレームの統計情報取得.
+//---------------------------------------------------------------------------
+const ParallelCommandRecorder::FrameStats& ParallelCommandRecorder::GetFrameStats() const
+{
+	return _frameStats;
+}
+
+//---------------------------------------------------------------------------
+//	遅延コンテキスト取得.
+//---------------------------------------------------------------------------
+DeferredContext* ParallelCommandRecorder::GetContext( u32 threadIndex ) const
+{
+	AROMA_ASSERT( threadIndex < _desc.threadCount, _T( "threadIndex is out of range.\n" ) );
+	return _workers[ threadIndex ].context;
+}
+
+//---------------------------------------------------------------------------
+//	記録スレッドメイン.
+//---------------------------------------------------------------------------
+void ParallelCommandRecorder::WorkerMain( u32 threadIndex )
+{
+	auto&	worker		= _workers[ threadIndex ];
+	u64		generation	= 0;
+
+	while( true )
+	{
+		const RecordFunc*	task = nullptr;
+		u64					requestTimeUs = 0;
+		{
+			std::unique_lock< std::mutex > lock( _mutex );
+			_startCondition.wait( lock, [ & ]{ return _quit || _generation != generation; } );
+			if( _quit ) break;
+
+			generation = _generation;
+			if( threadIndex >= _taskCount ) continue;	// 今回は担当タスク無し.
+
+			task			= &_tasks[ threadIndex ];
+			requestTimeUs	= _requestTimeUs;
+		}
+
+		// 記録.
+		const u64 beginTimeUs = GetTimeUs();
+		worker.context->Begin();
+		if( *task )
+		{
+			( *task )( worker.context, threadIndex );
+		}
+		const u64 recordedTimeUs = GetTimeUs();
+		worker.context->End( &worker.commandList );
+		const u64 endTimeUs = GetTimeUs();
+
+		worker.stats.taskIndex		= threadIndex;
+		worker.stats.waitTimeUs		= beginTimeUs - requestTimeUs;
+		worker.stats.recordTimeUs	= recordedTimeUs - beginTimeUs;
+		worker.stats.finishTimeUs	= endTimeUs - recordedTimeUs;
+		worker.stats.recordCount++;
+
+		// 完了通知.
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			_pendingCount--;
+			if( _pendingCount == 0 )
+			{
+				_doneCondition.notify_one();
+			}
+		}
+	}
+}
+
+} // namespace render
+} // namespace aroma
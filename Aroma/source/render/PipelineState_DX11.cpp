@@ -0,0 +1,158 @@
+﻿//===========================================================================
+//!
+//!	@file		PipelineState_DX11.cpp
+//!	@brief		パイプラインステート : DirectX11.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#ifdef AROMA_RENDER_DX11
+
+#include <aroma/render/PipelineState.h>
+#include <aroma/render/Device.h>
+#include <aroma/render/Shader.h>
+#include <aroma/render/InputLayout.h>
+#include <aroma/render/RenderStateCache.h>
+#include <aroma/data/Hash.h>
+
+namespace aroma {
+namespace render {
+
+namespace
+{
+	//-----------------------------------------------------------------------
+	//	ハンドル計算用キー.
+	//	パディングを含めて0クリアしてからハッシュ計算する.
+	//-----------------------------------------------------------------------
+	struct PipelineStateHashKey
+	{
+		u64						vertexShader;
+		u64						pixelShader;
+		u64						inputLayout;
+		u32						primitiveType;
+		BlendStateKey			blendState;
+		RasterizerStateKey		rasterizerState;
+		DepthStencilStateKey	depthStencilState;
+	};
+}
+
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+PipelineState::PipelineState()
+	: _initialized( false )
+	, _device( nullptr )
+	, _handle( kInvalidPipelineStateHandle )
+{
+	memory::Clear( _nativePipelineState );
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+PipelineState::~PipelineState()
+{
+	Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	初期化.
+//---------------------------------------------------------------------------
+void PipelineState::Initialize( Device* device, const Desc& desc )
+{
+	if( _initialized )
+	{
+		AROMA_ASSERT( false, _T( "Already initialized.\n" ) );
+		Finalize();
+	}
+	AROMA_ASSERT( desc.vertexShader && desc.pixelShader && desc.inputLayout, _T( "Shader or input layout is null.\n" ) );
+
+	_device = device;
+	_device->AddRef();
+	_desc = desc;
+	_desc.vertexShader->AddRef();
+	_desc.pixelShader->AddRef();
+	_desc.inputLayout->AddRef();
+
+	// ネイティブステートを解決.
+	// レンダーステートはデバイスのキャッシュが所有するため参照のみ保持.
+	auto renderStateCache = _device->GetRenderStateCache();
+	BlendStateKey			blendKey( _desc.blendState );
+	RasterizerStateKey		rasterizerKey( _desc.rasterizerState );
+	DepthStencilStateKey	depthStencilKey( _desc.depthStencilState );
+
+	_nativePipelineState.inputLayout		= _desc.inputLayout->GetNativeInputLayout();
+	_nativePipelineState.primitiveTopology	= ToNativePrimitiveType( _desc.primitiveType );
+	_nativePipelineState.vertexShader		= _desc.vertexShader->GetNativeVertexShader();
+	_nativePipelineState.pixelShader		= _desc.pixelShader->GetNativePixelShader();
+	_nativePipelineState.rasterizerState	= renderStateCache->GetNativeRasterizerState( rasterizerKey );
+	_nativePipelineState.blendState			= renderStateCache->GetNativeBlendState( blendKey );
+	_nativePipelineState.depthStencilState	= renderStateCache->GetNativeDepthStencilState( depthStencilKey );
+
+	// ハンドル計算.
+	PipelineStateHashKey hashKey;
+	memory::Clear( hashKey );
+	hashKey.vertexShader		= reinterpret_cast< uintptr_t >( _desc.vertexShader );
+	hashKey.pixelShader			= reinterpret_cast< uintptr_t >( _desc.pixelShader );
+	hashKey.inputLayout			= reinterpret_cast< uintptr_t >( _desc.inputLayout );
+	hashKey.primitiveType		= static_cast< u32 >( _desc.primitiveType );
+	hashKey.blendState			= blendKey;
+	hashKey.rasterizerState		= rasterizerKey;
+	hashKey.depthStencilState	= depthStencilKey;
+
+	const char* bytes = reinterpret_cast< const char* >( &hashKey );
+	_handle = data::HashFNV1a64( bytes, bytes + sizeof( PipelineStateHashKey ) );
+	if( _handle == kInvalidPipelineStateHandle )
+	{
+		_handle = 1;
+	}
+
+	_initialized = true;
+}
+
+//---------------------------------------------------------------------------
+//	解放.
+//---------------------------------------------------------------------------
+void PipelineState::Finalize()
+{
+	if( !_initialized ) return;
+
+	memory::Clear( _nativePipelineState );
+	memory::SafeRelease( _desc.vertexShader );
+	memory::SafeRelease( _desc.pixelShader );
+	memory::SafeRelease( _desc.inputLayout );
+	memory::SafeRelease( _device );
+	_desc.Default();
+	_handle = kInvalidPipelineStateHandle;
+	_initialized = false;
+}
+
+//---------------------------------------------------------------------------
+//	構成設定取得.
+//---------------------------------------------------------------------------
+const PipelineState::Desc& PipelineState::GetDesc() const
+{
+	return _desc;
+}
+
+//---------------------------------------------------------------------------
+//	ハンドル取得.
+//---------------------------------------------------------------------------
+PipelineStateHandle PipelineState::GetHandle() const
+{
+	return _handle;
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブAPIパイプラインステートの取得.
+//---------------------------------------------------------------------------
+const NativePipelineState& PipelineState::GetNativePipelineState() const
+{
+	return _nativePipelineState;
+}
+
+} // namespace render
+} // namespace aroma
+
+#endif
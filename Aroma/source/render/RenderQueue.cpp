@@ -0,0 +1,385 @@
+﻿//===========================================================================
+//!
+//!	@file		RenderQueue.cpp
+//!	@brief		描画キュー.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <memory>
+#include <aroma/render/RenderQueue.h>
+#include <aroma/render/DeferredContext.h>
+#include <aroma/common/Algorithm.h>
+#include <aroma/common/Task.h>
+
+namespace aroma {
+namespace render {
+
+namespace
+{
+	//! 並列ソート時の1分割あたりの最小要素数.
+	constexpr u32 kSortChunkSizeMin = 1024;
+
+	//-----------------------------------------------------------------------
+	//	並列実行で共有する状態.
+	//-----------------------------------------------------------------------
+	struct ParallelForState
+	{
+		TaskPromise< bool >		promise;
+		std::atomic< u32 >		nextChunk;
+		std::atomic< u32 >		remainingCount;
+	};
+
+	//-----------------------------------------------------------------------
+	//	正規化深度を指定ビット数に量子化.
+	//-----------------------------------------------------------------------
+	u64 QuantizeDepth( f32 depth, u32 bits )
+	{
+		const f32 clamped = Min( Max( depth, 0.0f ), 1.0f );
+		const u32 maxValue = ( 1ui32 << bits ) - 1;
+		return static_cast< u64 >( clamped * static_cast< f32 >( maxValue ) + 0.5f );
+	}
+
+	//-----------------------------------------------------------------------
+	//	64bit値を指定ビット数に畳み込み.
+	//-----------------------------------------------------------------------
+	u64 Fold( u64 value, u32 bits )
+	{
+		u64 result = 0;
+		while( value )
+		{
+			result ^= value;
+			value >>= bits;
+		}
+		return result & ( ( 1ui64 << bits ) - 1 );
+	}
+}
+
+//===========================================================================
+//	描画ソートキー.
+//===========================================================================
+//---------------------------------------------------------------------------
+//	不透明描画用キー作成.
+//---------------------------------------------------------------------------
+u64 DrawSortKey::MakeOpaque( u32 layer, PipelineStateHandle pipeline, u32 texture, f32 depth )
+{
+	u64 key = 0;
+	key |= static_cast< u64 >( layer & ( ( 1ui32 << kLayerBits ) - 1 ) ) << 56;
+	key |= Fold( pipeline, kPipelineBits ) << 32;
+	key |= static_cast< u64 >( texture & ( ( 1ui32 << kTextureBits ) - 1 ) ) << 16;
+	key |= QuantizeDepth( depth, kDepthBits );
+	return key;
+}
+
+//---------------------------------------------------------------------------
+//	半透明描画用キー作成.
+//---------------------------------------------------------------------------
+u64 DrawSortKey::MakeTranslucent( u32 layer, f32 depth, PipelineStateHandle pipeline, u32 texture )
+{
+	// 奥から描画するため深度を反転.
+	const u64 maxDepth = ( 1ui64 << kDepthBits ) - 1;
+
+	u64 key = 0;
+	key |= static_cast< u64 >( layer & ( ( 1ui32 << kLayerBits ) - 1 ) ) << 56;
+	key |= ( maxDepth - QuantizeDepth( depth, kDepthBits ) ) << 40;
+	key |= Fold( pipeline, kPipelineBits ) << 16;
+	key |= static_cast< u64 >( texture & ( ( 1ui32 << kTextureBits ) - 1 ) );
+	return key;
+}
+
+//---------------------------------------------------------------------------
+//	テクスチャID取得.
+//---------------------------------------------------------------------------
+u32 DrawSortKey::GetTextureId( const TextureView* texture )
+{
+	// アロケーションの下位ビットは常に0のため除外.
+	return static_cast< u32 >( Fold( reinterpret_cast< uintptr >( texture ) >> 4, kTextureBits ) );
+}
+
+//===========================================================================
+//	描画キュー.
+//===========================================================================
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+RenderQueue::RenderQueue()
+	: _initialized( false )
+	, _packets( nullptr )
+	, _entries( nullptr )
+	, _sortBuffer( nullptr )
+	, _packetCount( 0 )
+{
+	memory::Clear( _histograms );
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+RenderQueue::~RenderQueue()
+{
+	Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	初期化.
+//---------------------------------------------------------------------------
+void RenderQueue::Initialize( const Desc& desc )
+{
+	if( _initialized )
+	{
+		AROMA_ASSERT( false, _T( "Already initialized.\n" ) );
+		Finalize();
+	}
+	AROMA_ASSERT( desc.packetCapacity > 0, _T( "packetCapacity is zero.\n" ) );
+
+	_desc		= desc;
+	_packets	= new DrawPacket[ _desc.packetCapacity ];
+	_entries	= new SortEntry[ _desc.packetCapacity ];
+	_sortBuffer	= new SortEntry[ _desc.packetCapacity ];
+	_packetCount.store( 0, std::memory_order_relaxed );
+
+	_initialized = true;
+}
+
+//---------------------------------------------------------------------------
+//	解放.
+//---------------------------------------------------------------------------
+void RenderQueue::Finalize()
+{
+	if( !_initialized ) return;
+
+	memory::SafeDeleteArray( _packets );
+	memory::SafeDeleteArray( _entries );
+	memory::SafeDeleteArray( _sortBuffer );
+	_packetCount.store( 0, std::memory_order_relaxed );
+	_desc.Default();
+
+	_initialized = false;
+}
+
+//---------------------------------------------------------------------------
+//	パケット投入.
+//---------------------------------------------------------------------------
+bool RenderQueue::Submit( u64 sortKey, const DrawPacket& packet )
+{
+	const u32 index = _packetCount.fetch_add( 1, std::memory_order_relaxed );
+	if( index >= _desc.packetCapacity )
+	{
+		AROMA_ASSERT( false, _T( "Render queue is full.\n" ) );
+		return false;
+	}
+
+	_packets[ index ]		= packet;
+	_entries[ index ].key	= sortKey;
+	_entries[ index ].index	= index;
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	分割した範囲毎に関数を実行.
+//	ワーカーと呼び出しスレッドが未処理の範囲を順に取り合う.
+//	ワーカースレッドから呼び出されて他のワーカーが開始しない場合も,
+//	呼び出しスレッドが残りを実行するため待機で止まらない.
+//---------------------------------------------------------------------------
+template< typename F >
+void RenderQueue::ParallelFor( u32 chunkCount, F func )
+{
+	if( chunkCount <= 1 || _desc.scheduler == nullptr )
+	{
+		for( u32 chunk = 0; chunk < chunkCount; ++chunk )
+		{
+			func( chunk );
+		}
+		return;
+	}
+
+	auto state = std::make_shared< ParallelForState >();
+	Task< bool > task		= state->promise.GetTask();
+	state->nextChunk		= 0;
+	state->remainingCount	= chunkCount;
+
+	// 全範囲の完了後に開始したワーカーは範囲を取得できず, funcを呼び出さずに終了する.
+	auto work = [ state, func, chunkCount ]()
+	{
+		for( ;; )
+		{
+			const u32 chunk = state->nextChunk.fetch_add( 1, std::memory_order_relaxed );
+			if( chunk >= chunkCount ) break;
+
+			func( chunk );
+
+			// 最後に完了した範囲が一度だけ完了を通知する.
+			if( state->remainingCount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+			{
+				state->promise.SetValue( true );
+			}
+		}
+	};
+
+	for( u32 i = 1; i < chunkCount; ++i )
+	{
+		_desc.scheduler->Schedule( work );
+	}
+	work();
+	task.Wait();
+}
+
+//---------------------------------------------------------------------------
+//	ソートキー順に並べ替え.
+//---------------------------------------------------------------------------
+void RenderQueue::Sort()
+{
+	const u32 count = GetPacketCount();
+	if( count <= 1 ) return;
+
+	u32 chunkCount = 1;
+	if( _desc.scheduler && count >= _desc.parallelThreshold )
+	{
+		const u32 chunkMax = kSortChunkMax;
+		chunkCount = Max( 1ui32, Min( chunkMax, count / kSortChunkSizeMin ) );
+	}
+
+	SortEntry* src = _entries;
+	SortEntry* dst = _sortBuffer;
+
+	auto chunkBegin = [ count, chunkCount ]( u32 chunk )
+	{
+		return static_cast< u32 >( static_cast< u64 >( count ) * chunk / chunkCount );
+	};
+
+	for( u32 shift = 0; shift < 64; shift += 8 )
+	{
+		// 範囲毎に桁の出現数を数える.
+		ParallelFor( chunkCount, [ & ]( u32 chunk )
+		{
+			u32* histogram = _histograms[ chunk ];
+			memory::Clear( histogram, sizeof( u32 ) * kRadix );
+
+			const u32 end = chunkBegin( chunk + 1 );
+			for( u32 i = chunkBegin( chunk ); i < end; ++i )
+			{
+				++histogram[ ( src[ i ].key >> shift ) & ( kRadix - 1 ) ];
+			}
+		} );
+
+		// 全要素が同じ桁の場合は並べ替え不要.
+		const u32 firstDigit = static_cast< u32 >( ( src[ 0 ].key >> shift ) & ( kRadix - 1 ) );
+		u32 firstDigitCount = 0;
+		for( u32 chunk = 0; chunk < chunkCount; ++chunk )
+		{
+			firstDigitCount += _histograms[ chunk ][ firstDigit ];
+		}
+		if( firstDigitCount == count )
+		{
+			continue;
+		}
+
+		// 桁毎, 範囲毎の書き込み先を計算.
+		u32 offset = 0;
+		for( u32 digit = 0; digit < kRadix; ++digit )
+		{
+			for( u32 chunk = 0; chunk < chunkCount; ++chunk )
+			{
+				const u32 digitCount = _histograms[ chunk ][ digit ];
+				_histograms[ chunk ][ digit ] = offset;
+				offset += digitCount;
+			}
+		}
+
+		// 範囲毎に書き込み(範囲内の順序を保つため安定).
+		ParallelFor( chunkCount, [ & ]( u32 chunk )
+		{
+			u32* offsets = _histograms[ chunk ];
+
+			const u32 end = chunkBegin( chunk + 1 );
+			for( u32 i = chunkBegin( chunk ); i < end; ++i )
+			{
+				dst[ offsets[ ( src[ i ].key >> shift ) & ( kRadix - 1 ) ]++ ] = src[ i ];
+			}
+		} );
+
+		SortEntry* temp = src;
+		src = dst;
+		dst = temp;
+	}
+
+	_entries	= src;
+	_sortBuffer	= dst;
+}
+
+//---------------------------------------------------------------------------
+//	並べ替えたパケットを遅延コンテキストへ記録.
+//---------------------------------------------------------------------------
+void RenderQueue::Execute( DeferredContext* context ) const
+{
+	AROMA_ASSERT( context, _T( "context is null.\n" ) );
+
+	// 遅延コンテキストの各設定関数は同じ値の場合は何もしないため,
+	// 連続する同じステートはネイティブAPIへ1回のみ設定される.
+	// nullptrの項目は設定しないため, 直前のパケットの設定を引き継ぐ.
+	const u32 count = GetPacketCount();
+	for( u32 i = 0; i < count; ++i )
+	{
+		const auto& packet = _packets[ _entries[ i ].index ];
+
+		if( packet.pipelineState )
+		{
+			context->SetPipelineState( packet.pipelineState );
+		}
+		if( packet.vertexBuffer )
+		{
+			context->IASetVertexBuffer( 0, packet.vertexBuffer, packet.vertexStride, packet.vertexOffset );
+		}
+		if( packet.psBindingGroup )
+		{
+			// 個別設定するスロットはグループより優先.
+			context->PSSetBindingGroup( packet.psBindingGroup );
+		}
+		if( packet.vsConstantBuffer )
+		{
+			context->VSSetConstantBuffer( 0, packet.vsConstantBuffer );
+		}
+		if( packet.psConstantBuffer )
+		{
+			context->PSSetConstantBuffer( 0, packet.psConstantBuffer );
+		}
+		for( u32 slot = 0; slot < DrawPacket::kShaderResourcesMax; ++slot )
+		{
+			if( packet.psShaderResources[ slot ] )
+			{
+				context->PSSetShaderResource( slot, packet.psShaderResources[ slot ] );
+			}
+		}
+
+		if( packet.indexBuffer )
+		{
+			context->IASetIndexBuffer( packet.indexBuffer, packet.indexOffset );
+			context->DrawIndexed( packet.count, packet.start, packet.baseVertex );
+		}
+		else
+		{
+			context->Draw( packet.count, packet.start );
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+//	全パケット破棄.
+//---------------------------------------------------------------------------
+void RenderQueue::Clear()
+{
+	_packetCount.store( 0, std::memory_order_relaxed );
+}
+
+//---------------------------------------------------------------------------
+//	パケット数取得.
+//---------------------------------------------------------------------------
+u32 RenderQueue::GetPacketCount() const
+{
+	return Min( _packetCount.load( std::memory_order_relaxed ), _desc.packetCapacity );
+}
+
+} // namespace render
+} // namespace aroma
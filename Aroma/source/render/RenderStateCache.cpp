@@ -0,0 +1,251 @@
+﻿//===========================================================================
+//!
+//!	@file		RenderStateCache.cpp
+//!	@brief		レンダーステートキャッシュ : 永続化.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <cstring>
+#include <string>
+#include <aroma/render/RenderStateCache.h>
+#include <aroma/file/FileIO.h>
+#include <aroma/file/FileWriter.h>
+
+namespace aroma {
+namespace render {
+
+namespace
+{
+	//! キャッシュファイル識別子.
+	constexpr u32 kCacheMagic	= data::FourCC< 'A', 'R', 'S', 'C' >::value;
+
+	//! キャッシュファイルバージョン(キー構造を変更した場合は更新すること).
+	constexpr u32 kCacheVersion	= 2;
+
+	//-----------------------------------------------------------------------
+	//	ステート種別.
+	//-----------------------------------------------------------------------
+	enum StateType : u32
+	{
+		kStateTypeBlend,
+		kStateTypeRasterizer,
+		kStateTypeDepthStencil,
+		kStateTypeSampler,
+		kStateTypeViewportScissor,
+
+		kStateTypeNum,
+	};
+
+	//-----------------------------------------------------------------------
+	//	キャッシュファイルヘッダー.
+	//	ヘッダーの後ろにステート種別順でキーが連続して格納される.
+	//-----------------------------------------------------------------------
+	struct CacheHeader
+	{
+		u32	magic;
+		u32	version;
+		u32	keyBytes[ kStateTypeNum ];		// キー構造のサイズ(構造変更の検出用).
+		u32	keyCount[ kStateTypeNum ];
+		u32	payloadBytes;
+		u32	payloadCRC;
+	};
+
+	//-----------------------------------------------------------------------
+	//	各キーのサイズ.
+	//-----------------------------------------------------------------------
+	const u32 kKeyBytes[ kStateTypeNum ] =
+	{
+		sizeof( BlendStateKey ),
+		sizeof( RasterizerStateKey ),
+		sizeof( DepthStencilStateKey ),
+		sizeof( SamplerStateKey ),
+		sizeof( ViewportScissorStateKey ),
+	};
+
+	//-----------------------------------------------------------------------
+	//	キー追加.
+	//-----------------------------------------------------------------------
+	template< typename Cache >
+	u32 AppendKeys( std::vector< u8 >* outData, const Cache& cache, ReadWriteSpinLockObject& lock )
+	{
+		ScopedSharedLock scopedLock( lock );
+		for( auto& it : cache )
+		{
+			const u8* key = reinterpret_cast< const u8* >( &it.first );
+			outData->insert( outData->end(), key, key + sizeof( it.first ) );
+		}
+		return static_cast< u32 >( cache.size() );
+	}
+
+	//-----------------------------------------------------------------------
+	//	キー読み出し.
+	//-----------------------------------------------------------------------
+	template< typename Key, typename Func >
+	const u8* ForEachKey( const u8* data, u32 count, Func func )
+	{
+		Key key;
+		for( u32 i = 0; i < count; ++i )
+		{
+			memcpy( &key, data, sizeof( Key ) );
+			func( key );
+			data += sizeof( Key );
+		}
+		return data;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	キャッシュ済みキーのシリアライズ.
+//---------------------------------------------------------------------------
+void RenderStateCache::Serialize( std::vector< u8 >* outData ) const
+{
+	AROMA_ASSERT( outData, _T( "outData is null.\n" ) );
+
+	CacheHeader header;
+	memory::Clear( header );
+	header.magic	= kCacheMagic;
+	header.version	= kCacheVersion;
+	for( u32 i = 0; i < kStateTypeNum; ++i )
+	{
+		header.keyBytes[ i ] = kKeyBytes[ i ];
+	}
+
+	outData->clear();
+	outData->resize( sizeof( CacheHeader ) );
+	header.keyCount[ kStateTypeBlend ]				= AppendKeys( outData, _blendStateCache, GetLock( StateType::kBlend ) );
+	header.keyCount[ kStateTypeRasterizer ]			= AppendKeys( outData, _rasterizerStateCache, GetLock( StateType::kRasterizer ) );
+	header.keyCount[ kStateTypeDepthStencil ]		= AppendKeys( outData, _depthStencilStateCache, GetLock( StateType::kDepthStencil ) );
+	header.keyCount[ kStateTypeSampler ]			= AppendKeys( outData, _samplerStateCache, GetLock( StateType::kSampler ) );
+	header.keyCount[ kStateTypeViewportScissor ]	= AppendKeys( outData, _viewportScissorStateCache, GetLock( StateType::kViewportScissor ) );
+
+	const u8* payload	= outData->data() + sizeof( CacheHeader );
+	header.payloadBytes	= static_cast< u32 >( outData->size() - sizeof( CacheHeader ) );
+	header.payloadCRC	= data::CRC::GetCRCBulk( payload, header.payloadBytes );
+	memcpy( outData->data(), &header, sizeof( CacheHeader ) );
+}
+
+//---------------------------------------------------------------------------
+//	シリアライズデータからネイティブステートを事前生成.
+//---------------------------------------------------------------------------
+bool RenderStateCache::Prewarm( const void* data, size_t dataBytes )
+{
+	if( !data || dataBytes < sizeof( CacheHeader ) )
+	{
+		return false;
+	}
+
+	CacheHeader header;
+	memcpy( &header, data, sizeof( CacheHeader ) );
+	if( header.magic != kCacheMagic || header.version != kCacheVersion )
+	{
+		// 別バージョンのキャッシュは破棄.
+		return false;
+	}
+
+	u64 expectBytes = 0;
+	for( u32 i = 0; i < kStateTypeNum; ++i )
+	{
+		if( header.keyBytes[ i ] != kKeyBytes[ i ] )
+		{
+			// キー構造が異なる.
+			return false;
+		}
+		expectBytes += static_cast< u64 >( header.keyBytes[ i ] ) * header.keyCount[ i ];
+	}
+
+	const u8* payload = static_cast< const u8* >( data ) + sizeof( CacheHeader );
+	if( expectBytes != header.payloadBytes || header.payloadBytes > dataBytes - sizeof( CacheHeader ) )
+	{
+		AROMA_ASSERT( false, _T( "Render state cache is corrupted.\n" ) );
+		return false;
+	}
+	if( data::CRC::GetCRCBulk( payload, header.payloadBytes ) != header.payloadCRC )
+	{
+		AROMA_ASSERT( false, _T( "Render state cache CRC mismatch.\n" ) );
+		return false;
+	}
+
+	// 各ステートを生成.
+	payload = ForEachKey< BlendStateKey >( payload, header.keyCount[ kStateTypeBlend ],
+		[ this ]( const BlendStateKey& key ){ GetNativeBlendState( key ); } );
+	payload = ForEachKey< RasterizerStateKey >( payload, header.keyCount[ kStateTypeRasterizer ],
+		[ this ]( const RasterizerStateKey& key ){ GetNativeRasterizerState( key ); } );
+	payload = ForEachKey< DepthStencilStateKey >( payload, header.keyCount[ kStateTypeDepthStencil ],
+		[ this ]( const DepthStencilStateKey& key ){ GetNativeDepthStencilState( key ); } );
+	payload = ForEachKey< SamplerStateKey >( payload, header.keyCount[ kStateTypeSampler ],
+		[ this ]( const SamplerStateKey& key ){ GetNativeSamplerState( key ); } );
+	payload = ForEachKey< ViewportScissorStateKey >( payload, header.keyCount[ kStateTypeViewportScissor ],
+		[ this ]( const ViewportScissorStateKey& key )
+		{
+			NativeViewportScissorState state;
+			GetNativeViewportScissorState( key, &state, true );
+		} );
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	キャッシュ済みキーをファイルへ保存.
+//---------------------------------------------------------------------------
+bool RenderStateCache::SaveToFile( CTStr filePath ) const
+{
+	std::vector< u8 > serialized;
+	Serialize( &serialized );
+
+	// 書き込み途中で終了しても前回のキャッシュが壊れないよう一時ファイルから置き換える.
+	file::FileWriter::Desc desc;
+	desc.atomicReplace = true;
+	file::FileWriter cacheFile;
+	if( !cacheFile.Open( filePath, desc ) )
+	{
+		return false;
+	}
+	cacheFile.Write( serialized.data(), serialized.size() );
+	return cacheFile.Close();
+}
+
+//---------------------------------------------------------------------------
+//	ファイルからネイティブステートを事前生成.
+//---------------------------------------------------------------------------
+bool RenderStateCache::PrewarmFromFile( CTStr filePath )
+{
+	file::File cacheFile;
+	if( !cacheFile.Open( filePath, file::kOpenModeFlagRead, file::kShareFlagRead ) )
+	{
+		// 初回起動時等はファイルが無い.
+		return false;
+	}
+
+	size_t fileSize = 0;
+	if( !cacheFile.GetFileSize( &fileSize ) || fileSize < sizeof( CacheHeader ) )
+	{
+		return false;
+	}
+
+	std::vector< u8 > serialized( fileSize );
+	size_t readBytes = 0;
+	if( !cacheFile.ReadFile( serialized.data(), fileSize, &readBytes ) || readBytes != fileSize )
+	{
+		return false;
+	}
+	cacheFile.Close();
+
+	return Prewarm( serialized.data(), serialized.size() );
+}
+
+//---------------------------------------------------------------------------
+//	ファイルからネイティブステートを非同期に事前生成.
+//---------------------------------------------------------------------------
+Task< bool > RenderStateCache::PrewarmFromFileAsync( CTStr filePath, IScheduler* scheduler )
+{
+	std::basic_string< TChar > path( filePath );
+	return RunTask( scheduler, [ this, path ]
+	{
+		return PrewarmFromFile( path.c_str() );
+	} );
+}
+
+} // namespace render
+} // namespace aroma
@@ -9,23 +9,100 @@
 //===========================================================================
 #ifdef AROMA_RENDER_DX11
 
+#include <chrono>
 #include <aroma/render/RenderStateCache.h>
 #include <aroma/render/Device.h>
 #include <aroma/render/Texture.h>
 #include <aroma/render/TextureView.h>
+#include <aroma/common/Algorithm.h>
 
 namespace aroma {
 namespace render {
 
 namespace
 {
-	constexpr u32 kStatesMax = 4096;
+	//-----------------------------------------------------------------------
+	//	現在時刻取得(マイクロ秒).
+	//-----------------------------------------------------------------------
+	u64 GetTimeUs()
+	{
+		using namespace std::chrono;
+		return static_cast< u64 >( duration_cast< microseconds >( steady_clock::now().time_since_epoch() ).count() );
+	}
+
+	//-----------------------------------------------------------------------
+	//	生成時間ヒストグラムの区間取得.
+	//-----------------------------------------------------------------------
+	u32 GetCreateTimeBucket( u64 timeUs )
+	{
+		u32 bucket = 0;
+		while( timeUs > 0 && bucket < RenderStateCache::kCreateTimeHistogramMax - 1 )
+		{
+			timeUs >>= 2;
+			++bucket;
+		}
+		return bucket;
+	}
+
+	//-----------------------------------------------------------------------
+	//	呼び出しスレッドの統計スロット番号取得.
+	//-----------------------------------------------------------------------
+	u32 GetStatsSlotIndex( u32 slotMax )
+	{
+		static std::atomic< u32 > nextIndex( 0 );
+		static thread_local u32 index = nextIndex.fetch_add( 1, std::memory_order_relaxed );
+		return index % slotMax;
+	}
+
+	//-----------------------------------------------------------------------
+	//	ビューポートシザーステートをネイティブ形式に変換.
+	//-----------------------------------------------------------------------
+	void ConvertViewportScissorState( D3D11_VIEWPORT_SCISSOR* outState, const ViewportScissorStateKey& key )
+	{
+		outState->count = key.activeCount;
+		for( u32 i = 0; i < key.activeCount; ++i )
+		{
+			const auto& src		= key.slot[ i ];
+			auto& viewport		= outState->viewport[ i ];
+			auto& scissor		= outState->scissor[ i ];
+
+			viewport.TopLeftX 	= src.viewport.x;
+			viewport.TopLeftY 	= src.viewport.y;
+			viewport.Width		= src.viewport.w;
+			viewport.Height 	= src.viewport.h;
+			viewport.MinDepth 	= src.viewport.minDepth;
+			viewport.MaxDepth 	= src.viewport.maxDepth;
+
+			scissor.left		= src.scissor.x;
+			scissor.top			= src.scissor.y;
+			scissor.right		= src.scissor.x + src.scissor.w;
+			scissor.bottom		= src.scissor.y + src.scissor.h;
+		}
+	}
+
+	//-----------------------------------------------------------------------
+	//	ビューポートシザーステートの有効スロットをコピー.
+	//-----------------------------------------------------------------------
+	void CopyViewportScissorState( D3D11_VIEWPORT_SCISSOR* outState, const D3D11_VIEWPORT_SCISSOR& state )
+	{
+		outState->count = state.count;
+		memcpy( outState->viewport, state.viewport, sizeof( D3D11_VIEWPORT ) * state.count );
+		memcpy( outState->scissor, state.scissor, sizeof( D3D11_RECT ) * state.count );
+	}
 }
 
 //===========================================================================
 //!	@name		ブレンドステートハッシュキー.
 //===========================================================================
 //! @{
+//===========================================================================
+//!	@brief		デフォルトコンストラクタ.
+//===========================================================================
+BlendStateKey::BlendStateKey()
+{
+	memset( this, 0, sizeof( BlendStateKey ) );
+}
+
 //===========================================================================
 //!	@brief		コピーコンストラクタ.
 //===========================================================================
@@ -54,13 +131,23 @@ void BlendStateKey::Set( const BlendState& state )
 	colorMaskA				= state.colorMaskA ? 1 : 0;
 }
 
-bool operator==( const BlendStateKey& lhs, const BlendStateKey& rhs )
-{
-	return memcmp( &lhs, &rhs, sizeof( BlendStateKey ) ) == 0;
-}
-bool operator!=( const BlendStateKey& lhs, const BlendStateKey& rhs )
+//===========================================================================
+//!	@brief		ステートへ展開.
+//===========================================================================
+void BlendStateKey::Get( BlendState* outState ) const
 {
-	return !( lhs == rhs );
+	outState->sampleAlphaToCoverage	= sampleAlphaToCoverage != 0;
+	outState->blendEnable			= blendEnable != 0;
+	outState->rgbSource				= static_cast< Blend >( rgbSource );
+	outState->rgbDest				= static_cast< Blend >( rgbDest );
+	outState->rgbBlendOp			= static_cast< BlendOp >( rgbBlendOp );
+	outState->alphaSource			= static_cast< Blend >( alphaSource );
+	outState->alphaDest				= static_cast< Blend >( alphaDest );
+	outState->alphaBlendOp			= static_cast< BlendOp >( alphaBlendOp );
+	outState->colorMaskR			= colorMaskR != 0;
+	outState->colorMaskG			= colorMaskG != 0;
+	outState->colorMaskB			= colorMaskB != 0;
+	outState->colorMaskA			= colorMaskA != 0;
 }
 //! @}
 
@@ -68,6 +155,14 @@ bool operator!=( const BlendStateKey& lhs, const BlendStateKey& rhs )
 //!	@name		ラスタライザーステートステートハッシュキー.
 //===========================================================================
 //! @{
+//===========================================================================
+//!	@brief		デフォルトコンストラクタ.
+//===========================================================================
+RasterizerStateKey::RasterizerStateKey()
+{
+	memset( this, 0, sizeof( RasterizerStateKey ) );
+}
+
 //===========================================================================
 //!	@brief		コピーコンストラクタ.
 //===========================================================================
@@ -96,13 +191,22 @@ void RasterizerStateKey::Set( const RasterizerState& state )
 	antialiasedLineEnable	= state.antialiasedLineEnable ? 1 : 0;
 }
 
-bool operator==( const RasterizerStateKey& lhs, const RasterizerStateKey& rhs )
-{
-	return memcmp( &lhs, &rhs, sizeof( RasterizerStateKey ) ) == 0;
-}
-bool operator!=( const RasterizerStateKey& lhs, const RasterizerStateKey& rhs )
+//===========================================================================
+//!	@brief		ステートへ展開.
+//===========================================================================
+void RasterizerStateKey::Get( RasterizerState* outState ) const
 {
-	return !( lhs == rhs );
+	outState->depthBias				= depthBias;
+	outState->depthBiasClamp		= depthBiasClamp;
+	outState->slopeScaledDepthBias	= slopeScaledDepthBias;
+
+	outState->fillMode				= static_cast< FillMode >( fillMode );
+	outState->cullMode				= static_cast< CullMode >( cullMode );
+	outState->frontCounterClockwise	= frontCounterClockwise != 0;
+	outState->depthClipEnable		= depthClipEnable != 0;
+	outState->scissorEnable			= scissorEnable != 0;
+	outState->multisampleEnable		= multisampleEnable != 0;
+	outState->antialiasedLineEnable	= antialiasedLineEnable != 0;
 }
 //! @}
 
@@ -110,6 +214,14 @@ bool operator!=( const RasterizerStateKey& lhs, const RasterizerStateKey& rhs )
 //!	@name		深度ステンシルステートステートハッシュキー.
 //===========================================================================
 //! @{
+//===========================================================================
+//!	@brief		デフォルトコンストラクタ.
+//===========================================================================
+DepthStencilStateKey::DepthStencilStateKey()
+{
+	memset( this, 0, sizeof( DepthStencilStateKey ) );
+}
+
 //===========================================================================
 //!	@brief		コピーコンストラクタ.
 //===========================================================================
@@ -142,13 +254,26 @@ void DepthStencilStateKey::Set( const DepthStencilState& state )
 	stencilWriteMask			= static_cast< u32 >( state.stencilWriteMask );
 }
 
-bool operator==( const DepthStencilStateKey& lhs, const DepthStencilStateKey& rhs )
-{
-	return memcmp( &lhs, &rhs, sizeof( DepthStencilStateKey ) ) == 0;
-}
-bool operator!=( const DepthStencilStateKey& lhs, const DepthStencilStateKey& rhs )
+//===========================================================================
+//!	@brief		ステートへ展開.
+//===========================================================================
+void DepthStencilStateKey::Get( DepthStencilState* outState ) const
 {
-	return !( lhs == rhs );
+	outState->depthEnable					= depthEnable != 0;
+	outState->depthWrite					= depthWrite != 0;
+	outState->depthFunc						= static_cast< ComparisonFunc >( depthFunc );
+	outState->stencilEnable					= stencilEnable != 0;
+	outState->frontFaceStencilFailOp		= static_cast< StencilOp >( frontFaceStencilFailOp );
+	outState->frontFaceStencilDepthFailOp	= static_cast< StencilOp >( frontFaceStencilDepthFailOp );
+	outState->frontFaceStencilPassOp		= static_cast< StencilOp >( frontFaceStencilPassOp );
+	outState->frontFaceStencilFunc			= static_cast< ComparisonFunc >( frontFaceStencilFunc );
+	outState->backFaceStencilFailOp			= static_cast< StencilOp >( backFaceStencilFailOp );
+	outState->backFaceStencilDepthFailOp	= static_cast< StencilOp >( backFaceStencilDepthFailOp );
+	outState->backFaceStencilPassOp			= static_cast< StencilOp >( backFaceStencilPassOp );
+	outState->backFaceStencilFunc			= static_cast< ComparisonFunc >( backFaceStencilFunc );
+
+	outState->stencilReadMask				= static_cast< u8 >( stencilReadMask );
+	outState->stencilWriteMask				= static_cast< u8 >( stencilWriteMask );
 }
 //! @}
 
@@ -156,6 +281,14 @@ bool operator!=( const DepthStencilStateKey& lhs, const DepthStencilStateKey& rh
 //!	@name		サンプラーステートステートハッシュキー.
 //===========================================================================
 //! @{
+//===========================================================================
+//!	@brief		デフォルトコンストラクタ.
+//===========================================================================
+SamplerStateKey::SamplerStateKey()
+{
+	memset( this, 0, sizeof( SamplerStateKey ) );
+}
+
 //===========================================================================
 //!	@brief		コピーコンストラクタ.
 //===========================================================================
@@ -183,13 +316,21 @@ void SamplerStateKey::Set( const SamplerState& state )
 	maxAnisotropy				= static_cast< u32 >( state.maxAnisotropy );
 }
 
-bool operator==( const SamplerStateKey& lhs, const SamplerStateKey& rhs )
-{
-	return memcmp( &lhs, &rhs, sizeof( SamplerStateKey ) ) == 0;
-}
-bool operator!=( const SamplerStateKey& lhs, const SamplerStateKey& rhs )
+//===========================================================================
+//!	@brief		ステートへ展開.
+//===========================================================================
+void SamplerStateKey::Get( SamplerState* outState ) const
 {
-	return !( lhs == rhs );
+	outState->mipLODBias		= mipLODBias;
+	outState->minLOD			= minLOD;
+	outState->maxLOD			= maxLOD;
+	outState->borderColor		= borderColor;
+
+	outState->filter			= static_cast< Filter >( filter );
+	outState->addressU			= static_cast< TextureAddress >( addressU );
+	outState->addressV			= static_cast< TextureAddress >( addressV );
+	outState->addressW			= static_cast< TextureAddress >( addressW );
+	outState->maxAnisotropy		= static_cast< AnisotropicRatio >( maxAnisotropy );
 }
 //! @}
 
@@ -197,6 +338,14 @@ bool operator!=( const SamplerStateKey& lhs, const SamplerStateKey& rhs )
 //!	@name		ビューポートシザーステートステートハッシュキー.
 //===========================================================================
 //! @{
+//===========================================================================
+//!	@brief		デフォルトコンストラクタ.
+//===========================================================================
+ViewportScissorStateKey::ViewportScissorStateKey()
+{
+	memset( this, 0, sizeof( ViewportScissorStateKey ) );
+}
+
 //===========================================================================
 //!	@brief		コピーコンストラクタ.
 //===========================================================================
@@ -210,18 +359,32 @@ ViewportScissorStateKey::ViewportScissorStateKey( const ViewportScissorState& st
 //===========================================================================
 void ViewportScissorStateKey::Set( const ViewportScissorState& state )
 {
-	memset( this, 0, sizeof( ViewportScissorStateKey ) );
+	// 既定値以外が設定されている最後のスロットまでを有効とする.
+	const Viewport		defaultViewport;
+	const ScissorRect	defaultScissor;
+	u32 count = kViewportsSlotMax;
+	while( count > 1
+		&& memcmp( &state.viewport[ count - 1 ], &defaultViewport, sizeof( Viewport ) ) == 0
+		&& memcmp( &state.scissor[ count - 1 ], &defaultScissor, sizeof( ScissorRect ) ) == 0 )
+	{
+		--count;
+	}
 
-	for( u32 i = 0; i < kViewportsSlotMax; ++i )
+	activeCount = count;
+	for( u32 i = 0; i < count; ++i )
+	{
+		slot[ i ].viewport	= state.viewport[ i ];
+		slot[ i ].scissor	= state.scissor[ i ];
+	}
+	if( count < kViewportsSlotMax )
 	{
-		viewport[ i ]	= state.viewport[ i ];
-		scissor[ i ]	= state.scissor[ i ];
+		memset( &slot[ count ], 0, sizeof( Slot ) * ( kViewportsSlotMax - count ) );
 	}
 }
 
 bool operator==( const ViewportScissorStateKey& lhs, const ViewportScissorStateKey& rhs )
 {
-	return memcmp( &lhs, &rhs, sizeof( ViewportScissorStateKey ) ) == 0;
+	return lhs.activeCount == rhs.activeCount && memcmp( &lhs, &rhs, lhs.GetActiveBytes() ) == 0;
 }
 bool operator!=( const ViewportScissorStateKey& lhs, const ViewportScissorStateKey& rhs )
 {
@@ -238,12 +401,29 @@ bool operator!=( const ViewportScissorStateKey& lhs, const ViewportScissorStateK
 //---------------------------------------------------------------------------
 RenderStateCache::RenderStateCache( Device* device )
 	: _device( device )
+	, _viewportScissorCandidateIndex( 0 )
 {
 	_blendStateCache.reserve( kStatesMax );
 	_rasterizerStateCache.reserve( kStatesMax );
 	_depthStencilStateCache.reserve( kStatesMax );
 	_samplerStateCache.reserve( kStatesMax );
-	_viewportScissorStateCache.reserve( kStatesMax );
+	_viewportScissorStateCache.reserve( kViewportScissorStatesMax );
+	memory::Clear( _viewportScissorCandidates );
+	memory::Clear( _peakCount );
+
+	for( auto& slot : _statsSlots )
+	{
+		for( auto& counter : slot.counter )
+		{
+			counter.lookupCount.store( 0, std::memory_order_relaxed );
+			counter.hitCount.store( 0, std::memory_order_relaxed );
+			counter.createTimeUs.store( 0, std::memory_order_relaxed );
+			for( auto& count : counter.createTimeHistogram )
+			{
+				count.store( 0, std::memory_order_relaxed );
+			}
+		}
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -267,10 +447,6 @@ RenderStateCache::~RenderStateCache()
 	{
 		memory::SafeRelease( it.second );
 	}
-	for( auto& it : _viewportScissorStateCache )
-	{
-		memory::SafeDelete( it.second );	// RefObjectでは無いのでDelete.
-	}
 }
 
 //---------------------------------------------------------------------------
@@ -278,14 +454,21 @@ RenderStateCache::~RenderStateCache()
 //---------------------------------------------------------------------------
 NativeBlendState* RenderStateCache::GetNativeBlendState( const BlendStateKey& key )
 {
-	auto it = _blendStateCache.find( key );
-	if( it != _blendStateCache.end() )
 	{
-		// キャッシュを返却.
-		return it->second;
+		ScopedSharedLock lock( GetLock( StateType::kBlend ) );
+
+		auto it = _blendStateCache.find( key );
+		if( it != _blendStateCache.end() )
+		{
+			// キャッシュを返却.
+			RecordLookup( StateType::kBlend, true );
+			return it->second;
+		}
 	}
 
 	// キャッシュされていない場合は新規追加.
+	RecordLookup( StateType::kBlend, false );
+	const u64 beginTimeUs = GetTimeUs();
 	auto d3dDevice = _device->GetNativeDevice();
 
 	// TODO: 必要であればレンダーターゲット別独立ブレンド(Independent Blend)対応.
@@ -304,10 +487,19 @@ NativeBlendState* RenderStateCache::GetNativeBlendState( const BlendStateKey& ke
 	d3dBlendDesc.RenderTarget[0].RenderTargetWriteMask	|= key.colorMaskB ? D3D11_COLOR_WRITE_ENABLE_BLUE : 0;
 	d3dBlendDesc.RenderTarget[0].RenderTargetWriteMask	|= key.colorMaskA ? D3D11_COLOR_WRITE_ENABLE_ALPHA : 0;
 
-	ID3D11BlendState*	d3dBlendState;
+	ID3D11BlendState*	d3dBlendState = nullptr;
 	f32					blendFactor[ 4 ] = {};
 	d3dDevice->CreateBlendState( &d3dBlendDesc, &d3dBlendState );
-	_blendStateCache[ key ] = d3dBlendState;
+
+	// 生成中に他のスレッドが追加した場合はそちらを使用.
+	ScopedLock lock( GetLock( StateType::kBlend ) );
+	auto result = _blendStateCache.emplace( key, d3dBlendState );
+	if( !result.second )
+	{
+		memory::SafeRelease( d3dBlendState );
+		return result.first->second;
+	}
+	RecordCreate( StateType::kBlend, beginTimeUs, _blendStateCache.size() );
 	return d3dBlendState;
 }
 
@@ -316,14 +508,21 @@ NativeBlendState* RenderStateCache::GetNativeBlendState( const BlendStateKey& ke
 //---------------------------------------------------------------------------
 NativeRasterizerState* RenderStateCache::GetNativeRasterizerState( const RasterizerStateKey& key )
 {
-	auto it = _rasterizerStateCache.find( key );
-	if( it != _rasterizerStateCache.end() )
 	{
-		// キャッシュを返却.
-		return it->second;
+		ScopedSharedLock lock( GetLock( StateType::kRasterizer ) );
+
+		auto it = _rasterizerStateCache.find( key );
+		if( it != _rasterizerStateCache.end() )
+		{
+			// キャッシュを返却.
+			RecordLookup( StateType::kRasterizer, true );
+			return it->second;
+		}
 	}
 
 	// キャッシュされていない場合は新規追加.
+	RecordLookup( StateType::kRasterizer, false );
+	const u64 beginTimeUs = GetTimeUs();
 	auto d3dDevice = _device->GetNativeDevice();
 	D3D11_RASTERIZER_DESC d3dRasterizerDesc = {};
 	d3dRasterizerDesc.FillMode					= ToNativeFillMode( static_cast< FillMode >( key.fillMode ) );
@@ -337,9 +536,18 @@ NativeRasterizerState* RenderStateCache::GetNativeRasterizerState( const Rasteri
 	d3dRasterizerDesc.MultisampleEnable			= key.multisampleEnable ? TRUE : FALSE;
 	d3dRasterizerDesc.AntialiasedLineEnable		= key.antialiasedLineEnable ? TRUE : FALSE;
 
-	ID3D11RasterizerState*	d3dRasterizerState;
+	ID3D11RasterizerState*	d3dRasterizerState = nullptr;
 	d3dDevice->CreateRasterizerState( &d3dRasterizerDesc, &d3dRasterizerState );
-	_rasterizerStateCache[ key ] = d3dRasterizerState;
+
+	// 生成中に他のスレッドが追加した場合はそちらを使用.
+	ScopedLock lock( GetLock( StateType::kRasterizer ) );
+	auto result = _rasterizerStateCache.emplace( key, d3dRasterizerState );
+	if( !result.second )
+	{
+		memory::SafeRelease( d3dRasterizerState );
+		return result.first->second;
+	}
+	RecordCreate( StateType::kRasterizer, beginTimeUs, _rasterizerStateCache.size() );
 	return d3dRasterizerState;
 }
 
@@ -348,14 +556,21 @@ NativeRasterizerState* RenderStateCache::GetNativeRasterizerState( const Rasteri
 //---------------------------------------------------------------------------
 NativeDepthStencilState* RenderStateCache::GetNativeDepthStencilState( const DepthStencilStateKey& key )
 {
-	auto it = _depthStencilStateCache.find( key );
-	if( it != _depthStencilStateCache.end() )
 	{
-		// キャッシュを返却.
-		return it->second;
+		ScopedSharedLock lock( GetLock( StateType::kDepthStencil ) );
+
+		auto it = _depthStencilStateCache.find( key );
+		if( it != _depthStencilStateCache.end() )
+		{
+			// キャッシュを返却.
+			RecordLookup( StateType::kDepthStencil, true );
+			return it->second;
+		}
 	}
 
 	// キャッシュされていない場合は新規追加.
+	RecordLookup( StateType::kDepthStencil, false );
+	const u64 beginTimeUs = GetTimeUs();
 	auto d3dDevice = _device->GetNativeDevice();
 	D3D11_DEPTH_STENCIL_DESC d3dDepthStencilDesc = {};
 	d3dDepthStencilDesc.DepthEnable			= key.depthEnable ? TRUE : FALSE;
@@ -375,9 +590,18 @@ NativeDepthStencilState* RenderStateCache::GetNativeDepthStencilState( const Dep
 	d3dDepthStencilDesc.BackFace.StencilPassOp			= ToNativeStencilOp( static_cast< StencilOp >( key.backFaceStencilPassOp ) );
 	d3dDepthStencilDesc.BackFace.StencilFunc			= ToNativeComparisonFunc( static_cast< ComparisonFunc >( key.backFaceStencilFunc ) );
 
-	ID3D11DepthStencilState*	d3dDepthStencilState;
+	ID3D11DepthStencilState*	d3dDepthStencilState = nullptr;
 	d3dDevice->CreateDepthStencilState( &d3dDepthStencilDesc, &d3dDepthStencilState );
-	_depthStencilStateCache[ key ] = d3dDepthStencilState;
+
+	// 生成中に他のスレッドが追加した場合はそちらを使用.
+	ScopedLock lock( GetLock( StateType::kDepthStencil ) );
+	auto result = _depthStencilStateCache.emplace( key, d3dDepthStencilState );
+	if( !result.second )
+	{
+		memory::SafeRelease( d3dDepthStencilState );
+		return result.first->second;
+	}
+	RecordCreate( StateType::kDepthStencil, beginTimeUs, _depthStencilStateCache.size() );
 	return d3dDepthStencilState;
 }
 
@@ -386,14 +610,21 @@ NativeDepthStencilState* RenderStateCache::GetNativeDepthStencilState( const Dep
 //---------------------------------------------------------------------------
 NativeSamplerState* RenderStateCache::GetNativeSamplerState( const SamplerStateKey& key )
 {
-	auto it = _samplerStateCache.find( key );
-	if( it != _samplerStateCache.end() )
 	{
-		// キャッシュを返却.
-		return it->second;
+		ScopedSharedLock lock( GetLock( StateType::kSampler ) );
+
+		auto it = _samplerStateCache.find( key );
+		if( it != _samplerStateCache.end() )
+		{
+			// キャッシュを返却.
+			RecordLookup( StateType::kSampler, true );
+			return it->second;
+		}
 	}
 
 	// キャッシュされていない場合は新規追加.
+	RecordLookup( StateType::kSampler, false );
+	const u64 beginTimeUs = GetTimeUs();
 	auto d3dDevice = _device->GetNativeDevice();
 	D3D11_SAMPLER_DESC d3dSamplerDesc = {};
 	d3dSamplerDesc.Filter			= ToNativeFilter( static_cast< Filter >( key.filter ) );
@@ -410,48 +641,171 @@ NativeSamplerState* RenderStateCache::GetNativeSamplerState( const SamplerStateK
 	d3dSamplerDesc.MinLOD			= key.minLOD;
 	d3dSamplerDesc.MaxLOD			= key.maxLOD;
 
-	ID3D11SamplerState*	d3dSamplerState;
+	ID3D11SamplerState*	d3dSamplerState = nullptr;
 	d3dDevice->CreateSamplerState( &d3dSamplerDesc, &d3dSamplerState );
-	_samplerStateCache[ key ] = d3dSamplerState;
+
+	// 生成中に他のスレッドが追加した場合はそちらを使用.
+	ScopedLock lock( GetLock( StateType::kSampler ) );
+	auto result = _samplerStateCache.emplace( key, d3dSamplerState );
+	if( !result.second )
+	{
+		memory::SafeRelease( d3dSamplerState );
+		return result.first->second;
+	}
+	RecordCreate( StateType::kSampler, beginTimeUs, _samplerStateCache.size() );
 	return d3dSamplerState;
 }
 
 //---------------------------------------------------------------------------
 //	ネイティブAPIビューポートシザーステート取得.
 //---------------------------------------------------------------------------
-NativeViewportScissorState* RenderStateCache::GetNativeViewportScissorState( const ViewportScissorStateKey& key )
+void RenderStateCache::GetNativeViewportScissorState( const ViewportScissorStateKey& key, NativeViewportScissorState* outState )
+{
+	GetNativeViewportScissorState( key, outState, false );
+}
+
+void RenderStateCache::GetNativeViewportScissorState( const ViewportScissorStateKey& key, NativeViewportScissorState* outState, bool admit )
 {
-	auto it = _viewportScissorStateCache.find( key );
-	if( it != _viewportScissorStateCache.end() )
 	{
-		// キャッシュを返却.
-		return it->second;
+		// 取得時にLRUを更新するため排他ロック(ネイティブAPIは呼び出さない).
+		ScopedLock lock( GetLock( StateType::kViewportScissor ) );
+
+		auto it = _viewportScissorStateCache.find( key );
+		if( it != _viewportScissorStateCache.end() )
+		{
+			// キャッシュを返却し, 最近使用したものとしてLRU先頭へ移動.
+			auto& entry = it->second;
+			RecordLookup( StateType::kViewportScissor, true );
+			_viewportScissorStateLRU.splice( _viewportScissorStateLRU.begin(), _viewportScissorStateLRU, entry.lru );
+			CopyViewportScissorState( outState, entry.state );
+			return;
+		}
+
+		RecordLookup( StateType::kViewportScissor, false );
+		if( !admit )
+		{
+			// 直近に使用されたキーであればキャッシュ対象とする.
+			const u32 hash = static_cast< u32 >( std::hash< ViewportScissorStateKey >()( key ) );
+			for( u32 i = 0; i < kViewportScissorCandidatesMax; ++i )
+			{
+				if( _viewportScissorCandidates[ i ] == hash )
+				{
+					admit = true;
+					break;
+				}
+			}
+			if( !admit )
+			{
+				_viewportScissorCandidates[ _viewportScissorCandidateIndex ] = hash;
+				_viewportScissorCandidateIndex = ( _viewportScissorCandidateIndex + 1 ) % kViewportScissorCandidatesMax;
+			}
+		}
+
+		if( admit )
+		{
+			// 上限に達している場合は最も長く使用されていないものを破棄.
+			if( _viewportScissorStateCache.size() >= kViewportScissorStatesMax )
+			{
+				const ViewportScissorStateKey* oldest = _viewportScissorStateLRU.back();
+				_viewportScissorStateLRU.pop_back();
+				_viewportScissorStateCache.erase( _viewportScissorStateCache.find( *oldest ) );
+			}
+
+			// キャッシュへ新規追加.
+			const u64 beginTimeUs = GetTimeUs();
+			auto result = _viewportScissorStateCache.emplace( key, ViewportScissorStateEntry() );
+			auto& entry = result.first->second;
+			ConvertViewportScissorState( &entry.state, key );
+			_viewportScissorStateLRU.push_front( &result.first->first );
+			entry.lru = _viewportScissorStateLRU.begin();
+			RecordCreate( StateType::kViewportScissor, beginTimeUs, _viewportScissorStateCache.size() );
+
+			CopyViewportScissorState( outState, entry.state );
+			return;
+		}
 	}
 
-	// キャッシュされていない場合は新規追加.
-	D3D11_VIEWPORT_SCISSOR* d3dViewportScissor = new D3D11_VIEWPORT_SCISSOR;
-	for( u32 i = 0; i < kViewportsSlotMax; ++i )
+	// 一時的なステートはキャッシュせずに直接変換.
+	ConvertViewportScissorState( outState, key );
+}
+
+//---------------------------------------------------------------------------
+//	統計情報取得.
+//---------------------------------------------------------------------------
+void RenderStateCache::GetStats( Stats* outStats, bool reset )
+{
+	AROMA_ASSERT( outStats, _T( "outStats is null.\n" ) );
+
+	outStats->Default();
+
+	// スレッド別カウンターを集計.
+	auto read = [ reset ]( std::atomic< u64 >& counter )
+	{
+		return reset ? counter.exchange( 0, std::memory_order_relaxed ) : counter.load( std::memory_order_relaxed );
+	};
+	for( auto& slot : _statsSlots )
+	{
+		for( u32 i = 0; i < static_cast< u32 >( StateType::kNum ); ++i )
+		{
+			auto& counter	= slot.counter[ i ];
+			auto& stats		= outStats->type[ i ];
+			stats.lookupCount	+= read( counter.lookupCount );
+			stats.hitCount		+= read( counter.hitCount );
+			stats.createTimeUs	+= read( counter.createTimeUs );
+			for( u32 j = 0; j < kCreateTimeHistogramMax; ++j )
+			{
+				stats.createTimeHistogram[ j ] += read( counter.createTimeHistogram[ j ] );
+			}
+		}
+	}
+
+	for( u32 i = 0; i < static_cast< u32 >( StateType::kNum ); ++i )
+	{
+		auto& stats = outStats->type[ i ];
+		stats.missCount		= stats.lookupCount - Min( stats.hitCount, stats.lookupCount );
+
+		ScopedSharedLock lock( GetLock( static_cast< StateType >( i ) ) );
+		switch( static_cast< StateType >( i ) )
+		{
+		case StateType::kBlend:				stats.currentCount = static_cast< u32 >( _blendStateCache.size() );				break;
+		case StateType::kRasterizer:		stats.currentCount = static_cast< u32 >( _rasterizerStateCache.size() );		break;
+		case StateType::kDepthStencil:		stats.currentCount = static_cast< u32 >( _depthStencilStateCache.size() );		break;
+		case StateType::kSampler:			stats.currentCount = static_cast< u32 >( _samplerStateCache.size() );			break;
+		case StateType::kViewportScissor:	stats.currentCount = static_cast< u32 >( _viewportScissorStateCache.size() );	break;
+		default:																											break;
+		}
+		stats.peakCount		= _peakCount[ i ];
+		stats.capacity		= kStatesMax;
+	}
+	outStats->type[ static_cast< u32 >( StateType::kViewportScissor ) ].capacity = kViewportScissorStatesMax;
+}
+
+//---------------------------------------------------------------------------
+//	取得回数を記録.
+//---------------------------------------------------------------------------
+void RenderStateCache::RecordLookup( StateType stateType, bool hit )
+{
+	auto& counter = _statsSlots[ GetStatsSlotIndex( kStatsSlotMax ) ].counter[ static_cast< u32 >( stateType ) ];
+	counter.lookupCount.fetch_add( 1, std::memory_order_relaxed );
+	if( hit )
 	{
-		auto& viewport	= d3dViewportScissor->viewport[ i ];
-		auto& scissor	= d3dViewportScissor->scissor[ i ];
-
-		memory::Clear( viewport );
-		viewport.TopLeftX 	= key.viewport[ i ].x;
-		viewport.TopLeftY 	= key.viewport[ i ].y;
-		viewport.Width		= key.viewport[ i ].w;
-		viewport.Height 	= key.viewport[ i ].h;
-		viewport.MinDepth 	= key.viewport[ i ].minDepth;
-		viewport.MaxDepth 	= key.viewport[ i ].maxDepth;
-
-		memory::Clear( scissor );
-		scissor.left		= key.scissor[ i ].x;
-		scissor.top			= key.scissor[ i ].y;
-		scissor.right		= key.scissor[ i ].x + key.scissor[ i ].w;
-		scissor.bottom		= key.scissor[ i ].y + key.scissor[ i ].h;
+		counter.hitCount.fetch_add( 1, std::memory_order_relaxed );
 	}
+}
+
+//---------------------------------------------------------------------------
+//	ネイティブステート生成時間を記録.
+//---------------------------------------------------------------------------
+void RenderStateCache::RecordCreate( StateType stateType, u64 beginTimeUs, size_t count )
+{
+	const u64 timeUs = GetTimeUs() - beginTimeUs;
+
+	auto& counter = _statsSlots[ GetStatsSlotIndex( kStatsSlotMax ) ].counter[ static_cast< u32 >( stateType ) ];
+	counter.createTimeUs.fetch_add( timeUs, std::memory_order_relaxed );
+	counter.createTimeHistogram[ GetCreateTimeBucket( timeUs ) ].fetch_add( 1, std::memory_order_relaxed );
 
-	_viewportScissorStateCache[ key ] = d3dViewportScissor;
-	return d3dViewportScissor;
+	auto& peakCount = _peakCount[ static_cast< u32 >( stateType ) ];
+	peakCount = Max( peakCount, static_cast< u32 >( count ) );
 }
 //! @}
 
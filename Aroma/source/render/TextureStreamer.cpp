@@ -0,0 +1,602 @@
+﻿//===========================================================================
+//!
+//!	@file		TextureStreamer.cpp
+//!	@brief		テクスチャストリーミング.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <algorithm>
+#include <aroma/common/Algorithm.h>
+#include <aroma/render/TextureStreamer.h>
+#include <aroma/render/Device.h>
+#include <aroma/render/Texture.h>
+#include <aroma/render/TextureView.h>
+
+namespace aroma {
+namespace render {
+
+namespace
+{
+	//! 要求, 読み込み無し.
+	constexpr u32 kNoRequest = AROMA_UINT32_MAX;
+}
+
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+StreamingTexture::StreamingTexture()
+	: _mipCount( 0 )
+	, _tailMip( 0 )
+	, _view( nullptr )
+	, _residentMip( 0 )
+	, _requestedMip( kNoRequest )
+	, _desiredMip( 0 )
+	, _loadingMip( kNoRequest )
+	, _lastUsedFrame( 0 )
+	, _residentBytes( 0 )
+	, _loadingBytes( 0 )
+	, _registered( false )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+StreamingTexture::~StreamingTexture()
+{
+	AROMA_ASSERT( _view.load() == nullptr, _T( "View is not retired.\n" ) );
+}
+
+//---------------------------------------------------------------------------
+//	現在のテクスチャビュー取得.
+//---------------------------------------------------------------------------
+TextureView* StreamingTexture::GetView() const
+{
+	return _view.load( std::memory_order_acquire );
+}
+
+//---------------------------------------------------------------------------
+//	必要なミップレベルを要求.
+//---------------------------------------------------------------------------
+void StreamingTexture::RequestMip( u32 mip )
+{
+	u32 current = _requestedMip.load( std::memory_order_relaxed );
+	while( mip < current && !_requestedMip.compare_exchange_weak( current, mip, std::memory_order_relaxed ) )
+	{
+	}
+}
+
+//---------------------------------------------------------------------------
+//	常駐している最も詳細なミップレベル取得.
+//---------------------------------------------------------------------------
+u32 StreamingTexture::GetResidentMip() const
+{
+	return _residentMip.load( std::memory_order_acquire );
+}
+
+//---------------------------------------------------------------------------
+//	ミップマップ数取得.
+//---------------------------------------------------------------------------
+u32 StreamingTexture::GetMipCount() const
+{
+	return _mipCount;
+}
+
+//---------------------------------------------------------------------------
+//	コンストラクタ.
+//---------------------------------------------------------------------------
+TextureStreamer::TextureStreamer()
+	: _initialized( false )
+	, _device( nullptr )
+	, _frame( 0 )
+	, _residentBytes( 0 )
+	, _evictingBytes( 0 )
+	, _loadingCount( 0 )
+{
+}
+
+//---------------------------------------------------------------------------
+//	デストラクタ.
+//---------------------------------------------------------------------------
+TextureStreamer::~TextureStreamer()
+{
+	Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	初期化.
+//---------------------------------------------------------------------------
+void TextureStreamer::Initialize( Device* device, const Desc& desc )
+{
+	if( _initialized )
+	{
+		AROMA_ASSERT( false, _T( "Already initialized.\n" ) );
+		Finalize();
+	}
+
+	_device = device;
+	_device->AddRef();
+	_desc = desc;
+	_desc.mipTailSize	= Max( _desc.mipTailSize, 1ui32 );
+	_desc.maxLoadCount	= Max( _desc.maxLoadCount, 1ui32 );
+	_frame				= 0;
+	_residentBytes		= 0;
+	_evictingBytes		= 0;
+	_loadingCount		= 0;
+	_stats.Default();
+
+	_initialized = true;
+}
+
+//---------------------------------------------------------------------------
+//	解放.
+//---------------------------------------------------------------------------
+void TextureStreamer::Finalize()
+{
+	if( !_initialized ) return;
+
+	// 読み込み中のテクスチャの完了を待つ.
+	{
+		std::unique_lock< std::mutex > lock( _resultMutex );
+		_resultCondition.wait( lock, [ this ]{ return _loadResults.size() == _loadingCount; } );
+	}
+	ApplyLoadResults();
+
+	while( !_textures.empty() )
+	{
+		Unregister( _textures.back() );
+	}
+	ReleaseRetiredViews( true );
+
+	memory::SafeRelease( _device );
+	_desc.Default();
+	_stats.Default();
+	_initialized = false;
+}
+
+//---------------------------------------------------------------------------
+//	テクスチャ登録.
+//---------------------------------------------------------------------------
+StreamingTexture* TextureStreamer::Register( const data::DDSAccessor& dds )
+{
+	if( !_initialized )
+	{
+		AROMA_ASSERT( false, _T( "Not initialized.\n" ) );
+		return nullptr;
+	}
+	if( !dds.IsValid() || dds.IsCubeMap() || dds.IsVolumeTexture() || dds.GetMipMapCount() == 0 )
+	{
+		AROMA_ASSERT( false, _T( "Unsupported DDS data.\n" ) );
+		return nullptr;
+	}
+	if( dds.GetPixelFormat() == data::PixelFormat::kUnknown )
+	{
+		// ミップ毎に変換し直さないよう, 旧形式は登録前に変換しておく.
+		AROMA_ASSERT( false, _T( "Convert legacy DDS with data::ConvertLegacyDDS() before registering.\n" ) );
+		return nullptr;
+	}
+
+	StreamingTexture* texture = new StreamingTexture();
+	texture->_dds		= dds;
+	texture->_mipCount	= dds.GetMipMapCount();
+
+	// 幅, 高さがmipTailSize以下になる最初のミップまでを常駐させる.
+	u32 tailMip = 0;
+	while( tailMip + 1 < texture->_mipCount && Max( dds.GetWidth() >> tailMip, dds.GetHeight() >> tailMip ) > _desc.mipTailSize )
+	{
+		++tailMip;
+	}
+	texture->_tailMip = ClampToValidMip( texture, tailMip );
+
+	TextureView* view = CreateView( texture, texture->_tailMip );
+	if( view == nullptr )
+	{
+		memory::SafeRelease( texture );
+		return nullptr;
+	}
+
+	texture->_view			= view;
+	texture->_residentMip	= texture->_tailMip;
+	texture->_desiredMip	= texture->_tailMip;
+	texture->_lastUsedFrame	= _frame;
+	texture->_residentBytes	= CalcResidentBytes( texture, texture->_tailMip );
+	texture->_registered	= true;
+	_residentBytes += texture->_residentBytes;
+	_textures.push_back( texture );
+	return texture;
+}
+
+//---------------------------------------------------------------------------
+//	テクスチャ登録解除.
+//---------------------------------------------------------------------------
+void TextureStreamer::Unregister( StreamingTexture* texture )
+{
+	if( texture == nullptr ) return;
+
+	auto it = std::find( _textures.begin(), _textures.end(), texture );
+	if( it == _textures.end() )
+	{
+		AROMA_ASSERT( false, _T( "Texture is not registered.\n" ) );
+		return;
+	}
+	*it = _textures.back();
+	_textures.pop_back();
+
+	// 現在のビューは解放待ちに, 読み込み中のビューは完了時に破棄するため, 共に解放予定とする.
+	// 読み込み中の場合は現在のビューは読み込み開始時に解放予定に含めている.
+	if( texture->_loadingMip == kNoRequest )
+	{
+		_evictingBytes += texture->_residentBytes;
+	}
+	_evictingBytes			+= texture->_loadingBytes;
+	texture->_registered	= false;
+
+	// 描画中のフレームが参照している可能性があるため, ビューは解放待ちにする.
+	TextureView* view = texture->_view.exchange( nullptr, std::memory_order_acq_rel );
+	if( view )
+	{
+		_retiredViews.push_back( RetiredView{ view, _frame, texture->_residentBytes } );
+	}
+	texture->_residentBytes	= 0;
+
+	// 読み込み中の場合は読み込み完了時に解放される.
+	texture->Release();
+}
+
+//---------------------------------------------------------------------------
+//	更新.
+//---------------------------------------------------------------------------
+void TextureStreamer::Update()
+{
+	if( !_initialized ) return;
+
+	++_frame;
+	_stats.streamInCount	= 0;
+	_stats.evictCount		= 0;
+
+	ApplyLoadResults();
+	ReleaseRetiredViews( false );
+
+	// 今フレームの要求を集計.
+	std::vector< StreamingTexture* > streamIn;
+	std::vector< StreamingTexture* > victims;
+	for( StreamingTexture* texture : _textures )
+	{
+		const u32 requested = texture->_requestedMip.exchange( kNoRequest, std::memory_order_relaxed );
+		if( requested != kNoRequest )
+		{
+			texture->_desiredMip	= ClampToValidMip( texture, Min( requested, texture->_tailMip ) );
+			texture->_lastUsedFrame	= _frame;
+		}
+		if( texture->_loadingMip != kNoRequest )
+		{
+			continue;
+		}
+
+		const u32 residentMip = texture->_residentMip.load( std::memory_order_relaxed );
+		if( texture->_lastUsedFrame == _frame && texture->_desiredMip < residentMip )
+		{
+			streamIn.push_back( texture );
+		}
+
+		// 今フレーム使用していないテクスチャはミップテールまで, 使用中は要求レベルまで解放できる.
+		const u32 keepMip = ( texture->_lastUsedFrame == _frame ) ? texture->_desiredMip : texture->_tailMip;
+		if( residentMip < keepMip )
+		{
+			victims.push_back( texture );
+		}
+	}
+
+	// 解放は最後に使用したフレームが古い順.
+	std::sort( victims.begin(), victims.end(), []( const StreamingTexture* a, const StreamingTexture* b )
+	{
+		return a->_lastUsedFrame < b->_lastUsedFrame;
+	} );
+	size_t victimIndex = 0;
+
+	// 解放を1つ発行.
+	auto evictNext = [ & ]() -> bool
+	{
+		while( victimIndex < victims.size() )
+		{
+			StreamingTexture* victim = victims[ victimIndex++ ];
+			if( victim->_loadingMip != kNoRequest ) continue;
+			const u32 keepMip = ( victim->_lastUsedFrame == _frame ) ? victim->_desiredMip : victim->_tailMip;
+			StartLoad( victim, keepMip );
+			return true;
+		}
+		return false;
+	};
+
+	// 読み込みは不足しているミップ数が多い順.
+	std::sort( streamIn.begin(), streamIn.end(), []( const StreamingTexture* a, const StreamingTexture* b )
+	{
+		return ( a->_residentMip.load( std::memory_order_relaxed ) - a->_desiredMip ) > ( b->_residentMip.load( std::memory_order_relaxed ) - b->_desiredMip );
+	} );
+
+	for( StreamingTexture* texture : streamIn )
+	{
+		if( _loadingCount >= _desc.maxLoadCount )
+		{
+			break;
+		}
+		if( texture->_loadingMip != kNoRequest )
+		{
+			continue;
+		}
+
+		// バジェットに収まる最も詳細なレベルを選ぶ(不足する場合は使われていないテクスチャを解放).
+		// 入れ替えまでは現在のテクスチャも残るため, 読み込むミップ全体のメモリ量が追加で必要.
+		const u32 residentMip = texture->_residentMip.load( std::memory_order_relaxed );
+		u32 mip = texture->_desiredMip;
+		bool waitEviction = false;
+		while( mip < residentMip )
+		{
+			const u64 addBytes = CalcResidentBytes( texture, mip );
+			if( _residentBytes + addBytes <= _desc.memoryBudget )
+			{
+				break;
+			}
+			if( _residentBytes - _evictingBytes + addBytes <= _desc.memoryBudget )
+			{
+				// 解放の完了を待ってから読み込む.
+				waitEviction = true;
+				break;
+			}
+			if( !evictNext() )
+			{
+				// 解放できるテクスチャが無い場合は詳細度を1段下げる.
+				do
+				{
+					++mip;
+				} while( mip < residentMip && ClampToValidMip( texture, mip ) != mip );
+			}
+		}
+		if( !waitEviction && mip < residentMip )
+		{
+			StartLoad( texture, mip );
+		}
+	}
+
+	// バジェットを縮小した場合等, 解放予定分を除いても超過している分を解放.
+	// 使用中のテクスチャしか残っていない場合はメモリ量の大きいものから詳細度を1段下げる.
+	while( _residentBytes - _evictingBytes > _desc.memoryBudget )
+	{
+		if( evictNext() )
+		{
+			continue;
+		}
+
+		StreamingTexture* largest = nullptr;
+		for( StreamingTexture* texture : _textures )
+		{
+			if( texture->_loadingMip == kNoRequest && texture->_residentMip.load( std::memory_order_relaxed ) < texture->_tailMip &&
+				( largest == nullptr || texture->_residentBytes > largest->_residentBytes ) )
+			{
+				largest = texture;
+			}
+		}
+		if( largest == nullptr )
+		{
+			break;
+		}
+
+		u32 mip = largest->_residentMip.load( std::memory_order_relaxed );
+		do
+		{
+			++mip;
+		} while( mip < largest->_tailMip && ClampToValidMip( largest, mip ) != mip );
+		StartLoad( largest, mip );
+	}
+}
+
+//---------------------------------------------------------------------------
+//	メモリバジェット設定.
+//---------------------------------------------------------------------------
+void TextureStreamer::SetMemoryBudget( u64 memoryBudget )
+{
+	_desc.memoryBudget = memoryBudget;
+}
+
+//---------------------------------------------------------------------------
+//	統計情報取得.
+//---------------------------------------------------------------------------
+void TextureStreamer::GetStats( Stats* outStats ) const
+{
+	AROMA_ASSERT( outStats, _T( "outStats is null.\n" ) );
+
+	*outStats = _stats;
+	outStats->residentBytes	= _residentBytes;
+	outStats->memoryBudget	= _desc.memoryBudget;
+	outStats->textureCount	= static_cast< u32 >( _textures.size() );
+	outStats->loadingCount	= _loadingCount;
+}
+
+//---------------------------------------------------------------------------
+//	指定ミップ以降のテクスチャとビューを作成.
+//---------------------------------------------------------------------------
+TextureView* TextureStreamer::CreateView( const StreamingTexture* texture, u32 mip )
+{
+	Texture* nativeTexture = _device->CreateTexture2DFromDDS( texture->_dds, Usage::kImmutable, kBindFlagShaderResource, 0, mip );
+	if( nativeTexture == nullptr )
+	{
+		return nullptr;
+	}
+
+	TextureView::Desc viewDesc;
+	viewDesc.texture = nativeTexture;
+	TextureView* view = new TextureView();
+	view->Initialize( _device, viewDesc );
+
+	// テクスチャはビューが参照を保持する.
+	nativeTexture->Release();
+	return view;
+}
+
+//---------------------------------------------------------------------------
+//	指定ミップ以降を常駐させるメモリ量.
+//---------------------------------------------------------------------------
+u64 TextureStreamer::CalcResidentBytes( const StreamingTexture* texture, u32 mip )
+{
+	const data::PixelFormat format = texture->_dds.GetPixelFormat();
+	u64 bytes = 0;
+	for( u32 i = mip; i < texture->_mipCount; ++i )
+	{
+		data::SurfaceInfo info;
+		data::CalcSurfaceInfo( &info, Max( 1ui32, texture->_dds.GetWidth() >> i ), Max( 1ui32, texture->_dds.GetHeight() >> i ), format );
+		bytes += info.bytes;
+	}
+	return bytes * texture->_dds.GetArrayCount();
+}
+
+//---------------------------------------------------------------------------
+//	テクスチャの先頭にできるミップレベルに補正.
+//---------------------------------------------------------------------------
+u32 TextureStreamer::ClampToValidMip( const StreamingTexture* texture, u32 mip )
+{
+	// 圧縮フォーマットは先頭ミップの幅, 高さがブロックサイズの倍数である必要がある.
+	data::ImageSize blockSize;
+	data::GetPixelBlockSize( &blockSize, texture->_dds.GetPixelFormat() );
+
+	mip = Min( mip, texture->_mipCount - 1 );
+	while( mip > 0 )
+	{
+		const u32 width		= Max( 1ui32, texture->_dds.GetWidth() >> mip );
+		const u32 height	= Max( 1ui32, texture->_dds.GetHeight() >> mip );
+		if( width % blockSize.width == 0 && height % blockSize.height == 0 )
+		{
+			break;
+		}
+		--mip;
+	}
+	return mip;
+}
+
+//---------------------------------------------------------------------------
+//	読み込み(解放)を発行.
+//---------------------------------------------------------------------------
+void TextureStreamer::StartLoad( StreamingTexture* texture, u32 mip )
+{
+	const u32 residentMip	= texture->_residentMip.load( std::memory_order_relaxed );
+	const u64 bytes			= CalcResidentBytes( texture, mip );
+
+	// 読み込み(解放でも小さいテクスチャを作成する)は開始時点でメモリ量に加え,
+	// 入れ替え前のビューは解放待ちを経て解放されるまでメモリ量に残す.
+	if( mip < residentMip )
+	{
+		++_stats.streamInCount;
+	}
+	else
+	{
+		++_stats.evictCount;
+	}
+	_residentBytes			+= bytes;
+	_evictingBytes			+= texture->_residentBytes;
+	texture->_loadingBytes	= bytes;
+	texture->_loadingMip	= mip;
+	++_loadingCount;
+
+	// 完了を反映するまでテクスチャを保持する.
+	texture->AddRef();
+	auto job = [ this, texture, mip ]()
+	{
+		TextureView* view = CreateView( texture, mip );
+		{
+			std::lock_guard< std::mutex > lock( _resultMutex );
+			_loadResults.push_back( LoadResult{ texture, view, mip } );
+		}
+		_resultCondition.notify_all();
+	};
+
+	if( _desc.scheduler )
+	{
+		_desc.scheduler->Schedule( std::move( job ) );
+	}
+	else
+	{
+		job();
+	}
+}
+
+//---------------------------------------------------------------------------
+//	完了した読み込みを反映.
+//---------------------------------------------------------------------------
+void TextureStreamer::ApplyLoadResults()
+{
+	std::vector< LoadResult > results;
+	{
+		std::lock_guard< std::mutex > lock( _resultMutex );
+		results.swap( _loadResults );
+	}
+
+	for( LoadResult& result : results )
+	{
+		StreamingTexture* texture = result.texture;
+		const u64 bytes = texture->_loadingBytes;
+		--_loadingCount;
+		texture->_loadingMip	= kNoRequest;
+		texture->_loadingBytes	= 0;
+
+		if( !texture->_registered )
+		{
+			// 読み込み中に登録解除された(登録解除時に解放予定に含めている).
+			memory::SafeRelease( result.view );
+			_residentBytes -= bytes;
+			_evictingBytes -= bytes;
+			texture->Release();
+			continue;
+		}
+
+		if( result.view )
+		{
+			// 入れ替え前のビューは解放待ちになり, 解放予定のまま残る.
+			SwapView( texture, result.view, result.mip, texture->_residentBytes );
+			texture->_residentBytes = bytes;
+		}
+		else
+		{
+			// 作成に失敗した場合は現在のミップのまま.
+			AROMA_ASSERT( false, _T( "Failed to create streaming texture.\n" ) );
+			_residentBytes -= bytes;
+			_evictingBytes -= texture->_residentBytes;
+		}
+		texture->Release();
+	}
+}
+
+//---------------------------------------------------------------------------
+//	ビューを入れ替えて古いビューを解放待ちにする.
+//---------------------------------------------------------------------------
+void TextureStreamer::SwapView( StreamingTexture* texture, TextureView* view, u32 mip, u64 bytes )
+{
+	TextureView* oldView = texture->_view.exchange( view, std::memory_order_acq_rel );
+	texture->_residentMip.store( mip, std::memory_order_release );
+	if( oldView )
+	{
+		_retiredViews.push_back( RetiredView{ oldView, _frame, bytes } );
+	}
+}
+
+//---------------------------------------------------------------------------
+//	解放待ちのビューを解放.
+//---------------------------------------------------------------------------
+void TextureStreamer::ReleaseRetiredViews( bool releaseAll )
+{
+	auto it = std::remove_if( _retiredViews.begin(), _retiredViews.end(), [ this, releaseAll ]( RetiredView& retired )
+	{
+		if( !releaseAll && _frame - retired.frame < _desc.retireFrameCount )
+		{
+			return false;
+		}
+		memory::SafeRelease( retired.view );
+		_residentBytes -= retired.bytes;
+		_evictingBytes -= retired.bytes;
+		return true;
+	} );
+	_retiredViews.erase( it, _retiredViews.end() );
+}
+
+} // namespace render
+} // namespace aroma
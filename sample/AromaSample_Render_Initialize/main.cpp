@@ -21,6 +21,7 @@ namespace
 	const data::ImageSize		kSampleScreenSize( 1280, 720 );
 	constexpr u32				kSwapChainBufferNum	= 3;
 	constexpr u32				kBufferingCount = 2;
+	const TChar*				kRenderStateCachePath = _T( "RenderStateCache.bin" );
 
 	//! CPUメモリアロケーター.
 	class SampleCpuAllocator : public memory::IAllocator
@@ -126,13 +127,13 @@ namespace
 	u32							g_bufferingIndex	= 0;
 	render::Device*				g_device			= nullptr;
 	render::SwapChain*			g_swapChain			= nullptr;
-	render::DeferredContext*	g_context			= nullptr;
+	render::ParallelCommandRecorder*	g_recorder	= nullptr;
 	render::Shader*				g_vertexShader		= nullptr;
 	render::Shader*				g_pixelShader		= nullptr;
 	render::InputLayout*		g_inputLayout		= nullptr;
+	render::PipelineState*		g_spritePipelineState	= nullptr;
 	render::Buffer*				g_indexBuffer		= nullptr;
 	render::RenderTargetView*	g_backBufferView[ kSwapChainBufferNum ] = {};
-	render::Buffer*				g_constBuffer[ kBufferingCount ] = {};
 	f32							g_mipLevel			= 0.0f;
 	data::Color					g_bgColor			= { 1.0f, 1.0f, 1.0f, 1.0f };
 	
@@ -144,6 +145,7 @@ namespace
 
 	void Update( u32 frame );
 	void Draw();
+	void SetupPass( render::DeferredContext* context );
 	void DrawSprite( render::DeferredContext* context, Sprite* sprite );
 	void CreateSprite( Sprite** outSprite, CTStr ddsPath );
 
@@ -212,6 +214,9 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 	{
 		g_device = new render::Device();
 		g_device->Initialize();
+
+		// 前回起動時に使用したレンダーステートを事前生成.
+		g_device->GetRenderStateCache()->PrewarmFromFile( kRenderStateCachePath );
 	}
 
 	// スワップチェイン.
@@ -229,10 +234,11 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 		}
 	}
 
-	// 遅延コンテキスト.
+	// マルチスレッドコマンド記録(画面クリア + スプライト毎に1スレッド).
 	{
-		render::DeferredContext::Desc desc;
-		g_context = g_device->CreateDeferredContext( desc );
+		render::ParallelCommandRecorder::Desc desc;
+		desc.threadCount = 1 + ( u32 )SampleSprite::kNum;
+		g_recorder = g_device->CreateParallelCommandRecorder( desc );
 	}
 
 	// インデックスバッファ.
@@ -249,14 +255,6 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 			render::IndexType::k32, 0 );
 	}
 
-	// 定数バッファ.
-	for( u32 i = 0; i < kBufferingCount; ++i )
-	{
-		g_constBuffer[ i ] = g_device->CreateConstantBuffer(
-			sizeof( PSConstantBuffer ), render::Usage::kDynamic, nullptr,
-			sizeof( PSConstantBuffer ), 0 );
-	}
-
 	// 頂点シェーダー.
 	g_vertexShader	= g_device->CreateVertexShader( VsSimple::g_main, sizeof( VsSimple::g_main ) );
 
@@ -287,6 +285,34 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 		g_inputLayout		= g_device->CreateInputLayout( desc );
 	}
 
+	// スプライト描画用パイプラインステート.
+	{
+		render::PipelineState::Desc desc;
+		desc.vertexShader		= g_vertexShader;
+		desc.pixelShader		= g_pixelShader;
+		desc.inputLayout		= g_inputLayout;
+		desc.primitiveType		= render::PrimitiveType::kTriangleStrip;
+
+		// ブレンドステート.
+		desc.blendState.blendEnable		= true;
+		desc.blendState.rgbSource		= render::Blend::kSrcAlp;
+		desc.blendState.rgbDest			= render::Blend::kInvSrcAlp;
+		desc.blendState.alphaSource		= render::Blend::kSrcAlp;
+		desc.blendState.alphaDest		= render::Blend::kInvSrcAlp;
+
+		// ラスタライザーステート.
+		desc.rasterizerState.fillMode				= render::FillMode::kSolid;
+		desc.rasterizerState.cullMode				= render::CullMode::kNone;
+		desc.rasterizerState.frontCounterClockwise	= true;
+		desc.rasterizerState.depthClipEnable		= true;
+		desc.rasterizerState.scissorEnable			= false;
+
+		// 深度ステンシルステート.
+		desc.depthStencilState.depthEnable	= false;
+
+		g_spritePipelineState = g_device->CreatePipelineState( desc );
+	}
+
 	// スプライト.
 	{
 		// DirectX11logo
@@ -315,6 +341,7 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 	}
 
 	u32 frame = 0;
+	u64 prevDrawCount = 0;
 	g_updateFunc = UpdateInitialize;
 
     while( true )
@@ -333,27 +360,49 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLin
 		// 描画.
 		Draw();
 
+		// レンダーステートキャッシュのフレーム統計.
+		render::RenderStateCache::Stats stateStats;
+		g_device->GetRenderStateCacheStats( &stateStats, true );
+		for( u32 i = 0; i < static_cast< u32 >( render::RenderStateCache::StateType::kNum ); ++i )
+		{
+			const auto& stats = stateStats.type[ i ];
+			if( stats.missCount > 0 )
+			{
+				AROMA_DEBUG_OUT( "RenderStateCache[%u] miss = %llu / %llu, count = %u (peak %u / %u)\n",
+					i, stats.missCount, stats.lookupCount, stats.currentCount, stats.peakCount, stats.capacity );
+			}
+		}
+
+		// 描画コマンドのフレーム統計.
+		// 描画数が前フレームより増えた場合に出力.
+		render::CommandStats frameStats;
+		g_device->GetFrameStats( &frameStats, true );
+		if( frameStats.GetTotalDrawCount() > prevDrawCount )
+		{
+			AROMA_DEBUG_OUT( "Draw count increased: %llu -> %llu (state change = %llu, native bind = %llu, command list = %llu)\n",
+				prevDrawCount, frameStats.GetTotalDrawCount(), frameStats.GetTotalChangeCount(), frameStats.GetTotalBindCount(), frameStats.commandListCount );
+		}
+		prevDrawCount = frameStats.GetTotalDrawCount();
+
 		frame++;
 	}
 
 	// 終了.
+	g_device->GetRenderStateCache()->SaveToFile( kRenderStateCachePath );
 	for( u32 i = 0; i < ( u32 )SampleSprite::kNum; ++i )
 	{
 		memory::SafeDelete( g_sprite[ i ] );
 	}
+	memory::SafeRelease( g_spritePipelineState );
 	memory::SafeRelease( g_inputLayout );
 	memory::SafeRelease( g_vertexShader );
 	memory::SafeRelease( g_pixelShader );
-	for( u32 i = 0; i < kBufferingCount; ++i )
-	{
-		memory::SafeRelease( g_constBuffer[ i ] );
-	}
 	memory::SafeRelease( g_indexBuffer );
 	for( u32 i = 0; i < AROMA_ARRAY_OF( g_backBufferView ); ++i )
 	{
 		memory::SafeRelease( g_backBufferView[ i ] );
 	}
-	memory::SafeRelease( g_context );
+	memory::SafeRelease( g_recorder );
 	memory::SafeRelease( g_swapChain );
 	memory::SafeRelease( g_device );
 	render::Finalize();
@@ -533,58 +582,33 @@ void UpdateDoudesukaShake()
 
 void Draw()
 {
-	// 描画コマンド作成.
-	g_context->Begin();
+	// 記録タスク作成.
+	render::ParallelCommandRecorder::RecordFunc tasks[ 1 + ( u32 )SampleSprite::kNum ];
+	u32 taskCount = 0;
+
+	// 画面クリア.
+	tasks[ taskCount++ ] = []( render::DeferredContext* context, u32 )
 	{
 		auto currentBackBuffer = g_backBufferView[ g_swapChain->GetCurrentBufferIndex() ];
+		SetupPass( context );
+		context->ClearRenderTarget( currentBackBuffer, g_bgColor );
+	};
 
-		// ビューポート.
-		render::Viewport viewport;
-		viewport.x			= 0.0f;
-		viewport.y			= 0.0f;
-		viewport.w			= static_cast< f32 >( kSampleScreenSize.width );
-		viewport.h			= static_cast< f32 >( kSampleScreenSize.height );
-		viewport.minDepth	= 0.0f;
-		viewport.maxDepth	= 1.0f;
-		g_context->RSSetViewportScissorStateViewport( 0, viewport );
-
-		// シザー.
-		render::ScissorRect scissor;
-		scissor.x = 0;
-		scissor.y = 0;
-		scissor.w = kSampleScreenSize.width;
-		scissor.h = kSampleScreenSize.height;
-		g_context->RSSetViewportScissorStateScissor( 0, scissor );
-			
-		// レンダーターゲット設定.
-		g_context->OMSetRenderTargets( 1, &currentBackBuffer, nullptr );
-			
-		// 画面クリア.
-		g_context->ClearRenderTarget( currentBackBuffer, g_bgColor );
-
-		// PSステージ : 定数バッファ更新.
-		void* mapped = g_constBuffer[ g_bufferingIndex ]->Map();
-		{
-			PSConstantBuffer constBuf;
-			constBuf.mip = g_mipLevel;
-			memcpy( mapped, &constBuf, sizeof( PSConstantBuffer ) );
-		}
-		g_constBuffer[ g_bufferingIndex ]->Unmap();
-		g_context->PSSetConstantBuffer( 0, g_constBuffer[ g_bufferingIndex ] );
+	// スプライト描画(スプライト毎に別スレッドで記録).
+	for( auto& sprite : g_sprite )
+	{
+		if( !sprite || !sprite->visible ) continue;
 
-		// スプライト描画.
-		for( auto& sprite : g_sprite )
+		Sprite* target = sprite;
+		tasks[ taskCount++ ] = [ target ]( render::DeferredContext* context, u32 )
 		{
-			if( !sprite ) continue;
-			if( sprite->visible ) DrawSprite( g_context, sprite );
-		}
+			SetupPass( context );
+			DrawSprite( context, target );
+		};
 	}
-	render::CommandList* commandList;
-	g_context->End( &commandList );
 
-	// 描画コマンド実行.
-	g_device->ExecuteCommand( commandList );
-	memory::SafeRelease( commandList );
+	// 並列記録して配列順に実行.
+	g_recorder->Execute( taskCount, tasks );
 
 	// 画面に出力.
 	g_swapChain->Present( 1 );
@@ -593,51 +617,46 @@ void Draw()
 	g_bufferingIndex = ( g_bufferingIndex + 1 ) % kBufferingCount;
 }
 
-void DrawSprite( render::DeferredContext* context, Sprite* sprite )
+void SetupPass( render::DeferredContext* context )
 {
-	// ブレンドステート.
-	context->OMSetBlendStateSampleAlphaToCoverage( false );
-	context->OMSetBlendStateBlendEnable( true );
-	context->OMSetBlendStateRGBSource( render::Blend::kSrcAlp );
-	context->OMSetBlendStateRGBDest( render::Blend::kInvSrcAlp );
-	context->OMSetBlendStateRGBBlendOp( render::BlendOp::kAdd );
-	context->OMSetBlendStateAlphaSource( render::Blend::kSrcAlp );
-	context->OMSetBlendStateAlphaDest( render::Blend::kInvSrcAlp );
-	context->OMSetBlendStateAlphaBlendOp( render::BlendOp::kAdd );
-	context->OMSetBlendStateWriteMaskR( true );
-	context->OMSetBlendStateWriteMaskG( true );
-	context->OMSetBlendStateWriteMaskB( true );
-	context->OMSetBlendStateWriteMaskA( true );
-
-	// ラスタライザーステート.
-	context->RSSetRasterizerStateFillMode( render::FillMode::kSolid );
-	context->RSSetRasterizerStateCullMode( render::CullMode::kNone );
-	context->RSSetRasterizerStateFrontCounterClockwise( true );
-	context->RSSetRasterizerStateDepthBias( 0 );
-	context->RSSetRasterizerStateDepthBiasClamp( 0.f );
-	context->RSSetRasterizerStateSlopeScaledDepthBias( 0.f );
-	context->RSSetRasterizerStateDepthClipEnable( true );
-	context->RSSetRasterizerStateScissorEnable( false );
-	context->RSSetRasterizerStateMultisampleEnable( false );
-	context->RSSetRasterizerStateAntialiasedLineEnable( false );
-
-	// 深度ステンシルステート.
-	context->OMSetDepthStencilStateDepthEnable( false );
+	auto currentBackBuffer = g_backBufferView[ g_swapChain->GetCurrentBufferIndex() ];
+
+	// ビューポート.
+	render::Viewport viewport;
+	viewport.x			= 0.0f;
+	viewport.y			= 0.0f;
+	viewport.w			= static_cast< f32 >( kSampleScreenSize.width );
+	viewport.h			= static_cast< f32 >( kSampleScreenSize.height );
+	viewport.minDepth	= 0.0f;
+	viewport.maxDepth	= 1.0f;
+	context->RSSetViewportScissorStateViewport( 0, viewport );
+
+	// シザー.
+	render::ScissorRect scissor;
+	scissor.x = 0;
+	scissor.y = 0;
+	scissor.w = kSampleScreenSize.width;
+	scissor.h = kSampleScreenSize.height;
+	context->RSSetViewportScissorStateScissor( 0, scissor );
+
+	// レンダーターゲット設定.
+	context->OMSetRenderTargets( 1, &currentBackBuffer, nullptr );
+
+	// PSステージ : 定数(コンテキストの共有バッファに書き込まれる).
+	PSConstantBuffer constBuf;
+	constBuf.mip = g_mipLevel;
+	context->PSSetConstants( 0, &constBuf, sizeof( PSConstantBuffer ) );
+}
 
+void DrawSprite( render::DeferredContext* context, Sprite* sprite )
+{
 	// ポリゴン描画.
 	{
-		// シェーダー設定.
-		context->VSSetShader( g_vertexShader );
-		context->PSSetShader( g_pixelShader );
-
-		// 入力レイアウト設定.
-		context->IASetInputLayout( g_inputLayout );
-
-		// プリミティブタイプ設定.
-		context->IASetPrimitiveType( render::PrimitiveType::kTriangleStrip );
+		// シェーダー, 入力レイアウト, プリミティブタイプ, 各ステートを一括設定.
+		context->SetPipelineState( g_spritePipelineState );
 
 		// 頂点バッファ設定.
-		void* mapped = sprite->vtxBuffer[ g_bufferingIndex ]->Map();
+		void* mapped = context->Map( sprite->vtxBuffer[ g_bufferingIndex ] );
 		{
 			Vertex vtx[ 4 ] =
 			{
@@ -648,7 +667,7 @@ void DrawSprite( render::DeferredContext* context, Sprite* sprite )
 			};
 			memcpy( mapped, vtx, sizeof( vtx ) );
 		}
-		sprite->vtxBuffer[ g_bufferingIndex ]->Unmap();
+		context->Unmap( sprite->vtxBuffer[ g_bufferingIndex ] );
 		context->IASetVertexBuffer( 0, sprite->vtxBuffer[ g_bufferingIndex ], sizeof( Vertex ), 0 );
 
 		// テクスチャ設定.
@@ -670,23 +689,14 @@ void CreateSprite( Sprite** outSprite, CTStr ddsPath )
 {
 	*outSprite = new Sprite;
 	{
-		// DDSテクスチャファイル読み込み.
-		file::File* ddsFile	= new file::File;
-		void*	ddsBuf		= nullptr;
-		size_t	ddsBufSize	= 0;
-
-		bool result = ddsFile->Open( ddsPath, file::kOpenModeFlagRead, file::kShareFlagRead );
+		// DDSテクスチャファイルをマップ.
+		file::MappedFile ddsFile;
+		bool result = ddsFile.Open( ddsPath, file::kMapHintFlagSequential );
 		AROMA_ASSERT( result, _T( "Failed to file open.\n" ) );
-		result = ddsFile->GetFileSize( &ddsBufSize );
-		AROMA_ASSERT( result, _T( "Failed to GetFileSize.\n" ) );
-		ddsBuf = s_sampleCpuMemAllocator.Alloc( ddsBufSize, 1 );
-		result = ddsFile->ReadFile( ddsBuf, ddsBufSize, nullptr );
-		AROMA_ASSERT( result, _T( "Failed to ReadFile.\n" ) );
-		memory::SafeDelete( ddsFile );
-
-		// DDSからテクスチャリソース作成.
-		(*outSprite)->tex = g_device->CreateTexture2DFromDDS( data::DDSAccessor( ddsBuf ), render::Usage::kImmutable, render::kBindFlagShaderResource, 0 );
-		s_sampleCpuMemAllocator.Free( ddsBuf );
+
+		// DDSからテクスチャリソース作成(マップ先から直接作成).
+		(*outSprite)->tex = g_device->CreateTexture2DFromDDS( data::DDSAccessor( ddsFile.GetData(), ddsFile.GetSize() ), render::Usage::kImmutable, render::kBindFlagShaderResource, 0 );
+		ddsFile.Close();
 		{
 			render::TextureView::Desc	desc;
 			desc.texture	= (*outSprite)->tex;
@@ -0,0 +1,221 @@
+﻿//===========================================================================
+//!
+//!	@file		ArchiveTest.cpp
+//!	@brief		パックアーカイブのラウンドトリップテスト.
+//!
+//!	@details
+//!		ArchiveBuilderで書き出したアーカイブをArchiveReaderで読み込み,
+//!		空のアーカイブ, サイズ0のエントリ, 圧縮エントリを含めて元のデータと一致することを確認します.
+//!		空きバケットの無い不正なハッシュテーブルで検索が停止することも確認します.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <aroma/common/Scheduler.h>
+#include <aroma/data/CRC.h>
+#include <aroma/file/ArchiveBuilder.h>
+#include <aroma/file/ArchiveReader.h>
+#include <aroma/file/FileIO.h>
+
+using namespace aroma;
+using namespace aroma::file;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	検証失敗時に出力して失敗数を数える.
+//---------------------------------------------------------------------------
+std::atomic< u32 > g_failureCount( 0 );
+
+#define TEST_CHECK( exp )																\
+	do {																				\
+		if( !( exp ) )																	\
+		{																				\
+			fprintf( stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp );	\
+			++g_failureCount;															\
+		}																				\
+	} while( 0 )
+
+//! テストで作成するファイル(カレントディレクトリに作成し, 終了時に削除する).
+const TChar* const kArchivePath		= _T( "ArchiveTest.arpk" );
+const TChar* const kSourcePath		= _T( "ArchiveTest.src" );
+const TChar* const kEmptySourcePath	= _T( "ArchiveTest.empty" );
+
+//---------------------------------------------------------------------------
+//	テストデータ生成.
+//---------------------------------------------------------------------------
+std::vector< u8 > MakeData( size_t size, u32 seed )
+{
+	std::vector< u8 > data( size );
+	u32 state = seed;
+	for( size_t i = 0; i < size; ++i )
+	{
+		state = state * 1664525u + 1013904223u;
+		data[ i ] = ( i % 3 == 0 ) ? static_cast< u8 >( state >> 24 ) : static_cast< u8 >( i / 64 );
+	}
+	return data;
+}
+
+//---------------------------------------------------------------------------
+//	ファイル書き込み.
+//---------------------------------------------------------------------------
+bool WriteFileData( CTStr filePath, const std::vector< u8 >& data )
+{
+	File file;
+	if( !file.Open( filePath, kOpenModeFlagWrite | kOpenModeFlagTruncate, 0 ) ) return false;
+	return data.empty() || file.WriteFile( data.data(), data.size() );
+}
+
+//---------------------------------------------------------------------------
+//	エントリを展開して比較.
+//---------------------------------------------------------------------------
+bool ExtractAndCompare( const ArchiveReader& reader, CTStr path, const std::vector< u8 >& expected, IScheduler* scheduler )
+{
+	const ArchiveEntry* entry = reader.Find( path );
+	if( entry == nullptr || !reader.Verify( entry ) || reader.GetEntryOriginalSize( entry ) != expected.size() )
+	{
+		return false;
+	}
+	if( ( reinterpret_cast< uintptr >( reader.GetEntryData( entry ) ) & ( kArchiveAlignment - 1 ) ) != 0 )
+	{
+		return false;
+	}
+
+	std::vector< u8 > extracted( expected.size() );
+	return reader.ExtractEntry( entry, extracted.data(), extracted.size(), scheduler ) && extracted == expected;
+}
+
+//---------------------------------------------------------------------------
+//	空のアーカイブ.
+//---------------------------------------------------------------------------
+void TestEmptyArchive()
+{
+	ArchiveBuilder builder;
+	TEST_CHECK( builder.WriteToFile( kArchivePath ) );
+
+	ArchiveReader reader;
+	TEST_CHECK( reader.Open( kArchivePath ) );
+	TEST_CHECK( reader.GetEntryCount() == 0 );
+	TEST_CHECK( reader.Find( _T( "missing" ) ) == nullptr );
+}
+
+//---------------------------------------------------------------------------
+//	各種エントリのラウンドトリップ.
+//---------------------------------------------------------------------------
+void TestRoundTrip()
+{
+	const std::vector< u8 > empty;
+	const std::vector< u8 > small		= MakeData( 100, 1 );
+	const std::vector< u8 > large		= MakeData( 300000, 2 );
+	const std::vector< u8 > compressed	= MakeData( 700000, 3 );
+	const std::vector< u8 > fromFile	= MakeData( 5000, 4 );
+	TEST_CHECK( WriteFileData( kSourcePath, fromFile ) );
+	TEST_CHECK( WriteFileData( kEmptySourcePath, empty ) );
+
+	ArchiveBuilder builder;
+	TEST_CHECK( builder.AddEntry( _T( "empty.bin" ), nullptr, 0 ) );
+	TEST_CHECK( builder.AddEntry( _T( "empty_compressed.bin" ), nullptr, 0, kArchiveEntryFlagCompressed ) );
+	TEST_CHECK( builder.AddEntry( _T( "dir/small.bin" ), small.data(), small.size() ) );
+	TEST_CHECK( builder.AddEntry( _T( "dir/large.bin" ), large.data(), large.size() ) );
+	TEST_CHECK( builder.AddEntry( _T( "dir/compressed.bin" ), compressed.data(), compressed.size(), kArchiveEntryFlagCompressed ) );
+	TEST_CHECK( builder.AddFile( _T( "file.bin" ), kSourcePath ) );
+	TEST_CHECK( builder.AddFile( _T( "file_compressed.bin" ), kSourcePath, kArchiveEntryFlagCompressed ) );
+	TEST_CHECK( builder.AddFile( _T( "file_empty.bin" ), kEmptySourcePath ) );
+	TEST_CHECK( builder.GetEntryCount() == 8 );
+	TEST_CHECK( builder.WriteToFile( kArchivePath ) );
+
+	ThreadPoolScheduler scheduler;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = 2;
+	scheduler.Initialize( desc );
+
+	ArchiveReader reader;
+	TEST_CHECK( reader.Open( kArchivePath ) );
+	TEST_CHECK( reader.GetEntryCount() == 8 );
+	for( IScheduler* s : { static_cast< IScheduler* >( nullptr ), static_cast< IScheduler* >( &scheduler ) } )
+	{
+		TEST_CHECK( ExtractAndCompare( reader, _T( "empty.bin" ), empty, s ) );
+		TEST_CHECK( ExtractAndCompare( reader, _T( "empty_compressed.bin" ), empty, s ) );
+		TEST_CHECK( ExtractAndCompare( reader, _T( "dir/small.bin" ), small, s ) );
+		TEST_CHECK( ExtractAndCompare( reader, _T( "dir/large.bin" ), large, s ) );
+		TEST_CHECK( ExtractAndCompare( reader, _T( "dir/compressed.bin" ), compressed, s ) );
+		TEST_CHECK( ExtractAndCompare( reader, _T( "file.bin" ), fromFile, s ) );
+		TEST_CHECK( ExtractAndCompare( reader, _T( "file_compressed.bin" ), fromFile, s ) );
+		TEST_CHECK( ExtractAndCompare( reader, _T( "file_empty.bin" ), empty, s ) );
+	}
+
+	// パスの区切りと大文字小文字は区別しない.
+	TEST_CHECK( reader.Find( _T( "DIR\\Small.BIN" ) ) == reader.Find( _T( "dir/small.bin" ) ) );
+	TEST_CHECK( reader.Find( _T( "dir/missing.bin" ) ) == nullptr );
+
+	// 圧縮エントリは圧縮後のサイズで格納される.
+	const ArchiveEntry* entry = reader.Find( _T( "dir/compressed.bin" ) );
+	TEST_CHECK( entry && ( entry->flags & kArchiveEntryFlagCompressed ) && entry->size < compressed.size() );
+
+	reader.Close();
+	scheduler.Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	空きバケットの無いハッシュテーブルでも検索が停止する.
+//	目次のCRCを計算し直した不正なアーカイブを作成して確認する.
+//---------------------------------------------------------------------------
+void TestFullBucketTable()
+{
+	const std::vector< u8 > small = MakeData( 16, 5 );
+	ArchiveBuilder builder;
+	TEST_CHECK( builder.AddEntry( _T( "only.bin" ), small.data(), small.size() ) );
+	TEST_CHECK( builder.WriteToFile( kArchivePath ) );
+
+	std::vector< u8 > image;
+	{
+		File file;
+		size_t fileSize = 0;
+		TEST_CHECK( file.Open( kArchivePath, kOpenModeFlagRead, kShareFlagRead ) && file.GetFileSize( &fileSize ) );
+		image.resize( fileSize );
+		size_t readBytes = 0;
+		TEST_CHECK( file.ReadFile( image.data(), image.size(), &readBytes ) && readBytes == image.size() );
+	}
+
+	ArchiveHeader header;
+	memcpy( &header, image.data(), sizeof( header ) );
+	for( u32 i = 0; i < header.bucketCount; ++i )
+	{
+		const u32 index = 0;
+		memcpy( image.data() + header.bucketOffset + i * sizeof( u32 ), &index, sizeof( index ) );
+	}
+	const size_t tocBytes = header.entryCount * sizeof( ArchiveEntry ) + header.bucketCount * sizeof( u32 );
+	header.tocCRC = data::CRC::GetCRCBulk( image.data() + header.tocOffset, tocBytes );
+	memcpy( image.data(), &header, sizeof( header ) );
+	TEST_CHECK( WriteFileData( kArchivePath, image ) );
+
+	ArchiveReader reader;
+	TEST_CHECK( reader.Open( kArchivePath ) );
+	TEST_CHECK( reader.Find( _T( "only.bin" ) ) != nullptr );
+	TEST_CHECK( reader.Find( _T( "missing.bin" ) ) == nullptr );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main()
+{
+	TestEmptyArchive();
+	TestRoundTrip();
+	TestFullBucketTable();
+
+	RemoveFile( kArchivePath );
+	RemoveFile( kSourcePath );
+	RemoveFile( kEmptySourcePath );
+
+	const u32 failureCount = g_failureCount.load();
+	printf( "ArchiveTest: %s (%u failures)\n", failureCount == 0 ? "passed" : "FAILED", failureCount );
+	return failureCount == 0 ? 0 : 1;
+}
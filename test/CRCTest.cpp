@@ -0,0 +1,184 @@
+﻿//===========================================================================
+//!
+//!	@file		CRCTest.cpp
+//!	@brief		CRC32のテスト.
+//!
+//!	@details
+//!		既知のテストベクターと1ビットずつ計算する参照実装で, GetCRC()とGetCRCBulk()を確認します.
+//!		GetCRCBulk()は64バイト以上でPCLMULQDQによる畳み込み(対応CPUの場合)を使用するため,
+//!		畳み込みの各段(64バイト単位, 16バイト単位, 端数)を通る長さと先頭位置の組み合わせで確認します.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <aroma/data/CRC.h>
+
+using namespace aroma;
+using namespace aroma::data;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	検証失敗時に出力して失敗数を数える.
+//---------------------------------------------------------------------------
+std::atomic< u32 > g_failureCount( 0 );
+
+#define TEST_CHECK( exp )																\
+	do {																				\
+		if( !( exp ) )																	\
+		{																				\
+			fprintf( stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp );	\
+			++g_failureCount;															\
+		}																				\
+	} while( 0 )
+
+//---------------------------------------------------------------------------
+//	1ビットずつ計算する参照実装(最終反転なし. GetCRC()と同じ規約).
+//---------------------------------------------------------------------------
+u32 ReferenceCRC( const u8* p, size_t bytes )
+{
+	u32 crc = kCRCInitial;
+	for( size_t i = 0; i < bytes; ++i )
+	{
+		crc ^= p[ i ];
+		for( u32 bit = 0; bit < 8; ++bit )
+		{
+			crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? 0xedb88320u : 0 );
+		}
+	}
+	return crc;
+}
+
+//---------------------------------------------------------------------------
+//	テストデータ生成.
+//---------------------------------------------------------------------------
+std::vector< u8 > MakeData( size_t size, u32 seed )
+{
+	std::vector< u8 > data( size );
+	u32 state = seed;
+	for( size_t i = 0; i < size; ++i )
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		data[ i ] = static_cast< u8 >( state );
+	}
+	return data;
+}
+
+//---------------------------------------------------------------------------
+//	既知のテストベクター.
+//	一般的なCRC-32の値をビット反転した値になる(最終反転を行わないため).
+//---------------------------------------------------------------------------
+void TestKnownVectors()
+{
+	struct Vector
+	{
+		const char*		text;
+		u32				expected;
+	};
+	static const Vector kVectors[] =
+	{
+		{ "",												0xffffffffu },
+		{ "a",												0x174841bcu },
+		{ "123456789",										0x340bc6d9u },
+		{ "The quick brown fox jumps over the lazy dog",	0xbeb05cc6u },
+	};
+
+	for( const Vector& v : kVectors )
+	{
+		const size_t length = strlen( v.text );
+		TEST_CHECK( ReferenceCRC( reinterpret_cast< const u8* >( v.text ), length ) == v.expected );
+		TEST_CHECK( CRC::GetCRCBulk( v.text, length ) == v.expected );
+	}
+
+	// 畳み込みを通る長さの既知の値(0-255の繰り返し1024バイト).
+	std::vector< u8 > pattern( 1024 );
+	for( size_t i = 0; i < pattern.size(); ++i ) pattern[ i ] = static_cast< u8 >( i );
+	TEST_CHECK( CRC::GetCRCBulk( pattern.data(), pattern.size() ) == 0x48f4b3d9u );
+	TEST_CHECK( CRC::GetCRC( pattern.data(), static_cast< u32 >( pattern.size() ) ) == 0x48f4b3d9u );
+}
+
+//---------------------------------------------------------------------------
+//	GetCRCBulk()が参照実装と一致する.
+//---------------------------------------------------------------------------
+void TestBulkMatchesReference()
+{
+	const std::vector< u8 > data = MakeData( 4096 + 16, 1 );
+	for( size_t offset = 0; offset < 16; offset += 5 )
+	{
+		for( size_t length = 0; length <= 4096; length += ( length < 320 ? 1 : 61 ) )
+		{
+			const u8* p = data.data() + offset;
+			TEST_CHECK( CRC::GetCRCBulk( p, length ) == ReferenceCRC( p, length ) );
+		}
+	}
+
+	// 4バイト単位で計算するGetCRC()とも一致する(std::vectorの先頭は4バイト境界).
+	for( size_t length = 0; length <= 1024; length += 4 )
+	{
+		TEST_CHECK( CRC::GetCRC( data.data(), static_cast< u32 >( length ) ) == CRC::GetCRCBulk( data.data(), length ) );
+	}
+
+	// 大きなバッファ.
+	const std::vector< u8 > large = MakeData( 1024 * 1024 + 13, 2 );
+	TEST_CHECK( CRC::GetCRCBulk( large.data(), large.size() ) == ReferenceCRC( large.data(), large.size() ) );
+}
+
+//---------------------------------------------------------------------------
+//	分割して継続計算した結果が一括計算と一致する.
+//---------------------------------------------------------------------------
+void TestUpdateContinuation()
+{
+	const std::vector< u8 > data = MakeData( 10000, 3 );
+	const u32 expected = CRC::GetCRCBulk( data.data(), data.size() );
+
+	static const size_t kSplitSizes[] = { 1, 15, 16, 63, 64, 65, 1000, 4096 };
+	for( size_t split : kSplitSizes )
+	{
+		u32 crc = kCRCInitial;
+		for( size_t pos = 0; pos < data.size(); pos += split )
+		{
+			crc = CRC::UpdateCRCBulk( crc, data.data() + pos, data.size() - pos < split ? data.size() - pos : split );
+		}
+		TEST_CHECK( crc == expected );
+	}
+}
+
+//---------------------------------------------------------------------------
+//	速度計測(GetCRC()とGetCRCBulk()の結果の一致も確認される).
+//---------------------------------------------------------------------------
+void TestBenchmark()
+{
+	CRCBenchmarkResult results[ kCRCBenchmarkSizeCount ];
+	TEST_CHECK( CRC::Benchmark( 0, results ) );
+	for( u32 i = 0; i < kCRCBenchmarkSizeCount; ++i )
+	{
+		TEST_CHECK( results[ i ].succeeded );
+		TEST_CHECK( results[ i ].bytes == kCRCBenchmarkSizes[ i ] && results[ i ].iterations == 1 );
+		printf( "  %10llu bytes : GetCRC %8.1f MB/s, GetCRCBulk %8.1f MB/s\n",
+			static_cast< unsigned long long >( results[ i ].bytes ), results[ i ].byteWiseMBps, results[ i ].bulkMBps );
+	}
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main()
+{
+	TestKnownVectors();
+	TestBulkMatchesReference();
+	TestUpdateContinuation();
+	TestBenchmark();
+
+	const u32 failureCount = g_failureCount.load();
+	printf( "CRCTest: %s (%u failures)\n", failureCount == 0 ? "passed" : "FAILED", failureCount );
+	return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+﻿//===========================================================================
+//!
+//!	@file		ChunkedDecodeBenchmark.cpp
+//!	@brief		チャンク分割圧縮の展開速度計測.
+//!
+//!	@details
+//!		アセットに近い圧縮率のデータを生成し, 1スレッドとスレッドプールによる
+//!		並列展開の速度(MB/s)を出力します.
+//!		引数 : [データサイズ(MB)] [展開回数] [ワーカースレッド数(0で論理コア数-1)]
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <aroma/common/Scheduler.h>
+#include <aroma/data/ChunkedCompression.h>
+
+using namespace aroma;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	計測用データ生成.
+//	短い語の繰り返し, 連続した値, 乱数を混ぜて2倍程度に圧縮できるデータにする.
+//---------------------------------------------------------------------------
+void GenerateData( std::vector< u8 >* out, size_t size )
+{
+	static const char* const kWords[] = { "texture", "mesh", "vertex", "index", "material", "shader", "albedo", "normal" };
+
+	u32 state = 0x12345678u;
+	auto next = [ &state ]()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	out->clear();
+	out->reserve( size );
+	while( out->size() < size )
+	{
+		const u32 kind = next() % 4;
+		if( kind == 0 )
+		{
+			for( const char* p = kWords[ next() % 8 ]; *p; ++p ) out->push_back( static_cast< u8 >( *p ) );
+		}
+		else if( kind == 1 )
+		{
+			const u8 value = static_cast< u8 >( next() );
+			for( u32 i = next() % 32; i > 0; --i ) out->push_back( value );
+		}
+		else
+		{
+			for( u32 i = next() % 16; i > 0; --i ) out->push_back( static_cast< u8 >( next() ) );
+		}
+	}
+	out->resize( size );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main( int argc, char** argv )
+{
+	const size_t sizeMB		= argc > 1 ? static_cast< size_t >( strtoul( argv[ 1 ], nullptr, 10 ) ) : 64;
+	const u32 iterations	= argc > 2 ? static_cast< u32 >( strtoul( argv[ 2 ], nullptr, 10 ) ) : 8;
+	const u32 threadCount	= argc > 3 ? static_cast< u32 >( strtoul( argv[ 3 ], nullptr, 10 ) ) : 0;
+
+	std::vector< u8 > source;
+	GenerateData( &source, sizeMB * 1024 * 1024 );
+
+	ThreadPoolScheduler scheduler;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = threadCount;
+	scheduler.Initialize( desc );
+
+	data::ChunkedDecodeBenchmarkResult result;
+	data::BenchmarkChunkedDecode( source.data(), source.size(), &scheduler, iterations, &result );
+	const u32 workerCount = scheduler.GetThreadCount();
+	scheduler.Finalize();
+
+	printf( "ChunkedDecodeBenchmark: %llu bytes -> %llu bytes (%.1f%%), %u iterations\n",
+		static_cast< unsigned long long >( result.originalBytes ), static_cast< unsigned long long >( result.compressedBytes ),
+		result.originalBytes ? 100.0 * result.compressedBytes / result.originalBytes : 0.0, iterations );
+	printf( "  single thread : %8.1f MB/s\n", result.singleThreadMBps );
+	printf( "  parallel (%2u) : %8.1f MB/s\n", workerCount, result.multiThreadMBps );
+	printf( "  verify        : %s\n", result.succeeded ? "passed" : "FAILED" );
+	return result.succeeded ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+﻿//===========================================================================
+//!
+//!	@file		LZ4Test.cpp
+//!	@brief		LZ4とチャンク分割圧縮のラウンドトリップテスト.
+//!
+//!	@details
+//!		圧縮しやすいデータ, 乱数(圧縮できないデータ), 空のデータを圧縮して展開し,
+//!		元のデータと一致することを確認します.
+//!		切り詰め等で破損したデータは展開に失敗することも確認します.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <aroma/common/Scheduler.h>
+#include <aroma/data/ChunkedCompression.h>
+#include <aroma/data/LZ4.h>
+
+using namespace aroma;
+using namespace aroma::data;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	検証失敗時に出力して失敗数を数える.
+//---------------------------------------------------------------------------
+std::atomic< u32 > g_failureCount( 0 );
+
+#define TEST_CHECK( exp )																\
+	do {																				\
+		if( !( exp ) )																	\
+		{																				\
+			fprintf( stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp );	\
+			++g_failureCount;															\
+		}																				\
+	} while( 0 )
+
+//---------------------------------------------------------------------------
+//	再現可能な乱数.
+//---------------------------------------------------------------------------
+struct Random
+{
+	u32	state;
+
+	explicit Random( u32 seed ) : state( seed ) {}
+	u32 Next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+};
+
+//---------------------------------------------------------------------------
+//	テストデータ生成.
+//---------------------------------------------------------------------------
+enum class DataKind
+{
+	kCompressible,		//!< 短い周期と長い周期の繰り返し.
+	kIncompressible,	//!< 乱数.
+	kZero,				//!< 全て0.
+};
+
+std::vector< u8 > MakeData( DataKind kind, size_t size, u32 seed )
+{
+	Random random( seed );
+	std::vector< u8 > data( size );
+	for( size_t i = 0; i < size; ++i )
+	{
+		switch( kind )
+		{
+		case DataKind::kCompressible:	data[ i ] = ( random.Next() % 8 == 0 ) ? static_cast< u8 >( random.Next() ) : static_cast< u8 >( "abcab"[ i % 5 ] + ( i / 4096 ) % 3 ); break;
+		case DataKind::kIncompressible:	data[ i ] = static_cast< u8 >( random.Next() ); break;
+		case DataKind::kZero:			data[ i ] = 0; break;
+		}
+	}
+	return data;
+}
+
+//---------------------------------------------------------------------------
+//	LZ4で圧縮.
+//---------------------------------------------------------------------------
+std::vector< u8 > CompressLZ4( const std::vector< u8 >& src )
+{
+	std::vector< u8 > compressed( LZ4::GetCompressBound( src.size() ) );
+	const size_t compressedBytes = LZ4::Compress( src.data(), src.size(), compressed.data(), compressed.size() );
+	TEST_CHECK( compressedBytes > 0 );
+	compressed.resize( compressedBytes );
+	return compressed;
+}
+
+//---------------------------------------------------------------------------
+//	LZ4 : 各種データのラウンドトリップ.
+//---------------------------------------------------------------------------
+void TestLZ4RoundTrip()
+{
+	static const size_t kSizes[] = { 0, 1, 4, 12, 13, 15, 16, 255, 270, 4096, 65536 + 17, 300000 };
+	static const DataKind kKinds[] = { DataKind::kCompressible, DataKind::kIncompressible, DataKind::kZero };
+
+	u32 seed = 1;
+	for( DataKind kind : kKinds )
+	{
+		for( size_t size : kSizes )
+		{
+			const std::vector< u8 > src = MakeData( kind, size, seed++ );
+			const std::vector< u8 > compressed = CompressLZ4( src );
+			TEST_CHECK( compressed.size() <= LZ4::GetCompressBound( size ) );
+			if( kind != DataKind::kIncompressible && size >= 4096 )
+			{
+				TEST_CHECK( compressed.size() < size * 3 / 4 );
+			}
+
+			std::vector< u8 > decoded( size + 1, 0xcd );
+			TEST_CHECK( LZ4::Decompress( compressed.data(), compressed.size(), decoded.data(), size ) );
+			TEST_CHECK( size == 0 || memcmp( decoded.data(), src.data(), size ) == 0 );
+			TEST_CHECK( decoded[ size ] == 0xcd );
+		}
+	}
+
+	// 空の入力はnullptrでも扱える.
+	u8 compressed[ 16 ];
+	const size_t compressedBytes = LZ4::Compress( nullptr, 0, compressed, sizeof( compressed ) );
+	TEST_CHECK( compressedBytes > 0 );
+	TEST_CHECK( LZ4::Decompress( compressed, compressedBytes, nullptr, 0 ) );
+
+	// 格納先が不足した場合は失敗する.
+	const std::vector< u8 > src = MakeData( DataKind::kIncompressible, 1000, 99 );
+	std::vector< u8 > small( 500 );
+	TEST_CHECK( LZ4::Compress( src.data(), src.size(), small.data(), small.size() ) == 0 );
+}
+
+//---------------------------------------------------------------------------
+//	LZ4 : 破損したデータを展開しない.
+//---------------------------------------------------------------------------
+void TestLZ4Corrupted()
+{
+	const std::vector< u8 > src = MakeData( DataKind::kCompressible, 20000, 7 );
+	const std::vector< u8 > compressed = CompressLZ4( src );
+	std::vector< u8 > decoded( src.size() );
+
+	// 切り詰め, 末尾への追加, 展開後のサイズの不一致.
+	for( size_t length = 0; length < compressed.size(); ++length )
+	{
+		TEST_CHECK( !LZ4::Decompress( compressed.data(), length, decoded.data(), decoded.size() ) );
+	}
+	std::vector< u8 > appended = compressed;
+	appended.push_back( 0 );
+	TEST_CHECK( !LZ4::Decompress( appended.data(), appended.size(), decoded.data(), decoded.size() ) );
+	TEST_CHECK( !LZ4::Decompress( compressed.data(), compressed.size(), decoded.data(), decoded.size() - 1 ) );
+
+	// 最初のシーケンスの一致のオフセットを出力の先頭より前へ向ける.
+	// 先頭のトークンのリテラル長が15未満になるデータで確認する.
+	const std::vector< u8 > repeated( 1000, 'x' );
+	std::vector< u8 > corrupted = CompressLZ4( repeated );
+	TEST_CHECK( ( corrupted[ 0 ] >> 4 ) < 15 );
+	const size_t offsetPos = 1 + ( corrupted[ 0 ] >> 4 );
+	corrupted[ offsetPos ]		= 0xff;
+	corrupted[ offsetPos + 1 ]	= 0xff;
+	std::vector< u8 > out( repeated.size() );
+	TEST_CHECK( !LZ4::Decompress( corrupted.data(), corrupted.size(), out.data(), out.size() ) );
+	corrupted[ offsetPos ]		= 0;
+	corrupted[ offsetPos + 1 ]	= 0;
+	TEST_CHECK( !LZ4::Decompress( corrupted.data(), corrupted.size(), out.data(), out.size() ) );
+
+	// 任意のバイトを書き換えても展開先の範囲外へ書き込まない(成否は問わない).
+	Random random( 3 );
+	std::vector< u8 > guarded( src.size() + 64, 0xcd );
+	for( u32 i = 0; i < 2000; ++i )
+	{
+		std::vector< u8 > mutated = compressed;
+		mutated[ random.Next() % mutated.size() ] ^= static_cast< u8 >( 1 + random.Next() % 255 );
+		LZ4::Decompress( mutated.data(), mutated.size(), guarded.data(), src.size() );
+		bool intact = true;
+		for( size_t j = src.size(); j < guarded.size(); ++j ) intact &= guarded[ j ] == 0xcd;
+		TEST_CHECK( intact );
+	}
+}
+
+//---------------------------------------------------------------------------
+//	チャンク分割圧縮 : ラウンドトリップ(1スレッドと並列).
+//---------------------------------------------------------------------------
+void TestChunkedRoundTrip()
+{
+	ThreadPoolScheduler scheduler;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = 3;
+	scheduler.Initialize( desc );
+
+	static const size_t kSizes[] = { 0, 1, 4095, 4096, 4097, 100000 };
+	static const DataKind kKinds[] = { DataKind::kCompressible, DataKind::kIncompressible };
+
+	u32 seed = 100;
+	for( DataKind kind : kKinds )
+	{
+		for( size_t size : kSizes )
+		{
+			const std::vector< u8 > src = MakeData( kind, size, seed++ );
+			std::vector< u8 > compressed;
+			CompressChunked( src.data(), src.size(), &compressed, 4096 );
+			TEST_CHECK( GetChunkedOriginalSize( compressed.data(), compressed.size() ) == size );
+
+			std::vector< u8 > single( size ), parallel( size );
+			TEST_CHECK( DecompressChunked( compressed.data(), compressed.size(), single.data(), single.size(), nullptr ) );
+			TEST_CHECK( DecompressChunked( compressed.data(), compressed.size(), parallel.data(), parallel.size(), &scheduler ) );
+			TEST_CHECK( single == src );
+			TEST_CHECK( parallel == src );
+		}
+	}
+
+	scheduler.Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	チャンク分割圧縮 : 破損したデータを展開しない.
+//	ヘッダーが不正なデータの展開はアサートするため, 検証はGetChunkedOriginalSize()で行う.
+//---------------------------------------------------------------------------
+void TestChunkedCorrupted()
+{
+	const std::vector< u8 > src = MakeData( DataKind::kCompressible, 20000, 11 );
+	std::vector< u8 > compressed;
+	CompressChunked( src.data(), src.size(), &compressed, 4096 );
+
+	// 切り詰め.
+	for( size_t length = 0; length < compressed.size(); ++length )
+	{
+		TEST_CHECK( GetChunkedOriginalSize( compressed.data(), length ) == 0 );
+	}
+
+	// ヘッダー(識別子, チャンクサイズ, チャンク数)とオフセット表の先頭の破損.
+	const size_t kHeaderMutations[] = { 0, 5, 8, sizeof( ChunkedCompressionHeader ) };
+	for( size_t pos : kHeaderMutations )
+	{
+		std::vector< u8 > mutated = compressed;
+		mutated[ pos ] ^= 0x40;
+		TEST_CHECK( GetChunkedOriginalSize( mutated.data(), mutated.size() ) == 0 );
+	}
+
+	// チャンクの境界を1バイトずらすと, 圧縮されたチャンクが途中で終わり展開に失敗する.
+	const u64* offsets = reinterpret_cast< const u64* >( compressed.data() + sizeof( ChunkedCompressionHeader ) );
+	TEST_CHECK( offsets[ 1 ] - offsets[ 0 ] < 4096 );
+	std::vector< u8 > shifted = compressed;
+	const u64 boundary = offsets[ 1 ] - 1;
+	memcpy( shifted.data() + sizeof( ChunkedCompressionHeader ) + sizeof( u64 ), &boundary, sizeof( boundary ) );
+	TEST_CHECK( GetChunkedOriginalSize( shifted.data(), shifted.size() ) == src.size() );
+	std::vector< u8 > decoded( src.size() );
+	TEST_CHECK( !DecompressChunked( shifted.data(), shifted.size(), decoded.data(), decoded.size() ) );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main()
+{
+	TestLZ4RoundTrip();
+	TestLZ4Corrupted();
+	TestChunkedRoundTrip();
+	TestChunkedCorrupted();
+
+	const u32 failureCount = g_failureCount.load();
+	printf( "LZ4Test: %s (%u failures)\n", failureCount == 0 ? "passed" : "FAILED", failureCount );
+	return failureCount == 0 ? 0 : 1;
+}
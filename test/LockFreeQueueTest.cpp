@@ -0,0 +1,227 @@
+﻿//===========================================================================
+//!
+//!	@file		LockFreeQueueTest.cpp
+//!	@brief		固定長ロックフリーキューのストレステスト.
+//!
+//!	@details
+//!		複数スレッドから一括追加/一括取り出しを混ぜて大量に流し,
+//!		全要素が1度だけ順序通りに届くことを確認します.
+//!		コア数が少ない環境でも進むよう, キューが満杯/空の場合は他スレッドへ譲ります.
+//!		AROMA_SANITIZE_THREADを有効にしてビルドするとThreadSanitizerで
+//!		メモリオーダーの誤りを検出できます.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <aroma/common/LockFreeQueue.h>
+
+using namespace aroma;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	検証失敗時に出力して失敗数を数える.
+//---------------------------------------------------------------------------
+std::atomic< u32 > g_failureCount( 0 );
+
+#define TEST_CHECK( exp )																\
+	do {																				\
+		if( !( exp ) )																	\
+		{																				\
+			fprintf( stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp );	\
+			++g_failureCount;															\
+		}																				\
+	} while( 0 )
+
+//---------------------------------------------------------------------------
+//	破棄漏れ検出用の要素.
+//---------------------------------------------------------------------------
+std::atomic< s32 > g_aliveCount( 0 );
+
+struct Item
+{
+	u32	producer;
+	u32	sequence;
+
+	Item() : producer( 0 ), sequence( 0 ) { ++g_aliveCount; }
+	Item( u32 p, u32 s ) : producer( p ), sequence( s ) { ++g_aliveCount; }
+	Item( const Item& other ) : producer( other.producer ), sequence( other.sequence ) { ++g_aliveCount; }
+	Item& operator=( const Item& other ) { producer = other.producer; sequence = other.sequence; return *this; }
+	~Item() { --g_aliveCount; }
+};
+
+//---------------------------------------------------------------------------
+//	SPSC : 順序通りに全要素が届くか, 概算サイズが容量を超えないか.
+//---------------------------------------------------------------------------
+void TestSPSC()
+{
+	constexpr u32 kCount	= 200000;
+	constexpr u32 kBulkMax	= 13;
+
+	SPSCQueue< u32 > queue( 256 );
+	std::atomic< bool > finished( false );
+
+	std::thread producer( [ & ]
+	{
+		u32 values[ kBulkMax ];
+		u32 next = 0;
+		while( next < kCount )
+		{
+			// 単体追加と一括追加を交互に行う.
+			if( next & 1 )
+			{
+				if( queue.TryEnqueue( next ) ) ++next;
+				else std::this_thread::yield();
+				continue;
+			}
+			const u32 count = ( next % kBulkMax ) + 1;
+			u32 n = 0;
+			for( ; n < count && next + n < kCount; ++n ) values[ n ] = next + n;
+			const u32 enqueued = static_cast< u32 >( queue.TryEnqueueBulk( values, n ) );
+			if( enqueued == 0 ) std::this_thread::yield();
+			next += enqueued;
+		}
+	} );
+
+	std::thread observer( [ & ]
+	{
+		while( !finished.load( std::memory_order_acquire ) )
+		{
+			TEST_CHECK( queue.GetSizeApprox() <= queue.GetCapacity() );
+			std::this_thread::yield();
+		}
+	} );
+
+	u32 values[ kBulkMax ];
+	u32 expect = 0;
+	while( expect < kCount )
+	{
+		const size_t n = queue.TryDequeueBulk( values, ( expect % kBulkMax ) + 1 );
+		if( n == 0 ) std::this_thread::yield();
+		for( size_t i = 0; i < n; ++i )
+		{
+			TEST_CHECK( values[ i ] == expect );
+			expect = values[ i ] + 1;
+		}
+	}
+
+	producer.join();
+	finished.store( true, std::memory_order_release );
+	observer.join();
+	TEST_CHECK( queue.GetSizeApprox() == 0 );
+}
+
+//---------------------------------------------------------------------------
+//	MPMC : 全要素が1度だけ届き, 各生産者の順序が消費者毎に保たれるか.
+//---------------------------------------------------------------------------
+void TestMPMC()
+{
+	constexpr u32 kProducerCount	= 4;
+	constexpr u32 kConsumerCount	= 4;
+	constexpr u32 kCountPerProducer	= 50000;
+	constexpr u32 kBulkMax			= 7;
+
+	MPMCQueue< Item > queue( 64 );
+	std::vector< std::atomic< u8 > > received( kProducerCount * kCountPerProducer );
+	for( auto& flag : received ) flag.store( 0, std::memory_order_relaxed );
+	std::atomic< u32 > receivedCount( 0 );
+
+	std::vector< std::thread > threads;
+	for( u32 p = 0; p < kProducerCount; ++p )
+	{
+		threads.emplace_back( [ &, p ]
+		{
+			Item values[ kBulkMax ];
+			u32 next = 0;
+			while( next < kCountPerProducer )
+			{
+				if( p & 1 )
+				{
+					if( queue.TryEnqueue( Item( p, next ) ) ) ++next;
+					else std::this_thread::yield();
+					continue;
+				}
+				const u32 count = ( next % kBulkMax ) + 1;
+				u32 n = 0;
+				for( ; n < count && next + n < kCountPerProducer; ++n ) values[ n ] = Item( p, next + n );
+				const u32 enqueued = static_cast< u32 >( queue.TryEnqueueBulk( values, n ) );
+				if( enqueued == 0 ) std::this_thread::yield();
+				next += enqueued;
+			}
+		} );
+	}
+	for( u32 c = 0; c < kConsumerCount; ++c )
+	{
+		threads.emplace_back( [ &, c ]
+		{
+			Item values[ kBulkMax ];
+			s64 lastSequence[ kProducerCount ];
+			for( auto& sequence : lastSequence ) sequence = -1;
+
+			while( receivedCount.load( std::memory_order_relaxed ) < kProducerCount * kCountPerProducer )
+			{
+				const size_t n = ( c & 1 ) ? queue.TryDequeueBulk( values, kBulkMax ) : ( queue.TryDequeue( &values[ 0 ] ) ? 1 : 0 );
+				if( n == 0 ) std::this_thread::yield();
+				for( size_t i = 0; i < n; ++i )
+				{
+					const Item& item = values[ i ];
+					TEST_CHECK( item.producer < kProducerCount && item.sequence < kCountPerProducer );
+					if( item.producer >= kProducerCount || item.sequence >= kCountPerProducer ) continue;
+
+					TEST_CHECK( static_cast< s64 >( item.sequence ) > lastSequence[ item.producer ] );
+					lastSequence[ item.producer ] = item.sequence;
+					TEST_CHECK( received[ item.producer * kCountPerProducer + item.sequence ].fetch_add( 1, std::memory_order_relaxed ) == 0 );
+				}
+				receivedCount.fetch_add( static_cast< u32 >( n ), std::memory_order_relaxed );
+			}
+		} );
+	}
+	for( auto& thread : threads )
+	{
+		thread.join();
+	}
+
+	TEST_CHECK( receivedCount.load() == kProducerCount * kCountPerProducer );
+	TEST_CHECK( queue.GetSizeApprox() == 0 );
+}
+
+//---------------------------------------------------------------------------
+//	残った要素がデストラクタで破棄されるか.
+//---------------------------------------------------------------------------
+void TestDestroyRemaining()
+{
+	{
+		SPSCQueue< Item > spsc( 8 );
+		MPMCQueue< Item > mpmc( 8 );
+		for( u32 i = 0; i < 5; ++i )
+		{
+			TEST_CHECK( spsc.TryEnqueue( Item( 0, i ) ) );
+			TEST_CHECK( mpmc.TryEnqueue( Item( 0, i ) ) );
+		}
+		Item item;
+		TEST_CHECK( spsc.TryDequeue( &item ) && item.sequence == 0 );
+		TEST_CHECK( mpmc.TryDequeue( &item ) && item.sequence == 0 );
+	}
+	TEST_CHECK( g_aliveCount.load() == 0 );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main()
+{
+	TestSPSC();
+	TestMPMC();
+	TestDestroyRemaining();
+
+	const u32 failureCount = g_failureCount.load();
+	printf( "LockFreeQueueTest: %s (%u failures)\n", failureCount == 0 ? "passed" : "FAILED", failureCount );
+	return failureCount == 0 ? 0 : 1;
+}
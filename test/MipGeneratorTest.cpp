@@ -0,0 +1,211 @@
+﻿//===========================================================================
+//!
+//!	@file		MipGeneratorTest.cpp
+//!	@brief		ミップマップ生成のテスト.
+//!
+//!	@details
+//!		一様な色のイメージは全てのフォーマットとフィルターで全ミップが同じ色のままであること,
+//!		スケジューラーで並列に生成した結果が呼び出しスレッドのみで生成した結果と一致することを確認します.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <aroma/common/Algorithm.h>
+#include <aroma/common/Scheduler.h>
+#include <aroma/data/MipGenerator.h>
+
+using namespace aroma;
+using namespace aroma::data;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	検証失敗時に出力して失敗数を数える.
+//---------------------------------------------------------------------------
+std::atomic< u32 > g_failureCount( 0 );
+
+#define TEST_CHECK( exp )																\
+	do {																				\
+		if( !( exp ) )																	\
+		{																				\
+			fprintf( stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp );	\
+			++g_failureCount;															\
+		}																				\
+	} while( 0 )
+
+//! ミップマップ生成に対応するフォーマットと1ピクセルのバイト数.
+struct FormatCase
+{
+	PixelFormat		format;
+	u32				bytesPerPixel;
+};
+const FormatCase kFormats[] =
+{
+	{ PixelFormat::kR8G8B8A8Unorm,		4 },
+	{ PixelFormat::kR8G8B8A8UnormSrgb,	4 },
+	{ PixelFormat::kB8G8R8A8Unorm,		4 },
+	{ PixelFormat::kB8G8R8A8UnormSrgb,	4 },
+	{ PixelFormat::kB8G8R8X8Unorm,		4 },
+	{ PixelFormat::kB8G8R8X8UnormSrgb,	4 },
+	{ PixelFormat::kR8G8Unorm,			2 },
+	{ PixelFormat::kR8Unorm,			1 },
+	{ PixelFormat::kA8Unorm,			1 },
+};
+
+const MipFilter kFilters[] = { MipFilter::kBox, MipFilter::kKaiser, MipFilter::kLanczos };
+
+//---------------------------------------------------------------------------
+//	各ミップが指定したピクセルで埋まっているか確認.
+//---------------------------------------------------------------------------
+bool IsFilledWith( const std::vector< u8 >& image, u32 mipCount, u32 width, u32 height, PixelFormat format, const u8* pixel, u32 bytesPerPixel )
+{
+	size_t offset = 0;
+	for( u32 mip = 0; mip < mipCount; ++mip )
+	{
+		const u32 mipWidth	= Max( 1u, width >> mip );
+		const u32 mipHeight	= Max( 1u, height >> mip );
+		SurfaceInfo surface;
+		CalcSurfaceInfo( &surface, mipWidth, mipHeight, format );
+		for( u32 y = 0; y < mipHeight; ++y )
+		{
+			for( u32 x = 0; x < mipWidth; ++x )
+			{
+				if( memcmp( &image[ offset + y * surface.pitchBytes + x * bytesPerPixel ], pixel, bytesPerPixel ) != 0 ) return false;
+			}
+		}
+		offset += surface.bytes;
+	}
+	return offset == image.size();
+}
+
+//---------------------------------------------------------------------------
+//	一様な色のイメージは全ミップが同じ色のまま.
+//	負のローブを持つフィルター, ラップ/クランプ, sRGB空間でのフィルターも含めて確認する.
+//---------------------------------------------------------------------------
+void TestConstantImage()
+{
+	static const u8 kColors[][ 4 ] =
+	{
+		{ 0x00, 0x00, 0x00, 0xff },
+		{ 0xff, 0xff, 0xff, 0xff },
+		{ 0x12, 0x80, 0xed, 0x40 },
+		{ 0x01, 0x7f, 0xfe, 0x01 },
+	};
+	// SIMD(4ピクセル単位)と端数の両方を通るよう, 4の倍数でない幅を含める.
+	static const u32 kSizes[][ 2 ] = { { 1, 1 }, { 64, 64 }, { 37, 23 }, { 5, 130 } };
+
+	for( const FormatCase& format : kFormats )
+	{
+		TEST_CHECK( IsMipGenerationSupported( format.format ) );
+		for( MipFilter filter : kFilters )
+		{
+			for( const u8* color : kColors )
+			{
+				for( const u32* size : kSizes )
+				{
+					const u32 width		= size[ 0 ];
+					const u32 height	= size[ 1 ];
+					const size_t pitch	= static_cast< size_t >( width ) * format.bytesPerPixel;
+					std::vector< u8 > src( pitch * height );
+					for( size_t i = 0; i < src.size(); i += format.bytesPerPixel ) memcpy( &src[ i ], color, format.bytesPerPixel );
+
+					for( u32 variant = 0; variant < 4; ++variant )
+					{
+						MipGenerateDesc desc;
+						desc.filter	= filter;
+						desc.wrap	= ( variant & 1 ) != 0;
+						desc.srgb	= ( variant & 2 ) != 0;
+
+						std::vector< u8 > image;
+						u32 mipCount = 0;
+						TEST_CHECK( GenerateMips( src.data(), pitch, width, height, format.format, &image, &mipCount, desc ) );
+						TEST_CHECK( mipCount == GetFullMipCount( width, height ) );
+						TEST_CHECK( IsFilledWith( image, mipCount, width, height, format.format, color, format.bytesPerPixel ) );
+					}
+				}
+			}
+		}
+	}
+
+	// 完全に透明なテクセルの色は残らない(アルファで重み付けするため0になる).
+	const u8 transparent[ 4 ] = { 0x80, 0x80, 0x80, 0x00 };
+	const u8 cleared[ 4 ] = { 0x00, 0x00, 0x00, 0x00 };
+	std::vector< u8 > src( 16 * 16 * 4 );
+	for( size_t i = 0; i < src.size(); i += 4 ) memcpy( &src[ i ], transparent, 4 );
+	std::vector< u8 > image;
+	u32 mipCount = 0;
+	TEST_CHECK( GenerateMips( src.data(), 16 * 4, 16, 16, PixelFormat::kR8G8B8A8Unorm, &image, &mipCount ) );
+	TEST_CHECK( mipCount == 5 );
+	TEST_CHECK( memcmp( image.data(), transparent, 4 ) == 0 );
+	TEST_CHECK( memcmp( &image[ image.size() - 4 ], cleared, 4 ) == 0 );
+
+	// 最大ミップ数の指定.
+	MipGenerateDesc desc;
+	desc.maxMipCount = 2;
+	TEST_CHECK( GenerateMips( src.data(), 16 * 4, 16, 16, PixelFormat::kR8G8B8A8Unorm, &image, &mipCount, desc ) );
+	TEST_CHECK( mipCount == 2 );
+	TEST_CHECK( image.size() == ( 16 * 16 + 8 * 8 ) * 4 );
+}
+
+//---------------------------------------------------------------------------
+//	並列に生成した結果が呼び出しスレッドのみで生成した結果と一致する.
+//	出力行を複数の帯に分けるサイズで確認する.
+//---------------------------------------------------------------------------
+void TestParallelMatchesSingle()
+{
+	ThreadPoolScheduler scheduler;
+	ThreadPoolScheduler::Desc schedulerDesc;
+	schedulerDesc.threadCount = 3;
+	scheduler.Initialize( schedulerDesc );
+
+	const u32 width		= 640;
+	const u32 height	= 520;
+	u32 state = 12345;
+	for( const FormatCase& format : kFormats )
+	{
+		const size_t pitch = static_cast< size_t >( width ) * format.bytesPerPixel;
+		std::vector< u8 > src( pitch * height );
+		for( size_t i = 0; i < src.size(); ++i )
+		{
+			state = state * 1664525u + 1013904223u;
+			src[ i ] = static_cast< u8 >( ( state >> 24 ) / 4 + ( i / pitch ) % 192 );
+		}
+
+		for( MipFilter filter : kFilters )
+		{
+			MipGenerateDesc desc;
+			desc.filter					= filter;
+			desc.preserveAlphaCoverage	= true;
+
+			std::vector< u8 > single, parallel;
+			u32 singleMipCount = 0, parallelMipCount = 0;
+			TEST_CHECK( GenerateMips( src.data(), pitch, width, height, format.format, &single, &singleMipCount, desc ) );
+			desc.scheduler = &scheduler;
+			TEST_CHECK( GenerateMips( src.data(), pitch, width, height, format.format, &parallel, &parallelMipCount, desc ) );
+			TEST_CHECK( singleMipCount == parallelMipCount );
+			TEST_CHECK( single == parallel );
+		}
+	}
+
+	scheduler.Finalize();
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main()
+{
+	TestConstantImage();
+	TestParallelMatchesSingle();
+
+	const u32 failureCount = g_failureCount.load();
+	printf( "MipGeneratorTest: %s (%u failures)\n", failureCount == 0 ? "passed" : "FAILED", failureCount );
+	return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+﻿//===========================================================================
+//!
+//!	@file		PixelConvertTest.cpp
+//!	@brief		ピクセルフォーマット変換のテスト.
+//!
+//!	@details
+//!		各フォーマットについて, 行単位の変換(SIMD + 末尾のスカラー)と
+//!		1ピクセルずつの変換(SIMD関数は4ピクセル未満を扱わないため常にスカラー)が一致することを,
+//!		端数を含む幅で確認します. 並列のイメージ変換が1スレッドの結果と一致することも確認します.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <aroma/common/Scheduler.h>
+#include <aroma/data/PixelConvert.h>
+
+using namespace aroma;
+using namespace aroma::data;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	検証失敗時に出力して失敗数を数える.
+//---------------------------------------------------------------------------
+std::atomic< u32 > g_failureCount( 0 );
+
+#define TEST_CHECK( exp )																\
+	do {																				\
+		if( !( exp ) )																	\
+		{																				\
+			fprintf( stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp );	\
+			++g_failureCount;															\
+		}																				\
+	} while( 0 )
+
+//! 変換に対応するフォーマット.
+const DDSDXGIFormat kFormats[] =
+{
+	DDSDXGIFormat::kR8G8B8,
+	DDSDXGIFormat::kA8R8G8B8,
+	DDSDXGIFormat::kX8R8G8B8,
+	DDSDXGIFormat::kA8B8G8R8,
+	DDSDXGIFormat::kX8B8G8R8,
+	DDSDXGIFormat::kR5G6B5,
+	DDSDXGIFormat::kA1R5G5B5,
+	DDSDXGIFormat::kX1R5G5B5,
+	DDSDXGIFormat::kA4R4G4B4,
+	DDSDXGIFormat::kX4R4G4B4,
+	DDSDXGIFormat::kL8,
+	DDSDXGIFormat::kA8L8,
+	DDSDXGIFormat::kA8,
+};
+
+//---------------------------------------------------------------------------
+//	テストデータ生成.
+//---------------------------------------------------------------------------
+std::vector< u8 > MakeData( size_t size, u32 seed )
+{
+	std::vector< u8 > data( size );
+	u32 state = seed;
+	for( size_t i = 0; i < size; ++i )
+	{
+		state = state * 1664525u + 1013904223u;
+		data[ i ] = static_cast< u8 >( state >> 24 );
+	}
+	return data;
+}
+
+//---------------------------------------------------------------------------
+//	1ピクセルの変換結果の確認(フォーマットの定義通りか).
+//---------------------------------------------------------------------------
+void TestKnownValues()
+{
+	struct Case
+	{
+		DDSDXGIFormat	format;
+		u8				src[ 4 ];
+		u8				expected[ 4 ];
+	};
+	static const Case kCases[] =
+	{
+		{ DDSDXGIFormat::kR8G8B8,	{ 0x10, 0x20, 0x30 },		{ 0x30, 0x20, 0x10, 0xff } },
+		{ DDSDXGIFormat::kA8R8G8B8,	{ 0x10, 0x20, 0x30, 0x40 },	{ 0x30, 0x20, 0x10, 0x40 } },
+		{ DDSDXGIFormat::kX8R8G8B8,	{ 0x10, 0x20, 0x30, 0x40 },	{ 0x30, 0x20, 0x10, 0xff } },
+		{ DDSDXGIFormat::kA8B8G8R8,	{ 0x10, 0x20, 0x30, 0x40 },	{ 0x10, 0x20, 0x30, 0x40 } },
+		{ DDSDXGIFormat::kX8B8G8R8,	{ 0x10, 0x20, 0x30, 0x40 },	{ 0x10, 0x20, 0x30, 0xff } },
+		{ DDSDXGIFormat::kR5G6B5,	{ 0x1f, 0xf8 },				{ 0xff, 0x00, 0xff, 0xff } },
+		{ DDSDXGIFormat::kR5G6B5,	{ 0xe0, 0x07 },				{ 0x00, 0xff, 0x00, 0xff } },
+		{ DDSDXGIFormat::kA1R5G5B5,	{ 0x00, 0x7c },				{ 0xff, 0x00, 0x00, 0x00 } },
+		{ DDSDXGIFormat::kA1R5G5B5,	{ 0x1f, 0x80 },				{ 0x00, 0x00, 0xff, 0xff } },
+		{ DDSDXGIFormat::kX1R5G5B5,	{ 0xe0, 0x03 },				{ 0x00, 0xff, 0x00, 0xff } },
+		{ DDSDXGIFormat::kA4R4G4B4,	{ 0x21, 0x43 },				{ 0x33, 0x22, 0x11, 0x44 } },
+		{ DDSDXGIFormat::kX4R4G4B4,	{ 0x21, 0x43 },				{ 0x33, 0x22, 0x11, 0xff } },
+		{ DDSDXGIFormat::kL8,		{ 0x5a },					{ 0x5a, 0x5a, 0x5a, 0xff } },
+		{ DDSDXGIFormat::kA8L8,		{ 0x5a, 0x80 },				{ 0x5a, 0x5a, 0x5a, 0x80 } },
+		{ DDSDXGIFormat::kA8,		{ 0x5a },					{ 0x00, 0x00, 0x00, 0x5a } },
+	};
+
+	for( const Case& c : kCases )
+	{
+		TEST_CHECK( IsConvertibleToRGBA8( c.format ) );
+
+		// 行単位の変換でも同じ結果になるよう, 同じピクセルを並べて変換する.
+		const u32 bytesPerPixel = GetLegacyBytesPerPixel( c.format );
+		const u32 pixelCount = 37;
+		std::vector< u8 > src( bytesPerPixel * pixelCount );
+		for( u32 i = 0; i < pixelCount; ++i ) memcpy( &src[ i * bytesPerPixel ], c.src, bytesPerPixel );
+		std::vector< u8 > dst( pixelCount * 4 );
+		ConvertRowToRGBA8( c.format, src.data(), dst.data(), pixelCount );
+		for( u32 i = 0; i < pixelCount; ++i )
+		{
+			TEST_CHECK( memcmp( &dst[ i * 4 ], c.expected, 4 ) == 0 );
+		}
+	}
+	TEST_CHECK( !IsConvertibleToRGBA8( DDSDXGIFormat::kA8R3G3B2 ) );
+	TEST_CHECK( GetLegacyBytesPerPixel( DDSDXGIFormat::kA8R3G3B2 ) == 0 );
+}
+
+//---------------------------------------------------------------------------
+//	行単位の変換(SIMD)と1ピクセルずつの変換(スカラー)が一致する.
+//---------------------------------------------------------------------------
+void TestSimdMatchesScalar()
+{
+	u32 seed = 1;
+	for( DDSDXGIFormat format : kFormats )
+	{
+		const u32 bytesPerPixel = GetLegacyBytesPerPixel( format );
+		for( u32 width = 1; width <= 300; width = width < 70 ? width + 1 : width * 2 )
+		{
+			// 変換元は丁度のサイズで確保し, 末尾を越えて読まないことをサニタイザーで確認できるようにする.
+			const std::vector< u8 > src = MakeData( static_cast< size_t >( width ) * bytesPerPixel, seed++ );
+			std::vector< u8 > row( width * 4 + 16, 0xcd );
+			std::vector< u8 > scalar( width * 4 );
+			ConvertRowToRGBA8( format, src.data(), row.data(), width );
+			for( u32 i = 0; i < width; ++i )
+			{
+				ConvertRowToRGBA8( format, &src[ i * bytesPerPixel ], &scalar[ i * 4 ], 1 );
+			}
+			TEST_CHECK( memcmp( row.data(), scalar.data(), scalar.size() ) == 0 );
+
+			bool intact = true;
+			for( size_t i = scalar.size(); i < row.size(); ++i ) intact &= row[ i ] == 0xcd;
+			TEST_CHECK( intact );
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+//	並列のイメージ変換が1スレッドの結果と一致する.
+//---------------------------------------------------------------------------
+void TestImageParallel()
+{
+	ThreadPoolScheduler scheduler;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = 3;
+	scheduler.Initialize( desc );
+
+	const u32 width		= 333;
+	const u32 height	= 257;
+	u32 seed = 100;
+	for( DDSDXGIFormat format : kFormats )
+	{
+		// 行の末尾に余白のあるピッチで確認する.
+		const size_t srcPitch = static_cast< size_t >( width ) * GetLegacyBytesPerPixel( format ) + 5;
+		const size_t dstPitch = static_cast< size_t >( width ) * 4 + 12;
+		const std::vector< u8 > src = MakeData( srcPitch * height, seed++ );
+		std::vector< u8 > single( dstPitch * height, 0 ), parallel( dstPitch * height, 0 );
+		ConvertImageToRGBA8( format, src.data(), srcPitch, single.data(), dstPitch, width, height, nullptr );
+		ConvertImageToRGBA8( format, src.data(), srcPitch, parallel.data(), dstPitch, width, height, &scheduler );
+		TEST_CHECK( single == parallel );
+
+		std::vector< u8 > row( width * 4 );
+		ConvertRowToRGBA8( format, src.data() + srcPitch * ( height - 1 ), row.data(), width );
+		TEST_CHECK( memcmp( row.data(), single.data() + dstPitch * ( height - 1 ), row.size() ) == 0 );
+	}
+
+	scheduler.Finalize();
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main()
+{
+	TestKnownValues();
+	TestSimdMatchesScalar();
+	TestImageParallel();
+
+	const u32 failureCount = g_failureCount.load();
+	printf( "PixelConvertTest: %s (%u failures)\n", failureCount == 0 ? "passed" : "FAILED", failureCount );
+	return failureCount == 0 ? 0 : 1;
+}
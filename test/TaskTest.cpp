@@ -0,0 +1,331 @@
+﻿//===========================================================================
+//!
+//!	@file		TaskTest.cpp
+//!	@brief		非同期タスクとスケジューラーのテスト.
+//!
+//!	@details
+//!		Task<T>の継続, WhenAll(), 値と例外の伝搬, ManualSchedulerのジョブの実行順
+//!		(キューが満杯でオーバーフローリストへ退避した場合を含む)を確認します.
+//!		コルーチン対応コンパイラではco_awaitによる待機とスレッドの切り替えも確認します.
+//!
+//!	@author		Copyright (C) DebugCurry. All rights reserved.
+//!	@author		d0
+//!
+//===========================================================================
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <aroma/common/Scheduler.h>
+#include <aroma/common/Task.h>
+
+using namespace aroma;
+
+namespace {
+
+//---------------------------------------------------------------------------
+//	検証失敗時に出力して失敗数を数える.
+//---------------------------------------------------------------------------
+std::atomic< u32 > g_failureCount( 0 );
+
+#define TEST_CHECK( exp )																\
+	do {																				\
+		if( !( exp ) )																	\
+		{																				\
+			fprintf( stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #exp );	\
+			++g_failureCount;															\
+		}																				\
+	} while( 0 )
+
+//---------------------------------------------------------------------------
+//	タスクが指定したメッセージの例外で完了したか.
+//---------------------------------------------------------------------------
+template< typename T >
+bool IsFailedWith( const Task< T >& task, const char* message )
+{
+	try
+	{
+		task.Get();
+	}
+	catch( const std::runtime_error& e )
+	{
+		return std::string( e.what() ) == message;
+	}
+	return false;
+}
+
+//---------------------------------------------------------------------------
+//	継続 : 値の伝搬と実行スレッド.
+//---------------------------------------------------------------------------
+void TestContinuation()
+{
+	// スケジューラー未指定の継続は完了させたスレッドで実行される.
+	TaskPromise< int > promise;
+	Task< int > task = promise.GetTask();
+	Task< std::string > text = task.Then( nullptr, []( const Task< int >& t ){ return std::to_string( t.Get() * 2 ); } );
+	Task< size_t > length = text.Then( nullptr, []( const Task< std::string >& t ){ return t.Get().size(); } );
+	TEST_CHECK( !task.IsReady() && !text.IsReady() && !length.IsReady() );
+	promise.SetValue( 21 );
+	TEST_CHECK( task.IsReady() && text.IsReady() && length.IsReady() );
+	TEST_CHECK( text.Get() == "42" );
+	TEST_CHECK( length.Get() == 2 );
+
+	// 完了済みのタスクへの継続は登録したスレッドで即時実行される.
+	bool executed = false;
+	Task< void > after = MakeReadyTask( 1 ).Then( nullptr, [ &executed ]( const Task< int >& ){ executed = true; } );
+	TEST_CHECK( executed && after.IsReady() );
+
+	// スケジューラー指定の継続はそのスケジューラーで実行される.
+	ManualScheduler manual;
+	TaskPromise< void > trigger;
+	u32 stage = 0;
+	Task< u32 > chained = trigger.GetTask()
+		.Then( &manual, [ &stage ]( const Task< void >& ){ return ++stage; } )
+		.Then( &manual, [ &stage ]( const Task< u32 >& t ){ stage += 10; return t.Get() + stage; } );
+	trigger.SetValue();
+	TEST_CHECK( stage == 0 && !chained.IsReady() );
+	TEST_CHECK( manual.RunPending() == 1 );
+	TEST_CHECK( stage == 1 && !chained.IsReady() );
+
+	// 実行中に登録された継続は次回のRunPending()で実行される.
+	TEST_CHECK( manual.RunPending() == 1 );
+	TEST_CHECK( chained.IsReady() && chained.Get() == 12 );
+	TEST_CHECK( manual.RunPending() == 0 );
+
+	// ワーカースレッドで実行した結果をメインスレッドの継続で受け取る.
+	ThreadPoolScheduler pool;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = 2;
+	pool.Initialize( desc );
+
+	const std::thread::id mainThread = std::this_thread::get_id();
+	std::atomic< bool > onWorker( false );
+	Task< int > loaded = RunTask( &pool, [ &onWorker, mainThread ]{ onWorker = std::this_thread::get_id() != mainThread; return 7; } );
+	std::thread::id continuationThread;
+	Task< int > resumed = loaded.Then( &manual, [ &continuationThread ]( const Task< int >& t ){ continuationThread = std::this_thread::get_id(); return t.Get() + 1; } );
+	loaded.Wait();
+	while( !resumed.IsReady() )
+	{
+		manual.RunPending();
+		std::this_thread::yield();
+	}
+	TEST_CHECK( onWorker.load() );
+	TEST_CHECK( continuationThread == mainThread );
+	TEST_CHECK( resumed.Get() == 8 );
+
+	pool.Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	WhenAll : 全タスクの完了で完了する.
+//---------------------------------------------------------------------------
+void TestWhenAll()
+{
+	TEST_CHECK( WhenAll< int >( 0, nullptr ).IsReady() );
+
+	// 登録と逆順に完了させても最後の完了で完了する.
+	TaskPromise< int > promises[ 4 ];
+	Task< int > tasks[ 4 ];
+	for( u32 i = 0; i < 4; ++i ) tasks[ i ] = promises[ i ].GetTask();
+	Task< void > all = WhenAll( 4, tasks );
+	for( u32 i = 4; i-- > 1; )
+	{
+		promises[ i ].SetValue( static_cast< int >( i ) );
+		TEST_CHECK( !all.IsReady() );
+	}
+	promises[ 0 ].SetValue( 0 );
+	TEST_CHECK( all.IsReady() );
+
+	// 例外で完了したタスクも完了として数える.
+	TaskPromise< void > ok, failed;
+	Task< void > pair[ 2 ] = { ok.GetTask(), failed.GetTask() };
+	Task< void > both = WhenAll( 2, pair );
+	failed.SetException( std::make_exception_ptr( std::runtime_error( "failed" ) ) );
+	TEST_CHECK( !both.IsReady() );
+	ok.SetValue();
+	TEST_CHECK( both.IsReady() );
+	TEST_CHECK( IsFailedWith( pair[ 1 ], "failed" ) );
+
+	// ワーカースレッドで並行して完了する.
+	ThreadPoolScheduler pool;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = 3;
+	pool.Initialize( desc );
+
+	const u32 kTaskCount = 200;
+	std::atomic< u32 > sum( 0 );
+	std::vector< Task< u32 > > work( kTaskCount );
+	for( u32 i = 0; i < kTaskCount; ++i )
+	{
+		work[ i ] = RunTask( &pool, [ i, &sum ]{ sum += i; return i; } );
+	}
+	WhenAll( kTaskCount, work.data() ).Wait();
+	TEST_CHECK( sum.load() == kTaskCount * ( kTaskCount - 1 ) / 2 );
+	for( u32 i = 0; i < kTaskCount; ++i )
+	{
+		TEST_CHECK( work[ i ].IsReady() && work[ i ].Get() == i );
+	}
+
+	pool.Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	例外の伝搬.
+//---------------------------------------------------------------------------
+void TestException()
+{
+	// 関数の例外はタスクに格納され, Get()で再送出される.
+	ManualScheduler manual;
+	Task< int > thrown = RunTask( &manual, []() -> int { throw std::runtime_error( "load" ); } );
+	TEST_CHECK( manual.RunPending() == 1 );
+	TEST_CHECK( thrown.IsReady() );
+	TEST_CHECK( IsFailedWith( thrown, "load" ) );
+
+	// 継続内のGet()で後続のタスクへ伝搬する.
+	Task< int > propagated = thrown.Then( nullptr, []( const Task< int >& t ){ return t.Get() + 1; } );
+	Task< void > last = propagated.Then( nullptr, []( const Task< int >& t ){ t.Get(); } );
+	TEST_CHECK( IsFailedWith( propagated, "load" ) );
+	TEST_CHECK( IsFailedWith( last, "load" ) );
+
+	// 継続で例外を処理すれば後続は値で完了する.
+	Task< int > recovered = thrown.Then( nullptr, []( const Task< int >& t ){ return IsFailedWith( t, "load" ) ? -1 : 0; } );
+	TEST_CHECK( recovered.Get() == -1 );
+
+	// 継続自身の例外.
+	Task< void > failedContinuation = MakeReadyTask( 1 ).Then( nullptr, []( const Task< int >& ){ throw std::runtime_error( "continuation" ); } );
+	TEST_CHECK( IsFailedWith( failedContinuation, "continuation" ) );
+
+	// ワーカースレッドで送出された例外を待機したスレッドで受け取る.
+	ThreadPoolScheduler pool;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = 1;
+	pool.Initialize( desc );
+	Task< void > workerTask = RunTask( &pool, []{ throw std::runtime_error( "worker" ); } );
+	TEST_CHECK( IsFailedWith( workerTask, "worker" ) );
+	TEST_CHECK( RunTask( &pool, []{ return 5; } ).Get() == 5 );
+	pool.Finalize();
+}
+
+//---------------------------------------------------------------------------
+//	ManualScheduler : キューが満杯の場合も登録順に実行される.
+//---------------------------------------------------------------------------
+void TestManualSchedulerOrder()
+{
+	ManualScheduler manual( 2 );
+	std::vector< u32 > order;
+	u32 next = 0;
+	auto schedule = [ & ]( u32 count )
+	{
+		for( u32 i = 0; i < count; ++i )
+		{
+			const u32 index = next++;
+			manual.Schedule( [ &order, index ]{ order.push_back( index ); } );
+		}
+	};
+	auto isSequential = [ &order ]( u32 count )
+	{
+		if( order.size() != count ) return false;
+		for( u32 i = 0; i < count; ++i )
+		{
+			if( order[ i ] != i ) return false;
+		}
+		return true;
+	};
+
+	// 容量を超えた分はオーバーフローリストへ退避される.
+	schedule( 10 );
+	TEST_CHECK( manual.RunPending() == 10 );
+	TEST_CHECK( isSequential( 10 ) );
+
+	// 退避中の登録と実行数の指定を混ぜても登録順を保つ.
+	schedule( 10 );
+	TEST_CHECK( manual.RunPending( 3 ) == 3 );
+	schedule( 5 );
+	TEST_CHECK( manual.RunPending( 1 ) == 1 );
+	schedule( 1 );
+	TEST_CHECK( manual.RunPending() == 12 );
+	TEST_CHECK( isSequential( 26 ) );
+	TEST_CHECK( manual.RunPending() == 0 );
+
+	// 実行中のジョブからの登録(満杯でも待機しない)は次回に実行される.
+	const u32 index = next++;
+	manual.Schedule( [ &, index ]{ order.push_back( index ); schedule( 4 ); } );
+	schedule( 1 );
+	TEST_CHECK( manual.RunPending() == 2 );
+	TEST_CHECK( isSequential( 28 ) );
+	TEST_CHECK( manual.RunPending() == 4 );
+	TEST_CHECK( isSequential( 32 ) );
+}
+
+#ifdef AROMA_COROUTINE_ENABLE
+//---------------------------------------------------------------------------
+//	コルーチン : ワーカースレッドで読み込み, メインスレッドで再開する.
+//---------------------------------------------------------------------------
+Task< int > LoadAndResume( IScheduler* pool, IScheduler* mainThread, std::thread::id* resumedThread )
+{
+	const int value = co_await RunTask( pool, []{ return 20; } );
+	co_await ScheduleOn( mainThread );
+	*resumedThread = std::this_thread::get_id();
+	co_return value + 1;
+}
+
+Task< void > ThrowAfterAwait( IScheduler* pool )
+{
+	co_await RunTask( pool, []{ return 0; } );
+	throw std::runtime_error( "coroutine" );
+}
+
+Task< int > AwaitFailed( Task< void > task )
+{
+	co_await task;
+	co_return 0;
+}
+
+void TestCoroutine()
+{
+	ThreadPoolScheduler pool;
+	ThreadPoolScheduler::Desc desc;
+	desc.threadCount = 2;
+	pool.Initialize( desc );
+	ManualScheduler manual;
+
+	std::thread::id resumedThread;
+	Task< int > task = LoadAndResume( &pool, &manual, &resumedThread );
+	while( !task.IsReady() )
+	{
+		manual.RunPending();
+		std::this_thread::yield();
+	}
+	TEST_CHECK( task.Get() == 21 );
+	TEST_CHECK( resumedThread == std::this_thread::get_id() );
+
+	// コルーチン内の例外はタスクへ格納され, co_awaitで伝搬する.
+	Task< void > thrown = ThrowAfterAwait( &pool );
+	TEST_CHECK( IsFailedWith( thrown, "coroutine" ) );
+	TEST_CHECK( IsFailedWith( AwaitFailed( thrown ), "coroutine" ) );
+
+	pool.Finalize();
+}
+#endif
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//	エントリーポイント.
+//---------------------------------------------------------------------------
+int main()
+{
+	TestContinuation();
+	TestWhenAll();
+	TestException();
+	TestManualSchedulerOrder();
+#ifdef AROMA_COROUTINE_ENABLE
+	TestCoroutine();
+#endif
+
+	const u32 failureCount = g_failureCount.load();
+	printf( "TaskTest: %s (%u failures)\n", failureCount == 0 ? "passed" : "FAILED", failureCount );
+	return failureCount == 0 ? 0 : 1;
+}